@@ -59,19 +59,19 @@ CodebaseIndexer::CodebaseIndexer(
     std::shared_ptr<IWorkspaceManager> workspaceManager,
     std::shared_ptr<ILanguageDetector> languageDetector,
     std::shared_ptr<ILanguageParserFactory> parserFactory,
-    std::shared_ptr<EditorCoreThreadPool> threadPool)
+    std::shared_ptr<EditorCoreThreadPool> threadPool,
+    std::shared_ptr<Executor> executor)
     : workspaceManager_(workspaceManager),
       languageDetector_(languageDetector),
       parserFactory_(parserFactory),
       threadPool_(threadPool),
+      executor_(executor ? std::move(executor) : Executor::shared()),
       shutdownRequested_(false),
+      drainScheduled_(false),
       isIndexing_(false),
       filesIndexed_(0),
       totalFilesToIndex_(0),
       nextCallbackId_(0) {
-    
-    // Start worker thread
-    workerThread_ = std::thread(&CodebaseIndexer::indexWorker, this);
 }
 
 CodebaseIndexer::~CodebaseIndexer() {
@@ -110,12 +110,12 @@ void CodebaseIndexer::shutdown() {
         shutdownRequested_ = true;
     }
     
-    // Notify the worker thread to wake up
-    queueCondition_.notify_all();
-    
-    // Wait for worker thread to finish
-    if (workerThread_.joinable()) {
-        workerThread_.join();
+    // Wait for the queued tasks to be drained
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        queueCondition_.wait(lock, [this] {
+            return !drainScheduled_;
+        });
     }
     
     // Clear all data
@@ -484,35 +484,36 @@ void CodebaseIndexer::handleFileChange(const std::string& filePath, bool isCreat
     }
 }
 
-void CodebaseIndexer::indexWorker() {
-    while (true) {
+void CodebaseIndexer::drainIndexQueue() {
+    // Process a batch, then yield the thread to other background work; the
+    // queue is drained by one task at a time, so tasks keep their order
+    for (size_t processed = 0; processed < kIndexBatchSize; ++processed) {
         IndexTask task;
         
         {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            
-            // Wait for a task or shutdown request
-            queueCondition_.wait(lock, [this] {
-                return !indexQueue_.empty() || shutdownRequested_;
-            });
-            
-            if (shutdownRequested_ && indexQueue_.empty()) {
-                // Shutdown requested and no more tasks
-                break;
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (indexQueue_.empty()) {
+                drainScheduled_ = false;
+                queueCondition_.notify_all();
+                return;
             }
             
             // Get the next task
-            if (!indexQueue_.empty()) {
-                task = indexQueue_.front();
-                indexQueue_.pop();
-            } else {
-                continue;
-            }
+            task = indexQueue_.front();
+            indexQueue_.pop();
         }
         
         // Process the task
-        processTask(task);
+        try {
+            processTask(task);
+        } catch (const std::exception& e) {
+            EditorErrorReporter::reportError("CodebaseIndexer",
+                                             "Failed to index " + task.filePath + ": " + std::string(e.what()));
+        }
     }
+    
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    scheduleDrain_nolock();
 }
 
 void CodebaseIndexer::processTask(const IndexTask& task) {
@@ -763,7 +764,23 @@ void CodebaseIndexer::removeDirectoryFromIndex(const std::string& directory) {
 void CodebaseIndexer::addToIndexQueue(const IndexTask& task) {
     std::lock_guard<std::mutex> lock(queueMutex_);
     indexQueue_.push(task);
-    queueCondition_.notify_one();
+    if (!drainScheduled_) {
+        drainScheduled_ = true;
+        scheduleDrain_nolock();
+    }
+}
+
+void CodebaseIndexer::scheduleDrain_nolock() {
+    try {
+        executor_->submit(Executor::Lane::Background, ThreadPool::Priority::LOW, [this]() {
+            drainIndexQueue();
+        });
+    } catch (const std::exception& e) {
+        // The executor is shutting down; nothing will run the queue
+        drainScheduled_ = false;
+        queueCondition_.notify_all();
+        EditorErrorReporter::reportError("CodebaseIndexer", "Failed to schedule indexing: " + std::string(e.what()));
+    }
 }
 
 std::string CodebaseIndexer::getCodeSnippet(const std::string& filePath, size_t lineNumber, size_t contextLines) const {
@@ -6,6 +6,7 @@
 #include "interfaces/IWorkspaceManager.hpp"
 #include "EditorErrorReporter.h"
 #include "EditorCoreThreadPool.h"
+#include "Executor.h"
 
 #include <unordered_map>
 #include <unordered_set>
@@ -54,12 +55,14 @@ public:
      * @param languageDetector The language detector
      * @param parserFactory The language parser factory
      * @param threadPool The thread pool for async operations
+     * @param executor Executor that runs the index queue; defaults to the process-wide one
      */
     CodebaseIndexer(
         std::shared_ptr<IWorkspaceManager> workspaceManager,
         std::shared_ptr<ILanguageDetector> languageDetector,
         std::shared_ptr<ILanguageParserFactory> parserFactory,
-        std::shared_ptr<EditorCoreThreadPool> threadPool);
+        std::shared_ptr<EditorCoreThreadPool> threadPool,
+        std::shared_ptr<Executor> executor = nullptr);
     
     /**
      * @brief Destructor
@@ -113,7 +116,8 @@ public:
 
 private:
     // Helper methods
-    void indexWorker();
+    void drainIndexQueue();
+    void scheduleDrain_nolock();
     bool indexFile(const std::string& filePath, const std::string& content);
     bool indexFileWithParser(
         const std::string& filePath,
@@ -156,10 +160,14 @@ private:
     std::shared_ptr<ILanguageParserFactory> parserFactory_;
     std::shared_ptr<EditorCoreThreadPool> threadPool_;
     
-    // Worker thread
-    std::thread workerThread_;
+    // Index tasks processed by one drain task before it yields the thread
+    static constexpr size_t kIndexBatchSize = 32;
+    
+    // Index queue, drained one batch at a time on the executor's background lane
+    std::shared_ptr<Executor> executor_;
     std::atomic<bool> shutdownRequested_;
     std::queue<IndexTask> indexQueue_;  // Queue for indexing tasks
+    bool drainScheduled_;               // A drain task is queued or running; guarded by queueMutex_
     std::mutex queueMutex_;
     std::condition_variable queueCondition_;
     
@@ -8,6 +8,44 @@
 #include "AppDebugLog.h"
 #include <chrono>    // For std::chrono
 #include "MultiCursor.h"
+#include <string_view>
+
+namespace {
+
+// Backward searches read the buffer in chunks of this many lines
+constexpr size_t kBackwardSearchChunkLines = 256;
+
+bool equalsIgnoreCase(char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+}
+
+// Find the first match starting at or after from
+size_t findInLine(std::string_view text, std::string_view term, size_t from, bool caseSensitive) {
+    if (from > text.length() || term.length() > text.length() - from) {
+        return std::string_view::npos;
+    }
+    if (caseSensitive) {
+        return text.find(term, from);
+    }
+    auto it = std::search(text.begin() + from, text.end(), term.begin(), term.end(), equalsIgnoreCase);
+    return it == text.end() ? std::string_view::npos : static_cast<size_t>(it - text.begin());
+}
+
+// Find the last match ending at or before endCol
+size_t findLastInLine(std::string_view text, std::string_view term, size_t endCol, bool caseSensitive) {
+    endCol = std::min(endCol, text.length());
+    if (term.length() > endCol) {
+        return std::string_view::npos;
+    }
+    if (caseSensitive) {
+        return text.rfind(term, endCol - term.length());
+    }
+    std::string_view head = text.substr(0, endCol);
+    auto it = std::find_end(head.begin(), head.end(), term.begin(), term.end(), equalsIgnoreCase);
+    return it == head.end() ? std::string_view::npos : static_cast<size_t>(it - head.begin());
+}
+
+} // namespace
 
 // Constructor without dependencies - for backward compatibility
 Editor::Editor()
@@ -273,22 +311,21 @@ void Editor::printView(std::ostream& os) const {
         syntaxHighlightingManager_->setVisibleRange(startLine, endLine);
     }
     
-    // Display line numbers and content
-    for (size_t i = startLine; i <= endLine; ++i) {
+    // Fetch the styles for the whole range at once, before the buffer is read
+    std::vector<std::vector<SyntaxStyle>> rangeStyles;
+    if (syntaxHighlightingEnabled_ && currentHighlighter_) {
+        rangeStyles = syntaxHighlightingManager_->getHighlightingStyles(startLine, endLine);
+    }
+    
+    // Display line numbers and content; lines are streamed straight from the buffer
+    textBuffer_->forEachLine(startLine, endLine + 1, [&](size_t i, std::string_view line) {
         // Print line number
         os << std::setw(4) << (i + 1) << " | ";
         
-        const std::string& line = textBuffer_->getLine(i);
-        
-        // Get syntax highlighting styles for this line if enabled
-        std::vector<SyntaxStyle> lineStyles;
-        if (syntaxHighlightingEnabled_ && currentHighlighter_) {
-            lineStyles = syntaxHighlightingManager_->getHighlightingStyles(i, i)[0];
-        }
-        
         // Print the line content with highlighting if available
-        if (!lineStyles.empty()) {
-            printLineWithHighlighting(os, line, lineStyles);
+        const size_t styleIndex = i - startLine;
+        if (styleIndex < rangeStyles.size() && !rangeStyles[styleIndex].empty()) {
+            printLineWithHighlighting(os, line, rangeStyles[styleIndex]);
         } else {
             os << line;
         }
@@ -299,7 +336,8 @@ void Editor::printView(std::ostream& os) const {
         }
         
         os << std::endl;
-    }
+        return true;
+    });
     
     // Display status bar
     printStatusBar(os);
@@ -308,7 +346,7 @@ void Editor::printView(std::ostream& os) const {
     // This should be done separately if needed
 }
 
-void Editor::printLineWithHighlighting(std::ostream& os, const std::string& line, const std::vector<SyntaxStyle>& styles) const {
+void Editor::printLineWithHighlighting(std::ostream& os, std::string_view line, const std::vector<SyntaxStyle>& styles) const {
     // Default style
     const SyntaxColor defaultStyle = SyntaxColor::Default;
     
@@ -1905,126 +1943,76 @@ bool Editor::performSearchLogic(
     } else if (!forward && startCol == 0) {
         if (startLine > 0) {
             startLine--;
-            std::string prevLine = textBuffer_->getLine(startLine);
-            startCol = prevLine.length();
+            startCol = textBuffer_->lineLength(startLine);
         }
     }
     
-    // Helper for case-insensitive comparison
-    auto compareChars = [caseSensitive](char a, char b) -> bool {
-        if (caseSensitive) {
-            return a == b;
-        } else {
-            return std::tolower(a) == std::tolower(b);
-        }
+    // Lines are read as views straight out of the buffer; nothing is copied
+    bool found = false;
+    auto recordMatch = [&](size_t line, size_t col) {
+        outFoundLine = line;
+        outFoundCol = col;
+        found = true;
     };
     
-    // Search logic
     if (forward) {
         // Forward search
-        for (size_t line = startLine; line < textBuffer_->lineCount(); ++line) {
-            std::string lineText = textBuffer_->getLine(line);
-            size_t col = (line == startLine) ? startCol : 0;
-            
-            while (col <= lineText.length() - searchTerm.length()) {
-                bool found = true;
-                
-                for (size_t i = 0; i < searchTerm.length(); ++i) {
-                    if (!compareChars(lineText[col + i], searchTerm[i])) {
-                        found = false;
-                        break;
-                    }
-                }
-                
-                if (found) {
-                    outFoundLine = line;
-                    outFoundCol = col;
-                    return true;
-                }
-                
-                col++;
+        textBuffer_->forEachLine(startLine, textBuffer_->lineCount(), [&](size_t line, std::string_view lineText) {
+            size_t col = findInLine(lineText, searchTerm, line == startLine ? startCol : 0, caseSensitive);
+            if (col == std::string_view::npos) {
+                return true;
             }
+            recordMatch(line, col);
+            return false;
+        });
+        if (found) {
+            return true;
         }
         
         // If we reach here, wrap around to beginning of file
-        for (size_t line = 0; line <= startLine; ++line) {
-            std::string lineText = textBuffer_->getLine(line);
+        textBuffer_->forEachLine(0, startLine + 1, [&](size_t line, std::string_view lineText) {
+            size_t col = findInLine(lineText, searchTerm, 0, caseSensitive);
             size_t maxCol = (line == startLine) ? startCol : lineText.length();
-            
-            for (size_t col = 0; col < maxCol; ++col) {
-                if (col > lineText.length() - searchTerm.length()) {
-                    break;
-                }
-                
-                bool found = true;
-                
-                for (size_t i = 0; i < searchTerm.length(); ++i) {
-                    if (!compareChars(lineText[col + i], searchTerm[i])) {
-                        found = false;
-                        break;
-                    }
-                }
-                
-                if (found) {
-                    outFoundLine = line;
-                    outFoundCol = col;
-                    return true;
-                }
+            if (col == std::string_view::npos || col >= maxCol) {
+                return true;
             }
-        }
-    } else {
-        // Backward search
-        for (int line = static_cast<int>(startLine); line >= 0; --line) {
-            std::string lineText = textBuffer_->getLine(line);
-            size_t maxCol = (line == static_cast<int>(startLine)) ? startCol : lineText.length();
-            
-            for (int col = static_cast<int>(maxCol) - static_cast<int>(searchTerm.length()); col >= 0; --col) {
-                bool found = true;
-                
-                for (size_t i = 0; i < searchTerm.length(); ++i) {
-                    if (!compareChars(lineText[col + i], searchTerm[i])) {
-                        found = false;
-                        break;
-                    }
+            recordMatch(line, col);
+            return false;
+        });
+        return found;
+    }
+    
+    // Lines can only be visited in order, so a backward scan walks chunks of
+    // lines from the end and keeps the last match within each chunk.
+    // endColFor(line, length) bounds where a match on that line may end.
+    auto searchBackward = [&](size_t firstLine, size_t lastLine, auto endColFor) {
+        size_t chunkEnd = lastLine + 1;
+        while (chunkEnd > firstLine && !found) {
+            size_t chunkStart = chunkEnd - std::min(chunkEnd - firstLine, kBackwardSearchChunkLines);
+            textBuffer_->forEachLine(chunkStart, chunkEnd, [&](size_t line, std::string_view lineText) {
+                size_t col = findLastInLine(lineText, searchTerm, endColFor(line, lineText.length()), caseSensitive);
+                if (col != std::string_view::npos) {
+                    recordMatch(line, col);
                 }
-                
-                if (found) {
-                    outFoundLine = line;
-                    outFoundCol = col;
-                    return true;
-                }
-            }
-        }
-        
-        // If we reach here, wrap around to end of file
-        for (int line = static_cast<int>(textBuffer_->lineCount()) - 1; line >= static_cast<int>(startLine); --line) {
-            std::string lineText = textBuffer_->getLine(line);
-            
-            if (line == static_cast<int>(startLine) && lineText.length() <= startCol) {
-                continue; // Already searched this part
-            }
-            
-            for (int col = static_cast<int>(lineText.length()) - static_cast<int>(searchTerm.length()); col >= 0; --col) {
-                bool found = true;
-                
-                for (size_t i = 0; i < searchTerm.length(); ++i) {
-                    if (!compareChars(lineText[col + i], searchTerm[i])) {
-                        found = false;
-                        break;
-                    }
-                }
-                
-                if (found) {
-                    outFoundLine = line;
-                    outFoundCol = col;
-                    return true;
-                }
-            }
+                return true;
+            });
+            chunkEnd = chunkStart;
         }
+        return found;
+    };
+    
+    // Backward search
+    if (searchBackward(0, startLine, [&](size_t line, size_t length) {
+            return line == startLine ? std::min(startCol, length) : length;
+        })) {
+        return true;
     }
     
-    // Not found
-    return false;
+    // If we reach here, wrap around to end of file; the start line is
+    // searched again only if it extends past the starting column
+    return searchBackward(startLine, textBuffer_->lineCount() - 1, [&](size_t line, size_t length) {
+        return (line == startLine && length <= startCol) ? 0 : length;
+    });
 }
 
 void Editor::setLine(size_t lineIndex, const std::string& text) {
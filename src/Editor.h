@@ -93,7 +93,7 @@ public:
     std::string getWordUnderCursor() const; // Returns the word at the current cursor position
 
     void printView(std::ostream& os) const;
-    void printLineWithHighlighting(std::ostream& os, const std::string& line, const std::vector<SyntaxStyle>& styles) const;
+    void printLineWithHighlighting(std::ostream& os, std::string_view line, const std::vector<SyntaxStyle>& styles) const;
     void applyColorForSyntaxColor(std::ostream& os, SyntaxColor color) const;
     void printStatusBar(std::ostream& os) const;
     void positionCursor();
@@ -7,10 +7,16 @@
 
 using namespace std::chrono_literals;
 
+namespace {
+
+// Operations executed per batch by the TextBuffer owner thread
+constexpr size_t kTextBufferBatchSize = 64;
+
+} // namespace
+
 EditorCoreThreadPool::EditorCoreThreadPool(size_t numThreads)
     : running_(false)
     , textBufferOwnerIndex_(0)  // Default to first thread as TextBuffer owner
-    , textBufferOperationsAvailable_(false)
 {
     // Ensure at least one thread for the pool
     numThreads = std::max(numThreads, static_cast<size_t>(1));
@@ -21,6 +27,17 @@ EditorCoreThreadPool::EditorCoreThreadPool(size_t numThreads)
     LOG_DEBUG("EditorCoreThreadPool created with " + std::to_string(numThreads) + " threads");
 }
 
+EditorCoreThreadPool::EditorCoreThreadPool(std::shared_ptr<Executor> executor)
+    : running_(false)
+    , textBufferOwnerIndex_(0)
+    , executor_(executor ? std::move(executor) : Executor::shared())
+{
+    // The owner thread is the only thread of our own
+    workerThreads_.reserve(1);
+    
+    LOG_DEBUG("EditorCoreThreadPool created on an executor");
+}
+
 EditorCoreThreadPool::~EditorCoreThreadPool() {
     // Ensure threads are properly shut down
     shutdown();
@@ -67,7 +84,7 @@ void EditorCoreThreadPool::shutdown() {
     
     // Notify all waiting threads to check the running_ flag
     taskQueueCondition_.notify_all();
-    textBufferCondition_.notify_all();
+    textBufferQueue_.wake();
     
     // Wait for all threads to finish
     for (auto& thread : workerThreads_) {
@@ -129,6 +146,30 @@ bool EditorCoreThreadPool::isTextBufferOwnerThread() const {
 }
 
 void EditorCoreThreadPool::submitTask(std::function<void()> task) {
+    if (executor_) {
+        if (!running_) {
+            LOG_WARNING("Task submitted to stopped thread pool");
+            return;
+        }
+        
+        // Nobody waits on the future, so report failures here as the workers do
+        try {
+            executor_->submit(Executor::Lane::Interactive, [task = std::move(task)]() {
+                try {
+                    task();
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Exception in worker thread task: " + std::string(e.what()));
+                } catch (...) {
+                    LOG_ERROR("Unknown exception in worker thread task");
+                }
+            });
+        } catch (const std::exception& e) {
+            LOG_WARNING("Task submitted to stopped executor: " + std::string(e.what()));
+        }
+        return;
+    }
+    
+    bool ownerThreadOnly;
     {
         std::lock_guard<std::mutex> lock(taskQueueMutex_);
         
@@ -138,10 +179,16 @@ void EditorCoreThreadPool::submitTask(std::function<void()> task) {
         }
         
         taskQueue_.push(std::move(task));
+        ownerThreadOnly = workerThreads_.size() == 1;
     }
     
-    // Notify one waiting thread that a new task is available
-    taskQueueCondition_.notify_one();
+    // Notify one waiting thread that a new task is available; without
+    // general workers only the parked owner thread can run it
+    if (ownerThreadOnly) {
+        textBufferQueue_.wake();
+    } else {
+        taskQueueCondition_.notify_one();
+    }
 }
 
 size_t EditorCoreThreadPool::threadCount() const {
@@ -149,8 +196,11 @@ size_t EditorCoreThreadPool::threadCount() const {
 }
 
 void EditorCoreThreadPool::notifyTextBufferOperationsAvailable() {
-    textBufferOperationsAvailable_ = true;
-    textBufferCondition_.notify_one();
+    textBufferQueue_.wake();
+}
+
+TextBufferOperationQueue& EditorCoreThreadPool::textBufferOperations() {
+    return textBufferQueue_;
 }
 
 void EditorCoreThreadPool::generalWorkerFunction(size_t threadIndex) {
@@ -200,75 +250,59 @@ void EditorCoreThreadPool::textBufferWorkerFunction(size_t threadIndex) {
     // Set thread name for debugging (platform-specific, omitted here)
     
     while (running_) {
-        bool processedOperations = false;
-        
-        // First, process any TextBuffer operations
+        std::shared_ptr<TextBuffer> buffer;
         {
             std::lock_guard<std::mutex> lock(textBufferMutex_);
-            if (ownedTextBuffer_) {
-                processTextBufferOperations();
-                processedOperations = true;
-            }
+            buffer = ownedTextBuffer_;
+        }
+        
+        // First, process a batch of TextBuffer operations
+        if (buffer && processTextBufferOperations(*buffer) > 0) {
+            continue;
         }
         
         // If no TextBuffer operations were processed, check for general tasks
-        if (!processedOperations) {
-            std::function<void()> task;
-            
-            {
-                std::unique_lock<std::mutex> lock(taskQueueMutex_);
-                
-                if (!taskQueue_.empty()) {
-                    task = std::move(taskQueue_.front());
-                    taskQueue_.pop();
-                }
-            }
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(taskQueueMutex_);
             
-            // Execute the task if we got one
-            if (task) {
-                try {
-                    task();
-                } catch (const std::exception& e) {
-                    LOG_ERROR("Exception in TextBuffer thread task: " + std::string(e.what()));
-                } catch (...) {
-                    LOG_ERROR("Unknown exception in TextBuffer thread task");
-                }
-                continue;  // Skip the wait if we processed a task
+            if (!taskQueue_.empty()) {
+                task = std::move(taskQueue_.front());
+                taskQueue_.pop();
             }
         }
         
-        // If no work was done, wait for a notification or check periodically
-        {
-            std::unique_lock<std::mutex> lock(textBufferMutex_);
-            
-            // Wait until notified or timeout
-            textBufferCondition_.wait_for(lock, 10ms, [this] {
-                return textBufferOperationsAvailable_ || !running_;
-            });
-            
-            // Reset the notification flag
-            textBufferOperationsAvailable_ = false;
+        // Execute the task if we got one
+        if (task) {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception in TextBuffer thread task: " + std::string(e.what()));
+            } catch (...) {
+                LOG_ERROR("Unknown exception in TextBuffer thread task");
+            }
+            continue;  // Skip the wait if we processed a task
         }
+        
+        // Sleep until an operation is queued or we are woken up
+        textBufferQueue_.waitForOperations();
     }
     
     LOG_DEBUG("TextBuffer owner thread " + std::to_string(threadIndex) + " stopped");
 }
 
-void EditorCoreThreadPool::processTextBufferOperations() {
-    if (!ownedTextBuffer_) {
-        return;
-    }
+size_t EditorCoreThreadPool::processTextBufferOperations(TextBuffer& buffer) {
+    size_t processedCount = 0;
     
     try {
-        // Process all pending operations in the TextBuffer's queue
-        size_t processedCount = ownedTextBuffer_->processOperationQueue();
-        
-        if (processedCount > 0) {
-            LOG_DEBUG("Processed " + std::to_string(processedCount) + 
-                     " TextBuffer operations");
-        }
+        // Process one batch from the pool's queue, then anything pending in
+        // the TextBuffer's own queue
+        processedCount = textBufferQueue_.drain(buffer, kTextBufferBatchSize);
+        processedCount += buffer.processOperationQueue();
     } catch (const std::exception& e) {
         LOG_ERROR("Exception while processing TextBuffer operations: " + 
                  std::string(e.what()));
     }
-} 
\ No newline at end of file
+    
+    return processedCount;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "interfaces/IEditorCoreThreadPool.hpp"
+#include "TextBufferOperationQueue.h"
+#include "Executor.h"
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -31,6 +33,16 @@ public:
      */
     explicit EditorCoreThreadPool(size_t numThreads = 2);
     
+    /**
+     * @brief Constructs the pool on top of an executor
+     * 
+     * Only the TextBuffer owner thread is created; general tasks run on
+     * the executor's interactive lane instead of threads of their own.
+     * 
+     * @param executor The executor to run general tasks on
+     */
+    explicit EditorCoreThreadPool(std::shared_ptr<Executor> executor);
+    
     /**
      * @brief Destructor ensures proper shutdown of all threads
      */
@@ -45,6 +57,16 @@ public:
     void submitTask(std::function<void()> task) override;
     size_t threadCount() const override;
     void notifyTextBufferOperationsAvailable() override;
+    
+    /**
+     * @brief Get the queue of operations for the owned TextBuffer
+     * 
+     * Operations enqueued or posted here are executed in batches by the
+     * TextBuffer owner thread, which sleeps while the queue is empty.
+     * 
+     * @return The operation queue
+     */
+    TextBufferOperationQueue& textBufferOperations();
 
 private:
     // Thread pool state
@@ -52,6 +74,9 @@ private:
     std::atomic<bool> running_;
     size_t textBufferOwnerIndex_; // Index of the thread that owns TextBuffer
     
+    // Runs general tasks when set, in place of general worker threads
+    std::shared_ptr<Executor> executor_;
+    
     // Task queue for general tasks
     std::queue<std::function<void()>> taskQueue_;
     std::mutex taskQueueMutex_;
@@ -60,13 +85,12 @@ private:
     // TextBuffer management
     std::shared_ptr<TextBuffer> ownedTextBuffer_;
     std::mutex textBufferMutex_;
-    std::condition_variable textBufferCondition_;
-    std::atomic<bool> textBufferOperationsAvailable_;
+    TextBufferOperationQueue textBufferQueue_;
     
     // Thread worker functions
     void generalWorkerFunction(size_t threadIndex);
     void textBufferWorkerFunction(size_t threadIndex);
     
     // Helper methods
-    void processTextBufferOperations();
+    size_t processTextBufferOperations(TextBuffer& buffer);
 }; 
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "EditorCommands.h"
 #include <sstream>
 #include "AppDebugLog.h"
+#include "MappedFile.h"
+#include "diff/StreamingDiff.h"
 
 // Implementation of diff and merge methods
 
@@ -14,10 +16,11 @@ std::vector<std::string> Editor::getCurrentTextAsLines() const {
     // Reserve space to avoid reallocations
     lines.reserve(lineCount);
     
-    // Copy each line from the buffer
-    for (size_t i = 0; i < lineCount; ++i) {
-        lines.push_back(textBuffer_->getLine(i));
-    }
+    // Copy each line straight from the buffer's storage
+    textBuffer_->forEachLine(0, lineCount, [&lines](size_t, std::string_view line) {
+        lines.emplace_back(line);
+        return true;
+    });
     
     return lines;
 }
@@ -91,17 +94,50 @@ bool Editor::diffWithCurrent(const std::vector<std::string>& otherText) {
 }
 
 bool Editor::diffWithFile(const std::string& filename) {
-    // Get the current text as lines
-    auto currentText = getCurrentTextAsLines();
+    if (!diffEngine_) {
+        LOG_ERROR("Diff engine not available");
+        return false;
+    }
     
-    // Load the other file
-    std::vector<std::string> otherText;
-    if (!loadTextFromFile(filename, otherText)) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        LOG_ERROR("Failed to open file: " + filename);
         return false;
     }
     
-    // Show the diff
-    return showDiff(currentText, otherText);
+    try {
+        // Stream both texts through the diff a window at a time, so neither
+        // the file nor a copy of the buffer is ever held whole
+        TextBufferLineSource currentText(*textBuffer_);
+        MappedFileLineSource otherText(file);
+        UnifiedDiffBuilder output;
+        StreamingDiff diff(diffEngine_);
+        diff.run(currentText, otherText, [&output](const DiffChange& change, const StreamingDiff::ChangeText& text) {
+            output.add(change, text.lines1, text.lines2);
+            return true;
+        });
+        output.finish();
+        
+        // Clear the current buffer
+        while (textBuffer_->lineCount() > 0) {
+            textBuffer_->deleteLine(0);
+        }
+        
+        for (const auto& line : output.lines()) {
+            textBuffer_->addLine(line);
+        }
+        
+        // Reset cursor and scroll position
+        setCursor(0, 0);
+        
+        // Mark the buffer as modified
+        setModified(true);
+        
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error creating diff: " + std::string(e.what()));
+        return false;
+    }
 }
 
 bool Editor::mergeTexts(
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "ThreadPool.h"
+#include "AppDebugLog.h"
+
+/**
+ * @class Executor
+ * @brief Process-wide task executor with separate lanes per kind of work
+ *
+ * The editor used to start a thread pool per component plus a handful of
+ * dedicated threads, which oversubscribed the CPU as components were added.
+ * The executor owns all of those threads instead and splits them into lanes
+ * so different kinds of work cannot starve each other:
+ *
+ * - Interactive: short work the user is waiting on, such as highlighting
+ *   the visible lines. Sized to half the CPUs.
+ * - Background: throughput work such as indexing and highlighting the rest
+ *   of a document. Gets the remaining CPUs.
+ * - IO: tasks that block on sockets or files for a bounded time. Fixed
+ *   size, since these threads mostly wait; a task that never returns takes
+ *   a thread from every other IO user, so event loops that run for a
+ *   component's lifetime keep a thread of their own instead.
+ *
+ * Each lane is a work-stealing ThreadPool, so task priorities, aging,
+ * deadlines and cancellation tokens still apply within a lane. The executor
+ * also runs delayed tasks from one timer thread and keeps queue depth and
+ * wait time metrics for each lane.
+ *
+ * Components take the executor as a shared_ptr and default to shared(), the
+ * process-wide instance, which CoreModule also registers with the injector.
+ */
+class Executor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The kinds of work the executor keeps apart
+     */
+    enum class Lane {
+        Interactive = 0,
+        Background = 1,
+        IO = 2      ///< Bounded blocking work only; the lane has a fixed, small thread count
+    };
+
+    static constexpr size_t kLaneCount = 3;
+
+    /**
+     * @brief Thread counts per lane; zero picks a size from the CPU count
+     */
+    struct Options {
+        size_t interactiveThreads = 0;
+        size_t backgroundThreads = 0;
+        size_t ioThreads = 0;
+    };
+
+    /**
+     * @brief Point-in-time metrics for one lane
+     */
+    struct LaneMetrics {
+        size_t threadCount = 0;
+        size_t activeThreads = 0;
+        size_t queueDepth = 0;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t cancelled = 0;                     ///< Dropped unrun because their token was cancelled
+        uint64_t expired = 0;                       ///< Dropped unrun because their deadline passed
+        uint64_t promoted = 0;                      ///< Run ahead of their priority after aging
+        std::chrono::nanoseconds averageWait{0};   ///< Time from submission to start
+        std::chrono::nanoseconds p99Wait{0};       ///< Upper bound, to a power of two
+        std::chrono::nanoseconds maxWait{0};
+        std::chrono::nanoseconds averageRun{0};
+    };
+
+    /**
+     * @brief Constructor, sizing every lane from the CPU count
+     */
+    Executor()
+        : Executor(Options())
+    {
+    }
+
+    /**
+     * @brief Constructor
+     *
+     * @param options Thread counts per lane
+     */
+    explicit Executor(const Options& options)
+        : stop_(false)
+    {
+        const size_t cpus = hardwareThreads();
+        const size_t interactive = options.interactiveThreads ? options.interactiveThreads : std::max<size_t>(1, cpus / 2);
+        const size_t background = options.backgroundThreads ? options.backgroundThreads
+                                                            : std::max<size_t>(1, cpus - std::min(cpus, interactive));
+        const size_t io = options.ioThreads ? options.ioThreads : kDefaultIoThreads;
+
+        lanes_[laneIndex(Lane::Interactive)].pool = std::make_unique<ThreadPool>(interactive);
+        lanes_[laneIndex(Lane::Background)].pool = std::make_unique<ThreadPool>(background);
+        lanes_[laneIndex(Lane::IO)].pool = std::make_unique<ThreadPool>(io);
+
+        timerThread_ = std::thread([this] { timerLoop(); });
+
+        LOG_DEBUG("Executor created with " + std::to_string(interactive) + " interactive, " +
+                  std::to_string(background) + " background and " + std::to_string(io) + " IO threads");
+    }
+
+    /**
+     * @brief Destructor
+     *
+     * Drops scheduled tasks that are not due yet, then waits for every
+     * queued task to finish.
+     */
+    ~Executor() {
+        shutdown();
+        if (timerThread_.joinable()) {
+            timerThread_.join();
+        }
+        for (auto& lane : lanes_) {
+            lane.pool.reset();
+        }
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Get the process-wide executor, creating it on first use
+     */
+    static std::shared_ptr<Executor> shared() {
+        static std::shared_ptr<Executor> instance = std::make_shared<Executor>();
+        return instance;
+    }
+
+    /**
+     * @brief Submit a task to a lane at normal priority
+     *
+     * @return A future that will contain the function's return value
+     * @throws std::runtime_error if the executor has been shut down
+     */
+    template<class F, class... Args>
+    auto submit(Lane lane, F&& f, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
+        return submit(lane, ThreadPool::Priority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submit a task to a lane with a priority within that lane
+     *
+     * @return A future that will contain the function's return value
+     * @throws std::runtime_error if the executor has been shut down
+     */
+    template<class F, class... Args>
+    auto submit(Lane lane, ThreadPool::Priority priority, F&& f, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
+        ThreadPool::TaskOptions options;
+        options.priority = priority;
+        return submit(lane, options, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Submit a task to a lane with a priority, deadline and cancellation token
+     *
+     * @return A future that will contain the function's return value, or
+     *         report broken_promise if the task is dropped
+     * @throws std::runtime_error if the executor has been shut down
+     */
+    template<class F, class... Args>
+    auto submit(Lane lane, const ThreadPool::TaskOptions& options, F&& f, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
+        using ReturnType = typename std::invoke_result<F, Args...>::type;
+
+        LaneState& state = lanes_[laneIndex(lane)];
+        const Clock::time_point submitted = Clock::now();
+        state.submitted.fetch_add(1, std::memory_order_relaxed);
+
+        try {
+            return state.pool->submit(options,
+                [&state, submitted, f = std::forward<F>(f),
+                 args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> ReturnType {
+                    const Clock::time_point started = Clock::now();
+                    state.recordWait(started - submitted);
+
+                    // Count the task as completed however it leaves
+                    struct Completion {
+                        LaneState& state;
+                        Clock::time_point started;
+                        ~Completion() { state.recordRun(Clock::now() - started); }
+                    } completion{state, started};
+
+                    return std::apply(std::move(f), std::move(args));
+                });
+        } catch (...) {
+            state.submitted.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Run a task on a lane after a delay
+     *
+     * Nothing waits for the task, so it must handle its own errors. Tasks
+     * that are not due when the executor shuts down are dropped.
+     *
+     * @param lane The lane to run the task on
+     * @param delay How long to wait before submitting the task
+     * @param task The task to run
+     */
+    template<class F>
+    void schedule(Lane lane, Clock::duration delay, F&& task) {
+        {
+            std::lock_guard<std::mutex> lock(timerMutex_);
+            if (stop_) {
+                throw std::runtime_error("Cannot schedule task on stopped Executor");
+            }
+            timers_.emplace(Clock::now() + delay, TimerEntry{lane, ThreadPool::Task(std::forward<F>(task))});
+        }
+        timerCondition_.notify_one();
+    }
+
+    /**
+     * @brief Get the number of threads in a lane
+     */
+    size_t threadCount(Lane lane) const {
+        return lanes_[laneIndex(lane)].pool->getThreadCount();
+    }
+
+    /**
+     * @brief Get the number of tasks waiting to start in a lane
+     */
+    size_t queueDepth(Lane lane) const {
+        return lanes_[laneIndex(lane)].pool->getQueueSize();
+    }
+
+    /**
+     * @brief Get the metrics for a lane
+     */
+    LaneMetrics metrics(Lane lane) const {
+        const LaneState& state = lanes_[laneIndex(lane)];
+        LaneMetrics metrics;
+        metrics.threadCount = state.pool->getThreadCount();
+        metrics.activeThreads = state.pool->getActiveThreadCount();
+        metrics.queueDepth = state.pool->getQueueSize();
+        metrics.submitted = state.submitted.load(std::memory_order_relaxed);
+        metrics.completed = state.completed.load(std::memory_order_relaxed);
+        metrics.cancelled = state.pool->getCancelledTaskCount();
+        metrics.expired = state.pool->getExpiredTaskCount();
+        metrics.promoted = state.pool->getPromotedTaskCount();
+
+        const uint64_t started = state.started.load(std::memory_order_relaxed);
+        if (started > 0) {
+            metrics.averageWait = std::chrono::nanoseconds(state.totalWaitNs.load(std::memory_order_relaxed) / started);
+            metrics.maxWait = std::chrono::nanoseconds(state.maxWaitNs.load(std::memory_order_relaxed));
+
+            // Find the bucket holding the 99th percentile wait
+            const uint64_t target = started - started / 100;
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < kWaitBuckets; ++bucket) {
+                seen += state.waitHistogram[bucket].load(std::memory_order_relaxed);
+                if (seen >= target) {
+                    metrics.p99Wait = std::chrono::nanoseconds(bucket == 0 ? 1 : (uint64_t(1) << bucket));
+                    break;
+                }
+            }
+            metrics.p99Wait = std::min(metrics.p99Wait, metrics.maxWait);
+        }
+        if (metrics.completed > 0) {
+            metrics.averageRun = std::chrono::nanoseconds(state.totalRunNs.load(std::memory_order_relaxed) /
+                                                          metrics.completed);
+        }
+        return metrics;
+    }
+
+    /**
+     * @brief Get the display name of a lane
+     */
+    static const char* laneName(Lane lane) {
+        switch (lane) {
+            case Lane::Interactive: return "interactive";
+            case Lane::Background: return "background";
+            case Lane::IO: return "io";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief Stop accepting tasks
+     *
+     * Queued tasks still run; scheduled tasks that are not due are dropped.
+     * The destructor waits for the lanes to drain.
+     */
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(timerMutex_);
+            if (stop_) {
+                return;
+            }
+            stop_ = true;
+            timers_.clear();
+        }
+        timerCondition_.notify_all();
+
+        for (auto& lane : lanes_) {
+            lane.pool->shutdown();
+        }
+        LOG_DEBUG("Executor shut down");
+    }
+
+private:
+    // Threads for the IO lane when not configured; they mostly block
+    static constexpr size_t kDefaultIoThreads = 4;
+
+    // Wait times are bucketed by powers of two of nanoseconds
+    static constexpr size_t kWaitBuckets = 48;
+
+    struct LaneState {
+        std::unique_ptr<ThreadPool> pool;
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> started{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> totalWaitNs{0};
+        std::atomic<uint64_t> maxWaitNs{0};
+        std::atomic<uint64_t> totalRunNs{0};
+        std::array<std::atomic<uint64_t>, kWaitBuckets> waitHistogram{};
+
+        void recordWait(Clock::duration wait) {
+            const uint64_t ns = static_cast<uint64_t>(
+                std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count()));
+            size_t bucket = 0;
+            while (bucket + 1 < kWaitBuckets && (uint64_t(1) << bucket) < ns) {
+                ++bucket;
+            }
+            waitHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+            totalWaitNs.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t max = maxWaitNs.load(std::memory_order_relaxed);
+            while (ns > max && !maxWaitNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+            }
+            started.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void recordRun(Clock::duration run) {
+            totalRunNs.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(run).count()), std::memory_order_relaxed);
+            completed.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    struct TimerEntry {
+        Lane lane;
+        ThreadPool::Task task;
+    };
+
+    static size_t laneIndex(Lane lane) {
+        return static_cast<size_t>(lane);
+    }
+
+    static size_t hardwareThreads() {
+        const size_t cpus = std::thread::hardware_concurrency();
+        return cpus == 0 ? 2 : cpus;
+    }
+
+    /**
+     * @brief Timer thread function
+     *
+     * Submits each scheduled task to its lane once it is due.
+     */
+    void timerLoop() {
+        std::unique_lock<std::mutex> lock(timerMutex_);
+        while (!stop_) {
+            if (timers_.empty()) {
+                timerCondition_.wait(lock);
+                continue;
+            }
+
+            auto next = timers_.begin();
+            if (next->first > Clock::now()) {
+                timerCondition_.wait_until(lock, next->first);
+                continue;
+            }
+
+            TimerEntry entry = std::move(next->second);
+            timers_.erase(next);
+            lock.unlock();
+            try {
+                submit(entry.lane, std::move(entry.task));
+            } catch (const std::exception& e) {
+                LOG_ERROR("Failed to run scheduled task: " + std::string(e.what()));
+            }
+            lock.lock();
+        }
+    }
+
+    std::array<LaneState, kLaneCount> lanes_;
+
+    // Delayed tasks, ordered by due time
+    std::mutex timerMutex_;
+    std::condition_variable timerCondition_;
+    std::multimap<Clock::time_point, TimerEntry> timers_;
+    std::thread timerThread_;
+    bool stop_;
+};
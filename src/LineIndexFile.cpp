@@ -0,0 +1,272 @@
+#include "LineIndexFile.h"
+#include "MappedFile.h"
+#include "LoggingCompatibility.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Magic number identifying an index file ("VTBI")
+constexpr uint32_t kMagic = 0x49425456;
+
+// Fixed-size part of the layout before the page entries
+constexpr size_t kHeaderSize = 4 + 2 + 2 + 8 * 6;
+
+// Bytes hashed at the start and end of the file, and per interior sample
+constexpr uint64_t kEdgeSampleSize = 64 * 1024;
+constexpr uint64_t kInteriorSampleSize = 4 * 1024;
+constexpr uint64_t kInteriorSamples = 16;
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(const char* data, size_t length, uint64_t hash = kFnvOffset)
+{
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * kFnvPrime;
+    }
+    return hash;
+}
+
+void putFixed(std::string& out, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t getFixed(const std::string& in, size_t& pos, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    }
+    pos += bytes;
+    return value;
+}
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const std::string& in, size_t& pos, size_t end, uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < end; shift += 7) {
+        const unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+// Compute the stamp of an open file
+LineIndexFile::SourceStamp LineIndexFile::stamp(const std::string& filename, const MappedFile& file)
+{
+    SourceStamp result;
+    result.fileSize = file.size();
+
+    std::error_code ec;
+    auto writeTime = fs::last_write_time(filename, ec);
+    if (!ec) {
+        result.modificationTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    }
+
+    // Hash the edges of the file and evenly spaced interior samples
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    const uint64_t size = result.fileSize;
+    ranges.emplace_back(0, std::min(size, kEdgeSampleSize));
+    if (size > 2 * kEdgeSampleSize) {
+        const uint64_t interior = size - 2 * kEdgeSampleSize;
+        for (uint64_t i = 1; i <= kInteriorSamples; ++i) {
+            uint64_t offset = kEdgeSampleSize + interior * i / (kInteriorSamples + 1);
+            ranges.emplace_back(offset, std::min(kInteriorSampleSize, size - offset));
+        }
+    }
+    if (size > kEdgeSampleSize) {
+        uint64_t offset = std::max(size - kEdgeSampleSize, kEdgeSampleSize);
+        ranges.emplace_back(offset, size - offset);
+    }
+
+    uint64_t hash = fnv1a(reinterpret_cast<const char*>(&size), sizeof(size));
+    std::vector<char> buffer;
+    for (const auto& range : ranges) {
+        if (file.isMapped()) {
+            hash = fnv1a(file.data() + range.first, static_cast<size_t>(range.second), hash);
+            continue;
+        }
+        buffer.resize(static_cast<size_t>(range.second));
+        if (file.read(range.first, buffer.size(), buffer.data())) {
+            hash = fnv1a(buffer.data(), buffer.size(), hash);
+        }
+    }
+    result.fingerprint = hash;
+
+    return result;
+}
+
+// Encode index contents
+std::string LineIndexFile::encode(const Contents& contents)
+{
+    std::string out;
+    out.reserve(kHeaderSize + contents.pages.size() * 4 + 8);
+
+    putFixed(out, kMagic, 4);
+    putFixed(out, kVersion, 2);
+    putFixed(out, 0, 2);
+    putFixed(out, contents.stamp.fileSize, 8);
+    putFixed(out, static_cast<uint64_t>(contents.stamp.modificationTime), 8);
+    putFixed(out, contents.stamp.fingerprint, 8);
+    putFixed(out, contents.checkpointInterval, 8);
+    putFixed(out, contents.lineCount, 8);
+    putFixed(out, contents.pages.size(), 8);
+
+    const int64_t interval = static_cast<int64_t>(contents.checkpointInterval);
+    for (const auto& page : contents.pages) {
+        putVarint(out, page.length);
+        putVarint(out, zigzag(static_cast<int64_t>(page.lineCount) - interval));
+    }
+
+    putFixed(out, fnv1a(out.data(), out.size()), 8);
+    return out;
+}
+
+// Decode index contents
+std::optional<LineIndexFile::Contents> LineIndexFile::decode(const std::string& bytes)
+{
+    if (bytes.size() < kHeaderSize + 8) {
+        return std::nullopt;
+    }
+
+    const size_t payloadEnd = bytes.size() - 8;
+    size_t checksumPos = payloadEnd;
+    if (getFixed(bytes, checksumPos, 8) != fnv1a(bytes.data(), payloadEnd)) {
+        return std::nullopt;
+    }
+
+    size_t pos = 0;
+    if (getFixed(bytes, pos, 4) != kMagic || getFixed(bytes, pos, 2) != kVersion) {
+        return std::nullopt;
+    }
+    pos += 2; // Reserved
+
+    Contents contents;
+    contents.stamp.fileSize = getFixed(bytes, pos, 8);
+    contents.stamp.modificationTime = static_cast<int64_t>(getFixed(bytes, pos, 8));
+    contents.stamp.fingerprint = getFixed(bytes, pos, 8);
+    contents.checkpointInterval = getFixed(bytes, pos, 8);
+    contents.lineCount = getFixed(bytes, pos, 8);
+    const uint64_t pageCount = getFixed(bytes, pos, 8);
+
+    // Every page takes at least two bytes, which bounds a corrupt count
+    if (pageCount > (payloadEnd - pos) / 2) {
+        return std::nullopt;
+    }
+
+    contents.pages.resize(static_cast<size_t>(pageCount));
+    uint64_t totalLength = 0;
+    uint64_t totalLines = 0;
+    const int64_t interval = static_cast<int64_t>(contents.checkpointInterval);
+    for (auto& page : contents.pages) {
+        uint64_t encodedLines = 0;
+        if (!getVarint(bytes, pos, payloadEnd, page.length) || !getVarint(bytes, pos, payloadEnd, encodedLines)) {
+            return std::nullopt;
+        }
+        const int64_t lineCount = interval + unzigzag(encodedLines);
+        if (lineCount <= 0) {
+            return std::nullopt;
+        }
+        page.lineCount = static_cast<uint64_t>(lineCount);
+        totalLength += page.length;
+        totalLines += page.lineCount;
+    }
+
+    // The pages must tile the file exactly
+    if (pos != payloadEnd || totalLength != contents.stamp.fileSize || totalLines != contents.lineCount) {
+        return std::nullopt;
+    }
+
+    return contents;
+}
+
+// Write an index file atomically
+bool LineIndexFile::write(const std::string& indexFilename, const Contents& contents)
+{
+    const std::string bytes = encode(contents);
+    const std::string tempFilename =
+        indexFilename + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    {
+        std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_ERROR("Failed to create index file: " + tempFilename);
+            return false;
+        }
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        out.close();
+        if (out.fail()) {
+            LOG_ERROR("Failed to write index file: " + tempFilename);
+            std::error_code ec;
+            fs::remove(tempFilename, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempFilename, indexFilename, ec);
+    if (ec) {
+        LOG_ERROR("Failed to replace index file " + indexFilename + ": " + ec.message());
+        fs::remove(tempFilename, ec);
+        return false;
+    }
+
+    return true;
+}
+
+// Read an index file and validate it against a source stamp
+std::optional<LineIndexFile::Contents> LineIndexFile::read(const std::string& indexFilename, const SourceStamp& expected)
+{
+    std::ifstream in(indexFilename, std::ios::binary);
+    if (!in.is_open()) {
+        LOG_DEBUG("Index file does not exist: " + indexFilename);
+        return std::nullopt;
+    }
+
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto contents = decode(bytes);
+    if (!contents) {
+        LOG_DEBUG("Index file is corrupt or has an old layout: " + indexFilename);
+        return std::nullopt;
+    }
+
+    if (contents->stamp != expected) {
+        LOG_DEBUG("Index file is stale: " + indexFilename);
+        return std::nullopt;
+    }
+
+    return contents;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * @brief Persistent line index for a text file
+ *
+ * The index stores sparse checkpoints rather than one entry per line: the
+ * file is described as a sequence of ranges ("pages"), each with its byte
+ * length and line count. Lengths are the deltas between consecutive
+ * checkpoint offsets and line counts are stored relative to the checkpoint
+ * interval, both as varints, so a page usually costs 3-4 bytes.
+ *
+ * Every index carries a stamp of the file it describes (size, modification
+ * time and a fingerprint of sampled content) plus a checksum of its own
+ * bytes; read() rejects an index whose stamp or checksum does not match.
+ *
+ * Layout (version 2, little-endian):
+ *   u32 magic "VTBI", u16 version, u16 reserved
+ *   u64 file size, i64 mtime, u64 fingerprint
+ *   u64 checkpoint interval, u64 line count, u64 page count
+ *   per page: varint length, zigzag varint (line count - interval)
+ *   u64 FNV-1a checksum of everything before it
+ */
+class LineIndexFile {
+public:
+    /**
+     * @brief Identity of the file an index describes
+     */
+    struct SourceStamp {
+        uint64_t fileSize = 0;
+        int64_t modificationTime = 0;
+        uint64_t fingerprint = 0;
+
+        bool operator==(const SourceStamp& other) const {
+            return fileSize == other.fileSize && modificationTime == other.modificationTime &&
+                   fingerprint == other.fingerprint;
+        }
+        bool operator!=(const SourceStamp& other) const { return !(*this == other); }
+    };
+
+    /**
+     * @brief One checkpointed range of the file
+     */
+    struct Page {
+        uint64_t length = 0;     ///< Bytes in the range, line terminators included
+        uint64_t lineCount = 0;  ///< Lines in the range
+    };
+
+    /**
+     * @brief Decoded index contents
+     */
+    struct Contents {
+        SourceStamp stamp;
+        uint64_t checkpointInterval = 0;
+        uint64_t lineCount = 0;
+        std::vector<Page> pages;
+    };
+
+    static constexpr uint16_t kVersion = 2;
+
+    /**
+     * @brief Compute the stamp of an open file
+     *
+     * @param filename Path of the file (for its modification time)
+     * @param file The opened file (for size and fingerprint)
+     */
+    static SourceStamp stamp(const std::string& filename, const MappedFile& file);
+
+    /**
+     * @brief Encode index contents
+     */
+    static std::string encode(const Contents& contents);
+
+    /**
+     * @brief Decode index contents
+     *
+     * @return The contents, or nothing if the bytes are not a valid,
+     *         self-consistent version 2 index
+     */
+    static std::optional<Contents> decode(const std::string& bytes);
+
+    /**
+     * @brief Write an index file atomically (temporary file + rename)
+     */
+    static bool write(const std::string& indexFilename, const Contents& contents);
+
+    /**
+     * @brief Read an index file and validate it against a source stamp
+     *
+     * @return The contents, or nothing if the file is missing, corrupt or stale
+     */
+    static std::optional<Contents> read(const std::string& indexFilename, const SourceStamp& expected);
+};
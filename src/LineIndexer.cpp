@@ -0,0 +1,483 @@
+#include "LineIndexer.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LINE_INDEXER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(LINE_INDEXER_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LINE_INDEXER_SSE2 1
+#endif
+
+#if defined(LINE_INDEXER_X86) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define LINE_INDEXER_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define LINE_INDEXER_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define LINE_INDEXER_AVX2_TARGET
+#endif
+#endif
+
+namespace {
+
+// splitLines() hands out runs of this many lines to its worker threads
+constexpr size_t kSplitRunLines = 16384;
+
+inline unsigned popcount32(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcount(value));
+#else
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#endif
+}
+
+inline unsigned countTrailingZeros32(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    unsigned index = 0;
+    while (!(value & 1u)) {
+        value >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Emit the selected line breaks among those flagged in a block mask.
+// seen is the number of line breaks before the block, target the local
+// index of the next one to record.
+inline void selectFromMask(uint32_t mask, uint64_t blockOffset, size_t& seen, size_t& target, size_t step,
+                           std::vector<uint64_t>& out)
+{
+    const unsigned count = popcount32(mask);
+    while (seen + count > target) {
+        uint32_t remaining = mask;
+        for (size_t skip = target - seen; skip > 0; --skip) {
+            remaining &= remaining - 1;
+        }
+        out.push_back(blockOffset + countTrailingZeros32(remaining) + 1);
+        target += step;
+    }
+    seen += count;
+}
+
+// Scalar kernels, also used for the tails of the SIMD kernels
+
+size_t countScalar(const char* data, size_t length)
+{
+    return static_cast<size_t>(std::count(data, data + length, '\n'));
+}
+
+void findScalar(const char* data, size_t length, size_t& seen, size_t& target, size_t step, uint64_t base,
+                std::vector<uint64_t>& out)
+{
+    const char* cursor = data;
+    const char* end = data + length;
+    while (cursor < end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (!newline) {
+            break;
+        }
+        if (seen == target) {
+            out.push_back(base + static_cast<uint64_t>(newline - data) + 1);
+            target += step;
+        }
+        ++seen;
+        cursor = newline + 1;
+    }
+}
+
+#ifdef LINE_INDEXER_SSE2
+
+size_t countSse2(const char* data, size_t length)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    size_t total = 0;
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+        // Byte counters overflow after 255 blocks; fold them before that
+        const size_t blocks = std::min<size_t>((length - i) / 16, 255);
+        __m128i counters = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(bytes, newline));
+        }
+        __m128i sums = _mm_sad_epu8(counters, zero);
+        total += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+
+    return total + countScalar(data + i, length - i);
+}
+
+void findSse2(const char* data, size_t length, size_t& seen, size_t& target, size_t step, uint64_t base,
+              std::vector<uint64_t>& out)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+        if (mask) {
+            selectFromMask(mask, base + i, seen, target, step, out);
+        }
+    }
+
+    findScalar(data + i, length - i, seen, target, step, base + i, out);
+}
+
+#endif
+
+#ifdef LINE_INDEXER_AVX2
+
+LINE_INDEXER_AVX2_TARGET size_t countAvx2(const char* data, size_t length)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t total = 0;
+    size_t i = 0;
+
+    while (i + 32 <= length) {
+        // Byte counters overflow after 255 blocks; fold them before that
+        const size_t blocks = std::min<size_t>((length - i) / 32, 255);
+        __m256i counters = zero;
+        for (size_t b = 0; b < blocks; ++b, i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(bytes, newline));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_sad_epu8(counters, zero));
+        total += static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+
+    return total + countScalar(data + i, length - i);
+}
+
+LINE_INDEXER_AVX2_TARGET void findAvx2(const char* data, size_t length, size_t& seen, size_t& target, size_t step,
+                                       uint64_t base, std::vector<uint64_t>& out)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+        if (mask) {
+            selectFromMask(mask, base + i, seen, target, step, out);
+        }
+    }
+
+    findScalar(data + i, length - i, seen, target, step, base + i, out);
+}
+
+#endif
+
+LineIndexer::SimdLevel detectSimdLevel()
+{
+#ifdef LINE_INDEXER_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LineIndexer::SimdLevel::AVX2;
+    }
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 0x6) == 0x6);
+        __cpuidex(info, 7, 0);
+        if (osSavesYmm && (info[1] & (1 << 5))) {
+            return LineIndexer::SimdLevel::AVX2;
+        }
+    }
+#endif
+#endif
+#ifdef LINE_INDEXER_SSE2
+    return LineIndexer::SimdLevel::SSE2;
+#else
+    return LineIndexer::SimdLevel::SCALAR;
+#endif
+}
+
+const LineIndexer::SimdLevel kDetectedLevel = detectSimdLevel();
+std::atomic<LineIndexer::SimdLevel> activeLevel{kDetectedLevel};
+
+// Run task(index) for every index in [0, count) on up to threadCount threads
+template<typename Task>
+void runParallel(size_t count, size_t threadCount, Task task)
+{
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::atomic<bool> failed{false};
+
+    auto worker = [&]() {
+        try {
+            for (size_t index = next++; index < count && !failed; index = next++) {
+                task(index);
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                failure = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t extraThreads = std::min(threadCount, count) > 0 ? std::min(threadCount, count) - 1 : 0;
+    threads.reserve(extraThreads);
+    for (size_t i = 0; i < extraThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace
+
+// Count the line breaks in a memory range
+size_t LineIndexer::countLineBreaks(const char* data, size_t length)
+{
+    switch (activeLevel.load(std::memory_order_relaxed)) {
+#ifdef LINE_INDEXER_AVX2
+        case SimdLevel::AVX2:
+            return countAvx2(data, length);
+#endif
+#ifdef LINE_INDEXER_SSE2
+        case SimdLevel::SSE2:
+            return countSse2(data, length);
+#endif
+        default:
+            return countScalar(data, length);
+    }
+}
+
+// Find selected line breaks in a memory range
+void LineIndexer::findLineBreaks(const char* data, size_t length, size_t first, size_t step,
+                                 uint64_t base, std::vector<uint64_t>& out)
+{
+    size_t seen = 0;
+    size_t target = first;
+    step = std::max<size_t>(step, 1);
+
+    switch (activeLevel.load(std::memory_order_relaxed)) {
+#ifdef LINE_INDEXER_AVX2
+        case SimdLevel::AVX2:
+            findAvx2(data, length, seen, target, step, base, out);
+            break;
+#endif
+#ifdef LINE_INDEXER_SSE2
+        case SimdLevel::SSE2:
+            findSse2(data, length, seen, target, step, base, out);
+            break;
+#endif
+        default:
+            findScalar(data, length, seen, target, step, base, out);
+            break;
+    }
+}
+
+// Scan a file with default options
+LineIndexer::Result LineIndexer::scan(const MappedFile& file, size_t interval)
+{
+    return scan(file, interval, Options());
+}
+
+// Scan a file for line breaks
+LineIndexer::Result LineIndexer::scan(const MappedFile& file, size_t interval, const Options& options)
+{
+    Result result;
+    const uint64_t fileSize = file.size();
+    if (fileSize == 0) {
+        return result;
+    }
+
+    interval = std::max<size_t>(interval, 1);
+    const size_t chunkSize = std::max<size_t>(options.chunkSize, 4096);
+    const size_t chunkCount = static_cast<size_t>((fileSize + chunkSize - 1) / chunkSize);
+
+    size_t threadCount = options.threadCount;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Run fn(data, length) over a chunk, reading it first if the file is not mapped
+    auto withChunk = [&](size_t chunk, auto&& fn) {
+        const uint64_t offset = static_cast<uint64_t>(chunk) * chunkSize;
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(chunkSize, fileSize - offset));
+        if (file.isMapped()) {
+            fn(file.data() + offset, length, offset);
+            return;
+        }
+
+        thread_local std::vector<char> buffer;
+        buffer.resize(length);
+        if (!file.read(offset, length, buffer.data())) {
+            throw std::runtime_error("Short read while indexing at offset " + std::to_string(offset));
+        }
+        fn(buffer.data(), length, offset);
+    };
+
+    // Pass 1: count the line breaks in every chunk
+    std::vector<uint64_t> counts(chunkCount, 0);
+    runParallel(chunkCount, threadCount, [&](size_t chunk) {
+        withChunk(chunk, [&](const char* data, size_t length, uint64_t) {
+            counts[chunk] = countLineBreaks(data, length);
+        });
+    });
+
+    // Turn the counts into the global index of each chunk's first line break
+    std::vector<uint64_t> firstBreak(chunkCount, 0);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        firstBreak[chunk] = result.lineBreaks;
+        result.lineBreaks += counts[chunk];
+    }
+
+    // Pass 2: record every interval-th line break; chunks without one are skipped
+    std::vector<std::vector<uint64_t>> found(chunkCount);
+    runParallel(chunkCount, threadCount, [&](size_t chunk) {
+        const uint64_t start = firstBreak[chunk];
+        const uint64_t firstSelected = (start / interval + 1) * interval - 1;
+        if (firstSelected >= start + counts[chunk]) {
+            return;
+        }
+        withChunk(chunk, [&](const char* data, size_t length, uint64_t offset) {
+            findLineBreaks(data, length, static_cast<size_t>(firstSelected - start), interval, offset, found[chunk]);
+        });
+    });
+
+    result.boundaries.reserve(static_cast<size_t>(result.lineBreaks / interval));
+    for (const auto& boundaries : found) {
+        result.boundaries.insert(result.boundaries.end(), boundaries.begin(), boundaries.end());
+    }
+
+    char last = 0;
+    if (file.isMapped()) {
+        last = file.data()[fileSize - 1];
+    } else if (!file.read(fileSize - 1, 1, &last)) {
+        throw std::runtime_error("Short read while indexing at offset " + std::to_string(fileSize - 1));
+    }
+    result.endsWithLineBreak = last == '\n';
+
+    return result;
+}
+
+std::vector<std::string> LineIndexer::splitLines(const MappedFile& file)
+{
+    return splitLines(file, Options());
+}
+
+// Split a file into lines
+std::vector<std::string> LineIndexer::splitLines(const MappedFile& file, const Options& options)
+{
+    std::vector<std::string> lines;
+    const uint64_t fileSize = file.size();
+    if (fileSize == 0) {
+        return lines;
+    }
+
+    // Every boundary starts a run of exactly kSplitRunLines lines, so each
+    // run knows the index of its first line without looking at the others
+    const Result index = scan(file, kSplitRunLines, options);
+    lines.resize(static_cast<size_t>(index.lineBreaks) + (index.endsWithLineBreak ? 0 : 1));
+
+    std::vector<uint64_t> runStarts;
+    runStarts.reserve(index.boundaries.size() + 1);
+    runStarts.push_back(0);
+    for (uint64_t boundary : index.boundaries) {
+        if (boundary < fileSize) {
+            runStarts.push_back(boundary);
+        }
+    }
+
+    size_t threadCount = options.threadCount;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    runParallel(runStarts.size(), threadCount, [&](size_t run) {
+        const uint64_t offset = runStarts[run];
+        const uint64_t end = run + 1 < runStarts.size() ? runStarts[run + 1] : fileSize;
+        const size_t length = static_cast<size_t>(end - offset);
+
+        const char* data = nullptr;
+        thread_local std::vector<char> buffer;
+        if (file.isMapped()) {
+            data = file.data() + offset;
+        } else {
+            buffer.resize(length);
+            if (!file.read(offset, length, buffer.data())) {
+                throw std::runtime_error("Short read while splitting lines at offset " + std::to_string(offset));
+            }
+            data = buffer.data();
+        }
+
+        size_t lineIndex = run * kSplitRunLines;
+        const char* pos = data;
+        const char* const stop = data + length;
+        while (pos < stop) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', static_cast<size_t>(stop - pos)));
+            if (!lineEnd) {
+                lines[lineIndex].assign(pos, static_cast<size_t>(stop - pos));
+                break;
+            }
+            lines[lineIndex++].assign(pos, static_cast<size_t>(lineEnd - pos));
+            pos = lineEnd + 1;
+        }
+    });
+
+    return lines;
+}
+
+// Get the SIMD level the kernels dispatch to on this CPU
+LineIndexer::SimdLevel LineIndexer::simdLevel()
+{
+    return activeLevel.load(std::memory_order_relaxed);
+}
+
+// Get a printable name for a SIMD level
+const char* LineIndexer::simdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+// Force the kernels to a lower SIMD level
+void LineIndexer::setSimdLevel(SimdLevel level)
+{
+    activeLevel.store(std::min(level, kDetectedLevel), std::memory_order_relaxed);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/**
+ * @brief Fast newline indexer for large files
+ *
+ * Splits a file into chunks that are scanned on worker threads. Each chunk
+ * is scanned twice with the widest SIMD kernel the CPU supports (AVX2 or
+ * SSE2, picked at runtime, with a scalar fallback): once to count its line
+ * breaks, and once, after the per-chunk counts have been turned into
+ * global line numbers, to pick out the breaks that end every
+ * interval-th line. Results are identical for any chunk size or thread
+ * count.
+ */
+class LineIndexer {
+public:
+    /**
+     * @brief SIMD instruction set used by the scanning kernels
+     */
+    enum class SimdLevel {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     * @brief Tuning knobs for scan()
+     */
+    struct Options {
+        size_t chunkSize = 16 * 1024 * 1024;  ///< Bytes scanned per task
+        size_t threadCount = 0;               ///< Worker threads (0 = hardware concurrency)
+    };
+
+    /**
+     * @brief Result of scanning a file
+     */
+    struct Result {
+        uint64_t lineBreaks = 0;              ///< Number of '\n' bytes in the file
+        std::vector<uint64_t> boundaries;     ///< Offset just past every interval-th '\n'
+        bool endsWithLineBreak = false;       ///< Whether the last byte of the file is '\n'
+    };
+
+    /**
+     * @brief Scan a file for line breaks
+     *
+     * @param file The file to scan; mapped files are scanned in place
+     * @param interval Record a boundary after every interval-th line break
+     * @param options Chunking and threading options
+     * @return The line break count and boundaries
+     * @throws std::runtime_error if the file cannot be read
+     */
+    static Result scan(const MappedFile& file, size_t interval, const Options& options);
+    static Result scan(const MappedFile& file, size_t interval);
+
+    /**
+     * @brief Split a file into lines
+     *
+     * Lines end at '\n', which is not included; a final line without one is
+     * kept. The file is indexed with scan() and cut into runs of lines that
+     * are copied out on worker threads, so every line lands directly in its
+     * final slot and the vector is sized once.
+     *
+     * @param file The file to split; mapped files are read in place
+     * @param options Chunking and threading options
+     * @return One string per line
+     * @throws std::runtime_error if the file cannot be read
+     */
+    static std::vector<std::string> splitLines(const MappedFile& file, const Options& options);
+    static std::vector<std::string> splitLines(const MappedFile& file);
+
+    /**
+     * @brief Count the line breaks in a memory range
+     */
+    static size_t countLineBreaks(const char* data, size_t length);
+
+    /**
+     * @brief Find selected line breaks in a memory range
+     *
+     * Appends base + offset + 1 for the line breaks with local index
+     * first, first + step, first + 2 * step, ... (0-based) in the range.
+     */
+    static void findLineBreaks(const char* data, size_t length, size_t first, size_t step,
+                               uint64_t base, std::vector<uint64_t>& out);
+
+    /**
+     * @brief Get the SIMD level the kernels dispatch to on this CPU
+     */
+    static SimdLevel simdLevel();
+
+    /**
+     * @brief Get a printable name for a SIMD level
+     */
+    static const char* simdLevelName(SimdLevel level);
+
+    /**
+     * @brief Force the kernels to a lower SIMD level (for tests and benchmarks)
+     *
+     * Requests above what the CPU supports are clamped.
+     */
+    static void setSimdLevel(SimdLevel level);
+};
@@ -0,0 +1,243 @@
+#include "MappedFile.h"
+#include "LoggingCompatibility.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename, bool allowMapping)
+{
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to open file: " + filename);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        LOG_ERROR("Failed to get the size of file: " + filename);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    size_ = static_cast<uint64_t>(fileSize.QuadPart);
+    isOpen_ = true;
+
+    if (allowMapping && !mapContents()) {
+        LOG_DEBUG("Could not map " + filename + ", falling back to positional reads");
+    }
+    return true;
+}
+
+bool MappedFile::mapContents()
+{
+    // Empty files cannot be mapped; there is nothing to read anyway
+    if (size_ == 0) {
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(static_cast<HANDLE>(fileHandle_), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(view);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mappingHandle_) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+        mappingHandle_ = nullptr;
+    }
+    if (fileHandle_) {
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+        fileHandle_ = nullptr;
+    }
+    isOpen_ = false;
+    size_ = 0;
+}
+
+bool MappedFile::read(uint64_t offset, size_t length, char* out) const
+{
+    if (!isOpen_ || offset > size_ || length > size_ - offset) {
+        return false;
+    }
+    if (data_) {
+        std::memcpy(out, data_ + offset, length);
+        return true;
+    }
+
+    // Overlapped reads carry their own offset, so concurrent reads do not race
+    while (length > 0) {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 1u << 30));
+        DWORD bytesRead = 0;
+        if (!ReadFile(static_cast<HANDLE>(fileHandle_), out, chunk, &bytesRead, &overlapped) || bytesRead == 0) {
+            return false;
+        }
+
+        offset += bytesRead;
+        out += bytesRead;
+        length -= bytesRead;
+    }
+    return true;
+}
+
+void MappedFile::willNeed(uint64_t, uint64_t) const
+{
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename, bool allowMapping)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open file: " + filename + " (" + std::strerror(errno) + ")");
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        LOG_ERROR("Failed to stat file: " + filename + " (" + std::strerror(errno) + ")");
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    size_ = static_cast<uint64_t>(info.st_size);
+    isOpen_ = true;
+
+    if (allowMapping && !mapContents()) {
+        LOG_DEBUG("Could not map " + filename + ", falling back to positional reads");
+    }
+    return true;
+}
+
+bool MappedFile::mapContents()
+{
+    // Empty files cannot be mapped; there is nothing to read anyway
+    if (size_ == 0 || size_ > static_cast<uint64_t>(SIZE_MAX)) {
+        return false;
+    }
+
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = static_cast<const char*>(mapping);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), static_cast<size_t>(size_));
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    isOpen_ = false;
+    size_ = 0;
+}
+
+bool MappedFile::read(uint64_t offset, size_t length, char* out) const
+{
+    if (!isOpen_ || offset > size_ || length > size_ - offset) {
+        return false;
+    }
+    if (data_) {
+        std::memcpy(out, data_ + offset, length);
+        return true;
+    }
+
+    // pread carries its own offset, so concurrent reads do not race
+    while (length > 0) {
+        ssize_t bytesRead = ::pread(fd_, out, length, static_cast<off_t>(offset));
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            return false;
+        }
+
+        offset += static_cast<uint64_t>(bytesRead);
+        out += bytesRead;
+        length -= static_cast<size_t>(bytesRead);
+    }
+    return true;
+}
+
+void MappedFile::willNeed(uint64_t offset, uint64_t length) const
+{
+    if (!isOpen_ || offset >= size_) {
+        return;
+    }
+    length = std::min(length, size_ - offset);
+
+    if (data_) {
+        // madvise needs a page-aligned start address
+        const uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        const uint64_t alignedOffset = offset - offset % pageSize;
+        ::madvise(const_cast<char*>(data_) + alignedOffset, static_cast<size_t>(length + (offset - alignedOffset)),
+                  MADV_WILLNEED);
+    } else {
+#ifdef POSIX_FADV_WILLNEED
+        ::posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+    }
+}
+
+#endif
+
+std::string_view MappedFile::view(uint64_t offset, uint64_t length) const
+{
+    if (!data_ || offset >= size_) {
+        return std::string_view();
+    }
+    length = std::min(length, size_ - offset);
+    return std::string_view(data_ + offset, static_cast<size_t>(length));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Read-only random access to a file
+ *
+ * The file is memory-mapped when the platform allows it; otherwise reads
+ * fall back to positional reads (pread / overlapped ReadFile). Both paths
+ * are thread-safe: there is no shared file position, so any number of
+ * threads may read different ranges concurrently.
+ *
+ * A MappedFile is a snapshot of the file it was opened on. Views returned
+ * by view() stay valid for the lifetime of the object, even if the file is
+ * replaced on disk (on POSIX systems) in the meantime.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Open a file for reading
+     *
+     * @param filename The file to open
+     * @param allowMapping Set to false to force the positional-read path
+     * @return true if the file could be opened
+     */
+    bool open(const std::string& filename, bool allowMapping = true);
+
+    /**
+     * @brief Release the mapping and close the file
+     */
+    void close();
+
+    /**
+     * @brief Check whether a file is open
+     */
+    bool isOpen() const { return isOpen_; }
+
+    /**
+     * @brief Check whether the file contents are memory-mapped
+     */
+    bool isMapped() const { return data_ != nullptr; }
+
+    /**
+     * @brief Get the size of the file in bytes
+     */
+    uint64_t size() const { return size_; }
+
+    /**
+     * @brief Get the mapped contents, or nullptr if the file is not mapped
+     */
+    const char* data() const { return data_; }
+
+    /**
+     * @brief Get a view of a mapped byte range
+     *
+     * Only valid for mapped files; the range is clamped to the file size.
+     *
+     * @param offset Byte offset of the range
+     * @param length Length of the range in bytes
+     * @return A view into the mapping
+     */
+    std::string_view view(uint64_t offset, uint64_t length) const;
+
+    /**
+     * @brief Copy a byte range into a caller-provided buffer
+     *
+     * @param offset Byte offset of the range
+     * @param length Number of bytes to read
+     * @param out Destination with room for length bytes
+     * @return true if the whole range was read
+     */
+    bool read(uint64_t offset, size_t length, char* out) const;
+
+    /**
+     * @brief Hint that a byte range will be read soon
+     *
+     * Asks the kernel to start reading the range in the background. A no-op
+     * where the platform has no equivalent.
+     */
+    void willNeed(uint64_t offset, uint64_t length) const;
+
+private:
+    bool mapContents();
+
+    bool isOpen_ = false;
+    uint64_t size_ = 0;
+    const char* data_ = nullptr;
+
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
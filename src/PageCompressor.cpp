@@ -0,0 +1,200 @@
+#include "PageCompressor.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Matches are at least this long; shorter repeats are stored as literals
+constexpr size_t kMinMatch = 4;
+
+// The last match must start this far from the end and the final bytes are
+// always literals, as the LZ4 block format requires
+constexpr size_t kMatchStartLimit = 12;
+constexpr size_t kLastLiterals = 5;
+
+constexpr size_t kMaxOffset = 65535;
+constexpr unsigned kHashBits = 12;
+
+uint32_t read32(const char* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash4(const char* p)
+{
+    return (read32(p) * 2654435761U) >> (32 - kHashBits);
+}
+
+// Append a length that did not fit in its 4-bit token field
+void putLength(std::string& out, size_t length)
+{
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+void putSequence(std::string& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    const size_t matchCode = matchLength - kMinMatch;
+    const unsigned char token = static_cast<unsigned char>((std::min<size_t>(literalLength, 15) << 4) |
+                                                           std::min<size_t>(matchCode, 15));
+    out.push_back(static_cast<char>(token));
+    if (literalLength >= 15) {
+        putLength(out, literalLength - 15);
+    }
+    out.append(literals, literalLength);
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        putLength(out, matchCode - 15);
+    }
+}
+
+void putLastLiterals(std::string& out, const char* literals, size_t literalLength)
+{
+    out.push_back(static_cast<char>(std::min<size_t>(literalLength, 15) << 4));
+    if (literalLength >= 15) {
+        putLength(out, literalLength - 15);
+    }
+    out.append(literals, literalLength);
+}
+
+// Read an extended length; false if the block ends first
+bool getLength(const unsigned char*& in, const unsigned char* end, size_t& length)
+{
+    unsigned char byte;
+    do {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+// Compress a byte range
+std::string PageCompressor::compress(std::string_view input)
+{
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+
+    const char* const base = input.data();
+    const size_t size = input.size();
+    size_t anchor = 0;
+
+    if (size > kMatchStartLimit) {
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+        const size_t matchLimit = size - kLastLiterals;
+        size_t pos = 1;
+        table[hash4(base)] = 0;
+
+        while (pos + kMatchStartLimit <= size) {
+            const uint32_t h = hash4(base + pos);
+            const size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(pos);
+
+            if (pos - candidate > kMaxOffset || candidate >= pos || read32(base + candidate) != read32(base + pos)) {
+                ++pos;
+                continue;
+            }
+
+            // Extend the match forwards, then backwards over pending literals
+            size_t start = pos;
+            size_t from = candidate;
+            size_t length = kMinMatch;
+            while (pos + length < matchLimit && base[from + length] == base[pos + length]) {
+                ++length;
+            }
+            while (start > anchor && from > 0 && base[start - 1] == base[from - 1]) {
+                --start;
+                --from;
+                ++length;
+            }
+
+            putSequence(out, base + anchor, start - anchor, start - from, length);
+            anchor = start + length;
+            pos = anchor;
+
+            if (pos + kMatchStartLimit <= size) {
+                table[hash4(base + pos - 2)] = static_cast<uint32_t>(pos - 2);
+            }
+        }
+    }
+
+    putLastLiterals(out, base + anchor, size - anchor);
+    return out;
+}
+
+// Decompress a block produced by compress()
+std::optional<std::string> PageCompressor::decompress(std::string_view block, size_t rawSize)
+{
+    std::string out(rawSize, '\0');
+    char* const dst = rawSize > 0 ? &out[0] : nullptr;
+    size_t written = 0;
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(block.data());
+    const unsigned char* const end = in + block.size();
+
+    while (in < end) {
+        const unsigned char token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !getLength(in, end, literalLength)) {
+            return std::nullopt;
+        }
+        if (literalLength > static_cast<size_t>(end - in) || literalLength > rawSize - written) {
+            return std::nullopt;
+        }
+        if (literalLength > 0) {
+            std::memcpy(dst + written, in, literalLength);
+        }
+        in += literalLength;
+        written += literalLength;
+
+        // The last sequence has no match
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return std::nullopt;
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !getLength(in, end, matchLength)) {
+            return std::nullopt;
+        }
+        matchLength += kMinMatch;
+
+        if (offset == 0 || offset > written || matchLength > rawSize - written) {
+            return std::nullopt;
+        }
+
+        // Matches may overlap their own output, so copy byte by byte when they do
+        const char* from = dst + written - offset;
+        if (offset >= matchLength) {
+            std::memcpy(dst + written, from, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) {
+                dst[written + i] = from[i];
+            }
+        }
+        written += matchLength;
+    }
+
+    if (written != rawSize) {
+        return std::nullopt;
+    }
+    return out;
+}
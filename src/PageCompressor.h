@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Fast in-memory compression for cold pages
+ *
+ * Produces raw LZ4 blocks (no frame header or checksum): a greedy single
+ * pass over the input with a 4K-entry hash table of recent positions. The
+ * output can be decoded by any LZ4 block decoder and decompress() accepts
+ * any valid LZ4 block. Text typically shrinks to 30-50% of its size at
+ * several hundred MB/s, which makes re-reading a compressed page far
+ * cheaper than disk I/O.
+ */
+class PageCompressor {
+public:
+    /**
+     * @brief Compress a byte range
+     *
+     * @param input The bytes to compress
+     * @return The compressed block
+     */
+    static std::string compress(std::string_view input);
+
+    /**
+     * @brief Decompress a block produced by compress()
+     *
+     * @param block The compressed block
+     * @param rawSize The size of the original input
+     * @return The original bytes, or nothing if the block is malformed or
+     *         does not decode to exactly rawSize bytes
+     */
+    static std::optional<std::string> decompress(std::string_view block, size_t rawSize);
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief Ordered list of page numbers with O(1) lookup, insertion and removal
+ *
+ * The list links are stored in the hash map entries themselves, so every
+ * operation on a known page is a single hash lookup plus pointer updates.
+ * The front is the cold (least recently used) end, the back the hot end.
+ */
+class PageList {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    bool empty() const { return links_.empty(); }
+    size_t size() const { return links_.size(); }
+    bool contains(size_t pageNumber) const { return links_.find(pageNumber) != links_.end(); }
+
+    /**
+     * @brief Get the page at the cold end (npos if empty)
+     */
+    size_t front() const { return head_; }
+
+    /**
+     * @brief Get the page at the hot end (npos if empty)
+     */
+    size_t back() const { return tail_; }
+
+    /**
+     * @brief Get the page after pageNumber, towards the hot end (npos at the end)
+     */
+    size_t next(size_t pageNumber) const
+    {
+        auto it = links_.find(pageNumber);
+        return it != links_.end() ? it->second.next : npos;
+    }
+
+    /**
+     * @brief Insert a page at the hot end, moving it there if already present
+     */
+    void pushBack(size_t pageNumber)
+    {
+        erase(pageNumber);
+        links_.emplace(pageNumber, Links{tail_, npos});
+        if (tail_ != npos) {
+            links_[tail_].next = pageNumber;
+        } else {
+            head_ = pageNumber;
+        }
+        tail_ = pageNumber;
+    }
+
+    /**
+     * @brief Insert a page at the cold end, moving it there if already present
+     */
+    void pushFront(size_t pageNumber)
+    {
+        erase(pageNumber);
+        links_.emplace(pageNumber, Links{npos, head_});
+        if (head_ != npos) {
+            links_[head_].prev = pageNumber;
+        } else {
+            tail_ = pageNumber;
+        }
+        head_ = pageNumber;
+    }
+
+    /**
+     * @brief Remove a page
+     *
+     * @return True if the page was in the list
+     */
+    bool erase(size_t pageNumber)
+    {
+        auto it = links_.find(pageNumber);
+        if (it == links_.end()) {
+            return false;
+        }
+
+        const Links links = it->second;
+        links_.erase(it);
+
+        if (links.prev != npos) {
+            links_[links.prev].next = links.next;
+        } else {
+            head_ = links.next;
+        }
+        if (links.next != npos) {
+            links_[links.next].prev = links.prev;
+        } else {
+            tail_ = links.prev;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Remove and return the page at the cold end (npos if empty)
+     */
+    size_t popFront()
+    {
+        size_t pageNumber = head_;
+        if (pageNumber != npos) {
+            erase(pageNumber);
+        }
+        return pageNumber;
+    }
+
+    void clear()
+    {
+        links_.clear();
+        head_ = npos;
+        tail_ = npos;
+    }
+
+    /**
+     * @brief Renumber every page, keeping the order
+     *
+     * @param shift Maps an old page number to its new one; must be injective
+     */
+    template <typename Shift>
+    void renumber(Shift shift)
+    {
+        PageList shifted;
+        for (size_t pageNumber = head_; pageNumber != npos; pageNumber = links_[pageNumber].next) {
+            shifted.pushBack(shift(pageNumber));
+        }
+        *this = std::move(shifted);
+    }
+
+private:
+    struct Links {
+        size_t prev;
+        size_t next;
+    };
+
+    std::unordered_map<size_t, Links> links_;
+    size_t head_ = npos;
+    size_t tail_ = npos;
+};
@@ -0,0 +1,988 @@
+#include "PieceTableTextBuffer.h"
+#include "EditorError.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+
+namespace {
+    // Read-only lines kept alive for references returned by the const getLine().
+    // Reading more distinct lines than this releases the oldest copies first.
+    constexpr size_t kMaxMaterializedLines = 4096;
+
+    // Append the positions of every '\n' in data[0, length) to breaks, offset by base.
+    void collectLineBreaks(const char* data, size_t length, size_t base, std::vector<size_t>& breaks) {
+        const char* cursor = data;
+        const char* end = data + length;
+        while (cursor < end) {
+            const void* hit = std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+            if (!hit) {
+                break;
+            }
+            const char* newline = static_cast<const char*>(hit);
+            breaks.push_back(base + static_cast<size_t>(newline - data));
+            cursor = newline + 1;
+        }
+    }
+}
+
+PieceTableTextBuffer::PieceTableTextBuffer() {
+    clear(true); // Start with one empty line, like TextBuffer
+}
+
+PieceTableTextBuffer::PieceTableTextBuffer(const std::string& filename) {
+    clear(true);
+    loadFromFile(filename);
+}
+
+// ---------------------------------------------------------------------------
+// Tree maintenance
+// ---------------------------------------------------------------------------
+
+uint32_t PieceTableTextBuffer::nextPriority() {
+    // xorshift32: deterministic, cheap and good enough to keep the treap balanced
+    rngState_ ^= rngState_ << 13;
+    rngState_ ^= rngState_ >> 17;
+    rngState_ ^= rngState_ << 5;
+    return rngState_;
+}
+
+uint32_t PieceTableTextBuffer::allocateNode(BufferKind buffer, size_t start, size_t length) {
+    uint32_t index;
+    if (!freeNodes_.empty()) {
+        index = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[index] = Node();
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    Node& node = nodes_[index];
+    node.buffer = buffer;
+    node.start = start;
+    node.length = length;
+    node.lineBreaks = countLineBreaks(buffer, start, length);
+    node.priority = nextPriority();
+    updateNode(index);
+    return index;
+}
+
+void PieceTableTextBuffer::releaseSubtree(uint32_t node) {
+    std::vector<uint32_t> pending;
+    if (node != kNil) {
+        pending.push_back(node);
+    }
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+        if (nodes_[current].left != kNil) {
+            pending.push_back(nodes_[current].left);
+        }
+        if (nodes_[current].right != kNil) {
+            pending.push_back(nodes_[current].right);
+        }
+        freeNodes_.push_back(current);
+    }
+}
+
+void PieceTableTextBuffer::updateNode(uint32_t node) {
+    Node& n = nodes_[node];
+    n.subtreeLength = n.length;
+    n.subtreeLineBreaks = n.lineBreaks;
+    if (n.left != kNil) {
+        n.subtreeLength += nodes_[n.left].subtreeLength;
+        n.subtreeLineBreaks += nodes_[n.left].subtreeLineBreaks;
+    }
+    if (n.right != kNil) {
+        n.subtreeLength += nodes_[n.right].subtreeLength;
+        n.subtreeLineBreaks += nodes_[n.right].subtreeLineBreaks;
+    }
+}
+
+void PieceTableTextBuffer::split(uint32_t node, size_t offset, uint32_t& left, uint32_t& right) {
+    if (node == kNil) {
+        left = right = kNil;
+        return;
+    }
+
+    const size_t leftLength = nodes_[node].left == kNil ? 0 : nodes_[nodes_[node].left].subtreeLength;
+    const size_t pieceLength = nodes_[node].length;
+
+    if (offset <= leftLength) {
+        uint32_t innerLeft, innerRight;
+        split(nodes_[node].left, offset, innerLeft, innerRight);
+        nodes_[node].left = innerRight;
+        updateNode(node);
+        left = innerLeft;
+        right = node;
+    } else if (offset >= leftLength + pieceLength) {
+        uint32_t innerLeft, innerRight;
+        split(nodes_[node].right, offset - leftLength - pieceLength, innerLeft, innerRight);
+        nodes_[node].right = innerLeft;
+        updateNode(node);
+        left = node;
+        right = innerRight;
+    } else {
+        // The split point falls inside this piece: cut it in two. The tail
+        // inherits the head's priority so the heap order of its new right
+        // subtree (the head's old right subtree) stays intact.
+        const size_t cut = offset - leftLength;
+        uint32_t tail = allocateNode(nodes_[node].buffer, nodes_[node].start + cut, pieceLength - cut);
+        nodes_[tail].priority = nodes_[node].priority;
+        nodes_[tail].right = nodes_[node].right;
+        updateNode(tail);
+
+        nodes_[node].right = kNil;
+        nodes_[node].length = cut;
+        nodes_[node].lineBreaks -= nodes_[tail].lineBreaks;
+        updateNode(node);
+
+        left = node;
+        right = tail;
+    }
+}
+
+uint32_t PieceTableTextBuffer::merge(uint32_t left, uint32_t right) {
+    if (left == kNil) {
+        return right;
+    }
+    if (right == kNil) {
+        return left;
+    }
+
+    if (nodes_[left].priority > nodes_[right].priority) {
+        uint32_t merged = merge(nodes_[left].right, right);
+        nodes_[left].right = merged;
+        updateNode(left);
+        return left;
+    }
+
+    uint32_t merged = merge(left, nodes_[right].left);
+    nodes_[right].left = merged;
+    updateNode(right);
+    return right;
+}
+
+bool PieceTableTextBuffer::tryExtendRightmost(uint32_t node, size_t addStart, size_t length) {
+    if (node == kNil) {
+        return false;
+    }
+
+    if (nodes_[node].right != kNil) {
+        if (!tryExtendRightmost(nodes_[node].right, addStart, length)) {
+            return false;
+        }
+        updateNode(node);
+        return true;
+    }
+
+    // Consecutive typing appends to the add buffer right after the previous
+    // insertion, so the piece can simply grow instead of adding a new node.
+    Node& n = nodes_[node];
+    if (n.buffer != BufferKind::Add || n.start + n.length != addStart) {
+        return false;
+    }
+    n.length += length;
+    n.lineBreaks += countLineBreaks(BufferKind::Add, addStart, length);
+    updateNode(node);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Buffer helpers
+// ---------------------------------------------------------------------------
+
+const std::string& PieceTableTextBuffer::bufferFor(BufferKind buffer) const {
+    return buffer == BufferKind::Original ? originalBuffer_ : addBuffer_;
+}
+
+const std::vector<size_t>& PieceTableTextBuffer::lineBreaksFor(BufferKind buffer) const {
+    return buffer == BufferKind::Original ? originalLineBreaks_ : addLineBreaks_;
+}
+
+size_t PieceTableTextBuffer::countLineBreaks(BufferKind buffer, size_t start, size_t length) const {
+    const auto& breaks = lineBreaksFor(buffer);
+    auto first = std::lower_bound(breaks.begin(), breaks.end(), start);
+    auto last = std::lower_bound(first, breaks.end(), start + length);
+    return static_cast<size_t>(last - first);
+}
+
+// ---------------------------------------------------------------------------
+// Document level primitives
+// ---------------------------------------------------------------------------
+
+void PieceTableTextBuffer::insertAt(size_t offset, const std::string& text) {
+    if (text.empty()) {
+        return;
+    }
+
+    const size_t addStart = addBuffer_.size();
+    addBuffer_ += text;
+    collectLineBreaks(text.data(), text.size(), addStart, addLineBreaks_);
+
+    uint32_t left, right;
+    split(root_, offset, left, right);
+    if (!tryExtendRightmost(left, addStart, text.size())) {
+        uint32_t piece = allocateNode(BufferKind::Add, addStart, text.size());
+        left = merge(left, piece);
+    }
+    root_ = merge(left, right);
+}
+
+void PieceTableTextBuffer::eraseRange(size_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    uint32_t left, rest, middle, right;
+    split(root_, offset, left, rest);
+    split(rest, length, middle, right);
+    releaseSubtree(middle);
+    root_ = merge(left, right);
+}
+
+size_t PieceTableTextBuffer::totalLength() const {
+    return root_ == kNil ? 0 : nodes_[root_].subtreeLength;
+}
+
+size_t PieceTableTextBuffer::totalLineBreaks() const {
+    return root_ == kNil ? 0 : nodes_[root_].subtreeLineBreaks;
+}
+
+size_t PieceTableTextBuffer::lineStartOffset(size_t lineIndex) const {
+    if (lineIndex == 0) {
+        return 0;
+    }
+
+    // Line N starts right after the N-th line break (1-based)
+    size_t remaining = lineIndex - 1;
+    size_t base = 0;
+    uint32_t node = root_;
+    while (node != kNil) {
+        const Node& n = nodes_[node];
+        const size_t leftBreaks = n.left == kNil ? 0 : nodes_[n.left].subtreeLineBreaks;
+        if (remaining < leftBreaks) {
+            node = n.left;
+            continue;
+        }
+
+        remaining -= leftBreaks;
+        const size_t leftLength = n.left == kNil ? 0 : nodes_[n.left].subtreeLength;
+        if (remaining < n.lineBreaks) {
+            const auto& breaks = lineBreaksFor(n.buffer);
+            auto first = std::lower_bound(breaks.begin(), breaks.end(), n.start);
+            const size_t breakPos = *(first + static_cast<std::ptrdiff_t>(remaining));
+            return base + leftLength + (breakPos - n.start) + 1;
+        }
+
+        remaining -= n.lineBreaks;
+        base += leftLength + n.length;
+        node = n.right;
+    }
+    return totalLength();
+}
+
+size_t PieceTableTextBuffer::treeLineLength(size_t lineIndex) const {
+    const size_t start = lineStartOffset(lineIndex);
+    const size_t end = (lineIndex + 1 < lineCount()) ? lineStartOffset(lineIndex + 1) - 1 : totalLength();
+    return end - start;
+}
+
+void PieceTableTextBuffer::appendRange(size_t from, size_t to, std::string& out) const {
+    appendRangeFrom(root_, 0, from, to, out);
+}
+
+void PieceTableTextBuffer::appendRangeFrom(uint32_t node, size_t nodeBase, size_t from, size_t to, std::string& out) const {
+    if (node == kNil || from >= to) {
+        return;
+    }
+
+    const Node& n = nodes_[node];
+    const size_t leftLength = n.left == kNil ? 0 : nodes_[n.left].subtreeLength;
+    const size_t pieceStart = nodeBase + leftLength;
+    const size_t pieceEnd = pieceStart + n.length;
+
+    if (from < pieceStart) {
+        appendRangeFrom(n.left, nodeBase, from, to, out);
+    }
+    if (from < pieceEnd && to > pieceStart) {
+        const size_t begin = std::max(from, pieceStart);
+        const size_t end = std::min(to, pieceEnd);
+        out.append(bufferFor(n.buffer), n.start + (begin - pieceStart), end - begin);
+    }
+    if (to > pieceEnd) {
+        appendRangeFrom(n.right, pieceEnd, from, to, out);
+    }
+}
+
+std::string PieceTableTextBuffer::treeLine(size_t lineIndex) const {
+    const size_t start = lineStartOffset(lineIndex);
+    const size_t end = (lineIndex + 1 < lineCount()) ? lineStartOffset(lineIndex + 1) - 1 : totalLength();
+    std::string line;
+    line.reserve(end - start);
+    appendRange(start, end, line);
+    return line;
+}
+
+// ---------------------------------------------------------------------------
+// Line helpers
+// ---------------------------------------------------------------------------
+
+void PieceTableTextBuffer::checkLineIndex(size_t lineIndex, const char* operation) const {
+    if (lineIndex >= lineCount()) {
+        throw TextBufferException(std::string("Index out of range for ") + operation, EditorException::Severity::EDITOR_ERROR);
+    }
+}
+
+size_t PieceTableTextBuffer::currentLineLength(size_t lineIndex) const {
+    if (const std::string* written = writableLine(lineIndex)) {
+        return written->length();
+    }
+    return treeLineLength(lineIndex);
+}
+
+const std::string* PieceTableTextBuffer::writableLine(size_t lineIndex) const {
+    // Read-only copies always match the tree, so only writable ones matter.
+    // writableLines_ only changes in non-const members, so checking it
+    // without the lock is safe for concurrent const callers.
+    if (writableLines_ == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(materializedMutex_);
+    auto it = materialized_.find(lineIndex);
+    return it != materialized_.end() && it->second.writable ? &it->second.text : nullptr;
+}
+
+void PieceTableTextBuffer::commitMaterializedLines() {
+    if (writableLines_ > 0) {
+        std::vector<size_t> writable;
+        writable.reserve(writableLines_);
+        for (const auto& entry : materialized_) {
+            if (entry.second.writable) {
+                writable.push_back(entry.first);
+            }
+        }
+
+        // Highest index first, so a line break written into one line
+        // cannot shift the index of a line still waiting to be committed
+        std::sort(writable.rbegin(), writable.rend());
+        for (size_t lineIndex : writable) {
+            const std::string& text = materialized_[lineIndex].text;
+            if (lineIndex < lineCount() && treeLine(lineIndex) != text) {
+                replaceLineContent(lineIndex, text);
+            }
+        }
+    }
+
+    materialized_.clear();
+    readOnlyOrder_.clear();
+    writableLines_ = 0;
+}
+
+void PieceTableTextBuffer::beginModification() {
+    commitMaterializedLines();
+    modified_ = true;
+}
+
+void PieceTableTextBuffer::resetToText(std::string text, bool empty) {
+    originalBuffer_ = std::move(text);
+    originalLineBreaks_.clear();
+    collectLineBreaks(originalBuffer_.data(), originalBuffer_.size(), 0, originalLineBreaks_);
+
+    addBuffer_.clear();
+    addLineBreaks_.clear();
+    nodes_.clear();
+    freeNodes_.clear();
+    root_ = kNil;
+    materialized_.clear();
+    readOnlyOrder_.clear();
+    writableLines_ = 0;
+    empty_ = empty;
+
+    if (!originalBuffer_.empty()) {
+        root_ = allocateNode(BufferKind::Original, 0, originalBuffer_.size());
+    }
+}
+
+void PieceTableTextBuffer::replaceLineContent(size_t lineIndex, const std::string& text) {
+    const size_t start = lineStartOffset(lineIndex);
+    eraseRange(start, treeLineLength(lineIndex));
+    insertAt(start, text);
+}
+
+// ---------------------------------------------------------------------------
+// ITextBuffer: line operations
+// ---------------------------------------------------------------------------
+
+void PieceTableTextBuffer::addLine(const std::string& line) {
+    beginModification();
+    if (empty_) {
+        empty_ = false;
+        insertAt(0, line);
+    } else {
+        insertAt(totalLength(), "\n" + line);
+    }
+}
+
+void PieceTableTextBuffer::insertLine(size_t index, const std::string& line) {
+    if (index > lineCount()) {
+        throw TextBufferException("Index out of range for insertLine", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+
+    if (empty_) {
+        empty_ = false;
+        insertAt(0, line);
+    } else if (index < lineCount()) {
+        insertAt(lineStartOffset(index), line + "\n");
+    } else {
+        insertAt(totalLength(), "\n" + line);
+    }
+}
+
+void PieceTableTextBuffer::deleteLine(size_t index) {
+    checkLineIndex(index, "deleteLine");
+    beginModification();
+
+    const size_t count = lineCount();
+    if (count == 1) {
+        // Keep the buffer at one (now empty) line, like TextBuffer
+        eraseRange(0, totalLength());
+    } else if (index + 1 < count) {
+        const size_t start = lineStartOffset(index);
+        eraseRange(start, lineStartOffset(index + 1) - start);
+    } else {
+        // Last line: remove it together with the line break that precedes it
+        const size_t start = lineStartOffset(index) - 1;
+        eraseRange(start, totalLength() - start);
+    }
+}
+
+void PieceTableTextBuffer::replaceLine(size_t index, const std::string& newLine) {
+    checkLineIndex(index, "replaceLine");
+    beginModification();
+    replaceLineContent(index, newLine);
+}
+
+void PieceTableTextBuffer::setLine(size_t lineIndex, const std::string& text) {
+    checkLineIndex(lineIndex, "setLine");
+    beginModification();
+    replaceLineContent(lineIndex, text);
+}
+
+void PieceTableTextBuffer::deleteLines(size_t startIndex, size_t endIndex) {
+    const size_t count = lineCount();
+    if (startIndex >= count || endIndex >= count || startIndex > endIndex) {
+        throw TextBufferException("Invalid range for deleteLines", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (startIndex == endIndex) {
+        return;
+    }
+    beginModification();
+
+    // Deletes [startIndex, endIndex); endIndex is always a valid line so at least one line survives
+    const size_t start = lineStartOffset(startIndex);
+    eraseRange(start, lineStartOffset(endIndex) - start);
+}
+
+void PieceTableTextBuffer::insertLines(size_t index, const std::vector<std::string>& newLines) {
+    if (index > lineCount()) {
+        throw TextBufferException("Index out of range for insertLines", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (newLines.empty()) {
+        return;
+    }
+    beginModification();
+
+    size_t joinedLength = newLines.size() - 1;
+    for (const auto& line : newLines) {
+        joinedLength += line.length();
+    }
+    std::string joined;
+    joined.reserve(joinedLength + 1);
+    for (size_t i = 0; i < newLines.size(); ++i) {
+        if (i > 0) {
+            joined += '\n';
+        }
+        joined += newLines[i];
+    }
+
+    if (empty_) {
+        empty_ = false;
+        insertAt(0, joined);
+    } else if (index < lineCount()) {
+        joined += '\n';
+        insertAt(lineStartOffset(index), joined);
+    } else {
+        joined.insert(joined.begin(), '\n');
+        insertAt(totalLength(), joined);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ITextBuffer: accessors
+// ---------------------------------------------------------------------------
+
+const std::string& PieceTableTextBuffer::getLine(size_t index) const {
+    checkLineIndex(index, "getLine");
+
+    // Map nodes do not move on insertion, so a reference stays valid until
+    // its entry is released: by the next modifying call, or here once
+    // kMaxMaterializedLines newer read-only copies have been made
+    std::lock_guard<std::mutex> lock(materializedMutex_);
+    auto it = materialized_.find(index);
+    if (it != materialized_.end()) {
+        return it->second.text;
+    }
+
+    while (readOnlyOrder_.size() >= kMaxMaterializedLines) {
+        // Lines made writable since must survive until committed
+        auto oldest = materialized_.find(readOnlyOrder_.front());
+        if (oldest != materialized_.end() && !oldest->second.writable) {
+            materialized_.erase(oldest);
+        }
+        readOnlyOrder_.pop_front();
+    }
+
+    MaterializedLine& line = materialized_[index];
+    line.text = treeLine(index);
+    readOnlyOrder_.push_back(index);
+    return line.text;
+}
+
+std::string& PieceTableTextBuffer::getLine(size_t index) {
+    checkLineIndex(index, "getLine (non-const)");
+
+    auto it = materialized_.find(index);
+    if (it != materialized_.end()) {
+        if (!it->second.writable) {
+            it->second.writable = true;
+            ++writableLines_;
+        }
+        return it->second.text;
+    }
+
+    MaterializedLine& line = materialized_[index];
+    line.text = treeLine(index);
+    line.writable = true;
+    ++writableLines_;
+    return line.text;
+}
+
+size_t PieceTableTextBuffer::lineCount() const {
+    return empty_ ? 0 : totalLineBreaks() + 1;
+}
+
+bool PieceTableTextBuffer::isEmpty() const {
+    return empty_;
+}
+
+size_t PieceTableTextBuffer::lineLength(size_t lineIndex) const {
+    checkLineIndex(lineIndex, "lineLength");
+    return currentLineLength(lineIndex);
+}
+
+size_t PieceTableTextBuffer::characterCount() const {
+    if (empty_) {
+        return 0;
+    }
+
+    size_t count = totalLength() - totalLineBreaks();
+    if (writableLines_ > 0) {
+        std::lock_guard<std::mutex> lock(materializedMutex_);
+        for (const auto& entry : materialized_) {
+            if (entry.second.writable) {
+                count = count + entry.second.text.length() - treeLineLength(entry.first);
+            }
+        }
+    }
+    return count;
+}
+
+size_t PieceTableTextBuffer::forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const {
+    const size_t end = std::min(endLine, lineCount());
+    if (startLine >= end) {
+        return 0;
+    }
+
+    // Descend to the piece holding the first requested byte, stacking the
+    // ancestors that still have to be visited in order after it
+    const size_t startOffset = lineStartOffset(startLine);
+    std::vector<uint32_t> stack;
+    size_t skip = 0;
+    size_t base = 0;
+    uint32_t node = root_;
+    while (node != kNil) {
+        const Node& n = nodes_[node];
+        const size_t pieceStart = base + (n.left == kNil ? 0 : nodes_[n.left].subtreeLength);
+        if (startOffset < pieceStart) {
+            stack.push_back(node);
+            node = n.left;
+        } else if (startOffset < pieceStart + n.length) {
+            stack.push_back(node);
+            skip = startOffset - pieceStart;
+            break;
+        } else {
+            base = pieceStart + n.length;
+            node = n.right;
+        }
+    }
+
+    size_t lineIndex = startLine;
+    size_t visited = 0;
+    bool stopped = false;
+    std::string spanning; // Only used for lines that cross a piece boundary
+    auto emit = [&](std::string_view line) {
+        if (const std::string* written = writableLine(lineIndex)) {
+            line = *written;
+        }
+        ++visited;
+        stopped = !visitor(lineIndex++, line) || lineIndex >= end;
+    };
+
+    // In-order traversal of the remaining pieces, splitting on line breaks;
+    // lines contained in one piece are handed out as views into its buffer
+    node = kNil;
+    while (!stopped && (node != kNil || !stack.empty())) {
+        while (node != kNil) {
+            stack.push_back(node);
+            node = nodes_[node].left;
+        }
+        node = stack.back();
+        stack.pop_back();
+
+        const Node& n = nodes_[node];
+        const char* data = bufferFor(n.buffer).data() + n.start + skip;
+        const char* pieceEnd = bufferFor(n.buffer).data() + n.start + n.length;
+        skip = 0;
+        while (!stopped && data < pieceEnd) {
+            const void* hit = std::memchr(data, '\n', static_cast<size_t>(pieceEnd - data));
+            if (!hit) {
+                spanning.append(data, static_cast<size_t>(pieceEnd - data));
+                break;
+            }
+            const char* newline = static_cast<const char*>(hit);
+            if (spanning.empty()) {
+                emit(std::string_view(data, static_cast<size_t>(newline - data)));
+            } else {
+                spanning.append(data, static_cast<size_t>(newline - data));
+                emit(spanning);
+                spanning.clear();
+            }
+            data = newline + 1;
+        }
+
+        node = n.right;
+    }
+    if (!stopped) {
+        emit(spanning); // The last line has no trailing line break
+    }
+    return visited;
+}
+
+std::vector<std::string> PieceTableTextBuffer::getAllLines() const {
+    // Special case: a single empty line is reported as no lines, like TextBuffer
+    if (lineCount() == 1 && currentLineLength(0) == 0) {
+        return std::vector<std::string>();
+    }
+    return getLines();
+}
+
+bool PieceTableTextBuffer::isValidPosition(size_t lineIndex, size_t colIndex) const {
+    if (lineIndex >= lineCount()) {
+        return false;
+    }
+    return colIndex <= currentLineLength(lineIndex);
+}
+
+std::pair<size_t, size_t> PieceTableTextBuffer::clampPosition(size_t lineIndex, size_t colIndex) const {
+    if (empty_) {
+        return {0, 0};
+    }
+
+    lineIndex = std::min(lineIndex, lineCount() - 1);
+    colIndex = std::min(colIndex, currentLineLength(lineIndex));
+    return {lineIndex, colIndex};
+}
+
+void PieceTableTextBuffer::printToStream(std::ostream& os) const {
+    forEachLine(0, lineCount(), [&os](size_t, std::string_view line) {
+        os << line << '\n';
+        return true;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// ITextBuffer: file operations
+// ---------------------------------------------------------------------------
+
+bool PieceTableTextBuffer::saveToFile(const std::string& filename) const {
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile.is_open()) {
+        ErrorReporter::logError("Could not open file for saving: " + filename);
+        return false;
+    }
+
+    forEachLine(0, lineCount(), [&outfile](size_t, std::string_view line) {
+        outfile.write(line.data(), static_cast<std::streamsize>(line.size()));
+        outfile.put('\n');
+        return true;
+    });
+
+    if (outfile.fail()) {
+        ErrorReporter::logError("Failed while writing to file: " + filename);
+        outfile.close();
+        return false;
+    }
+
+    outfile.close();
+    return true;
+}
+
+bool PieceTableTextBuffer::loadFromFile(const std::string& filename) {
+    std::ifstream infile(filename, std::ios::binary | std::ios::ate);
+    if (!infile.is_open()) {
+        ErrorReporter::logError("Could not open file for loading: " + filename);
+        return false;
+    }
+
+    // The whole file becomes the immutable original buffer in a single read
+    const std::streamoff fileSize = infile.tellg();
+    std::string contents(fileSize > 0 ? static_cast<size_t>(fileSize) : 0, '\0');
+    infile.seekg(0, std::ios::beg);
+    if (!contents.empty() && !infile.read(&contents[0], static_cast<std::streamsize>(contents.size()))) {
+        ErrorReporter::logError("An I/O error occurred while reading file: " + filename);
+        infile.close();
+        return false;
+    }
+    infile.close();
+
+    // Match std::getline semantics: a trailing line break does not start a new line
+    const bool empty = contents.empty();
+    if (!empty && contents.back() == '\n') {
+        contents.pop_back();
+    }
+
+    resetToText(std::move(contents), empty);
+    modified_ = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ITextBuffer: character level operations
+// ---------------------------------------------------------------------------
+
+void PieceTableTextBuffer::insertChar(size_t lineIndex, size_t colIndex, char ch) {
+    checkLineIndex(lineIndex, "insertChar");
+    if (colIndex > currentLineLength(lineIndex)) {
+        throw TextBufferException("Column index out of range for insertChar", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+    insertAt(lineStartOffset(lineIndex) + colIndex, std::string(1, ch));
+}
+
+void PieceTableTextBuffer::deleteChar(size_t lineIndex, size_t colIndex) {
+    checkLineIndex(lineIndex, "deleteChar");
+    beginModification();
+
+    const size_t start = lineStartOffset(lineIndex);
+    const size_t length = treeLineLength(lineIndex);
+    if (colIndex == 0) {
+        // Backspace at start of line joins with the previous line
+        if (lineIndex > 0) {
+            eraseRange(start - 1, 1);
+        }
+    } else if (colIndex <= length) {
+        eraseRange(start + colIndex - 1, 1);
+    } else if (length > 0) {
+        // Beyond the end of the line: treat as backspace at the end of the line
+        eraseRange(start + length - 1, 1);
+    }
+}
+
+void PieceTableTextBuffer::deleteCharForward(size_t lineIndex, size_t colIndex) {
+    checkLineIndex(lineIndex, "deleteCharForward");
+
+    const size_t count = lineCount();
+    const size_t currentLength = currentLineLength(lineIndex);
+    if (colIndex > currentLength && (lineIndex == count - 1 || colIndex > currentLength + 100)) {
+        throw TextBufferException("Column index out of range for deleteCharForward", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+
+    const size_t start = lineStartOffset(lineIndex);
+    const size_t length = treeLineLength(lineIndex);
+    if (colIndex < length) {
+        eraseRange(start + colIndex, 1);
+    } else if (lineIndex < count - 1) {
+        // Delete at end of line joins with the next line
+        eraseRange(start + length, 1);
+    }
+}
+
+void PieceTableTextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol, size_t endCol, const std::string& newText) {
+    checkLineIndex(lineIndex, "replaceLineSegment (lineIndex)");
+    const size_t length = currentLineLength(lineIndex);
+    if (startCol > length || endCol > length) {
+        throw TextBufferException("Column index out of range for replaceLineSegment", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (startCol > endCol) {
+        throw TextBufferException("Start column cannot be greater than end column for replaceLineSegment", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+
+    const size_t start = lineStartOffset(lineIndex) + startCol;
+    eraseRange(start, endCol - startCol);
+    insertAt(start, newText);
+}
+
+void PieceTableTextBuffer::deleteLineSegment(size_t lineIndex, size_t startCol, size_t endCol) {
+    checkLineIndex(lineIndex, "deleteLineSegment (lineIndex)");
+    const size_t length = currentLineLength(lineIndex);
+    if (startCol > length || endCol > length) {
+        throw TextBufferException("Column index out of range for deleteLineSegment", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (startCol > endCol) {
+        throw TextBufferException("Start column cannot be greater than end column for deleteLineSegment", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+
+    eraseRange(lineStartOffset(lineIndex) + startCol, endCol - startCol);
+}
+
+void PieceTableTextBuffer::splitLine(size_t lineIndex, size_t colIndex) {
+    checkLineIndex(lineIndex, "splitLine");
+    if (colIndex > currentLineLength(lineIndex)) {
+        throw TextBufferException("Column index out of range for splitLine", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+    insertAt(lineStartOffset(lineIndex) + colIndex, "\n");
+}
+
+void PieceTableTextBuffer::joinLines(size_t lineIndex) {
+    if (lineIndex + 1 >= lineCount()) {
+        throw TextBufferException("Cannot join last line with next line", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+    eraseRange(lineStartOffset(lineIndex + 1) - 1, 1);
+}
+
+void PieceTableTextBuffer::clear(bool keepEmptyLine) {
+    resetToText(std::string(), !keepEmptyLine);
+}
+
+void PieceTableTextBuffer::insertString(size_t lineIndex, size_t colIndex, const std::string& text) {
+    checkLineIndex(lineIndex, "insertString (lineIndex)");
+    if (colIndex > currentLineLength(lineIndex)) {
+        throw TextBufferException("Index out of range for insertString (colIndex)", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+    insertAt(lineStartOffset(lineIndex) + colIndex, text);
+}
+
+std::string PieceTableTextBuffer::getLineSegment(size_t lineIndex, size_t startCol, size_t endCol) const {
+    checkLineIndex(lineIndex, "getLineSegment (lineIndex)");
+
+    const size_t length = currentLineLength(lineIndex);
+    if (startCol > endCol || startCol > length) {
+        throw TextBufferException("Invalid column range for getLineSegment", EditorException::Severity::EDITOR_ERROR);
+    }
+    endCol = std::min(endCol, length);
+
+    if (const std::string* written = writableLine(lineIndex)) {
+        return written->substr(startCol, endCol - startCol);
+    }
+
+    const size_t start = lineStartOffset(lineIndex);
+    std::string segment;
+    segment.reserve(endCol - startCol);
+    appendRange(start + startCol, start + endCol, segment);
+    return segment;
+}
+
+size_t PieceTableTextBuffer::getLineCount() const {
+    return lineCount();
+}
+
+std::vector<std::string> PieceTableTextBuffer::getLines() const {
+    std::vector<std::string> lines;
+    lines.reserve(lineCount());
+    forEachLine(0, lineCount(), [&lines](size_t, std::string_view line) {
+        lines.emplace_back(line);
+        return true;
+    });
+    return lines;
+}
+
+void PieceTableTextBuffer::replaceText(size_t startLine, size_t startCol, size_t endLine, size_t endCol, const std::string& text) {
+    const size_t count = lineCount();
+    if (startLine >= count || endLine >= count) {
+        throw TextBufferException("Line index out of range for replaceText", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (startLine > endLine) {
+        throw TextBufferException("Invalid range for replaceText", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    if (startLine == endLine) {
+        replaceLineSegment(startLine, startCol, endCol, text);
+        return;
+    }
+    beginModification();
+
+    const size_t from = lineStartOffset(startLine) + std::min(startCol, treeLineLength(startLine));
+    const size_t to = lineStartOffset(endLine) + std::min(endCol, treeLineLength(endLine));
+    eraseRange(from, to - from);
+    insertAt(from, text);
+}
+
+void PieceTableTextBuffer::insertText(size_t line, size_t col, const std::string& text) {
+    if (line >= lineCount()) {
+        throw TextBufferException("Invalid line index for insertText", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (col > currentLineLength(line)) {
+        throw TextBufferException("Invalid column index for insertText", EditorException::Severity::EDITOR_ERROR);
+    }
+    beginModification();
+    insertAt(lineStartOffset(line) + col, text);
+}
+
+void PieceTableTextBuffer::deleteText(size_t startLine, size_t startCol, size_t endLine, size_t endCol) {
+    const size_t count = lineCount();
+    if (startLine >= count || endLine >= count) {
+        throw TextBufferException("Line index out of range for deleteText", EditorException::Severity::EDITOR_ERROR);
+    }
+    if (startLine > endLine) {
+        throw TextBufferException("Invalid range for deleteText", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    if (startLine == endLine) {
+        deleteLineSegment(startLine, startCol, endCol);
+        return;
+    }
+    beginModification();
+
+    const size_t from = lineStartOffset(startLine) + std::min(startCol, treeLineLength(startLine));
+    const size_t to = lineStartOffset(endLine) + std::min(endCol, treeLineLength(endLine));
+    eraseRange(from, to - from);
+}
+
+bool PieceTableTextBuffer::isModified() const {
+    return modified_;
+}
+
+void PieceTableTextBuffer::setModified(bool modified) {
+    modified_ = modified;
+}
+
+// ---------------------------------------------------------------------------
+// Diagnostics
+// ---------------------------------------------------------------------------
+
+size_t PieceTableTextBuffer::getPieceCount() const {
+    return nodes_.size() - freeNodes_.size();
+}
+
+size_t PieceTableTextBuffer::getAddBufferSize() const {
+    return addBuffer_.size();
+}
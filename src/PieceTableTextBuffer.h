@@ -0,0 +1,197 @@
+#pragma once
+
+#include "interfaces/ITextBuffer.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief A piece-table text buffer
+ *
+ * This class implements the ITextBuffer interface on top of a piece table:
+ * an immutable original buffer holding the file contents as loaded, an
+ * append-only add buffer holding every piece of inserted text, and a
+ * balanced tree (a treap) of pieces describing the current document.
+ * Every tree node caches the length and line-break count of its subtree,
+ * so locating a line and splicing text in or out are O(log n) operations
+ * regardless of file size, and no existing text is ever copied on edit.
+ *
+ * Lines are materialized on demand. References returned by getLine() stay
+ * valid until the next modifying call, which is also when the materialized
+ * copies are released. The const getLine() keeps at most a few thousand
+ * read-only copies, releasing the oldest first, so a reference it returned
+ * also expires once that many other lines have been read; prefer
+ * forEachLine() for walking large ranges. Text written through the
+ * non-const getLine() reference is folded back into the piece table before
+ * the next modification.
+ *
+ * Like TextBuffer, this class is not thread-safe for writers. Concurrent
+ * calls to const members are safe: the materialized lines are guarded by
+ * an internal mutex.
+ */
+class PieceTableTextBuffer : public ITextBuffer {
+public:
+    /**
+     * @brief Constructor
+     *
+     * Creates a buffer containing a single empty line, matching TextBuffer.
+     */
+    PieceTableTextBuffer();
+
+    /**
+     * @brief Constructor with file
+     *
+     * Creates a buffer initialized from a file.
+     *
+     * @param filename The path to the file to load
+     */
+    explicit PieceTableTextBuffer(const std::string& filename);
+
+    ~PieceTableTextBuffer() override = default;
+
+    // ITextBuffer interface implementation
+    void addLine(const std::string& line) override;
+    void insertLine(size_t index, const std::string& line) override;
+    void deleteLine(size_t index) override;
+    void replaceLine(size_t index, const std::string& newLine) override;
+    void setLine(size_t lineIndex, const std::string& text) override;
+    void deleteLines(size_t startIndex, size_t endIndex) override;
+    void insertLines(size_t index, const std::vector<std::string>& newLines) override;
+    const std::string& getLine(size_t index) const override;
+    std::string& getLine(size_t index) override;
+    size_t lineCount() const override;
+    bool isEmpty() const override;
+    size_t lineLength(size_t lineIndex) const override;
+    size_t characterCount() const override;
+    std::vector<std::string> getAllLines() const override;
+    size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const override;
+    bool isValidPosition(size_t lineIndex, size_t colIndex) const override;
+    std::pair<size_t, size_t> clampPosition(size_t lineIndex, size_t colIndex) const override;
+    void printToStream(std::ostream& os) const override;
+    bool saveToFile(const std::string& filename) const override;
+    bool loadFromFile(const std::string& filename) override;
+    void insertChar(size_t lineIndex, size_t colIndex, char ch) override;
+    void deleteChar(size_t lineIndex, size_t colIndex) override;
+    void deleteCharForward(size_t lineIndex, size_t colIndex) override;
+    void replaceLineSegment(size_t lineIndex, size_t startCol, size_t endCol, const std::string& newText) override;
+    void deleteLineSegment(size_t lineIndex, size_t startCol, size_t endCol) override;
+    void splitLine(size_t lineIndex, size_t colIndex) override;
+    void joinLines(size_t lineIndex) override;
+    void clear(bool keepEmptyLine) override;
+    void insertString(size_t lineIndex, size_t colIndex, const std::string& text) override;
+    std::string getLineSegment(size_t lineIndex, size_t startCol, size_t endCol) const override;
+    size_t getLineCount() const override;
+    std::vector<std::string> getLines() const override;
+    void replaceText(size_t startLine, size_t startCol, size_t endLine, size_t endCol, const std::string& text) override;
+    void insertText(size_t line, size_t col, const std::string& text) override;
+    void deleteText(size_t startLine, size_t startCol, size_t endLine, size_t endCol) override;
+    bool isModified() const override;
+    void setModified(bool modified) override;
+
+    /**
+     * @brief Get the number of pieces currently describing the document
+     *
+     * Mostly useful for diagnostics and benchmarks; the count grows with
+     * fragmentation caused by edits and is reset by clear() and loadFromFile().
+     *
+     * @return The number of pieces in the tree
+     */
+    size_t getPieceCount() const;
+
+    /**
+     * @brief Get the size of the append-only add buffer in bytes
+     *
+     * @return The number of bytes appended by edits since the last load or clear
+     */
+    size_t getAddBufferSize() const;
+
+private:
+    /**
+     * @brief Identifies which backing buffer a piece refers to
+     */
+    enum class BufferKind : uint8_t {
+        Original,   ///< The immutable buffer filled by loadFromFile()
+        Add         ///< The append-only buffer filled by edits
+    };
+
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    /**
+     * @brief A treap node describing one piece of the document
+     */
+    struct Node {
+        BufferKind buffer = BufferKind::Add;
+        size_t start = 0;              ///< Start offset in the backing buffer
+        size_t length = 0;             ///< Length of the piece in bytes
+        size_t lineBreaks = 0;         ///< Number of '\n' inside the piece
+        size_t subtreeLength = 0;      ///< Total length of this subtree
+        size_t subtreeLineBreaks = 0;  ///< Total line breaks in this subtree
+        uint32_t priority = 0;         ///< Treap heap priority
+        uint32_t left = kNil;
+        uint32_t right = kNil;
+    };
+
+    /**
+     * @brief A line handed out by getLine() that is not yet backed by the tree
+     */
+    struct MaterializedLine {
+        std::string text;
+        bool writable = false;         ///< Handed out via the non-const getLine()
+    };
+
+    // Tree maintenance
+    uint32_t allocateNode(BufferKind buffer, size_t start, size_t length);
+    void releaseSubtree(uint32_t node);
+    void updateNode(uint32_t node);
+    void split(uint32_t node, size_t offset, uint32_t& left, uint32_t& right);
+    uint32_t merge(uint32_t left, uint32_t right);
+    bool tryExtendRightmost(uint32_t node, size_t addStart, size_t length);
+    uint32_t nextPriority();
+
+    // Buffer helpers
+    const std::string& bufferFor(BufferKind buffer) const;
+    const std::vector<size_t>& lineBreaksFor(BufferKind buffer) const;
+    size_t countLineBreaks(BufferKind buffer, size_t start, size_t length) const;
+
+    // Document level primitives
+    void insertAt(size_t offset, const std::string& text);
+    void eraseRange(size_t offset, size_t length);
+    size_t totalLength() const;
+    size_t totalLineBreaks() const;
+    size_t lineStartOffset(size_t lineIndex) const;
+    size_t treeLineLength(size_t lineIndex) const;
+    void appendRange(size_t from, size_t to, std::string& out) const;
+    void appendRangeFrom(uint32_t node, size_t nodeBase, size_t from, size_t to, std::string& out) const;
+    std::string treeLine(size_t lineIndex) const;
+
+    // Line helpers
+    void checkLineIndex(size_t lineIndex, const char* operation) const;
+    size_t currentLineLength(size_t lineIndex) const;
+    const std::string* writableLine(size_t lineIndex) const;
+    void commitMaterializedLines();
+    void beginModification();
+    void resetToText(std::string text, bool empty);
+    void replaceLineContent(size_t lineIndex, const std::string& text);
+
+    std::string originalBuffer_;                        ///< Immutable file contents
+    std::string addBuffer_;                             ///< Append-only inserted text
+    std::vector<size_t> originalLineBreaks_;            ///< Positions of '\n' in originalBuffer_
+    std::vector<size_t> addLineBreaks_;                 ///< Positions of '\n' in addBuffer_
+
+    std::vector<Node> nodes_;                           ///< Node storage, indexed by uint32_t
+    std::vector<uint32_t> freeNodes_;                   ///< Recycled node slots
+    uint32_t root_ = kNil;                              ///< Root of the piece tree
+    uint32_t rngState_ = 0x9E3779B9u;                   ///< Xorshift state for treap priorities
+    bool empty_ = false;                                ///< True when the buffer has zero lines
+
+    mutable std::unordered_map<size_t, MaterializedLine> materialized_; ///< Lines handed out by getLine()
+    mutable std::deque<size_t> readOnlyOrder_;          ///< Lines materialized by the const getLine(), oldest first
+    mutable size_t writableLines_ = 0;                  ///< Writable entries in materialized_
+    mutable std::mutex materializedMutex_;              ///< Guards materialized_ for const readers
+
+    bool modified_ = false;
+};
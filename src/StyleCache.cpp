@@ -0,0 +1,332 @@
+#include "StyleCache.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Dead spans are only reclaimed once there are at least this many and they
+// make up half the arena, so compaction stays amortized O(1) per store
+constexpr size_t kMinDeadSpansToCompact = 4096;
+
+constexpr size_t kMaxPackedValue = std::numeric_limits<uint16_t>::max();
+
+bool fitsPacked(const std::vector<SyntaxStyle>& styles)
+{
+    if (styles.size() > kMaxPackedValue) {
+        return false;
+    }
+    for (const auto& style : styles) {
+        if (style.endCol < style.startCol || style.startCol > kMaxPackedValue ||
+            style.endCol - style.startCol > kMaxPackedValue) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+StyleCache::StyleCache()
+{
+    states_.push_back(LexerState());
+}
+
+const StyleCache::LineSlot* StyleCache::findSlot(size_t line) const
+{
+    const size_t page = line / PAGE_LINES;
+    if (page >= pages_.size() || !pages_[page]) {
+        return nullptr;
+    }
+    return &pages_[page]->slots[line % PAGE_LINES];
+}
+
+StyleCache::LineSlot& StyleCache::slotFor(size_t line)
+{
+    const size_t page = line / PAGE_LINES;
+    if (page >= pages_.size()) {
+        pages_.resize(page + 1);
+    }
+    if (!pages_[page]) {
+        pages_[page] = std::make_unique<Page>();
+    }
+    return pages_[page]->slots[line % PAGE_LINES];
+}
+
+bool StyleCache::intern(const LexerState& state, uint16_t& id)
+{
+    // A file has a handful of distinct states (mostly the default one), so
+    // a linear search beats hashing
+    for (size_t i = 0; i < states_.size(); ++i) {
+        if (states_[i] == state) {
+            id = static_cast<uint16_t>(i);
+            return true;
+        }
+    }
+    if (states_.size() > kMaxPackedValue) {
+        return false;
+    }
+    states_.push_back(state);
+    id = static_cast<uint16_t>(states_.size() - 1);
+    return true;
+}
+
+void StyleCache::release(LineSlot& slot, size_t line)
+{
+    if (!(slot.flags & LineSlot::PRESENT)) {
+        return;
+    }
+    if (slot.flags & LineSlot::WIDE) {
+        wideLines_.erase(line);
+    } else {
+        deadSpans_ += slot.spanCount;
+    }
+    slot.flags = 0;
+    slot.spanCount = 0;
+    slot.generation = 0;
+    --cachedLines_;
+    --pages_[line / PAGE_LINES]->cachedLines;
+}
+
+void StyleCache::store(size_t line, const std::vector<SyntaxStyle>& styles,
+                       const LexerState& startState, const LexerState& endState)
+{
+    LineSlot& slot = slotFor(line);
+
+    uint16_t startId = 0;
+    uint16_t endId = 0;
+    if (!intern(startState, startId) || !intern(endState, endId)) {
+        // Too many distinct states to intern; leave the line uncached
+        release(slot, line);
+        return;
+    }
+
+    const bool packed = fitsPacked(styles) && spans_.size() + styles.size() <= std::numeric_limits<uint32_t>::max();
+    const bool reuse = packed && (slot.flags & LineSlot::PRESENT) && !(slot.flags & LineSlot::WIDE) &&
+                       styles.size() <= slot.spanCount;
+
+    if (reuse) {
+        // Rewrite in place; a re-highlighted line rarely gains spans
+        deadSpans_ += slot.spanCount - styles.size();
+    } else {
+        release(slot, line);
+        ++cachedLines_;
+        ++pages_[line / PAGE_LINES]->cachedLines;
+        if (packed) {
+            slot.offset = static_cast<uint32_t>(spans_.size());
+            spans_.resize(spans_.size() + styles.size());
+        }
+    }
+
+    if (packed) {
+        PackedSpan* spans = spans_.data() + slot.offset;
+        for (size_t i = 0; i < styles.size(); ++i) {
+            spans[i].start = static_cast<uint16_t>(styles[i].startCol);
+            spans[i].length = static_cast<uint16_t>(styles[i].endCol - styles[i].startCol);
+            spans[i].color = static_cast<uint8_t>(styles[i].color);
+        }
+        slot.spanCount = static_cast<uint16_t>(styles.size());
+        slot.flags = LineSlot::PRESENT;
+    } else {
+        wideLines_[line] = styles;
+        slot.spanCount = 0;
+        slot.flags = LineSlot::PRESENT | LineSlot::WIDE;
+    }
+    slot.generation = generation_;
+    slot.startState = startId;
+    slot.endState = endId;
+    slot.referenced.store(1, std::memory_order_relaxed);
+
+    if (deadSpans_ >= kMinDeadSpansToCompact && deadSpans_ * 2 >= spans_.size()) {
+        compact();
+    }
+}
+
+bool StyleCache::contains(size_t line) const
+{
+    const LineSlot* slot = findSlot(line);
+    return slot && (slot->flags & LineSlot::PRESENT);
+}
+
+bool StyleCache::isValid(size_t line) const
+{
+    const LineSlot* slot = findSlot(line);
+    return slot && (slot->flags & LineSlot::PRESENT) && slot->generation == generation_;
+}
+
+std::vector<SyntaxStyle> StyleCache::styles(size_t line) const
+{
+    std::vector<SyntaxStyle> result;
+    const LineSlot* slot = findSlot(line);
+    if (!slot || !(slot->flags & LineSlot::PRESENT)) {
+        return result;
+    }
+    if (slot->flags & LineSlot::WIDE) {
+        auto it = wideLines_.find(line);
+        if (it != wideLines_.end()) {
+            result = it->second;
+        }
+        return result;
+    }
+
+    result.reserve(slot->spanCount);
+    const PackedSpan* spans = spans_.data() + slot->offset;
+    for (size_t i = 0; i < slot->spanCount; ++i) {
+        result.emplace_back(spans[i].start, static_cast<size_t>(spans[i].start) + spans[i].length,
+                            static_cast<SyntaxColor>(spans[i].color));
+    }
+    return result;
+}
+
+LexerState StyleCache::startState(size_t line) const
+{
+    const LineSlot* slot = findSlot(line);
+    return slot && (slot->flags & LineSlot::PRESENT) ? states_[slot->startState] : LexerState();
+}
+
+LexerState StyleCache::endState(size_t line) const
+{
+    const LineSlot* slot = findSlot(line);
+    return slot && (slot->flags & LineSlot::PRESENT) ? states_[slot->endState] : LexerState();
+}
+
+void StyleCache::touch(size_t line) const
+{
+    const LineSlot* slot = findSlot(line);
+    if (slot && (slot->flags & LineSlot::PRESENT)) {
+        slot->referenced.store(1, std::memory_order_relaxed);
+    }
+}
+
+void StyleCache::invalidate(size_t line)
+{
+    const size_t page = line / PAGE_LINES;
+    if (page < pages_.size() && pages_[page]) {
+        pages_[page]->slots[line % PAGE_LINES].generation = 0;
+    }
+}
+
+void StyleCache::invalidateAll()
+{
+    if (++generation_ != 0) {
+        return;
+    }
+
+    // The counter wrapped; stamp every slot stale so none matches by accident
+    for (auto& page : pages_) {
+        if (page) {
+            for (auto& slot : page->slots) {
+                slot.generation = 0;
+            }
+        }
+    }
+    generation_ = 1;
+}
+
+size_t StyleCache::evict(size_t targetCount, size_t keepStart, size_t keepEnd)
+{
+    const size_t lineCapacity = pages_.size() * PAGE_LINES;
+    size_t dropped = 0;
+
+    // Two turns at most: the first may only clear the bits of lines read
+    // since the previous sweep
+    for (size_t step = 0; step < 2 * lineCapacity && cachedLines_ > targetCount; ++step) {
+        if (clockHand_ >= lineCapacity) {
+            clockHand_ = 0;
+        }
+        const size_t line = clockHand_++;
+        const size_t page = line / PAGE_LINES;
+        if (!pages_[page] || pages_[page]->cachedLines == 0) {
+            // Skip the rest of an empty page
+            clockHand_ = (page + 1) * PAGE_LINES;
+            continue;
+        }
+
+        LineSlot& slot = pages_[page]->slots[line % PAGE_LINES];
+        if (!(slot.flags & LineSlot::PRESENT) || (line >= keepStart && line <= keepEnd)) {
+            continue;
+        }
+        if (slot.referenced.exchange(0, std::memory_order_relaxed)) {
+            continue;
+        }
+        release(slot, line);
+        ++dropped;
+    }
+
+    // Free pages left empty
+    for (auto& page : pages_) {
+        if (page && page->cachedLines == 0) {
+            page.reset();
+        }
+    }
+    if (deadSpans_ * 2 >= spans_.size()) {
+        compact();
+    }
+    return dropped;
+}
+
+void StyleCache::clear()
+{
+    pages_.clear();
+    spans_.clear();
+    spans_.shrink_to_fit();
+    deadSpans_ = 0;
+    states_.resize(1);
+    wideLines_.clear();
+    cachedLines_ = 0;
+    clockHand_ = 0;
+}
+
+void StyleCache::compact()
+{
+    std::vector<PackedSpan> spans;
+    spans.reserve(spans_.size() - deadSpans_);
+    for (auto& page : pages_) {
+        if (!page || page->cachedLines == 0) {
+            continue;
+        }
+        for (auto& slot : page->slots) {
+            if ((slot.flags & LineSlot::PRESENT) && !(slot.flags & LineSlot::WIDE)) {
+                const uint32_t offset = static_cast<uint32_t>(spans.size());
+                spans.insert(spans.end(), spans_.begin() + slot.offset,
+                             spans_.begin() + slot.offset + slot.spanCount);
+                slot.offset = offset;
+            }
+        }
+    }
+    spans_.swap(spans);
+    deadSpans_ = 0;
+}
+
+size_t StyleCache::validLineCount() const
+{
+    size_t count = 0;
+    for (const auto& page : pages_) {
+        if (!page || page->cachedLines == 0) {
+            continue;
+        }
+        for (const auto& slot : page->slots) {
+            if ((slot.flags & LineSlot::PRESENT) && slot.generation == generation_) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+size_t StyleCache::memoryUsage() const
+{
+    size_t bytes = sizeof(*this);
+    bytes += pages_.capacity() * sizeof(pages_[0]);
+    for (const auto& page : pages_) {
+        if (page) {
+            bytes += sizeof(Page);
+        }
+    }
+    bytes += spans_.capacity() * sizeof(PackedSpan);
+    bytes += states_.capacity() * sizeof(LexerState);
+    for (const auto& entry : wideLines_) {
+        // Hash node plus the unpacked styles
+        bytes += sizeof(entry) + 2 * sizeof(void*) + entry.second.capacity() * sizeof(SyntaxStyle);
+    }
+    return bytes;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "SyntaxHighlighter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Compact per-line cache of highlighting styles
+ *
+ * Spans of all lines are packed into one arena (16-bit start and length,
+ * 8-bit color) and each line owns a 16-byte slot holding its offset into the
+ * arena, a generation stamp, interned lexer states and a clock bit.
+ * Invalidating every line bumps the generation instead of touching the
+ * slots, and eviction sweeps a clock hand that skips lines read since its
+ * last pass. Lines with columns beyond 16 bits are kept unpacked on the side.
+ *
+ * Not synchronized: the owner serializes writers. touch() and the const
+ * queries may run concurrently with each other.
+ */
+class StyleCache {
+public:
+    StyleCache();
+
+    // Copying would have to duplicate the clock bits; the owner never needs it
+    StyleCache(const StyleCache&) = delete;
+    StyleCache& operator=(const StyleCache&) = delete;
+
+    /**
+     * @brief Store the styles of a line, replacing any cached ones
+     *
+     * @param line The line index
+     * @param styles The line's styles
+     * @param startState The lexer state the line was highlighted from
+     * @param endState The lexer state the line ended in
+     */
+    void store(size_t line, const std::vector<SyntaxStyle>& styles,
+               const LexerState& startState, const LexerState& endState);
+
+    // Whether a line has cached styles, current or not
+    bool contains(size_t line) const;
+
+    // Whether a line has cached styles that have not been invalidated
+    bool isValid(size_t line) const;
+
+    // Unpack the cached styles of a line; empty if it has none
+    std::vector<SyntaxStyle> styles(size_t line) const;
+
+    // Lexer states of a cached line; the default state if it has none
+    LexerState startState(size_t line) const;
+    LexerState endState(size_t line) const;
+
+    // Mark a line as read, so the next eviction sweep passes over it
+    void touch(size_t line) const;
+
+    // Mark the styles of one line, or of every line, as stale
+    void invalidate(size_t line);
+    void invalidateAll();
+
+    /**
+     * @brief Drop cached lines until at most targetCount remain
+     *
+     * Lines in [keepStart, keepEnd] are never dropped. A line read since the
+     * clock hand last passed it loses its bit and gets a second chance.
+     *
+     * @return The number of lines dropped
+     */
+    size_t evict(size_t targetCount, size_t keepStart, size_t keepEnd);
+
+    // Drop everything
+    void clear();
+
+    // Lines with cached styles, current or not
+    size_t cachedLineCount() const { return cachedLines_; }
+
+    // Lines with current styles
+    size_t validLineCount() const;
+
+    // Bytes held by the cache
+    size_t memoryUsage() const;
+
+private:
+    struct PackedSpan {
+        uint16_t start;
+        uint16_t length;
+        uint8_t color;
+    };
+
+    struct LineSlot {
+        enum Flags : uint8_t {
+            PRESENT = 1 << 0,  // Styles are cached
+            WIDE    = 1 << 1   // Styles live in wideLines_ instead of the arena
+        };
+
+        uint32_t offset = 0;      // First span in the arena
+        uint32_t generation = 0;  // Generation the styles were stored in; 0 once invalidated
+        uint16_t spanCount = 0;
+        uint16_t startState = 0;  // Index into states_
+        uint16_t endState = 0;
+        uint8_t flags = 0;
+        mutable std::atomic<uint8_t> referenced{0};
+    };
+
+    // Slots are allocated a page at a time, so a large file with a few
+    // screens cached pays only for the pages around them
+    static constexpr size_t PAGE_LINES = 1024;
+
+    struct Page {
+        LineSlot slots[PAGE_LINES];
+        size_t cachedLines = 0;
+    };
+
+    const LineSlot* findSlot(size_t line) const;
+    LineSlot& slotFor(size_t line);
+    bool intern(const LexerState& state, uint16_t& id);
+    void release(LineSlot& slot, size_t line);
+    void compact();
+
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<PackedSpan> spans_;
+    size_t deadSpans_ = 0;
+
+    // Distinct lexer states; index 0 is the default state
+    std::vector<LexerState> states_;
+
+    // Styles of lines that do not fit the packed layout
+    std::unordered_map<size_t, std::vector<SyntaxStyle>> wideLines_;
+
+    uint32_t generation_ = 1;
+    size_t cachedLines_ = 0;
+    size_t clockHand_ = 0;
+};
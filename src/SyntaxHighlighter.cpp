@@ -7,6 +7,7 @@
 #include <algorithm> // For std::sort and potentially std::min
 #include <regex> // For std::regex and std::smatch
 #include <memory> // Required for std::unique_ptr
+#include <cstring>
 #include "EditorError.h"
 
 // Add static debug flag for SyntaxHighlighter
@@ -37,6 +38,444 @@ static std::string trimTrailingWhitespace(const std::string& str) {
     return str.substr(0, end + 1);
 }
 
+// --- KeywordTable ---
+
+uint32_t KeywordTable::hash(const char* word, size_t length, uint32_t seed) {
+    // FNV-1a with the seed folded into the offset basis
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(word[i]);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+void KeywordTable::addWords(const std::vector<std::string>& words, SyntaxColor color) {
+    SyntaxColor existing;
+    for (const auto& word : words) {
+        if (!find(word.data(), word.size(), existing)) {
+            entries_.push_back({word, color});
+            rebuild();
+        }
+    }
+}
+
+void KeywordTable::rebuild() {
+    // Try seeds until every word hashes to its own slot, growing the table
+    // when a size keeps colliding. Tables hold a few dozen words, so this
+    // settles within a few thousand slots.
+    size_t size = 16;
+    while (size < entries_.size() * 4) {
+        size <<= 1;
+    }
+    
+    for (;; size <<= 1) {
+        std::vector<int32_t> slots(size);
+        for (uint32_t seed = 1; seed <= 256; ++seed) {
+            std::fill(slots.begin(), slots.end(), -1);
+            bool collision = false;
+            for (size_t i = 0; i < entries_.size() && !collision; ++i) {
+                const std::string& word = entries_[i].word;
+                int32_t& slot = slots[hash(word.data(), word.size(), seed) & (size - 1)];
+                collision = slot != -1;
+                slot = static_cast<int32_t>(i);
+            }
+            if (!collision) {
+                slots_ = std::move(slots);
+                seed_ = seed;
+                mask_ = static_cast<uint32_t>(size - 1);
+                return;
+            }
+        }
+    }
+}
+
+bool KeywordTable::find(const char* word, size_t length, SyntaxColor& color) const {
+    if (slots_.empty()) {
+        return false;
+    }
+    
+    int32_t index = slots_[hash(word, length, seed_) & mask_];
+    if (index < 0) {
+        return false;
+    }
+    
+    const Entry& entry = entries_[index];
+    if (entry.word.size() != length || std::memcmp(entry.word.data(), word, length) != 0) {
+        return false;
+    }
+    color = entry.color;
+    return true;
+}
+
+// --- Scanners for PatternBasedHighlighter rules ---
+// These follow ECMAScript regex semantics in the "C" locale, which is what
+// std::regex used for the same patterns.
+
+static inline bool isWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool isDigitChar(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// \b at pos: a word character on exactly one side
+static inline bool isWordBoundary(const std::string& s, size_t pos) {
+    bool before = pos > 0 && isWordChar(s[pos - 1]);
+    bool after = pos < s.length() && isWordChar(s[pos]);
+    return before != after;
+}
+
+static inline size_t skipDigits(const std::string& s, size_t pos) {
+    while (pos < s.length() && isDigitChar(s[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+static inline size_t skipWordChars(const std::string& s, size_t pos) {
+    while (pos < s.length() && isWordChar(s[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+// ([uUlLfF]|[eE][-+]?[0-9]+)?\b from pos, trying the alternatives in the
+// order the regex would. Returns the match end, or npos.
+static size_t matchNumberSuffix(const std::string& s, size_t pos) {
+    const size_t n = s.length();
+    if (pos < n) {
+        const char c = s[pos];
+        if ((c == 'u' || c == 'U' || c == 'l' || c == 'L' || c == 'f' || c == 'F') && isWordBoundary(s, pos + 1)) {
+            return pos + 1;
+        }
+        if (c == 'e' || c == 'E') {
+            for (int withSign = 1; withSign >= 0; --withSign) {
+                size_t digitsStart = pos + 1;
+                if (withSign) {
+                    if (digitsStart >= n || (s[digitsStart] != '-' && s[digitsStart] != '+')) {
+                        continue;
+                    }
+                    ++digitsStart;
+                }
+                for (size_t end = skipDigits(s, digitsStart); end > digitsStart; --end) {
+                    if (isWordBoundary(s, end)) {
+                        return end;
+                    }
+                }
+            }
+        }
+    }
+    return isWordBoundary(s, pos) ? pos : std::string::npos;
+}
+
+// ([0-9]+(\.[0-9]*)?|\.[0-9]+) followed by the suffix, at pos. The caller
+// has checked the leading \b. Returns the match end, or npos.
+static size_t matchNumber(const std::string& s, size_t pos) {
+    const size_t n = s.length();
+    if (isDigitChar(s[pos])) {
+        for (size_t intEnd = skipDigits(s, pos); intEnd > pos; --intEnd) {
+            if (intEnd < n && s[intEnd] == '.') {
+                for (size_t fracEnd = skipDigits(s, intEnd + 1); fracEnd > intEnd; --fracEnd) {
+                    size_t end = matchNumberSuffix(s, fracEnd);
+                    if (end != std::string::npos) {
+                        return end;
+                    }
+                }
+            }
+            size_t end = matchNumberSuffix(s, intEnd);
+            if (end != std::string::npos) {
+                return end;
+            }
+        }
+    } else if (s[pos] == '.') {
+        for (size_t fracEnd = skipDigits(s, pos + 1); fracEnd > pos + 1; --fracEnd) {
+            size_t end = matchNumberSuffix(s, fracEnd);
+            if (end != std::string::npos) {
+                return end;
+            }
+        }
+    }
+    return std::string::npos;
+}
+
+// q(?:[^q\\]|\\.)*q at pos for the quote character q. Every character has
+// exactly one way to match, so no backtracking is needed. Returns the match
+// end, or npos.
+static size_t matchQuoted(const std::string& s, size_t pos, char quote) {
+    const size_t n = s.length();
+    size_t current = pos + 1;
+    while (current < n) {
+        const char c = s[current];
+        if (c == quote) {
+            return current + 1;
+        }
+        if (c == '\\') {
+            // '.' does not match line terminators
+            if (current + 1 >= n || s[current + 1] == '\n' || s[current + 1] == '\r') {
+                return std::string::npos;
+            }
+            current += 2;
+        } else {
+            ++current;
+        }
+    }
+    return std::string::npos;
+}
+
+// Recognize \b(word|word|...)\b or \bword\b where every word is made of word
+// characters. Such a pattern matches exactly the whole words it lists, which
+// a keyword table can look up without a regex.
+static bool parseKeywordPattern(const std::string& pattern, std::vector<std::string>& words) {
+    if (pattern.size() < 5 || pattern.compare(0, 2, "\\b") != 0 ||
+        pattern.compare(pattern.size() - 2, 2, "\\b") != 0) {
+        return false;
+    }
+    
+    std::string body = pattern.substr(2, pattern.size() - 4);
+    if (body.size() >= 2 && body.front() == '(' && body.back() == ')') {
+        body = body.substr(1, body.size() - 2);
+    }
+    
+    words.clear();
+    size_t start = 0;
+    while (start <= body.size()) {
+        size_t end = body.find('|', start);
+        if (end == std::string::npos) {
+            end = body.size();
+        }
+        std::string word = body.substr(start, end - start);
+        if (word.empty() || !std::all_of(word.begin(), word.end(), isWordChar)) {
+            return false;
+        }
+        words.push_back(word);
+        start = end + 1;
+    }
+    return !words.empty();
+}
+
+// --- PatternBasedHighlighter ---
+
+void PatternBasedHighlighter::addPattern(const std::string& patternStr, SyntaxColor color, [[maybe_unused]] HighlightCategory category) {
+    logDebug("PatternBasedHighlighter::addPattern for '" + languageName_ + "' with pattern: \"" + 
+            patternStr.substr(0, std::min(size_t(50), patternStr.length())) + 
+            (patternStr.length() > 50 ? "..." : "") + "\"");
+    try {
+        std::vector<std::string> words;
+        if (parseKeywordPattern(patternStr, words)) {
+            WRITE_LOCK(patterns_mutex_);
+            addKeywords_nolock(words, color);
+            return;
+        }
+        
+        std::regex regex(patternStr);
+        WRITE_LOCK(patterns_mutex_);
+        regexes_.push_back(std::move(regex));
+        rules_.push_back({Rule::Kind::REGEX, TokenRule::IDENTIFIER, color, regexes_.size() - 1});
+    } catch (const std::regex_error& regex_ex) {
+        ErrorReporter::logError("PatternBasedHighlighter::addPattern - Regex error: " + 
+                                std::string(regex_ex.what()) + " for pattern: " + patternStr);
+        ErrorReporter::logException(SyntaxHighlightingException(
+            std::string("PatternBasedHighlighter::addPattern: Invalid regex '") + 
+            patternStr + "': " + regex_ex.what(), 
+            EditorException::Severity::EDITOR_ERROR));
+    } catch (const EditorException& ed_ex) {
+        ErrorReporter::logException(ed_ex);
+    } catch (const std::exception& ex) {
+        ErrorReporter::logException(SyntaxHighlightingException(
+            std::string("PatternBasedHighlighter::addPattern: ") + ex.what(), 
+            EditorException::Severity::EDITOR_ERROR));
+    } catch (...) {
+        ErrorReporter::logUnknownException("PatternBasedHighlighter::addPattern");
+    }
+}
+
+void PatternBasedHighlighter::addKeywords_nolock(const std::vector<std::string>& words, SyntaxColor color) {
+    // Consecutive keyword rules share one table: a word listed by an earlier
+    // rule keeps its color, just as the earlier rule would have styled it first
+    if (rules_.empty() || rules_.back().kind != Rule::Kind::KEYWORDS) {
+        keywordTables_.emplace_back();
+        rules_.push_back({Rule::Kind::KEYWORDS, TokenRule::IDENTIFIER, color, keywordTables_.size() - 1});
+    }
+    keywordTables_[rules_.back().index].addWords(words, color);
+}
+
+void PatternBasedHighlighter::addTokenRule(TokenRule rule, SyntaxColor color, [[maybe_unused]] HighlightCategory category) {
+    WRITE_LOCK(patterns_mutex_);
+    rules_.push_back({Rule::Kind::TOKEN, rule, color, 0});
+}
+
+void PatternBasedHighlighter::addPreprocessorDirectives(const std::vector<std::string>& directives, SyntaxColor color,
+                                                        [[maybe_unused]] HighlightCategory category) {
+    WRITE_LOCK(patterns_mutex_);
+    keywordTables_.emplace_back();
+    keywordTables_.back().addWords(directives, color);
+    rules_.push_back({Rule::Kind::DIRECTIVES, TokenRule::IDENTIFIER, color, keywordTables_.size() - 1});
+}
+
+std::unique_ptr<std::vector<SyntaxStyle>> PatternBasedHighlighter::highlightLine(const std::string& line, [[maybe_unused]] size_t lineIndex) const {
+    if (isDebugLoggingEnabled()) {
+        logDebug("PatternBasedHighlighter::highlightLine for '" + languageName_ + "' on line: \"" + 
+                line.substr(0, std::min(size_t(50), line.length())) + 
+                (line.length() > 50 ? "..." : "") + "\"");
+    }
+    auto styles = std::make_unique<std::vector<SyntaxStyle>>();
+    
+    try {
+        READ_LOCK(patterns_mutex_);
+        
+        // Keep track of which positions have already been styled
+        std::vector<char> positionStyled(line.length(), 0);
+        
+        // Style a match unless an earlier rule already styled part of it
+        auto addMatch = [&](size_t startCol, size_t endCol, SyntaxColor color) {
+            for (size_t i = startCol; i < endCol; ++i) {
+                if (positionStyled[i]) {
+                    return;
+                }
+            }
+            styles->push_back(SyntaxStyle(startCol, endCol, color));
+            std::fill(positionStyled.begin() + startCol, positionStyled.begin() + endCol, 1);
+        };
+        
+        const size_t n = line.length();
+        
+        // Apply each rule to the line
+        for (const Rule& rule : rules_) {
+            switch (rule.kind) {
+            case Rule::Kind::KEYWORDS: {
+                // Only whole words can match \b(word|...)\b
+                const KeywordTable& table = keywordTables_[rule.index];
+                size_t pos = 0;
+                while (pos < n) {
+                    if (!isWordChar(line[pos])) {
+                        ++pos;
+                        continue;
+                    }
+                    size_t end = skipWordChars(line, pos);
+                    SyntaxColor color;
+                    if (table.find(line.data() + pos, end - pos, color)) {
+                        addMatch(pos, end, color);
+                    }
+                    pos = end;
+                }
+                break;
+            }
+            case Rule::Kind::DIRECTIVES: {
+                size_t pos = 0;
+                while (pos < n && isSpaceChar(line[pos])) {
+                    ++pos;
+                }
+                if (pos >= n || line[pos] != '#') {
+                    break;
+                }
+                ++pos;
+                while (pos < n && isSpaceChar(line[pos])) {
+                    ++pos;
+                }
+                size_t end = skipWordChars(line, pos);
+                SyntaxColor color;
+                if (end > pos && keywordTables_[rule.index].find(line.data() + pos, end - pos, color)) {
+                    addMatch(0, end, color);
+                }
+                break;
+            }
+            case Rule::Kind::TOKEN: {
+                size_t pos = 0;
+                while (pos < n) {
+                    const char c = line[pos];
+                    size_t end = std::string::npos;
+                    switch (rule.token) {
+                    case TokenRule::NUMBER:
+                        if ((isDigitChar(c) || c == '.') && isWordBoundary(line, pos)) {
+                            end = matchNumber(line, pos);
+                        }
+                        break;
+                    case TokenRule::CHAR_LITERAL:
+                        if (c == '\'') {
+                            end = matchQuoted(line, pos, '\'');
+                        }
+                        break;
+                    case TokenRule::STRING_LITERAL:
+                        if (c == '"') {
+                            end = matchQuoted(line, pos, '"');
+                        }
+                        break;
+                    case TokenRule::FUNCTION_NAME:
+                        if (isWordChar(c)) {
+                            // Only a whole word can be followed by \s*\(
+                            size_t wordEnd = skipWordChars(line, pos);
+                            if (!isDigitChar(c) && isWordBoundary(line, pos)) {
+                                size_t next = wordEnd;
+                                while (next < n && isSpaceChar(line[next])) {
+                                    ++next;
+                                }
+                                if (next < n && line[next] == '(') {
+                                    end = wordEnd;
+                                }
+                            }
+                            if (end == std::string::npos) {
+                                pos = wordEnd;
+                                continue;
+                            }
+                        }
+                        break;
+                    case TokenRule::IDENTIFIER:
+                        if (isWordChar(c) && !isDigitChar(c)) {
+                            end = skipWordChars(line, pos);
+                        }
+                        break;
+                    }
+                    
+                    if (end != std::string::npos) {
+                        addMatch(pos, end, rule.color);
+                        pos = end;
+                    } else {
+                        ++pos;
+                    }
+                }
+                break;
+            }
+            case Rule::Kind::REGEX: {
+                std::sregex_iterator it(line.begin(), line.end(), regexes_[rule.index]);
+                std::sregex_iterator end;
+                for (; it != end; ++it) {
+                    const std::smatch& match = *it;
+                    if (match.length(0) == 0) { // Prevent issues with zero-length matches
+                        continue;
+                    }
+                    size_t startCol = match.position();
+                    addMatch(startCol, startCol + match.length(), rule.color);
+                }
+                break;
+            }
+            }
+        }
+    } catch (const EditorException& ed_ex) {
+        ErrorReporter::logException(ed_ex);
+    } catch (const std::exception& ex) {
+        ErrorReporter::logException(SyntaxHighlightingException(
+            std::string("PatternBasedHighlighter::highlightLine: ") + ex.what(), 
+            EditorException::Severity::EDITOR_ERROR));
+    } catch (...) {
+        ErrorReporter::logUnknownException("PatternBasedHighlighter::highlightLine");
+    }
+    
+    // Sort styles by start position for rendering 
+    // (this shouldn't affect the precedence since we already filtered out overlaps)
+    std::sort(styles->begin(), styles->end(), 
+              [](const SyntaxStyle& a, const SyntaxStyle& b) {
+                  return a.startCol < b.startCol;
+              });
+    
+    return styles;
+}
+
 // Implementation of PatternBasedHighlighter::highlightBuffer
 std::vector<std::vector<SyntaxStyle>> PatternBasedHighlighter::highlightBuffer(
     const ITextBuffer& buffer) const {
@@ -224,6 +663,22 @@ static size_t findCharEnd(const std::string& line, size_t startPos) {
     return line.length(); 
 }
 
+// Length of the raw string prefix R"delimiter( at pos, or 0 if there is none.
+// The delimiter is up to 16 characters other than parentheses, backslash and
+// whitespace.
+static size_t matchRawStringPrefix(const std::string& s, size_t pos) {
+    if (pos + 2 >= s.length() || s[pos] != 'R' || s[pos + 1] != '"') {
+        return 0;
+    }
+    size_t current = pos + 2;
+    const size_t limit = std::min(s.length(), current + LexerState::MAX_DELIMITER_LENGTH);
+    while (current < limit && !isSpaceChar(s[current]) &&
+           s[current] != '(' && s[current] != ')' && s[current] != '\\') {
+        ++current;
+    }
+    return (current < s.length() && s[current] == '(') ? current + 1 - pos : 0;
+}
+
 void CppHighlighter::findNextStatefulToken(const std::string& segment, size_t& outNextTokenPos, NextTokenType& outTokenType) const {
     outNextTokenPos = std::string::npos;
     outTokenType = NextTokenType::UNKNOWN;
@@ -234,14 +689,13 @@ void CppHighlighter::findNextStatefulToken(const std::string& segment, size_t& o
     size_t stringPos = segment.find("\""); // Standard string
     size_t charPos = segment.find("'");
 
-    // Regex for raw string prefix: R"(delimiter?(
-    // Delimiter can be 0-16 chars, not containing '(', ')', '\\', or whitespace.
-    // std::regex rawStringRegex("R\\\"\\("); // SIMPLIFIED REGEX for R"(
-    std::regex rawStringRegex(R"#(R"([^\s()\\]{0,16})\()#"); // Full regex using C++ Raw String Literal
-    std::smatch rawStringMatch;
+    // Raw string prefix: R"delimiter(
     size_t rawStringStartPos = std::string::npos;
-    if (std::regex_search(segment, rawStringMatch, rawStringRegex)) {
-        rawStringStartPos = rawStringMatch.position(0);
+    for (size_t pos = segment.find("R\""); pos != std::string::npos; pos = segment.find("R\"", pos + 1)) {
+        if (matchRawStringPrefix(segment, pos) > 0) {
+            rawStringStartPos = pos;
+            break;
+        }
     }
 
     // Next, determine the first occurring token with proper nesting behavior
@@ -320,10 +774,7 @@ void CppHighlighter::findNextStatefulToken(const std::string& segment, size_t& o
 }
 
 void CppHighlighter::appendBaseStyles(std::vector<SyntaxStyle>& existingStyles, const std::string& subLine, size_t offset) const {
-    logDebug("CppHL::appendBaseStyles - Segment: '" + subLine + "', Offset: " + std::to_string(offset));
-    
     if (subLine.empty()) {
-        logDebug("CppHL::appendBaseStyles - Segment empty, returning.");
         return;
     }
     
@@ -334,15 +785,14 @@ void CppHighlighter::appendBaseStyles(std::vector<SyntaxStyle>& existingStyles,
         segmentStyles = std::move(*segmentStylesPtr);
     }
 
-    std::string debugOutput = "CppHL::appendBaseStyles - Got " + std::to_string(segmentStyles.size()) + 
-                             " styles from PatternBasedHighlighter for segment '" + subLine + "'";
-    logDebug(debugOutput);
-    
-    for (const auto& s_style : segmentStyles) {
-        std::string styleInfo = "  Raw Style: (" + std::to_string(s_style.startCol) + "," + 
-                              std::to_string(s_style.endCol) + ") Color: " + 
-                              std::to_string(static_cast<int>(s_style.color));
-        logDebug(styleInfo);
+    if (isDebugLoggingEnabled()) {
+        logDebug("CppHL::appendBaseStyles - Got " + std::to_string(segmentStyles.size()) + 
+                 " styles from PatternBasedHighlighter for segment '" + subLine + "', Offset: " + std::to_string(offset));
+        for (const auto& s_style : segmentStyles) {
+            logDebug("  Raw Style: (" + std::to_string(s_style.startCol) + "," + 
+                     std::to_string(s_style.endCol) + ") Color: " + 
+                     std::to_string(static_cast<int>(s_style.color)));
+        }
     }
 
     for (const auto& s_style : segmentStyles) {
@@ -373,59 +823,53 @@ void CppHighlighter::appendBaseStyles(std::vector<SyntaxStyle>& existingStyles,
 }
 
 std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const std::string& line, size_t lineIndex) const {
+    // Carry the state over from the previous line only if that is the line
+    // highlighted last; otherwise start fresh
+    LexerState state;
+    if (lineIndex > 0 && lastProcessedLineIndex_ == lineIndex - 1) {
+        state = lastLineState_;
+    }
+    lastProcessedLineIndex_ = lineIndex;
+    
+    auto styles = highlightLineFrom(line, lineIndex, state);
+    lastLineState_ = state;
+    return styles;
+}
+
+std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLineFrom(
+    const std::string& line, size_t lineIndex, LexerState& state) const {
+    // Unpack the state the line starts in; it is packed again at the end
+    bool isInBlockComment = state.has(LexerState::IN_BLOCK_COMMENT);
+    bool isInRawString = state.has(LexerState::IN_RAW_STRING);
+    std::string rawStringDelimiter = state.rawStringDelimiter();
+    bool isInString = state.has(LexerState::IN_STRING);
+    bool isInChar = state.has(LexerState::IN_CHAR);
+    bool isInMacroContinuation = state.has(LexerState::IN_MACRO_CONTINUATION);
+    
     // Debug output to understand the state
-    logDebug("CppHighlighter::highlightLine - Line: '" + line + "', Index: " + std::to_string(lineIndex) + ", isInBlockComment: " + (isInBlockComment_ ? "true" : "false"));
+    if (isDebugLoggingEnabled()) {
+        logDebug("CppHighlighter::highlightLineFrom - Line: '" + line + "', Index: " + std::to_string(lineIndex) + ", isInBlockComment: " + (isInBlockComment ? "true" : "false"));
+    }
 
     // Check for line ending with backslash - needs to happen before other processing
     std::string trimmedLine = trimTrailingWhitespace(line);
     bool lineEndsWithBackslash = !trimmedLine.empty() && trimmedLine.back() == '\\';
     
-    // Special handling for macro continuations
-    // If the previous line ended with a backslash and this line is the next sequential line,
-    // we treat this line as part of the macro continuation
-    if (isInMacroContinuation_ && lineIndex > 0 && lastProcessedLineIndex_ == lineIndex - 1) {
-        // Set the "last processed line" to the current line
-        lastProcessedLineIndex_ = lineIndex;
-        
-        // Check if this line also continues the macro
-        isInMacroContinuation_ = lineEndsWithBackslash;
-        
-        // Instead of returning an empty vector, process the line normally but track that we're in a continuation
-        // We want syntax highlighting to work on continuation lines
+    // Special handling for macro continuations: if the previous line ended
+    // with a backslash, this line is part of the macro. Check whether it
+    // continues the macro too; it is still highlighted normally.
+    if (isInMacroContinuation) {
+        isInMacroContinuation = lineEndsWithBackslash;
     }
     
-    // Reset the statement block states for non-continuation lines
-    if (lineIndex == 0 || lastProcessedLineIndex_ != lineIndex - 1) {
-        isInBlockComment_ = false;
-        isInString_ = false;
-        isInChar_ = false;
-        isInRawString_ = false;
-        rawStringDelimiter_.clear();
-        isInMacroContinuation_ = false;
-    }
-    
-    // Track that we've processed this line
-    lastProcessedLineIndex_ = lineIndex;
-    
     std::vector<SyntaxStyle> styles;
     size_t currentPos = 0;
 
-    // If the line ended mid-raw-string, the next line continues that raw string.
-    // (Raw string logic comes before other stateful tokens like comments)
-    if (isInRawString_ && lineIndex > 0 && lastProcessedLineIndex_ == lineIndex - 1) {
-        isInRawString_ = false; // Raw string processing ends with this line
-    }
-
-    // Explicitly clear 'styles' before checking for macro continuation, as a desperate measure.
-    styles.clear(); 
-
     // Check if this is the first line of a preprocessor directive
-    // bool isPreprocessorDirective = false;  // Remove this line if it's not used or defined elsewhere
-    if (!isInMacroContinuation_ && line.length() > 0) {
+    if (!isInMacroContinuation && line.length() > 0) {
         // Find the first non-whitespace character
         size_t nonWhitespacePos = line.find_first_not_of(" \t");
         if (nonWhitespacePos != std::string::npos && line[nonWhitespacePos] == '#') {
-            // isPreprocessorDirective = true;
             // Add style for the preprocessor directive
             size_t directiveEnd = line.find_first_of(" \t", nonWhitespacePos + 1);
             if (directiveEnd == std::string::npos) directiveEnd = line.length();
@@ -433,7 +877,7 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
             
             // Check if line ends with backslash to start continuation
             if (lineEndsWithBackslash) {
-                isInMacroContinuation_ = true;
+                isInMacroContinuation = true;
             }
         }
     }
@@ -441,33 +885,33 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
     while (currentPos < line.length()) {
         size_t segmentStartPos = currentPos; // Start of the segment we might pass to appendBaseStyles
 
-        if (isInBlockComment_) {
+        if (isInBlockComment) {
             size_t commentEndPos = line.find("*/", currentPos);
             if (commentEndPos != std::string::npos) {
                 styles.push_back(SyntaxStyle(currentPos, commentEndPos + 2, SyntaxColor::Comment));
                 currentPos = commentEndPos + 2;
-                isInBlockComment_ = false;
+                isInBlockComment = false;
             } else {
                 styles.push_back(SyntaxStyle(currentPos, line.length(), SyntaxColor::Comment));
                 currentPos = line.length();
-                // isInBlockComment_ remains true
+                // isInBlockComment remains true
             }
             continue; // Styled this segment as comment, restart loop
-        } else if (isInRawString_) {
-            std::string terminator = ")" + rawStringDelimiter_ + "\"";
+        } else if (isInRawString) {
+            std::string terminator = ")" + rawStringDelimiter + "\"";
             size_t rawStringEndPos = line.find(terminator, currentPos);
             if (rawStringEndPos != std::string::npos) {
                 styles.push_back(SyntaxStyle(currentPos, rawStringEndPos + terminator.length(), SyntaxColor::String));
                 currentPos = rawStringEndPos + terminator.length();
-                isInRawString_ = false;
-                rawStringDelimiter_.clear();
+                isInRawString = false;
+                rawStringDelimiter.clear();
             } else {
                 styles.push_back(SyntaxStyle(currentPos, line.length(), SyntaxColor::String));
                 currentPos = line.length();
-                // isInRawString_ and rawStringDelimiter_ remain for next line
+                // isInRawString and rawStringDelimiter remain for next line
             }
             continue; // Styled this segment as raw string, restart loop
-        } else if (isInString_) {
+        } else if (isInString) {
             size_t stringEndPos = findStringEnd(line, currentPos); // findStringEnd expects pos *after* opening quote
             // For a continued string, currentPos is 0. The original opening quote was on a previous line.
             // We need to find the end from currentPos.
@@ -476,23 +920,23 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
             styles.push_back(SyntaxStyle(currentPos, actualStringEndPos, SyntaxColor::String));
             currentPos = actualStringEndPos;
             if (actualStringEndPos < line.length() || (actualStringEndPos == line.length() && line.back() == '"' && (line.length() < 2 || line[line.length()-2] != '\\'))) { // Properly terminated
-                 isInString_ = false;
-            } // else: isInString_ remains true for next line
+                 isInString = false;
+            } // else: isInString remains true for next line
             continue;
-        } else if (isInChar_) {
+        } else if (isInChar) {
             // Similar logic for continued char, though less common.
             // Assuming a char literal can't legitimately span lines for highlighting simplicity.
-            // If isInChar_ is true, it implies an unterminated char from previous line. Style as error/default.
-            // For this iteration, we'll assume if isInChar_ is true, it's an error from previous line.
+            // If isInChar is true, it implies an unterminated char from previous line. Style as error/default.
+            // For this iteration, we'll assume if isInChar is true, it's an error from previous line.
             // The first char of this line is part of that unterminated char.
             // This state should ideally be cleared if line starts fresh.
             // The current resetStateForNewLine should handle this.
-            // If still in isInChar_ it means it was unterminated on the *previous* line.
+            // If still in isInChar it means it was unterminated on the *previous* line.
             // We'll treat the start of this line as default and reset isInChar.
             // This simplification might need review for very complex char literal error handling.
             appendBaseStyles(styles, line.substr(currentPos, 1), currentPos); // Style first char as default
             currentPos++;
-            isInChar_ = false; // Assume error state ends here for this line
+            isInChar = false; // Assume error state ends here for this line
             continue;
         }
 
@@ -516,43 +960,40 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
                 if (commentEndPos != std::string::npos) {
                     styles.push_back(SyntaxStyle(currentPos, commentEndPos + 2, SyntaxColor::Comment));
                     currentPos = commentEndPos + 2;
-                    // isInBlockComment_ remains false
+                    // isInBlockComment remains false
                 } else {
                     styles.push_back(SyntaxStyle(currentPos, line.length(), SyntaxColor::Comment));
                     currentPos = line.length();
-                    isInBlockComment_ = true;
+                    isInBlockComment = true;
                 }
             } else if (tokenType == NextTokenType::LINE_COMMENT) {
                 styles.push_back(SyntaxStyle(currentPos, line.length(), SyntaxColor::Comment));
                 currentPos = line.length();
             } else if (tokenType == NextTokenType::RAW_STRING) {
                 // New raw string found
-                std::regex rawStringRegex(R"#(R"([^\s()\\]{0,16})\()#"); // Full regex using C++ Raw String Literal
-                std::smatch match;
-                std::string segmentForRegex = line.substr(currentPos);
-
-                if (std::regex_search(segmentForRegex, match, rawStringRegex) && match.position(0) == 0) {
-                    rawStringDelimiter_ = match.str(1);
-                    isInRawString_ = true;
-                    size_t prefixLength = match.length(0);
+                size_t prefixLength = matchRawStringPrefix(line, currentPos);
+
+                if (prefixLength > 0) {
+                    rawStringDelimiter = line.substr(currentPos + 2, prefixLength - 3);
+                    isInRawString = true;
                     styles.push_back(SyntaxStyle(currentPos, currentPos + prefixLength, SyntaxColor::String));
                     currentPos += prefixLength;
 
                     // Now look for the terminator on the same line
-                    std::string terminator = ")" + rawStringDelimiter_ + "\"";
+                    std::string terminator = ")" + rawStringDelimiter + "\"";
                     size_t rawStringEndPosInRemainder = line.substr(currentPos).find(terminator);
 
                     if (rawStringEndPosInRemainder != std::string::npos) {
                         // Terminator found on the same line
                         styles.push_back(SyntaxStyle(currentPos, currentPos + rawStringEndPosInRemainder + terminator.length(), SyntaxColor::String));
                         currentPos += rawStringEndPosInRemainder + terminator.length();
-                        isInRawString_ = false;
-                        rawStringDelimiter_.clear();
+                        isInRawString = false;
+                        rawStringDelimiter.clear();
                     } else {
                         // Unterminated on this line
                         styles.push_back(SyntaxStyle(currentPos, line.length(), SyntaxColor::String));
                         currentPos = line.length();
-                        // isInRawString_ remains true, rawStringDelimiter_ is set
+                        // isInRawString remains true, rawStringDelimiter is set
                     }
                 } else {
                     // This case should ideally not be hit if findNextStatefulToken worked correctly
@@ -575,9 +1016,9 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
                 
                 currentPos = stringEndPos;
                 if (stringEndPos == line.length() && (line.empty() || line.back() != '"' || (line.length() >= 2 && line[line.length()-2] == '\\'))) { // Unterminated
-                    isInString_ = true;
+                    isInString = true;
                 } else {
-                    isInString_ = false; // Terminated on this line
+                    isInString = false; // Terminated on this line
                 }
             } else if (tokenType == NextTokenType::CHAR) {
                 size_t actualOpeningQuotePos = currentPos;
@@ -587,15 +1028,15 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
                 currentPos = charEndPos;
 
                 if (charEndPos == line.length() && (line.empty() || line.back() != '\'' || (line.length() >=2 && line[line.length()-2] == '\\'))) { // Unterminated
-                    isInChar_ = true;
+                    isInChar = true;
                 } else if (charEndPos == actualOpeningQuotePos + 1) { // Empty char '' is invalid, but findCharEnd might return this
                     // This case could be styled as error or just let appendBaseStyles handle it if we advance
                     // For now, styled as string of length 1 (just the quote) by above logic, currentPos advanced.
                     // This implies it's handled.
-                     isInChar_ = false;
+                     isInChar = false;
                 }
                  else {
-                    isInChar_ = false; // Terminated
+                    isInChar = false; // Terminated
                 }
             }
         } else { // No more stateful tokens on this line
@@ -609,10 +1050,18 @@ std::unique_ptr<std::vector<SyntaxStyle>> CppHighlighter::highlightLine(const st
     // After processing the line with stateful tokens and pattern-based styles,
     // determine if THIS line itself ends with a backslash (and is not a comment/string ending)
     // to set up macro continuation for the NEXT line.
-    if (!isInBlockComment_ && !isInRawString_ && !isInString_ && !isInChar_) {
-        isInMacroContinuation_ = lineEndsWithBackslash;
+    if (!isInBlockComment && !isInRawString && !isInString && !isInChar) {
+        isInMacroContinuation = lineEndsWithBackslash;
     }
     
+    // Pack the state this line ends in for the next line
+    state.set(LexerState::IN_BLOCK_COMMENT, isInBlockComment);
+    state.set(LexerState::IN_RAW_STRING, isInRawString);
+    state.setRawStringDelimiter(isInRawString ? rawStringDelimiter : std::string());
+    state.set(LexerState::IN_STRING, isInString);
+    state.set(LexerState::IN_CHAR, isInChar);
+    state.set(LexerState::IN_MACRO_CONTINUATION, isInMacroContinuation);
+    
     // Ensure styles are sorted for merging and correct rendering order
     auto mergedStyles = mergeStyles(styles);
 
@@ -626,21 +1075,22 @@ std::vector<std::vector<SyntaxStyle>> CppHighlighter::highlightBuffer(const ITex
     }
     result.reserve(buffer.lineCount());
     
-    // Cannot copy the highlighter due to mutex, so create a new instance
-    // Initialize the mutable state variables since this is a const method
-    mutable_reset(); // Reset all the mutable state for buffer processing
+    // Each line starts in the state the line before it ended in
+    LexerState state;
     
     for (size_t i = 0; i < buffer.lineCount(); ++i) {
         std::string lineContent = buffer.getLine(i);
-        auto lineStylesPtr = this->highlightLine(lineContent, i);
+        auto lineStylesPtr = this->highlightLineFrom(lineContent, i, state);
         
         if (lineStylesPtr) {
-            logDebug("For line " + std::to_string(i) + " ('" + lineContent.substr(0,40) + (lineContent.length() > 40 ? "..." : "") + "'), received " + std::to_string(lineStylesPtr->size()) + " styles.");
-            if ((i == 1 || i == 2)) { // Lines of interest for MultiLinePreprocessorDirectives
-                if (lineStylesPtr->empty()) {
-                    logDebug("Line " + std::to_string(i) + " received styles are indeed EMPTY.");
-                } else {
-                    logDebug("Line " + std::to_string(i) + " received styles are NOT EMPTY. First style: (" + std::to_string((*lineStylesPtr)[0].startCol) + "," + std::to_string((*lineStylesPtr)[0].endCol) + ") Color: " + std::to_string(static_cast<int>((*lineStylesPtr)[0].color)));
+            if (isDebugLoggingEnabled()) {
+                logDebug("For line " + std::to_string(i) + " ('" + lineContent.substr(0,40) + (lineContent.length() > 40 ? "..." : "") + "'), received " + std::to_string(lineStylesPtr->size()) + " styles.");
+                if ((i == 1 || i == 2)) { // Lines of interest for MultiLinePreprocessorDirectives
+                    if (lineStylesPtr->empty()) {
+                        logDebug("Line " + std::to_string(i) + " received styles are indeed EMPTY.");
+                    } else {
+                        logDebug("Line " + std::to_string(i) + " received styles are NOT EMPTY. First style: (" + std::to_string((*lineStylesPtr)[0].startCol) + "," + std::to_string((*lineStylesPtr)[0].endCol) + ") Color: " + std::to_string(static_cast<int>((*lineStylesPtr)[0].color)));
+                    }
                 }
             }
             result.push_back(std::move(*lineStylesPtr));
@@ -654,11 +1104,6 @@ std::vector<std::vector<SyntaxStyle>> CppHighlighter::highlightBuffer(const ITex
 
 // Add a helper method to reset the mutable state
 void CppHighlighter::mutable_reset() const {
-    isInBlockComment_ = false;
-    isInString_ = false; 
-    isInChar_ = false;   
-    isInRawString_ = false;
-    rawStringDelimiter_.clear();
+    lastLineState_ = LexerState();
     lastProcessedLineIndex_ = static_cast<size_t>(-1); 
-    isInMacroContinuation_ = false; // Reset for buffer processing
-} 
\ No newline at end of file
+}
@@ -10,6 +10,8 @@
 #include <iostream>
 #include <atomic> // For memory barriers
 #include <sstream>
+#include <cstdint>
+#include <cstring>
 #include "EditorError.h" // Needed for ErrorReporter and EditorException
 #include "ThreadSafetyConfig.h" // Import thread safety configuration
 
@@ -53,6 +55,42 @@ struct SyntaxStyle {
         : startCol(start), endCol(end), color(c) {}
 };
 
+// Lexer state at a line boundary: the constructs still open at the end of a
+// line, which the next line starts in. Kept small and trivially copyable so
+// a copy can be cached for every line.
+struct LexerState {
+    enum Flags : uint8_t {
+        IN_BLOCK_COMMENT      = 1 << 0,
+        IN_RAW_STRING         = 1 << 1,
+        IN_STRING             = 1 << 2,
+        IN_CHAR               = 1 << 3,
+        IN_MACRO_CONTINUATION = 1 << 4
+    };
+
+    // Longest raw string delimiter the standard allows
+    static constexpr size_t MAX_DELIMITER_LENGTH = 16;
+
+    uint8_t flags = 0;
+    uint8_t delimiterLength = 0;
+    char delimiter[MAX_DELIMITER_LENGTH] = {};
+
+    bool has(uint8_t flag) const { return (flags & flag) != 0; }
+    void set(uint8_t flag, bool on) { flags = on ? (flags | flag) : (flags & ~flag); }
+
+    std::string rawStringDelimiter() const { return std::string(delimiter, delimiterLength); }
+    void setRawStringDelimiter(const std::string& value) {
+        delimiterLength = static_cast<uint8_t>(std::min(value.size(), MAX_DELIMITER_LENGTH));
+        std::memset(delimiter, 0, sizeof(delimiter));
+        std::memcpy(delimiter, value.data(), delimiterLength);
+    }
+
+    bool operator==(const LexerState& other) const {
+        return flags == other.flags && delimiterLength == other.delimiterLength &&
+               std::memcmp(delimiter, other.delimiter, delimiterLength) == 0;
+    }
+    bool operator!=(const LexerState& other) const { return !(*this == other); }
+};
+
 // Base class for all syntax highlighters
 class SyntaxHighlighter {
 public:
@@ -60,7 +98,15 @@ public:
     
     // Highlight a line of text
     virtual std::unique_ptr<std::vector<SyntaxStyle>> highlightLine(const std::string& line, size_t lineIndex) const = 0;
-    
+
+    // Highlight a line that starts in the given lexer state, leaving the state
+    // the line ends in. Stateless highlighters always end in the default state.
+    virtual std::unique_ptr<std::vector<SyntaxStyle>> highlightLineFrom(
+        const std::string& line, size_t lineIndex, LexerState& state) const {
+        state = LexerState();
+        return highlightLine(line, lineIndex);
+    }
+
     // Highlight a full buffer
     virtual std::vector<std::vector<SyntaxStyle>> highlightBuffer(const ITextBuffer& buffer) const = 0;
     
@@ -93,7 +139,49 @@ enum class NextTokenType {
     CHAR
 };
 
-// Pattern-based syntax highlighter that uses regex patterns for highlighting
+// Keyword lookup through a perfect hash built as words are added: every word
+// owns a distinct slot, so a lookup hashes the word once and compares it
+// against at most one entry
+class KeywordTable {
+public:
+    // Add words with their color; a word already in the table keeps its first color
+    void addWords(const std::vector<std::string>& words, SyntaxColor color);
+    
+    // Look up a word, returning false if it is not in the table
+    bool find(const char* word, size_t length, SyntaxColor& color) const;
+    
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    
+private:
+    static uint32_t hash(const char* word, size_t length, uint32_t seed);
+    void rebuild();
+    
+    struct Entry {
+        std::string word;
+        SyntaxColor color;
+    };
+    
+    std::vector<Entry> entries_;
+    std::vector<int32_t> slots_; // Index into entries_ per slot, -1 if empty
+    uint32_t seed_ = 0;
+    uint32_t mask_ = 0;
+};
+
+// Token shapes PatternBasedHighlighter matches with hand-written scanners.
+// Each matches exactly what the regex beside it would.
+enum class TokenRule {
+    NUMBER,          // \b([0-9]+(\.[0-9]*)?|\.[0-9]+)([uUlLfF]|[eE][-+]?[0-9]+)?\b
+    CHAR_LITERAL,    // '(?:[^'\\]|\\.)*'
+    STRING_LITERAL,  // "(?:[^"\\]|\\.)*"
+    FUNCTION_NAME,   // \b([a-zA-Z_][a-zA-Z0-9_]*)(?=\s*\()
+    IDENTIFIER       // [a-zA-Z_][a-zA-Z0-9_]*
+};
+
+// Pattern-based syntax highlighter. Rules are applied in the order they were
+// added and the first rule to style a character wins. Keyword alternations
+// and the token shapes above are compiled into lookup tables and scanners;
+// any other pattern falls back to std::regex.
 class PatternBasedHighlighter : public SyntaxHighlighter {
 public:
     PatternBasedHighlighter(const std::string& name) : languageName_(name) {
@@ -103,81 +191,7 @@ public:
     virtual ~PatternBasedHighlighter() = default;
     
     // Main method to highlight a single line based on patterns
-    virtual std::unique_ptr<std::vector<SyntaxStyle>> highlightLine(const std::string& line, [[maybe_unused]] size_t lineIndex) const override {
-        logDebug("PatternBasedHighlighter::highlightLine for '" + languageName_ + "' on line: \"" + 
-                line.substr(0, std::min(size_t(50), line.length())) + 
-                (line.length() > 50 ? "..." : "") + "\"");
-        auto styles = std::make_unique<std::vector<SyntaxStyle>>();
-        
-        try {
-            logDebug("PatternBasedHighlighter::highlightLine - Attempting read lock");
-            READ_LOCK(patterns_mutex_);
-            logDebug("PatternBasedHighlighter::highlightLine - Acquired read lock");
-            
-            // Keep track of which positions have already been styled
-            std::vector<bool> positionStyled(line.length(), false);
-            
-            // Apply each pattern to the line
-            for (const auto& pattern_pair : patterns_) {
-                const auto& regex = pattern_pair.first;
-                const SyntaxColor color = pattern_pair.second;
-                
-                std::sregex_iterator it(line.begin(), line.end(), regex);
-                std::sregex_iterator end;
-                
-                while (it != end) {
-                    const std::smatch& match = *it;
-                    if (match.size() > 0) {
-                        if (match.length(0) == 0) { // Prevent issues with zero-length matches
-                            ++it;
-                            continue;
-                        }
-                        size_t startCol = match.position();
-                        size_t endCol = startCol + match.length();
-                        
-                        // Check if this range is already styled - only add if not
-                        bool alreadyStyled = false;
-                        for (size_t i = startCol; i < endCol && i < positionStyled.size(); ++i) {
-                            if (positionStyled[i]) {
-                                alreadyStyled = true;
-                                break;
-                            }
-                        }
-                        
-                        if (!alreadyStyled) {
-                            styles->push_back(SyntaxStyle(startCol, endCol, color));
-                            logDebug("PBHL match '" + match.str(0) + "' -> (" + 
-                                    std::to_string(startCol) + "," + std::to_string(endCol) + 
-                                    ") C:" + std::to_string(static_cast<int>(color)));
-                            
-                            // Mark these positions as styled
-                            for (size_t i = startCol; i < endCol && i < positionStyled.size(); ++i) {
-                                positionStyled[i] = true;
-                            }
-                        }
-                    }
-                    ++it;
-                }
-            }
-        } catch (const EditorException& ed_ex) {
-            ErrorReporter::logException(ed_ex);
-        } catch (const std::exception& ex) {
-            ErrorReporter::logException(SyntaxHighlightingException(
-                std::string("PatternBasedHighlighter::highlightLine: ") + ex.what(), 
-                EditorException::Severity::EDITOR_ERROR));
-        } catch (...) {
-            ErrorReporter::logUnknownException("PatternBasedHighlighter::highlightLine");
-        }
-        
-        // Sort styles by start position for rendering 
-        // (this shouldn't affect the precedence since we already filtered out overlaps)
-        std::sort(styles->begin(), styles->end(), 
-                  [](const SyntaxStyle& a, const SyntaxStyle& b) {
-                      return a.startCol < b.startCol;
-                  });
-        
-        return styles;
-    }
+    virtual std::unique_ptr<std::vector<SyntaxStyle>> highlightLine(const std::string& line, [[maybe_unused]] size_t lineIndex) const override;
     
     // Highlight a full buffer
     std::vector<std::vector<SyntaxStyle>> highlightBuffer(const ITextBuffer& buffer) const override;
@@ -192,31 +206,17 @@ public:
     }
     
 protected:
-    // Add a pattern with its associated color and category
-    void addPattern(const std::string& patternStr, SyntaxColor color, [[maybe_unused]] HighlightCategory category = HighlightCategory::UNKNOWN) {
-        logDebug("PatternBasedHighlighter::addPattern for '" + languageName_ + "' with pattern: \"" + 
-                patternStr.substr(0, std::min(size_t(50), patternStr.length())) + 
-                (patternStr.length() > 50 ? "..." : "") + "\"");
-        try {
-            WRITE_LOCK(patterns_mutex_);
-            patterns_.push_back(std::make_pair(std::regex(patternStr), color));
-        } catch (const std::regex_error& regex_ex) {
-            ErrorReporter::logError("PatternBasedHighlighter::addPattern - Regex error: " + 
-                                    std::string(regex_ex.what()) + " for pattern: " + patternStr);
-            ErrorReporter::logException(SyntaxHighlightingException(
-                std::string("PatternBasedHighlighter::addPattern: Invalid regex '") + 
-                patternStr + "': " + regex_ex.what(), 
-                EditorException::Severity::EDITOR_ERROR));
-        } catch (const EditorException& ed_ex) {
-            ErrorReporter::logException(ed_ex);
-        } catch (const std::exception& ex) {
-            ErrorReporter::logException(SyntaxHighlightingException(
-                std::string("PatternBasedHighlighter::addPattern: ") + ex.what(), 
-                EditorException::Severity::EDITOR_ERROR));
-        } catch (...) {
-            ErrorReporter::logUnknownException("PatternBasedHighlighter::addPattern");
-        }
-    }
+    // Add a pattern with its associated color and category. Patterns of the
+    // form \b(word|word|...)\b go into a keyword table; anything else is
+    // compiled as a regex.
+    void addPattern(const std::string& patternStr, SyntaxColor color, [[maybe_unused]] HighlightCategory category = HighlightCategory::UNKNOWN);
+    
+    // Add a token shape matched by a hand-written scanner
+    void addTokenRule(TokenRule rule, SyntaxColor color, [[maybe_unused]] HighlightCategory category = HighlightCategory::UNKNOWN);
+    
+    // Add preprocessor directives, matched like ^\s*#\s*(directive|...)\b
+    void addPreprocessorDirectives(const std::vector<std::string>& directives, SyntaxColor color,
+                                   [[maybe_unused]] HighlightCategory category = HighlightCategory::UNKNOWN);
     
     void addSupportedExtension(const std::string& ext) {
         WRITE_LOCK(patterns_mutex_);
@@ -224,8 +224,21 @@ protected:
     }
     
 protected:
-    mutable READER_WRITER_MUTEX patterns_mutex_; // For thread-safe access to patterns and extensions
-    std::vector<std::pair<std::regex, SyntaxColor>> patterns_;
+    struct Rule {
+        enum class Kind { KEYWORDS, DIRECTIVES, TOKEN, REGEX };
+        
+        Kind kind;
+        TokenRule token;
+        SyntaxColor color;  // Keyword tables carry a color per word instead
+        size_t index;       // Into keywordTables_ or regexes_, depending on kind
+    };
+    
+    void addKeywords_nolock(const std::vector<std::string>& words, SyntaxColor color);
+    
+    mutable READER_WRITER_MUTEX patterns_mutex_; // For thread-safe access to rules and extensions
+    std::vector<Rule> rules_;
+    std::vector<KeywordTable> keywordTables_;
+    std::vector<std::regex> regexes_;
     std::vector<std::string> supportedExtensions_;
 
 private:
@@ -245,29 +258,29 @@ public:
         addPattern("\\b(if|else|for|while|do|switch|case|default|break|continue|return|goto|try|catch|throw|new|delete|operator|template|typename|this|friend|explicit|inline|virtual|static|const|constexpr|volatile|mutable|extern|auto|decltype|namespace|using|asm|typedef|sizeof|alignas|alignof|noexcept|static_assert|thread_local)\\b", SyntaxColor::Keyword, HighlightCategory::KEYWORD);
         addPattern("\\b(void|bool|char|char16_t|char32_t|wchar_t|short|int|long|float|double|signed|unsigned)\\b", SyntaxColor::Type, HighlightCategory::TYPE_PRIMITIVE);
         addPattern("\\b(class|struct|enum|union)\\b", SyntaxColor::Type, HighlightCategory::TYPE_USER_DEFINED);
-        addPattern("\\b([0-9]+(\\.[0-9]*)?|\\.[0-9]+)([uUlLfF]|[eE][-+]?[0-9]+)?\\b", SyntaxColor::Number, HighlightCategory::LITERAL);
-        addPattern(R"(\'(?:[^\'\\]|\\.)*\')", SyntaxColor::String, HighlightCategory::LITERAL);
-        addPattern(R"(\"(?:[^\"\\]|\\.)*\")", SyntaxColor::String, HighlightCategory::LITERAL);
+        addTokenRule(TokenRule::NUMBER, SyntaxColor::Number, HighlightCategory::LITERAL);
+        addTokenRule(TokenRule::CHAR_LITERAL, SyntaxColor::String, HighlightCategory::LITERAL);
+        addTokenRule(TokenRule::STRING_LITERAL, SyntaxColor::String, HighlightCategory::LITERAL);
         addPattern("\\b(true|false|nullptr)\\b", SyntaxColor::Keyword, HighlightCategory::LITERAL);
-        addPattern("^\\s*#\\s*(define|include|if|ifdef|ifndef|else|elif|endif|pragma|line|error|warning)(?:\\b|\\s|$)", SyntaxColor::Preprocessor, HighlightCategory::PREPROCESSOR);
-        addPattern("\\b([a-zA-Z_][a-zA-Z0-9_]*)(?=\\s*\\()", SyntaxColor::Function, HighlightCategory::IDENTIFIER);
-        addPattern("[a-zA-Z_][a-zA-Z0-9_]*", SyntaxColor::Identifier, HighlightCategory::IDENTIFIER);
+        addPreprocessorDirectives({"define", "include", "if", "ifdef", "ifndef", "else", "elif", "endif", "pragma", "line", "error", "warning"}, SyntaxColor::Preprocessor, HighlightCategory::PREPROCESSOR);
+        addTokenRule(TokenRule::FUNCTION_NAME, SyntaxColor::Function, HighlightCategory::IDENTIFIER);
+        addTokenRule(TokenRule::IDENTIFIER, SyntaxColor::Identifier, HighlightCategory::IDENTIFIER);
         logDebug("CppHighlighter Constructor - End - Patterns Added: Count Details...");
     }
 
+    // Lines highlighted in order carry the previous line's end state; any
+    // other line starts in the default state
     std::unique_ptr<std::vector<SyntaxStyle>> highlightLine(const std::string& line, size_t lineIndex) const override;
+    std::unique_ptr<std::vector<SyntaxStyle>> highlightLineFrom(
+        const std::string& line, size_t lineIndex, LexerState& state) const override;
     std::vector<std::vector<SyntaxStyle>> highlightBuffer(const ITextBuffer& buffer) const override;
-    
+
     // Helper method to reset mutable state variables
     void mutable_reset() const;
 
-    mutable bool isInBlockComment_ = false;
-    mutable bool isInRawString_ = false;
-    mutable std::string rawStringDelimiter_;
-    mutable bool isInString_ = false;
-    mutable bool isInChar_ = false;
+    // End state of the line last passed to highlightLine(line, lineIndex)
+    mutable LexerState lastLineState_;
     mutable size_t lastProcessedLineIndex_ = static_cast<size_t>(-1);
-    mutable bool isInMacroContinuation_ = false;
 
 private:
     void findNextStatefulToken(const std::string& segment, size_t& nextTokenPos, NextTokenType& tokenType) const;
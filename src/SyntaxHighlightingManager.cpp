@@ -17,13 +17,11 @@
 #include <cstdarg>
 #include <cstdio>
 #include <algorithm>
+#include <limits>
 #include <cstring>
 #include "EditContext.h"
 #include "TextUtils.h"
 
-// Define the time constants
-constexpr size_t RECENT_PROCESSED_TTL_SECONDS = 60; // 1 minute
-
 // Initialize static members
 bool SyntaxHighlightingManager::globalDebugLoggingEnabled_ = false;
 
@@ -107,35 +105,29 @@ void SyntaxHighlightingManager::logManagerMessage(EditorException::Severity seve
 #pragma warning(pop)
 #endif
 
-SyntaxHighlightingManager::SyntaxHighlightingManager()
+SyntaxHighlightingManager::SyntaxHighlightingManager(std::shared_ptr<Executor> executor)
     : buffer_(nullptr)
     , enabled_(true)
     , highlightingTimeoutMs_(DEFAULT_HIGHLIGHTING_TIMEOUT_MS)
     , contextLines_(DEFAULT_CONTEXT_LINES)
     , debugLoggingEnabled_(globalDebugLoggingEnabled_)
-    , threadPool_(std::make_unique<ThreadPool>(DEFAULT_THREAD_POOL_SIZE))
+    , executor_(executor ? std::move(executor) : Executor::shared())
 {
     LOG_DEBUG("SyntaxHighlightingManager created");
 }
 
 SyntaxHighlightingManager::~SyntaxHighlightingManager() {
     try {
-        // Clear any pending tasks
-        if (threadPool_) {
-            threadPool_->shutdown();
-        }
+        // Queued tasks return straight away once disabled; wait for them
+        // and any running ones, since the executor outlives this manager
+        enabled_.store(false, std::memory_order_release);
+        cancelActiveTasks();
+        waitForTasks();
         
         // Clear all data structures to ensure clean release
         {
             std::unique_lock<std::shared_mutex> lock(mutex_);
-            cachedStyles_.clear();
-            invalidatedLines_.clear();
-            lineTimestamps_.clear();
-            lineAccessTimes_.clear();
-            processedRanges_.clear();
-            recentlyProcessedLines_.clear();
-            activeLineTasks_.clear();
-            activeRangeTasks_.clear();
+            styleCache_.clear();
         }
         
         logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::~SyntaxHighlightingManager",
@@ -224,11 +216,7 @@ bool SyntaxHighlightingManager::isEnabled() const {
 void SyntaxHighlightingManager::setBuffer(const ITextBuffer* buffer) {
     try {
         // Cancel any pending tasks first
-        {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
-            activeLineTasks_.clear();
-            activeRangeTasks_.clear();
-        }
+        cancelActiveTasks();
         
         // Atomically update the buffer pointer
         buffer_.store(buffer, std::memory_order_release);
@@ -247,21 +235,13 @@ void SyntaxHighlightingManager::setBuffer(const ITextBuffer* buffer) {
     }
 }
 
-std::unique_ptr<std::vector<SyntaxStyle>> SyntaxHighlightingManager::highlightLine_nolock(size_t line) {
+bool SyntaxHighlightingManager::highlightLine_nolock(size_t line, const ThreadPool::CancellationToken* token) {
     // This method assumes the caller already holds a unique (write) lock
     
-    auto startTime = std::chrono::steady_clock::now();
-    
-    // Get the current highlighter
-    SyntaxHighlighter* highlighter = getHighlighterPtr_nolock();
-    if (!highlighter) {
-        return nullptr;
-    }
-    
     // Get the buffer safely (this is thread-safe because it uses atomics internally)
     const ITextBuffer* buffer = getBuffer();
     if (!buffer) {
-        return nullptr;
+        return false;
     }
     
     try {
@@ -271,39 +251,110 @@ std::unique_ptr<std::vector<SyntaxStyle>> SyntaxHighlightingManager::highlightLi
                 logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLine_nolock", 
                                   "Line %zu is out of range (buffer has %zu lines)", line, buffer->lineCount());
             }
-            return nullptr;
+            return false;
         }
         
-        // Get the line text from the buffer
-        const std::string& lineText = buffer->getLine(line);
-        
+        // Highlight the line, then the lines after it for as long as its
+        // end state differs from the state they were highlighted from
+        auto startTime = std::chrono::steady_clock::now();
+        if (highlightAndCache_nolock(line, buffer->getLine(line))) {
+            auto timeout = std::chrono::milliseconds(highlightingTimeoutMs_.load(std::memory_order_acquire));
+            relexFollowingLines_nolock(buffer, line + 1, startTime, timeout, token);
+        }
+        return true;
+    } catch (const std::exception& ex) {
+        logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::highlightLine_nolock", 
+                          "Exception highlighting line %zu: %s", line, ex.what());
+        return false;
+    }
+}
+
+std::unique_ptr<std::vector<SyntaxStyle>> SyntaxHighlightingManager::highlightText_nolock(
+    size_t line, const std::string& lineText, LexerState& state) {
+    // This method assumes the caller already holds a unique (write) lock
+    
+    auto startTime = std::chrono::steady_clock::now();
+    
+    // Get the current highlighter
+    SyntaxHighlighter* highlighter = getHighlighterPtr_nolock();
+    if (!highlighter) {
+        return nullptr;
+    }
+    
+    try {
         // Create a new vector for the highlighting styles
         auto styles = std::make_unique<std::vector<SyntaxStyle>>();
         
-        // Highlight the line
-        auto result = highlighter->highlightLine(lineText, line);
+        // Highlight the line from the state the previous line ended in
+        auto result = highlighter->highlightLineFrom(lineText, line, state);
         if (result) {
             *styles = std::move(*result);
         }
         
-        // Update timestamp and mark as processed
-        markAsRecentlyProcessed(line);
-        
         if (debugLoggingEnabled_) {
             auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::steady_clock::now() - startTime);
-            logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLine_nolock", 
+            logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightText_nolock", 
                               "Highlighted line %zu in %lld μs", line, duration.count());
         }
         
         return styles;
     } catch (const std::exception& ex) {
-        logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::highlightLine_nolock", 
+        logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::highlightText_nolock", 
                           "Exception highlighting line %zu: %s", line, ex.what());
         return nullptr;
     }
 }
 
+// The state a line starts in is the end state of the line before it; a line
+// whose predecessor has not been highlighted starts in the default state and
+// is re-lexed if the predecessor turns out to end in a different one
+LexerState SyntaxHighlightingManager::lineStartState_nolock(size_t line) const {
+    return line == 0 ? LexerState() : styleCache_.endState(line - 1);
+}
+
+// Highlight a line into the cache. Returns true if the next cached line was
+// highlighted from a different state than this line now ends in; that line
+// is invalidated and has to be re-lexed too.
+bool SyntaxHighlightingManager::highlightAndCache_nolock(size_t line, const std::string& lineText) {
+    // This method assumes the caller already holds a unique (write) lock
+    const LexerState startState = lineStartState_nolock(line);
+    LexerState endState = startState;
+    auto styles = highlightText_nolock(line, lineText, endState);
+    if (!styles) {
+        return false;
+    }
+    
+    styleCache_.store(line, *styles, startState, endState);
+    
+    const size_t next = line + 1;
+    if (styleCache_.contains(next) && styleCache_.startState(next) != endState) {
+        styleCache_.invalidate(next);
+        return true;
+    }
+    return false;
+}
+
+// Re-lex lines from the given one until a line ends in the state the line
+// after it was highlighted from, as after opening or closing a block comment.
+// Returns false if the timeout or a cancelled token stopped it first; the
+// next line is left invalidated then, so it is re-lexed when requested.
+bool SyntaxHighlightingManager::relexFollowingLines_nolock(
+    const ITextBuffer* buffer, size_t line,
+    const std::chrono::steady_clock::time_point& startTime, const std::chrono::milliseconds& timeout,
+    const ThreadPool::CancellationToken* token) {
+    bool stopped = false;
+    buffer->forEachLine(line, buffer->lineCount(), [&](size_t current, std::string_view text) {
+        if ((token && token->isCancelled()) || std::chrono::steady_clock::now() - startTime > timeout) {
+            stopped = true;
+            return false;
+        }
+        lineScratch_.assign(text.data(), text.size());
+        return highlightAndCache_nolock(current, lineScratch_);
+    });
+    return !stopped;
+}
+
 void SyntaxHighlightingManager::highlightLine(size_t line) {
     auto startTime = std::chrono::steady_clock::now();
     
@@ -315,25 +366,8 @@ void SyntaxHighlightingManager::highlightLine(size_t line) {
         // Acquire a unique lock for writing
         std::unique_lock lock(mutex_);
         
-        // Ensure line is in cache range
-        if (cachedStyles_.size() <= line) {
-            cachedStyles_.resize(line + 1);
-        }
-        
         // Highlight the line and update cache
-        auto styles = highlightLine_nolock(line);
-        if (styles) {
-            // Create cache entry with the new styles
-            cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-            
-            // Update timestamps
-            auto now = std::chrono::steady_clock::now();
-            lineTimestamps_[line] = now;
-            lineAccessTimes_[line] = now;
-            
-            // Remove from invalidated lines set if present
-            invalidatedLines_.erase(line);
-        }
+        highlightLine_nolock(line);
         
         if (debugLoggingEnabled_) {
             auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -348,7 +382,8 @@ void SyntaxHighlightingManager::highlightLine(size_t line) {
 }
 
 bool SyntaxHighlightingManager::highlightLines_nolock(
-    size_t startLine, size_t endLine, const std::chrono::milliseconds& timeout) {
+    size_t startLine, size_t endLine, const std::chrono::milliseconds& timeout,
+    const ThreadPool::CancellationToken* token) {
     try {
         // Record the start time to enforce the timeout
         auto startTime = std::chrono::steady_clock::now();
@@ -363,11 +398,6 @@ bool SyntaxHighlightingManager::highlightLines_nolock(
             return false;
         }
         
-        // Ensure the cache is large enough
-        if (cachedStyles_.size() <= endLine) {
-            cachedStyles_.resize(endLine + 1);
-        }
-        
         // Determine if this range includes the visible area
         bool containsVisibleArea = false;
         {
@@ -380,6 +410,7 @@ bool SyntaxHighlightingManager::highlightLines_nolock(
         }
         
         // Process lines, prioritizing visible ones if this range contains the visible area
+        bool completed = false;
         if (containsVisibleArea) {
             // Get visible range
             size_t visibleStart = visibleStartLine_.load(std::memory_order_acquire);
@@ -389,149 +420,24 @@ bool SyntaxHighlightingManager::highlightLines_nolock(
             size_t visibleStartProcessing = std::max(startLine, visibleStart);
             size_t visibleEndProcessing = std::min(endLine, visibleEnd);
             
-            // Process the visible range first (higher priority)
-            for (size_t line = visibleStartProcessing; line <= visibleEndProcessing; ++line) {
-                // Check timeout
-                auto elapsed = std::chrono::steady_clock::now() - startTime;
-                if (elapsed > timeout) {
-                    logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLines_nolock",
-                                     "Timeout reached after processing visible lines %zu-%zu (elapsed: %lld ms)",
-                                     visibleStartProcessing, line - 1,
-                                     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
-                    return false; // Timeout reached
-                }
-                
-                // Check if the line needs highlighting
-                if (line >= cachedStyles_.size() || 
-                    !cachedStyles_[line] || 
-                    !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                    invalidatedLines_.count(line) > 0) {
-                    
-                    // Highlight the line
-                    auto styles = highlightLine_nolock(line);
-                    
-                    if (styles) {
-                        // Create cache entry with the new styles
-                        cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-                        
-                        // Update timestamps
-                        auto now = std::chrono::steady_clock::now();
-                        lineTimestamps_[line] = now;
-                        lineAccessTimes_[line] = now;
-                        
-                        // Remove from invalidated lines set
-                        invalidatedLines_.erase(line);
-                    }
-                }
-            }
-            
-            // Process lines before visible area
-            for (size_t line = startLine; line < visibleStartProcessing; ++line) {
-                // Check timeout
-                auto elapsed = std::chrono::steady_clock::now() - startTime;
-                if (elapsed > timeout) {
-                    logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLines_nolock",
-                                     "Timeout reached after processing before-visible lines %zu-%zu (elapsed: %lld ms)",
-                                     startLine, line - 1,
-                                     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
-                    return false; // Timeout reached
-                }
-                
-                // Check if the line needs highlighting
-                if (line >= cachedStyles_.size() || 
-                    !cachedStyles_[line] || 
-                    !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                    invalidatedLines_.count(line) > 0) {
-                    
-                    // Highlight the line
-                    auto styles = highlightLine_nolock(line);
-                    
-                    if (styles) {
-                        // Create cache entry with the new styles
-                        cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-                        
-                        // Update timestamps
-                        auto now = std::chrono::steady_clock::now();
-                        lineTimestamps_[line] = now;
-                        lineAccessTimes_[line] = now;
-                        
-                        // Remove from invalidated lines set
-                        invalidatedLines_.erase(line);
-                    }
-                }
-            }
-            
-            // Process lines after visible area
-            for (size_t line = visibleEndProcessing + 1; line <= endLine; ++line) {
-                // Check timeout
-                auto elapsed = std::chrono::steady_clock::now() - startTime;
-                if (elapsed > timeout) {
-                    logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLines_nolock",
-                                     "Timeout reached after processing after-visible lines %zu-%zu (elapsed: %lld ms)",
-                                     visibleEndProcessing + 1, line - 1,
-                                     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
-                    return false; // Timeout reached
-                }
-                
-                // Check if the line needs highlighting
-                if (line >= cachedStyles_.size() || 
-                    !cachedStyles_[line] || 
-                    !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                    invalidatedLines_.count(line) > 0) {
-                    
-                    // Highlight the line
-                    auto styles = highlightLine_nolock(line);
-                    
-                    if (styles) {
-                        // Create cache entry with the new styles
-                        cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-                        
-                        // Update timestamps
-                        auto now = std::chrono::steady_clock::now();
-                        lineTimestamps_[line] = now;
-                        lineAccessTimes_[line] = now;
-                        
-                        // Remove from invalidated lines set
-                        invalidatedLines_.erase(line);
-                    }
-                }
-            }
+            // Process the visible range first (higher priority), then the lines
+            // before and after it
+            completed = highlightRange_nolock(buffer, visibleStartProcessing, visibleEndProcessing + 1,
+                                              startTime, timeout, "visible ", token) &&
+                        highlightRange_nolock(buffer, startLine, visibleStartProcessing,
+                                              startTime, timeout, "before-visible ", token) &&
+                        highlightRange_nolock(buffer, visibleEndProcessing + 1, endLine + 1,
+                                              startTime, timeout, "after-visible ", token);
         } else {
             // Process lines sequentially
-            for (size_t line = startLine; line <= endLine; ++line) {
-                // Check timeout
-                auto elapsed = std::chrono::steady_clock::now() - startTime;
-                if (elapsed > timeout) {
-                    logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLines_nolock",
-                                     "Timeout reached after processing lines %zu-%zu (elapsed: %lld ms)",
-                                     startLine, line - 1,
-                                     std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
-                    return false; // Timeout reached
-                }
-                
-                // Check if the line needs highlighting
-                if (line >= cachedStyles_.size() || 
-                    !cachedStyles_[line] || 
-                    !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                    invalidatedLines_.count(line) > 0) {
-                    
-                    // Highlight the line
-                    auto styles = highlightLine_nolock(line);
-                    
-                    if (styles) {
-                        // Create cache entry with the new styles
-                        cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-                        
-                        // Update timestamps
-                        auto now = std::chrono::steady_clock::now();
-                        lineTimestamps_[line] = now;
-                        lineAccessTimes_[line] = now;
-                        
-                        // Remove from invalidated lines set
-                        invalidatedLines_.erase(line);
-                    }
-                }
-            }
+            completed = highlightRange_nolock(buffer, startLine, endLine + 1, startTime, timeout, "", token);
+        }
+        
+        // Keep the cache bounded; the lines just requested stay cached
+        evictLines_nolock(startLine, endLine);
+        
+        if (!completed) {
+            return false; // Timeout reached or cancelled
         }
         
         if (debugLoggingEnabled_) {
@@ -543,18 +449,6 @@ bool SyntaxHighlightingManager::highlightLines_nolock(
                              startLine, endLine, elapsed.count());
         }
         
-        // Update processed range tracking
-        ProcessedRange range;
-        range.startLine = startLine;
-        range.endLine = endLine;
-        range.timestamp = std::chrono::steady_clock::now();
-        processedRanges_.push_back(range);
-        
-        // Limit the size of the processed ranges queue
-        while (processedRanges_.size() > MAX_PROCESSED_RANGES) {
-            processedRanges_.pop_front();
-        }
-        
         return true; // All lines processed
     } catch (const std::exception& ex) {
         logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::highlightLines_nolock",
@@ -563,6 +457,63 @@ bool SyntaxHighlightingManager::highlightLines_nolock(
     }
 }
 
+bool SyntaxHighlightingManager::highlightRange_nolock(
+    const ITextBuffer* buffer, size_t startLine, size_t endLine,
+    const std::chrono::steady_clock::time_point& startTime, const std::chrono::milliseconds& timeout,
+    const char* rangeName, const ThreadPool::CancellationToken* token) {
+    // Lines [startLine, endLine) are read as views; only lines that need
+    // highlighting are copied, into a scratch string that keeps its capacity
+    bool stopped = false;
+    bool stateChanged = false;
+    buffer->forEachLine(startLine, endLine, [&](size_t line, std::string_view text) {
+        // Background tasks stop between lines once their range is stale
+        if (token && token->isCancelled()) {
+            stopped = true;
+            return false;
+        }
+        
+        // Check timeout
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        if (elapsed > timeout) {
+            logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::highlightLines_nolock",
+                             "Timeout reached after processing %slines %zu-%zu (elapsed: %lld ms)",
+                             rangeName, startLine, line - 1,
+                             std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+            stopped = true;
+            return false;
+        }
+        
+        // Check if the line needs highlighting
+        if (styleCache_.isValid(line)) {
+            stateChanged = false;
+            return true;
+        }
+        
+        // Highlight the line
+        lineScratch_.assign(text.data(), text.size());
+        stateChanged = highlightAndCache_nolock(line, lineScratch_);
+        
+        // Background tasks carry a token; count their lines, and those
+        // outside the visible range and its context, as wasted work
+        if (token) {
+            const size_t context = contextLines_.load(std::memory_order_relaxed);
+            const size_t visibleStart = visibleStartLine_.load(std::memory_order_acquire);
+            const size_t visibleEnd = visibleEndLine_.load(std::memory_order_acquire);
+            backgroundLinesHighlighted_.fetch_add(1, std::memory_order_relaxed);
+            if (line + context < visibleStart || line > visibleEnd + context) {
+                backgroundLinesOffscreen_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return true;
+    });
+    
+    // The last line's end state changed, so lines past the range are stale
+    if (!stopped && stateChanged) {
+        return relexFollowingLines_nolock(buffer, endLine, startTime, timeout, token);
+    }
+    return !stopped;
+}
+
 std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlightingStyles(
     size_t startLine, size_t endLine) const {
     
@@ -595,13 +546,10 @@ std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlighting
         
         // Check if all lines are valid in cache
         for (size_t line = startLine; line <= effectiveEndLine; ++line) {
-            // Update access time to prevent cache eviction
-            lineAccessTimes_[line] = std::chrono::steady_clock::now();
+            // Mark the line as read so eviction passes over it
+            styleCache_.touch(line);
             
-            if (line >= cachedStyles_.size() || 
-                !cachedStyles_[line] || 
-                !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                invalidatedLines_.count(line) > 0) {
+            if (!styleCache_.isValid(line)) {
                 allLinesValid = false;
                 break;
             }
@@ -614,7 +562,7 @@ std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlighting
             result.reserve(effectiveEndLine - startLine + 1);
             
             for (size_t line = startLine; line <= effectiveEndLine; ++line) {
-                result.push_back(cachedStyles_[line]->styles);
+                result.push_back(styleCache_.styles(line));
             }
             
             if (debugLoggingEnabled_) {
@@ -626,7 +574,7 @@ std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlighting
             }
             
             // Schedule background processing for the context area around this range
-            if (threadPool_ && shouldQueueTask(TaskType::CONTEXT_RANGE)) {
+            if (shouldQueueTask(TaskType::CONTEXT_RANGE)) {
                 // Release shared lock before spawning async task
                 sharedLock.unlock();
                 
@@ -669,11 +617,6 @@ std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlighting
             return {}; // Empty range
         }
         
-        // Ensure cache has enough space
-        if (cachedStyles_.size() <= effectiveEndLine) {
-            cachedStyles_.resize(effectiveEndLine + 1);
-        }
-        
         // Highlight lines as needed with timeout
         auto timeout = std::chrono::milliseconds(highlightingTimeoutMs_.load(std::memory_order_acquire));
         
@@ -685,48 +628,31 @@ std::vector<std::vector<SyntaxStyle>> SyntaxHighlightingManager::getHighlighting
         result.reserve(effectiveEndLine - startLine + 1);
         
         for (size_t line = startLine; line <= effectiveEndLine; ++line) {
-            if (line < cachedStyles_.size() && 
-                cachedStyles_[line] && 
-                cachedStyles_[line]->valid.load(std::memory_order_acquire)) {
-                // Use cached styles
-                result.push_back(cachedStyles_[line]->styles);
-            } else {
-                // Line not highlighted, use empty styles
-                result.push_back({});
-            }
+            // Use cached styles; a line not highlighted gets empty styles
+            result.push_back(styleCache_.isValid(line) ? styleCache_.styles(line) : std::vector<SyntaxStyle>());
             
-            // Update access time to prevent cache eviction
-            lineAccessTimes_[line] = std::chrono::steady_clock::now();
+            // Mark the line as read so eviction passes over it
+            styleCache_.touch(line);
         }
         
         // Check if there are lines that still need highlighting
         bool needsBackgroundProcessing = false;
         for (size_t line = startLine; line <= effectiveEndLine; ++line) {
-            if (line >= cachedStyles_.size() || 
-                !cachedStyles_[line] || 
-                !cachedStyles_[line]->valid.load(std::memory_order_acquire) ||
-                invalidatedLines_.count(line) > 0) {
+            if (!styleCache_.isValid(line)) {
                 needsBackgroundProcessing = true;
                 break;
             }
         }
         
         // If we couldn't process all lines in time, schedule background processing
-        if (needsBackgroundProcessing && threadPool_ && shouldQueueTask(TaskType::VISIBLE_RANGE)) {
+        if (needsBackgroundProcessing && shouldQueueTask(TaskType::VISIBLE_RANGE)) {
             // Schedule the visible range for background processing
             processVisibleRangeAsync(startLine, effectiveEndLine);
         }
         
-        // Also process the context area in the background
-        if (threadPool_ && shouldQueueTask(TaskType::CONTEXT_RANGE)) {
-            // Calculate optimal processing range including context
-            auto optimalRange = calculateOptimalProcessingRange(startLine, effectiveEndLine);
-            
-            // Process asynchronously if range is larger than the requested range
-            if (optimalRange.first < startLine || optimalRange.second > effectiveEndLine) {
-                processVisibleRangeAsync(optimalRange.first, optimalRange.second);
-            }
-        }
+        // The context area is left to the fast path: it is queued on the next
+        // read of this range, once the requested lines are cached, so a cache
+        // miss highlights only the lines that were asked for
         
         if (debugLoggingEnabled_) {
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -758,13 +684,8 @@ void SyntaxHighlightingManager::invalidateLine(size_t line) {
     try {
         std::unique_lock lock(mutex_);
         
-        // Add to invalidated lines set
-        invalidatedLines_.insert(line);
-        
         // If line is in cache, mark it as invalid
-        if (line < cachedStyles_.size() && cachedStyles_[line]) {
-            cachedStyles_[line]->valid.store(false, std::memory_order_release);
-        }
+        styleCache_.invalidate(line);
         
         // Invalidate the last processed range if it contains this line
         if (lastProcessedRange_.valid && 
@@ -804,13 +725,8 @@ void SyntaxHighlightingManager::invalidateLines(size_t startLine, size_t endLine
         
         // Invalidate each line in the range
         for (size_t line = startLine; line <= endLine; ++line) {
-            // Add to invalidated lines set
-            invalidatedLines_.insert(line);
-            
             // If line is in cache, mark it as invalid
-            if (line < cachedStyles_.size() && cachedStyles_[line]) {
-                cachedStyles_[line]->valid.store(false, std::memory_order_release);
-            }
+            styleCache_.invalidate(line);
         }
         
         // Invalidate the last processed range if it overlaps with this range
@@ -846,23 +762,9 @@ void SyntaxHighlightingManager::invalidateAllLines() {
 void SyntaxHighlightingManager::invalidateAllLines_nolock() {
     // This method assumes the caller already holds a unique (write) lock
     
-    // Get maximum line count safely
-    const ITextBuffer* buffer = getBuffer();
-    if (buffer) {
-        size_t bufferLineCount = buffer->lineCount();
-        
-        // Add all lines to invalidated lines set
-        for (size_t line = 0; line < bufferLineCount; ++line) {
-            invalidatedLines_.insert(line);
-        }
-        
-        // Mark all cached lines as invalid
-        for (size_t line = 0; line < cachedStyles_.size(); ++line) {
-            if (cachedStyles_[line]) {
-                cachedStyles_[line]->valid.store(false, std::memory_order_release);
-            }
-        }
-    }
+    // Mark all cached lines as invalid; the cache bumps its generation
+    // rather than visiting every line
+    styleCache_.invalidateAll();
     
     // Invalidate the last processed range
     lastProcessedRange_.invalidate();
@@ -883,8 +785,8 @@ void SyntaxHighlightingManager::setVisibleRange(size_t startLine, size_t endLine
                          "Visible range set to %zu-%zu", startLine, endLine);
     }
     
-    // Process the visible range in the background using the thread pool
-    if (threadPool_ && isEnabled()) {
+    // Process the visible range in the background using the executor
+    if (isEnabled()) {
         // Calculate optimal processing range to include context
         auto optimalRange = calculateOptimalProcessingRange(startLine, endLine);
         
@@ -929,20 +831,12 @@ size_t SyntaxHighlightingManager::getContextLines() const {
 
 bool SyntaxHighlightingManager::isLineInCache(size_t line) const {
     std::shared_lock lock(this->mutex_);
-    return line < this->cachedStyles_.size() && 
-           this->cachedStyles_[line] != nullptr;
+    return this->styleCache_.contains(line);
 }
 
 bool SyntaxHighlightingManager::isLineValid(size_t line) const {
     std::shared_lock lock(this->mutex_);
-    
-    if (line >= this->cachedStyles_.size() || 
-        !this->cachedStyles_[line]) {
-        return false;
-    }
-    
-    return this->cachedStyles_[line]->valid.load(std::memory_order_acquire) && 
-           this->invalidatedLines_.count(line) == 0;
+    return this->styleCache_.isValid(line);
 }
 
 // Calculate the optimal processing range based on a given visible range
@@ -979,162 +873,29 @@ std::pair<size_t, size_t> SyntaxHighlightingManager::calculateOptimalProcessingR
     }
 }
 
-bool SyntaxHighlightingManager::isEntryExpired_nolock(size_t line) const {
-    // Check if it's in the invalidated set
-    if (invalidatedLines_.count(line) > 0) {
-        return true;  // Explicitly invalidated
-    }
-    
-    // Check if the timestamp exists for this line
-    auto timestampIt = lineTimestamps_.find(line);
-    if (timestampIt == lineTimestamps_.end()) {
-        return true;  // No timestamp, consider expired
-    }
-    
-    // Calculate how old the entry is
-    auto now = std::chrono::steady_clock::now();
-    auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - timestampIt->second).count();
-    
-    // Return true if older than cache lifetime (cast to unsigned for comparison)
-    return static_cast<size_t>(age) > 60000; // 1 minute lifetime
-}
-
-void SyntaxHighlightingManager::evictLRUEntries_nolock(size_t targetSize) const {
+void SyntaxHighlightingManager::evictLines_nolock(size_t keepStart, size_t keepEnd) {
     // This method assumes the caller already holds a unique (write) lock
     
-    // No need to do anything if we're under target
-    if (cachedStyles_.size() <= targetSize) {
+    if (styleCache_.cachedLineCount() <= MAX_CACHE_LINES) {
         return;
     }
     
-    // Copy access times to a vector for sorting
-    std::vector<std::pair<size_t, std::chrono::steady_clock::time_point>> lineAccessPairs;
-    lineAccessPairs.reserve(lineAccessTimes_.size());
-    
-    for (const auto& pair : lineAccessTimes_) {
-        lineAccessPairs.push_back(pair);
-    }
-    
-    // Sort by access time (oldest first)
-    std::sort(lineAccessPairs.begin(), lineAccessPairs.end(),
-              [](const auto& a, const auto& b) {
-                  return a.second < b.second;
-              });
-    
-    // Number of entries to remove
-    size_t entriesToRemove = cachedStyles_.size() - targetSize;
-    size_t removedCount = 0;
-    
-    // Remove entries from cache
-    for (const auto& pair : lineAccessPairs) {
-        size_t line = pair.first;
-        
-        // Skip visible lines
-        size_t visibleStart = visibleStartLine_.load(std::memory_order_acquire);
-        size_t visibleEnd = visibleEndLine_.load(std::memory_order_acquire);
-        if (line >= visibleStart && line <= visibleEnd) {
-            continue;
-        }
-        
-        // Skip lines that are already invalid or nullptr
-        if (line >= cachedStyles_.size() || !cachedStyles_[line]) {
-            continue;
-        }
-        
-        // Mark entry as invalid
-        cachedStyles_[line]->valid.store(false, std::memory_order_release);
-        
-        // In debug mode, we keep the data but mark as invalid
-        // In release mode, we can free the memory
-        #ifndef _DEBUG
-        cachedStyles_[line].reset();
-        #endif
-        
-        removedCount++;
-        if (removedCount >= entriesToRemove) {
-            break;
-        }
-    }
+    // Evict down to the cleanup ratio so that eviction does not run again
+    // for every few lines highlighted. Visible lines are read on every
+    // repaint, so their clock bits keep them cached.
+    const size_t targetSize = static_cast<size_t>(MAX_CACHE_LINES * CACHE_CLEANUP_RATIO);
+    const size_t evicted = styleCache_.evict(targetSize, keepStart, keepEnd);
     
-    // Log cache eviction if debug logging is enabled
     if (debugLoggingEnabled_) {
-        logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::evictLRUEntries_nolock", 
-                          "Evicted %zu entries from highlighting cache", removedCount);
-    }
-    
-    // If we couldn't evict enough entries through LRU, we may need to force eviction
-    if (removedCount < entriesToRemove && cachedStyles_.size() > targetSize) {
-        size_t remainingToRemove = entriesToRemove - removedCount;
-        size_t forceRemoved = 0;
-        
-        for (size_t i = 0; i < cachedStyles_.size() && forceRemoved < remainingToRemove; ++i) {
-            // Skip visible lines and already invalid entries
-            size_t visibleStart = visibleStartLine_.load(std::memory_order_acquire);
-            size_t visibleEnd = visibleEndLine_.load(std::memory_order_acquire);
-            if ((i >= visibleStart && i <= visibleEnd) || !cachedStyles_[i]) {
-                continue;
-            }
-            
-            // Mark entry as invalid
-            cachedStyles_[i]->valid.store(false, std::memory_order_release);
-            
-            // In debug mode, we keep the data but mark as invalid
-            // In release mode, we can free the memory
-            #ifndef _DEBUG
-            cachedStyles_[i].reset();
-            #endif
-            
-            forceRemoved++;
-        }
-        
-        // Log forced eviction if debug logging is enabled
-        if (debugLoggingEnabled_ && forceRemoved > 0) {
-            logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::evictLRUEntries_nolock", 
-                              "Forced eviction of %zu additional entries", forceRemoved);
-        }
-    }
-}
-
-bool SyntaxHighlightingManager::wasRecentlyProcessed(size_t line) const {
-    std::shared_lock lock(mutex_);
-    
-    auto it = recentlyProcessedLines_.find(line);
-    if (it == recentlyProcessedLines_.end()) {
-        return false;
-    }
-    
-    // Check if the timestamp is recent enough
-    auto now = std::chrono::steady_clock::now();
-    auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second).count();
-    
-    // Cast to unsigned for comparison
-    return static_cast<size_t>(age) <= 5000; // 5 seconds window
-}
-
-void SyntaxHighlightingManager::markAsRecentlyProcessed(size_t line) {
-    std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    // Add timestamp for the processed line
-    recentlyProcessedLines_[line] = std::chrono::steady_clock::now();
-    
-    // If we have too many entries, remove old ones
-    if (recentlyProcessedLines_.size() > 1000) {
-        auto now = std::chrono::steady_clock::now();
-        for (auto it = recentlyProcessedLines_.begin(); it != recentlyProcessedLines_.end();) {
-            auto elapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count();
-            if (static_cast<size_t>(elapsedSeconds) > RECENT_PROCESSED_TTL_SECONDS) {
-                it = recentlyProcessedLines_.erase(it);
-            } else {
-                ++it;
-            }
-        }
+        logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::evictLines_nolock", 
+                          "Evicted %zu entries from highlighting cache", evicted);
     }
 }
 
 void SyntaxHighlightingManager::logCacheMetrics(const char* context, size_t visibleLines, size_t totalProcessed) const {
     logManagerMessage(EditorException::Severity::Debug, context,
-                     "Cache metrics: visible=%zu, processed=%zu, timestamps=%zu, access=%zu",
-                     visibleLines, totalProcessed, lineTimestamps_.size(), lineAccessTimes_.size());
+                     "Cache metrics: visible=%zu, processed=%zu, cached=%zu, bytes=%zu",
+                     visibleLines, totalProcessed, styleCache_.cachedLineCount(), styleCache_.memoryUsage());
 }
 
 // Process a visible range asynchronously
@@ -1145,61 +906,96 @@ void SyntaxHighlightingManager::processVisibleRangeAsync(size_t startLine, size_
     }
     
     try {
-        // Check if we have a thread pool
-        if (!threadPool_) {
-            if (debugLoggingEnabled_) {
-                logManagerMessage(EditorException::Severity::Warning, "SyntaxHighlightingManager::processVisibleRangeAsync",
-                                 "No thread pool available for async processing");
-            }
-            return;
-        }
-        
-        // Take a shared lock to check if we already have an active task for this range
-        std::shared_lock lock(mutex_);
+        std::lock_guard<std::mutex> lock(activeTasksMutex_);
         
-        // Create a unique key for this range
-        std::string rangeKey = std::to_string(startLine) + "-" + std::to_string(endLine);
+        // Forget tasks that have finished
+        for (auto it = activeRangeTasks_.begin(); it != activeRangeTasks_.end();) {
+            it = it->second.isRunning() ? std::next(it) : activeRangeTasks_.erase(it);
+        }
         
-        // Check if we already have a task for this range
-        auto taskIt = activeRangeTasks_.find(rangeKey);
-        if (taskIt != activeRangeTasks_.end()) {
-            // Task already exists
-            auto& future = taskIt->second;
+        // A request that touches the visible range limits background work to
+        // the visible range and its context: tasks for ranges the user has
+        // scrolled away from are cancelled, and merged ranges are clipped
+        size_t windowStart = 0;
+        size_t windowEnd = std::numeric_limits<size_t>::max();
+        const size_t visibleStart = visibleStartLine_.load(std::memory_order_acquire);
+        const size_t visibleEnd = visibleEndLine_.load(std::memory_order_acquire);
+        if (startLine <= visibleEnd && endLine >= visibleStart) {
+            auto window = calculateOptimalProcessingRange(visibleStart, visibleEnd);
+            windowStart = std::min(window.first, startLine);
+            windowEnd = std::max(window.second, endLine);
             
-            // Check if it's still running
-            if (future.valid() && future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
-                if (debugLoggingEnabled_) {
-                    logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::processVisibleRangeAsync",
-                                     "Task already running for range %zu-%zu", startLine, endLine);
+            for (auto it = activeRangeTasks_.begin(); it != activeRangeTasks_.end();) {
+                if (it->second.endLine < windowStart || it->first > windowEnd) {
+                    it->second.token.cancel();
+                    rangeTasksCancelled_.fetch_add(1, std::memory_order_relaxed);
+                    it = activeRangeTasks_.erase(it);
+                } else {
+                    ++it;
                 }
-                return;  // Let the existing task complete
             }
         }
         
-        // Convert to unique lock for modifying the task map
-        lock.unlock();
-        std::unique_lock uniqueLock(mutex_);
+        // Active ranges are disjoint and sorted, so the ones that overlap or
+        // touch [startLine, endLine] are consecutive
+        auto first = activeRangeTasks_.lower_bound(startLine);
+        if (first != activeRangeTasks_.begin() && std::prev(first)->second.endLine + 1 >= startLine) {
+            --first;
+        }
+        auto last = first;
+        while (last != activeRangeTasks_.end() && last->first <= endLine + 1) {
+            ++last;
+        }
+        
+        // A single task already covers the whole request
+        if (first != last && first->first <= startLine && first->second.endLine >= endLine) {
+            rangeTasksDeduplicated_.fetch_add(1, std::memory_order_relaxed);
+            if (debugLoggingEnabled_) {
+                logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::processVisibleRangeAsync",
+                                 "Task already running for range %zu-%zu", first->first, first->second.endLine);
+            }
+            return;  // Let the existing task complete
+        }
+        
+        // Otherwise replace the overlapping tasks with one for the union;
+        // lines they already highlighted are cached, so none are redone
+        size_t mergedStart = startLine;
+        size_t mergedEnd = endLine;
+        for (auto it = first; it != last; ++it) {
+            mergedStart = std::min(mergedStart, it->first);
+            mergedEnd = std::max(mergedEnd, it->second.endLine);
+            it->second.token.cancel();
+            rangeTasksCoalesced_.fetch_add(1, std::memory_order_relaxed);
+        }
+        activeRangeTasks_.erase(first, last);
+        mergedStart = std::max(mergedStart, windowStart);
+        mergedEnd = std::min(mergedEnd, windowEnd);
         
         // Determine task type - visible range gets highest priority
         TaskType taskType = TaskType::VISIBLE_RANGE;
         
-        // Submit task to thread pool using the submit method
-        auto future = threadPool_->submit(
-            getTaskPriority(taskType),
+        // Submit task to the executor lane for this task type
+        RangeTask task;
+        task.endLine = mergedEnd;
+        task.future = submitTask(
+            taskType,
+            task.token,
             &SyntaxHighlightingManager::taskHighlightLines,
-            const_cast<SyntaxHighlightingManager*>(this), // Required because taskHighlightLines is const but threadPool->submit expects non-const
-            startLine, 
-            endLine, 
-            taskType
+            this,
+            mergedStart, 
+            mergedEnd, 
+            taskType,
+            task.token
         );
+        rangeTasksSubmitted_.fetch_add(1, std::memory_order_relaxed);
         
-        // Store the future in the active tasks map
-        activeRangeTasks_[rangeKey] = std::move(future);
+        // Store the task in the active tasks map
+        activeRangeTasks_[mergedStart] = std::move(task);
         
         if (debugLoggingEnabled_) {
             logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::processVisibleRangeAsync",
                              "Submitted task for range %zu-%zu with priority %d", 
-                             startLine, endLine, static_cast<int>(getTaskPriority(taskType)));
+                             mergedStart, mergedEnd, static_cast<int>(getTaskPriority(taskType)));
         }
     } catch (const std::exception& ex) {
         logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::processVisibleRangeAsync",
@@ -1208,8 +1004,9 @@ void SyntaxHighlightingManager::processVisibleRangeAsync(size_t startLine, size_
 }
 
 // Task function for highlighting a range of lines
-void SyntaxHighlightingManager::taskHighlightLines(size_t startLine, size_t endLine, TaskType taskType) const {
-    if (!isEnabled()) {
+void SyntaxHighlightingManager::taskHighlightLines(size_t startLine, size_t endLine, TaskType taskType,
+                                                   const ThreadPool::CancellationToken& token) const {
+    if (!isEnabled() || token.isCancelled()) {
         return;
     }
     
@@ -1226,15 +1023,19 @@ void SyntaxHighlightingManager::taskHighlightLines(size_t startLine, size_t endL
             timeoutMs = static_cast<size_t>(timeoutMs * 1.5);
         }
         
-        // Acquire lock and process lines
+        // Acquire lock and process lines; the range may have gone stale
+        // while this task waited for it
         std::unique_lock lock(mutex_);
+        if (token.isCancelled()) {
+            return;
+        }
         
         // Highlight the lines with appropriate timeout
         auto timeout = std::chrono::milliseconds(timeoutMs);
         
         // Use a non-const version of this to call highlightLines_nolock
         SyntaxHighlightingManager* nonConstThis = const_cast<SyntaxHighlightingManager*>(this);
-        bool allProcessed = nonConstThis->highlightLines_nolock(startLine, endLine, timeout);
+        bool allProcessed = nonConstThis->highlightLines_nolock(startLine, endLine, timeout, &token);
         
         if (debugLoggingEnabled_) {
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -1243,7 +1044,7 @@ void SyntaxHighlightingManager::taskHighlightLines(size_t startLine, size_t endL
             logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::taskHighlightLines",
                              "Background processing for lines %zu-%zu completed in %lld ms (%s)",
                              startLine, endLine, duration.count(),
-                             allProcessed ? "all processed" : "timeout reached");
+                             allProcessed ? "all processed" : token.isCancelled() ? "cancelled" : "timeout reached");
         }
     } catch (const std::exception& ex) {
         logManagerMessage(EditorException::Severity::EDITOR_ERROR, "SyntaxHighlightingManager::taskHighlightLines",
@@ -1254,19 +1055,103 @@ void SyntaxHighlightingManager::taskHighlightLines(size_t startLine, size_t endL
     }
 }
 
-// Thread pool management methods
+// Submit a task and count it until it finishes or is dropped
+template<class F, class... Args>
+std::future<void> SyntaxHighlightingManager::submitTask(TaskType taskType, const ThreadPool::CancellationToken& token,
+                                                        F&& f, Args&&... args) const {
+    auto executor = getExecutor();
+    
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex_);
+        ++tasksInFlight_;
+    }
+    
+    // Finishes the task's count once: when the task has run, or when it is
+    // released without running, after the executor drops it because its
+    // token was cancelled or because it could not be submitted. The future
+    // shares the task's state, so a dropped task is only released once its
+    // future is gone too; active task maps drop the futures they cancel.
+    struct Finished {
+        const SyntaxHighlightingManager* manager;
+        bool counted = false;
+        
+        explicit Finished(const SyntaxHighlightingManager* owner) : manager(owner) {}
+        Finished(const Finished&) = delete;
+        Finished& operator=(const Finished&) = delete;
+        
+        void operator()() {
+            if (counted) {
+                return;
+            }
+            counted = true;
+            std::lock_guard<std::mutex> lock(manager->tasksMutex_);
+            if (--manager->tasksInFlight_ == 0) {
+                manager->tasksDone_.notify_all();
+            }
+        }
+        ~Finished() { (*this)(); }
+    };
+    auto finished = std::make_shared<Finished>(this);
+    
+    ThreadPool::TaskOptions options;
+    options.priority = getTaskPriority(taskType);
+    options.token = token;
+    return executor->submit(getTaskLane(taskType), options,
+        [finished = std::move(finished), call = std::bind(std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+            struct Guard {
+                Finished& done;
+                ~Guard() { done(); }
+            } guard{*finished};
+            call();
+        });
+}
+
+// Wait until no submitted task is queued or running
+void SyntaxHighlightingManager::waitForTasks() const {
+    std::unique_lock<std::mutex> lock(tasksMutex_);
+    tasksDone_.wait(lock, [this] { return tasksInFlight_ == 0; });
+}
+
+// Cancel every active task; queued ones are dropped and running ones stop
+// at the next line
+void SyntaxHighlightingManager::cancelActiveTasks() const {
+    std::lock_guard<std::mutex> lock(activeTasksMutex_);
+    for (auto& entry : activeLineTasks_) {
+        entry.second.token.cancel();
+    }
+    for (auto& entry : activeRangeTasks_) {
+        entry.second.token.cancel();
+    }
+    rangeTasksCancelled_.fetch_add(activeRangeTasks_.size(), std::memory_order_relaxed);
+    activeLineTasks_.clear();
+    activeRangeTasks_.clear();
+}
+
+// Executor management methods
+void SyntaxHighlightingManager::setExecutor(std::shared_ptr<Executor> executor) {
+    if (!executor) {
+        executor = Executor::shared();
+    }
+    
+    // Tasks already submitted finish on the old executor; release it outside
+    // the lock, since destroying a private executor waits for its tasks
+    std::shared_ptr<Executor> previous = std::atomic_exchange(&executor_, std::move(executor));
+    cancelActiveTasks();
+    previous.reset();
+}
+
+std::shared_ptr<Executor> SyntaxHighlightingManager::getExecutor() const {
+    return std::atomic_load(&executor_);
+}
+
 void SyntaxHighlightingManager::setThreadPoolSize(size_t numThreads) {
     try {
-        // Create a new thread pool with the specified size
-        auto newThreadPool = std::make_unique<ThreadPool>(numThreads);
-        
-        // Replace the old thread pool
-        std::unique_lock lock(mutex_);
-        threadPool_ = std::move(newThreadPool);
-        
-        // Clear active tasks
-        activeLineTasks_.clear();
-        activeRangeTasks_.clear();
+        // A fixed size needs threads of our own rather than the shared executor
+        Executor::Options options;
+        options.interactiveThreads = numThreads;
+        options.backgroundThreads = numThreads;
+        options.ioThreads = 1;
+        setExecutor(std::make_shared<Executor>(options));
         
         logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::setThreadPoolSize",
                          "Thread pool size set to %zu", numThreads);
@@ -1277,36 +1162,47 @@ void SyntaxHighlightingManager::setThreadPoolSize(size_t numThreads) {
 }
 
 size_t SyntaxHighlightingManager::getThreadPoolSize() const {
-    if (!threadPool_) {
-        return 0;
-    }
-    return threadPool_->getThreadCount();
+    return getExecutor()->threadCount(Executor::Lane::Interactive);
 }
 
 size_t SyntaxHighlightingManager::getActiveThreadCount() const {
-    if (!threadPool_) {
-        return 0;
-    }
-    return threadPool_->getActiveThreadCount();
+    auto executor = getExecutor();
+    return executor->metrics(Executor::Lane::Interactive).activeThreads +
+           executor->metrics(Executor::Lane::Background).activeThreads;
 }
 
 size_t SyntaxHighlightingManager::getQueuedTaskCount() const {
-    if (!threadPool_) {
-        return 0;
-    }
-    return threadPool_->getQueueSize();
+    auto executor = getExecutor();
+    return executor->queueDepth(Executor::Lane::Interactive) + executor->queueDepth(Executor::Lane::Background);
 }
 
 // Get the current cache size
 size_t SyntaxHighlightingManager::getCacheSize() const {
     std::shared_lock lock(mutex_);
-    size_t validCount = 0;
-    for (const auto& entry : cachedStyles_) {
-        if (entry && entry->valid.load(std::memory_order_acquire)) {
-            validCount++;
-        }
-    }
-    return validCount;
+    return styleCache_.validLineCount();
+}
+
+size_t SyntaxHighlightingManager::getCacheMemoryUsage() const {
+    std::shared_lock lock(mutex_);
+    return styleCache_.memoryUsage();
+}
+
+SyntaxHighlightingManager::BackgroundStats SyntaxHighlightingManager::getBackgroundStats() const {
+    BackgroundStats stats;
+    stats.rangeTasksSubmitted = rangeTasksSubmitted_.load(std::memory_order_relaxed);
+    stats.rangeTasksDeduplicated = rangeTasksDeduplicated_.load(std::memory_order_relaxed);
+    stats.rangeTasksCoalesced = rangeTasksCoalesced_.load(std::memory_order_relaxed);
+    stats.rangeTasksCancelled = rangeTasksCancelled_.load(std::memory_order_relaxed);
+    stats.linesHighlighted = backgroundLinesHighlighted_.load(std::memory_order_relaxed);
+    stats.linesHighlightedOffscreen = backgroundLinesOffscreen_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Get the executor lane based on task type
+Executor::Lane SyntaxHighlightingManager::getTaskLane(TaskType taskType) const {
+    // Only whole-document work goes to the background lane; everything else
+    // is near where the user is looking
+    return taskType == TaskType::BACKGROUND_RANGE ? Executor::Lane::Background : Executor::Lane::Interactive;
 }
 
 // Get task priority based on task type
@@ -1327,12 +1223,8 @@ ThreadPool::Priority SyntaxHighlightingManager::getTaskPriority(TaskType taskTyp
 
 // Determine if a task should be queued based on current load
 bool SyntaxHighlightingManager::shouldQueueTask(TaskType taskType) const {
-    if (!threadPool_) {
-        return false;
-    }
-    
-    // Get the current queue size
-    size_t queueSize = threadPool_->getQueueSize();
+    // Get the current queue size of the lane the task would go to
+    size_t queueSize = getExecutor()->queueDepth(getTaskLane(taskType));
     
     // Apply throttling based on task type and current load
     switch (taskType) {
@@ -1365,15 +1257,6 @@ void SyntaxHighlightingManager::processSingleLineAsync(size_t line) {
     }
     
     try {
-        // Check if we have a thread pool
-        if (!threadPool_) {
-            if (debugLoggingEnabled_) {
-                logManagerMessage(EditorException::Severity::Warning, "SyntaxHighlightingManager::processSingleLineAsync",
-                                 "No thread pool available for async processing");
-            }
-            return;
-        }
-        
         // Check if we should queue the task based on current load
         if (!shouldQueueTask(TaskType::SINGLE_LINE)) {
             if (debugLoggingEnabled_) {
@@ -1383,17 +1266,13 @@ void SyntaxHighlightingManager::processSingleLineAsync(size_t line) {
             return;
         }
         
-        // Take a shared lock to check if we already have an active task for this line
-        std::shared_lock lock(mutex_);
+        std::lock_guard<std::mutex> lock(activeTasksMutex_);
         
         // Check if we already have a task for this line
         auto taskIt = activeLineTasks_.find(line);
         if (taskIt != activeLineTasks_.end()) {
-            // Task already exists
-            auto& future = taskIt->second;
-            
             // Check if it's still running
-            if (future.valid() && future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+            if (taskIt->second.isRunning()) {
                 if (debugLoggingEnabled_) {
                     logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::processSingleLineAsync",
                                      "Task already running for line %zu", line);
@@ -1402,20 +1281,19 @@ void SyntaxHighlightingManager::processSingleLineAsync(size_t line) {
             }
         }
         
-        // Convert to unique lock for modifying the task map
-        lock.unlock();
-        std::unique_lock uniqueLock(mutex_);
-        
-        // Submit task to thread pool
-        auto future = threadPool_->submit(
-            getTaskPriority(TaskType::SINGLE_LINE),
+        // Submit task to the executor
+        ActiveTask task;
+        task.future = submitTask(
+            TaskType::SINGLE_LINE,
+            task.token,
             &SyntaxHighlightingManager::taskHighlightLine,
             this,
-            line
+            line,
+            task.token
         );
         
-        // Store the future in the active tasks map
-        activeLineTasks_[line] = std::move(future);
+        // Store the task in the active tasks map
+        activeLineTasks_[line] = std::move(task);
         
         if (debugLoggingEnabled_) {
             logManagerMessage(EditorException::Severity::Debug, "SyntaxHighlightingManager::processSingleLineAsync",
@@ -1429,8 +1307,8 @@ void SyntaxHighlightingManager::processSingleLineAsync(size_t line) {
 }
 
 // Task function for highlighting a single line
-void SyntaxHighlightingManager::taskHighlightLine(size_t line) {
-    if (!isEnabled()) {
+void SyntaxHighlightingManager::taskHighlightLine(size_t line, const ThreadPool::CancellationToken& token) {
+    if (!isEnabled() || token.isCancelled()) {
         return;
     }
     
@@ -1441,34 +1319,13 @@ void SyntaxHighlightingManager::taskHighlightLine(size_t line) {
         std::unique_lock lock(mutex_);
         
         // Check if the line is still invalid or needs processing
-        if (line < cachedStyles_.size() && 
-            cachedStyles_[line] && 
-            cachedStyles_[line]->valid.load(std::memory_order_acquire) &&
-            invalidatedLines_.count(line) == 0) {
+        if (styleCache_.isValid(line)) {
             // Line is already valid, nothing to do
             return;
         }
         
         // Highlight the line
-        auto styles = highlightLine_nolock(line);
-        
-        if (styles) {
-            // Ensure cache has enough space
-            if (cachedStyles_.size() <= line) {
-                cachedStyles_.resize(line + 1);
-            }
-            
-            // Create cache entry with the new styles
-            cachedStyles_[line] = std::make_unique<CacheEntry>(std::move(*styles));
-            
-            // Update timestamps
-            auto now = std::chrono::steady_clock::now();
-            lineTimestamps_[line] = now;
-            lineAccessTimes_[line] = now;
-            
-            // Remove from invalidated lines set
-            invalidatedLines_.erase(line);
-        }
+        highlightLine_nolock(line, &token);
         
         if (debugLoggingEnabled_) {
             auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -4,20 +4,22 @@
 #include "EditorError.h"
 #include "TextBuffer.h"
 #include "interfaces/ISyntaxHighlightingManager.hpp"
-#include "ThreadPool.h"
+#include "Executor.h"
+#include "StyleCache.h"
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <chrono>
 #include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
 #include <atomic>
 #include <memory>
 #include <string>
 #include <sstream>
 #include <thread>
 #include <future>
-#include <deque>
+#include <map>
 
 // Forward declarations
 class ITextBuffer;
@@ -41,9 +43,6 @@ public:
     // Minimum number of lines to process per batch before timing out
     static constexpr size_t MIN_LINES_PER_BATCH = 5;
     
-    // Cache entry lifetime in milliseconds
-    static constexpr size_t CACHE_ENTRY_LIFETIME_MS = 10000; // 10 seconds
-    
     // Maximum number of lines to cache before triggering eviction
     static constexpr size_t MAX_CACHE_LINES = 10000;
     
@@ -53,20 +52,11 @@ public:
     // Maximum batch size for processing lines
     static constexpr size_t MAX_BATCH_SIZE = 25;  // Added explicit batch size limit
     
-    // Time window to consider a line as "recently processed" (milliseconds)
-    static constexpr size_t RECENTLY_PROCESSED_WINDOW_MS = 1000;  // 1 second
-    
     // Minimum number of requested lines to process before timing out
     static constexpr size_t MIN_PROCESS_LINES_BEFORE_TIMEOUT = 10;
     
-    // Default number of threads in thread pool
-    static constexpr size_t DEFAULT_THREAD_POOL_SIZE = 2;
-    
     // Maximum size of the work queue (to prevent unbounded growth)
     static constexpr size_t MAX_WORK_QUEUE_SIZE = 100;
-    
-    // Maximum number of processed ranges to track
-    static constexpr size_t MAX_PROCESSED_RANGES = 50;
 
     /**
      * @brief Task types for thread pool
@@ -78,8 +68,12 @@ public:
         SINGLE_LINE        ///< Highlighting single line
     };
 
-    // Constructor
-    SyntaxHighlightingManager();
+    /**
+     * @brief Constructor
+     *
+     * @param executor Executor for background highlighting; defaults to the process-wide one
+     */
+    explicit SyntaxHighlightingManager(std::shared_ptr<Executor> executor = nullptr);
     
     // Destructor
     ~SyntaxHighlightingManager() override;
@@ -109,34 +103,44 @@ public:
     void highlightLine(size_t line) override;
     
     // Thread pool management
+    void setExecutor(std::shared_ptr<Executor> executor);
+    std::shared_ptr<Executor> getExecutor() const;
     void setThreadPoolSize(size_t numThreads);
     size_t getThreadPoolSize() const;
     size_t getActiveThreadCount() const;
     size_t getQueuedTaskCount() const;
     
+    /**
+     * @brief Counters for background highlighting work
+     *
+     * Lines highlighted off screen were outside the visible range and its
+     * context lines when a background task reached them, so that work was
+     * wasted unless the user scrolls back.
+     */
+    struct BackgroundStats {
+        size_t rangeTasksSubmitted = 0;     ///< Range tasks handed to the executor
+        size_t rangeTasksDeduplicated = 0;  ///< Requests already covered by an active task
+        size_t rangeTasksCoalesced = 0;     ///< Active tasks merged into a wider request
+        size_t rangeTasksCancelled = 0;     ///< Active tasks cancelled as stale
+        size_t linesHighlighted = 0;        ///< Lines highlighted by background tasks
+        size_t linesHighlightedOffscreen = 0;
+    };
+    BackgroundStats getBackgroundStats() const;
+    
     // Internal methods for testing
     size_t getCacheSize() const override;
+    size_t getCacheMemoryUsage() const;  // Bytes held by the style cache
     bool isDebugLoggingEnabled() const override { return debugLoggingEnabled_; }
     void setDebugLoggingEnabled(bool enabled) override { debugLoggingEnabled_ = enabled; }
     static bool getGlobalDebugLoggingState() { return globalDebugLoggingEnabled_; }
     static void setDebugLoggingEnabled_static(bool enabled) { globalDebugLoggingEnabled_ = enabled; }
     
 private:
-    // Cache entry for highlighted line
-    struct CacheEntry {
-        std::vector<SyntaxStyle> styles;
-        std::atomic<bool> valid;
-        
-        explicit CacheEntry(std::vector<SyntaxStyle> s)
-            : styles(std::move(s)), valid(true) {}
-    };
-    
     // Range tracking for optimization
     struct ProcessedRange {
         bool valid = false;
         size_t startLine = 0;
         size_t endLine = 0;
-        std::chrono::steady_clock::time_point timestamp;
         
         void update(size_t start, size_t end) {
             valid = true;
@@ -150,28 +154,40 @@ private:
     };
     
     // Internal highlighting methods
-    std::unique_ptr<std::vector<SyntaxStyle>> highlightLine_nolock(size_t line);
-    bool highlightLines_nolock(size_t startLine, size_t endLine, const std::chrono::milliseconds& timeout);
+    bool highlightLine_nolock(size_t line, const ThreadPool::CancellationToken* token = nullptr);
+    std::unique_ptr<std::vector<SyntaxStyle>> highlightText_nolock(size_t line, const std::string& lineText,
+                                                                   LexerState& state);
+    bool highlightAndCache_nolock(size_t line, const std::string& lineText);
+    bool relexFollowingLines_nolock(const ITextBuffer* buffer, size_t line,
+                                    const std::chrono::steady_clock::time_point& startTime,
+                                    const std::chrono::milliseconds& timeout,
+                                    const ThreadPool::CancellationToken* token);
+    LexerState lineStartState_nolock(size_t line) const;
+    bool highlightLines_nolock(size_t startLine, size_t endLine, const std::chrono::milliseconds& timeout,
+                               const ThreadPool::CancellationToken* token = nullptr);
+    bool highlightRange_nolock(const ITextBuffer* buffer, size_t startLine, size_t endLine,
+                               const std::chrono::steady_clock::time_point& startTime,
+                               const std::chrono::milliseconds& timeout, const char* rangeName,
+                               const ThreadPool::CancellationToken* token);
     void invalidateAllLines_nolock();
     void invalidateLines_nolock(size_t startLine, size_t endLine);
-    void evictLRUEntries_nolock(size_t countToEvict) const;
-    void evictLinesOlderThan_nolock(const std::chrono::steady_clock::time_point& threshold) const;
-    void markAsRecentlyProcessed(size_t line);
-    bool wasRecentlyProcessed(size_t line) const;
+    void evictLines_nolock(size_t keepStart, size_t keepEnd);
     std::pair<size_t, size_t> calculateOptimalProcessingRange(size_t requestedStart, size_t requestedEnd) const;
     
     // Cache query methods
     bool isLineInCache(size_t line) const;
     bool isLineValid(size_t line) const;
-    bool isEntryExpired_nolock(size_t line) const;
     
     // Thread pool task methods
     void processVisibleRangeAsync(size_t startLine, size_t endLine) const;
     void processSingleLineAsync(size_t line);
-    void taskHighlightLines(size_t startLine, size_t endLine, TaskType taskType) const;
-    void taskHighlightLine(size_t line);
+    void taskHighlightLines(size_t startLine, size_t endLine, TaskType taskType,
+                            const ThreadPool::CancellationToken& token) const;
+    void taskHighlightLine(size_t line, const ThreadPool::CancellationToken& token);
+    void cancelActiveTasks() const;
     
     // Thread priority helpers
+    Executor::Lane getTaskLane(TaskType taskType) const;
     ThreadPool::Priority getTaskPriority(TaskType taskType) const;
     bool shouldQueueTask(TaskType taskType) const;
     
@@ -202,17 +218,8 @@ private:
     // Whether syntax highlighting is enabled
     std::atomic<bool> enabled_{true}; // Changed to atomic for lock-free reads
     
-    // Cache of highlighted lines
-    mutable std::vector<std::unique_ptr<CacheEntry>> cachedStyles_;
-    
-    // Set of invalidated lines (awaiting rehighlighting)
-    mutable std::unordered_set<size_t> invalidatedLines_;
-    
-    // Track line timestamps (for eviction)
-    mutable std::unordered_map<size_t, std::chrono::steady_clock::time_point> lineTimestamps_;
-    
-    // Track line access times (for LRU)
-    mutable std::unordered_map<size_t, std::chrono::steady_clock::time_point> lineAccessTimes_;
+    // Cache of highlighted lines, with their validity and clock bits
+    StyleCache styleCache_;
     
     // Current visible range of lines
     mutable std::atomic<size_t> visibleStartLine_{0};
@@ -227,11 +234,9 @@ private:
     // Last processed range for optimization
     ProcessedRange lastProcessedRange_;
     
-    // Track processed ranges for optimization
-    mutable std::deque<ProcessedRange> processedRanges_;
-    
-    // Track recently processed lines to avoid duplicate work
-    mutable std::unordered_map<size_t, std::chrono::steady_clock::time_point> recentlyProcessedLines_;
+    // Reused copy of the line being highlighted, so highlighting a range
+    // does not allocate a string per line
+    std::string lineScratch_;
     
     // Debug logging flag
     bool debugLoggingEnabled_ = false;
@@ -239,12 +244,52 @@ private:
     // Static debug logging flag - used for all instances
     static bool globalDebugLoggingEnabled_;
     
-    // Thread pool for background highlighting
-    std::unique_ptr<ThreadPool> threadPool_;
+    // Submit a task and count it until it finishes or is dropped
+    template<class F, class... Args>
+    std::future<void> submitTask(TaskType taskType, const ThreadPool::CancellationToken& token,
+                                 F&& f, Args&&... args) const;
+    void waitForTasks() const;
+    
+    // Executor for background highlighting, shared with the rest of the editor
+    std::shared_ptr<Executor> executor_;
+    
+    // Tasks submitted and not yet finished; they hold a raw this pointer,
+    // so the destructor waits for them since the executor outlives us
+    mutable std::mutex tasksMutex_;
+    mutable std::condition_variable tasksDone_;
+    mutable size_t tasksInFlight_ = 0;
+    
+    // A submitted task and the token that cancels it
+    struct ActiveTask {
+        ThreadPool::CancellationToken token;
+        std::future<void> future;
+        
+        bool isRunning() const {
+            return future.valid() && future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready;
+        }
+    };
+    
+    // An active task for the lines [startLine, endLine]
+    struct RangeTask : ActiveTask {
+        size_t endLine = 0;
+    };
+    
+    // Guards the active task maps; taken without mutex_ or under it, never
+    // the other way round, so requests made while highlighting can queue work
+    mutable std::mutex activeTasksMutex_;
     
     // Track active tasks for each line to prevent duplicate work
-    mutable std::unordered_map<size_t, std::future<void>> activeLineTasks_;
-    
-    // Track tasks for ranges (startLine-endLine) to prevent duplicate work
-    mutable std::unordered_map<std::string, std::future<void>> activeRangeTasks_;
+    mutable std::unordered_map<size_t, ActiveTask> activeLineTasks_;
+    
+    // Active range tasks keyed by start line; overlapping requests are
+    // coalesced, so the ranges never overlap
+    mutable std::map<size_t, RangeTask> activeRangeTasks_;
+    
+    // Background work counters, see BackgroundStats
+    mutable std::atomic<size_t> rangeTasksSubmitted_{0};
+    mutable std::atomic<size_t> rangeTasksDeduplicated_{0};
+    mutable std::atomic<size_t> rangeTasksCoalesced_{0};
+    mutable std::atomic<size_t> rangeTasksCancelled_{0};
+    std::atomic<size_t> backgroundLinesHighlighted_{0};
+    std::atomic<size_t> backgroundLinesOffscreen_{0};
 }; 
\ No newline at end of file
@@ -4,6 +4,19 @@
 #include <ostream>       // For std::ostream (needed for printToStream)
 #include <iostream>      // For std::cout, std::endl
 #include <fstream>       // For std::ofstream and std::ifstream
+#include <algorithm>     // For std::min
+#include <filesystem>    // For atomic replacement on save
+#include "LineIndexer.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// saveToFile() writes in blocks of at least this many bytes
+constexpr size_t kSaveBlockSize = 1024 * 1024;
+
+} // namespace
 
 TextBuffer::TextBuffer() {
     clear(true); // Start with one empty line
@@ -75,49 +88,85 @@ void TextBuffer::printToStream(std::ostream& os) const {
 
 // File operations
 bool TextBuffer::saveToFile(const std::string& filename) const {
-    std::ofstream outfile(filename);
-    if (!outfile.is_open()) {
-        ErrorReporter::logError("Could not open file for saving: " + filename);
-        return false;
+    // Write next to the target and rename it into place, so a failed save
+    // leaves the original intact and readers never see a partial file
+    std::error_code ec;
+    std::string target = filename;
+    if (fs::is_symlink(filename, ec)) {
+        auto resolved = fs::canonical(filename, ec);
+        if (!ec) {
+            target = resolved.string();
+        }
     }
+    const std::string tempFilename =
+        target + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
 
-    for (const auto& line : lines_) {
-        outfile << line << '\n'; // Append newline, as typical for text files
+    {
+        std::ofstream outfile(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!outfile.is_open()) {
+            ErrorReporter::logError("Could not open file for saving: " + tempFilename);
+            return false;
+        }
+
+        // Gather lines into large blocks; long lines are written straight from
+        // the buffer instead of being copied
+        std::string block;
+        block.reserve(kSaveBlockSize);
+        for (const auto& line : lines_) {
+            if (block.size() + line.size() >= kSaveBlockSize) {
+                outfile.write(block.data(), static_cast<std::streamsize>(block.size()));
+                block.clear();
+            }
+            if (line.size() >= kSaveBlockSize) {
+                outfile.write(line.data(), static_cast<std::streamsize>(line.size()));
+            } else {
+                block.append(line);
+            }
+            block.push_back('\n'); // Append newline, as typical for text files
+        }
+        outfile.write(block.data(), static_cast<std::streamsize>(block.size()));
+
+        outfile.close();
+        if (outfile.fail()) {
+            ErrorReporter::logError("Failed while writing to file: " + tempFilename);
+            fs::remove(tempFilename, ec);
+            return false;
+        }
     }
 
-    if (outfile.fail()) {
-        ErrorReporter::logError("Failed while writing to file: " + filename);
-        outfile.close(); // Attempt to close even on failure
-        return false;
+    // Keep the permissions of the file being replaced
+    auto status = fs::status(target, ec);
+    if (!ec && fs::exists(status)) {
+        fs::permissions(tempFilename, status.permissions(), ec);
     }
 
-    outfile.close();
+    fs::rename(tempFilename, target, ec);
+    if (ec) {
+        ErrorReporter::logError("Could not replace " + target + ": " + ec.message());
+        fs::remove(tempFilename, ec);
+        return false;
+    }
     return true;
 }
 
 bool TextBuffer::loadFromFile(const std::string& filename) {
-    std::ifstream infile(filename);
-    if (!infile.is_open()) {
+    MappedFile file;
+    if (!file.open(filename)) {
         ErrorReporter::logError("Could not open file for loading: " + filename);
         return false;
     }
 
-    lines_.clear(); // Clear existing content before loading
-    std::string current_line;
-    while (std::getline(infile, current_line)) {
-        lines_.push_back(current_line);
-    }
-
-    if (infile.bad()) { // I/O error during read
-        ErrorReporter::logError("An I/O error occurred while reading file: " + filename);
-        infile.close();
-        // lines_.clear(); // Optionally clear partially loaded data on error
+    // The file is split in place from its mapping on all cores; the buffer
+    // only changes once the whole file has been read
+    std::vector<std::string> loaded;
+    try {
+        loaded = LineIndexer::splitLines(file);
+    } catch (const std::exception& ex) {
+        ErrorReporter::logError("An I/O error occurred while reading file: " + filename + " (" + ex.what() + ")");
         return false;
     }
-    // Note: infile.eof() is expected if read to end. infile.fail() might be set if getline fails for other reasons
-    // but eof is not an error in itself for reading. We've read all we could.
 
-    infile.close();
+    lines_ = std::move(loaded);
     return true;
 }
 
@@ -333,6 +382,17 @@ std::vector<std::string> TextBuffer::getAllLines() const {
     return lines_; // Returns a copy of the lines vector
 }
 
+// Visit a range of lines without copying them
+size_t TextBuffer::forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const {
+    const size_t end = std::min(endLine, lines_.size());
+    for (size_t i = startLine; i < end; ++i) {
+        if (!visitor(i, lines_[i])) {
+            return i - startLine + 1;
+        }
+    }
+    return startLine < end ? end - startLine : 0;
+}
+
 // New method: Replace a segment of text within a line
 void TextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol, size_t endCol, const std::string& newText) {
     if (lineIndex >= lines_.size()) {
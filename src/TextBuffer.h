@@ -37,6 +37,7 @@ public:
     size_t lineLength(size_t lineIndex) const override;
     size_t characterCount() const override;
     std::vector<std::string> getAllLines() const override;
+    size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const override;
     
     // Safety improvements
     bool isValidPosition(size_t lineIndex, size_t colIndex) const override;
@@ -1,7 +1,9 @@
 #include "TextBufferOperationQueue.h"
 #include "TextBuffer.h"
 #include "EditorError.h"
+#include "AppDebugLog.h"
 #include <chrono>
+#include <cstddef>
 
 // TextBufferOperation implementation
 TextBufferOperation::TextBufferOperation(OperationFunction operation, bool hasResult)
@@ -63,9 +65,26 @@ std::shared_future<TextBufferOperation::ResultType> TextBufferOperation::getFutu
 }
 
 // TextBufferOperationQueue implementation
-TextBufferOperationQueue::TextBufferOperationQueue()
-    : shutdown_(false)
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+TextBufferOperationQueue::TextBufferOperationQueue(size_t capacity)
+    : mask_(roundUpToPowerOfTwo(capacity) - 1)
 {
+    // Slot i is free for the producer that claims position i
+    slots_.reset(new Slot[mask_ + 1]);
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
 }
 
 TextBufferOperationQueue::~TextBufferOperationQueue() {
@@ -75,60 +94,187 @@ TextBufferOperationQueue::~TextBufferOperationQueue() {
 std::shared_future<TextBufferOperation::ResultType> TextBufferOperationQueue::enqueue(
     TextBufferOperation::OperationFunction operation, bool hasResult) 
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    auto op = std::make_shared<TextBufferOperation>(std::move(operation), hasResult);
+    auto future = op->getFuture();
+    push(nullptr, std::move(op));
+    return future;
+}
+
+void TextBufferOperationQueue::post(TextBufferOperation::OperationFunction operation) {
+    push(std::move(operation), nullptr);
+}
+
+void TextBufferOperationQueue::push(TextBufferOperation::OperationFunction function,
+                                    std::shared_ptr<TextBufferOperation> operation) {
+    // A full ring means the consumer is busy; back off until it frees a slot
+    for (unsigned attempt = 0; ; ++attempt) {
+        if (shutdown_.load(std::memory_order_acquire)) {
+            throw TextBufferException("Cannot enqueue to a shutdown operation queue", 
+                                      EditorException::Severity::EDITOR_ERROR);
+        }
+        if (tryPush(function, operation)) {
+            break;
+        }
+        if (attempt < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
     
-    if (shutdown_) {
-        throw TextBufferException("Cannot enqueue to a shutdown operation queue", 
-                                  EditorException::Severity::Error);
+    // Pairs with the fence in waitForOperations(): either the consumer sees
+    // the published slot before parking, or we see that it is parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumerWaiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_dequeue_.notify_one();
+    }
+}
+
+bool TextBufferOperationQueue::tryPush(TextBufferOperation::OperationFunction& function,
+                                       std::shared_ptr<TextBufferOperation>& operation) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots_[position & mask_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            // The slot is free; claim the position
+            if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer has not freed this slot yet
+            return false;
+        } else {
+            // Another producer claimed the position first
+            position = tail_.load(std::memory_order_relaxed);
+        }
     }
     
-    auto op = std::make_shared<TextBufferOperation>(std::move(operation), hasResult);
-    queue_.push(op);
+    slot->function = std::move(function);
+    slot->operation = std::move(operation);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool TextBufferOperationQueue::hasReadyOperation() const {
+    const size_t position = head_.load(std::memory_order_relaxed);
+    return slots_[position & mask_].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+std::shared_ptr<TextBufferOperation> TextBufferOperationQueue::dequeue() {
+    // Wait until an operation is published or shutdown is requested
+    while (!hasReadyOperation()) {
+        if (shutdown_.load(std::memory_order_acquire) && isEmpty()) {
+            return nullptr;
+        }
+        waitForOperations();
+    }
     
-    // Notify one waiting thread that a new operation is available
-    cv_dequeue_.notify_one();
+    const size_t position = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[position & mask_];
+    auto op = std::move(slot.operation);
+    if (!op) {
+        // Posted functions are wrapped only on this path
+        op = std::make_shared<TextBufferOperation>(std::move(slot.function));
+    }
+    slot.function = nullptr;
+    slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+    head_.store(position + 1, std::memory_order_release);
     
-    return op->getFuture();
+    notifyIfEmpty();
+    return op;
 }
 
-std::shared_ptr<TextBufferOperation> TextBufferOperationQueue::dequeue() {
+size_t TextBufferOperationQueue::drain(TextBuffer& buffer, size_t maxOperations) {
+    size_t executed = 0;
+    size_t position = head_.load(std::memory_order_relaxed);
+    
+    while (executed < maxOperations) {
+        Slot& slot = slots_[position & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            break;
+        }
+        
+        auto function = std::move(slot.function);
+        auto op = std::move(slot.operation);
+        slot.function = nullptr;
+        
+        // Free the slot before running the operation so producers blocked on
+        // a full ring can continue
+        slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+        head_.store(++position, std::memory_order_release);
+        
+        if (op) {
+            op->execute(buffer);
+        } else {
+            try {
+                function(buffer);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception in posted TextBuffer operation: " + std::string(e.what()));
+            }
+        }
+        ++executed;
+    }
+    
+    if (executed > 0) {
+        notifyIfEmpty();
+    }
+    return executed;
+}
+
+bool TextBufferOperationQueue::waitForOperations() {
+    if (hasReadyOperation()) {
+        return true;
+    }
+    
     std::unique_lock<std::mutex> lock(mutex_);
+    consumerWaiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     
-    // Wait until the queue is not empty or shutdown is requested
-    cv_dequeue_.wait(lock, [this] { 
-        return !queue_.empty() || shutdown_;
+    cv_dequeue_.wait(lock, [this] {
+        return hasReadyOperation() || wakeRequested_ || shutdown_.load(std::memory_order_relaxed);
     });
     
-    // If the queue is empty after shutdown, return nullptr
-    if (queue_.empty()) {
-        return nullptr;
+    consumerWaiting_.store(false, std::memory_order_relaxed);
+    wakeRequested_ = false;
+    return hasReadyOperation();
+}
+
+void TextBufferOperationQueue::wake() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeRequested_ = true;
+    cv_dequeue_.notify_one();
+}
+
+void TextBufferOperationQueue::notifyIfEmpty() {
+    if (!isEmpty()) {
+        return;
     }
     
-    // Get the front operation
-    auto op = queue_.front();
-    queue_.pop();
-    
-    // If queue becomes empty, notify any threads waiting for that condition
-    if (queue_.empty()) {
+    // Pairs with the fence in waitUntilEmpty()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (emptyWaiters_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
         cv_empty_.notify_all();
     }
-    
-    return op;
 }
 
 bool TextBufferOperationQueue::isEmpty() const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    return queue_.empty();
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
 }
 
 size_t TextBufferOperationQueue::size() const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    return queue_.size();
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
 }
 
 void TextBufferOperationQueue::shutdown() {
     std::unique_lock<std::mutex> lock(mutex_);
-    shutdown_ = true;
+    shutdown_.store(true, std::memory_order_release);
     
     // Notify all waiting threads
     cv_dequeue_.notify_all();
@@ -136,19 +282,27 @@ void TextBufferOperationQueue::shutdown() {
 }
 
 bool TextBufferOperationQueue::waitUntilEmpty(size_t timeout_ms) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    
-    if (queue_.empty()) {
+    if (isEmpty()) {
         return true;
     }
     
-    if (timeout_ms == 0) {
-        // Wait indefinitely
-        cv_empty_.wait(lock, [this] { return queue_.empty(); });
-        return true;
-    } else {
-        // Wait with timeout
-        return cv_empty_.wait_for(lock, std::chrono::milliseconds(timeout_ms), 
-                                [this] { return queue_.empty(); });
+    emptyWaiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    bool empty;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (timeout_ms == 0) {
+            // Wait indefinitely
+            cv_empty_.wait(lock, [this] { return isEmpty(); });
+            empty = true;
+        } else {
+            // Wait with timeout
+            empty = cv_empty_.wait_for(lock, std::chrono::milliseconds(timeout_ms), 
+                                       [this] { return isEmpty(); });
+        }
     }
-} 
\ No newline at end of file
+    
+    emptyWaiters_.fetch_sub(1, std::memory_order_relaxed);
+    return empty;
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <functional>
-#include <queue>
+#include <cstddef>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
@@ -75,30 +75,82 @@ private:
 
 /**
  * @class TextBufferOperationQueue
- * @brief Thread-safe queue for TextBuffer operations
+ * @brief Bounded multi-producer/single-consumer queue for TextBuffer operations
  * 
- * This class provides a thread-safe queue for TextBuffer operations,
- * allowing operations to be enqueued from any thread and dequeued
- * by the owner thread for execution.
+ * Operations can be enqueued from any thread and are drained by the owner
+ * thread for execution. The queue is a fixed-size ring of slots, each with a
+ * sequence number that tells producers and the consumer whether the slot is
+ * free or holds a published operation, so neither side takes a lock. When the
+ * ring is full, producers wait for the consumer to free a slot.
+ * 
+ * Only one thread may consume at a time (dequeue(), drain() and
+ * waitForOperations()). An idle consumer parks in waitForOperations() and
+ * producers wake it only when it is actually waiting.
  */
 class TextBufferOperationQueue {
 public:
-    TextBufferOperationQueue();
+    static constexpr size_t kDefaultCapacity = 4096;
+    
+    /**
+     * @brief Constructs the queue
+     * @param capacity Maximum number of pending operations, rounded up to a power of two
+     */
+    explicit TextBufferOperationQueue(size_t capacity = kDefaultCapacity);
     ~TextBufferOperationQueue();
     
+    TextBufferOperationQueue(const TextBufferOperationQueue&) = delete;
+    TextBufferOperationQueue& operator=(const TextBufferOperationQueue&) = delete;
+    
     /**
      * @brief Enqueues an operation
      * @param operation The operation to enqueue
      * @return A future that will contain the result of the operation
+     * @throws TextBufferException if the queue has been shut down
      */
     std::shared_future<TextBufferOperation::ResultType> enqueue(TextBufferOperation::OperationFunction operation, bool hasResult = false);
     
     /**
-     * @brief Dequeues an operation
-     * @return The next operation in the queue, or nullptr if the queue is empty
+     * @brief Enqueues a fire-and-forget operation
+     * 
+     * Unlike enqueue(), no promise or TextBufferOperation is allocated.
+     * Exceptions thrown by the operation are logged and discarded.
+     * 
+     * @param operation The operation to enqueue
+     * @throws TextBufferException if the queue has been shut down
+     */
+    void post(TextBufferOperation::OperationFunction operation);
+    
+    /**
+     * @brief Dequeues an operation, waiting until one is available
+     * @return The next operation in the queue, or nullptr once the queue is shut down and empty
      */
     std::shared_ptr<TextBufferOperation> dequeue();
     
+    /**
+     * @brief Executes pending operations on a buffer without waiting
+     * @param buffer The buffer to operate on
+     * @param maxOperations Maximum number of operations to execute
+     * @return The number of operations executed
+     */
+    size_t drain(TextBuffer& buffer, size_t maxOperations = 64);
+    
+    /**
+     * @brief Parks the consumer until an operation is available
+     * 
+     * Also returns when wake() or shutdown() is called.
+     * 
+     * @return True if an operation is ready to be drained
+     */
+    bool waitForOperations();
+    
+    /**
+     * @brief Wakes a consumer parked in waitForOperations()
+     * 
+     * If the consumer is not parked, its next waitForOperations() call
+     * returns immediately instead.
+     */
+    void wake();
+    
     /**
      * @brief Checks if the queue is empty
      * @return True if the queue is empty, false otherwise
@@ -111,6 +163,11 @@ public:
      */
     size_t size() const;
     
+    /**
+     * @brief Returns the maximum number of pending operations
+     */
+    size_t capacity() const { return mask_ + 1; }
+    
     /**
      * @brief Signals that no more operations will be added
      * This will allow waiters on dequeue to return nullptr
@@ -125,9 +182,32 @@ public:
     bool waitUntilEmpty(size_t timeout_ms = 0);
 
 private:
-    std::queue<std::shared_ptr<TextBufferOperation>> queue_;
+    // A ring slot holds either a posted function or a full operation
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        TextBufferOperation::OperationFunction function;
+        std::shared_ptr<TextBufferOperation> operation;
+    };
+    
+    void push(TextBufferOperation::OperationFunction function, std::shared_ptr<TextBufferOperation> operation);
+    bool tryPush(TextBufferOperation::OperationFunction& function, std::shared_ptr<TextBufferOperation>& operation);
+    bool hasReadyOperation() const;
+    void notifyIfEmpty();
+    
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    
+    // Producers and the consumer advance separate counters; keep them on
+    // separate cache lines
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<size_t> head_{0};
+    
+    // Parking state, only touched when a thread is about to sleep or wake one
+    alignas(64) std::atomic<bool> consumerWaiting_{false};
+    std::atomic<size_t> emptyWaiters_{0};
+    std::atomic<bool> shutdown_{false};
+    bool wakeRequested_ = false;
     mutable std::mutex mutex_;
     std::condition_variable cv_dequeue_;
     std::condition_variable cv_empty_;
-    bool shutdown_;
-}; 
\ No newline at end of file
+};
@@ -1,5 +1,7 @@
 #include "TextBuffer.h"
+#include "EditorCoreThreadPool.h"
 #include "AppDebugLog.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -9,165 +11,113 @@
 using namespace std::chrono_literals;
 
 // This demo shows how the TextBuffer can be safely accessed from multiple threads
-// using the operation queue.
+// using the operation queue, and reports the queue's throughput and enqueue latency.
+
+namespace {
+
+// Number of threads submitting operations and operations each submits
+constexpr int kProducerThreads = 4;
+constexpr int kOperationsPerProducer = 50000;
+
+// Every Nth operation waits for its result; the rest are fire-and-forget
+constexpr int kWaitForResultEvery = 100;
+
+double percentile(std::vector<double>& samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+} // namespace
 
 int main() {
     // Initialize logging
     LOG_INIT("TextBufferQueueDemo");
     LOG_DEBUG("Starting TextBuffer queue demo");
-    
-    // Create a TextBuffer
-    TextBuffer buffer;
-    
-    // Add some initial content
-    buffer.addLine("Line 1 - Initial content");
-    buffer.addLine("Line 2 - Initial content");
-    buffer.addLine("Line 3 - Initial content");
-    
-    LOG_DEBUG("Initial buffer content:");
-    for (size_t i = 0; i < buffer.lineCount(); ++i) {
-        LOG_DEBUG("  Line " + std::to_string(i) + ": " + buffer.getLine(i));
-    }
-    
-    // Set the main thread as the owner
-    buffer.setOwnerThread(std::this_thread::get_id());
-    
-    // Create an atomic flag to signal threads to stop
-    std::atomic<bool> stopThreads(false);
-    
-    // Create a thread that simulates a worker thread adding lines
-    std::thread adderThread([&buffer, &stopThreads]() {
-        LOG_DEBUG("Adder thread started");
-        int counter = 0;
-        
-        while (!stopThreads) {
-            // Request to add a line
-            auto future = buffer.requestAddLine("Line added by worker thread - " + std::to_string(counter++));
-            
-            // Wait for the operation to complete
-            try {
-                future.wait();
-                LOG_DEBUG("Adder thread: Line added successfully");
-            }
-            catch (const std::exception& e) {
-                LOG_ERROR("Adder thread: Failed to add line: " + std::string(e.what()));
-            }
-            
-            // Sleep for a short time
-            std::this_thread::sleep_for(100ms);
-        }
-        
-        LOG_DEBUG("Adder thread stopped");
-    });
-    
-    // Create a thread that simulates a worker thread modifying lines
-    std::thread modifierThread([&buffer, &stopThreads]() {
-        LOG_DEBUG("Modifier thread started");
-        int counter = 0;
-        
-        while (!stopThreads) {
-            // Get the current line count
-            size_t lineCount = buffer.lineCount();
-            
-            if (lineCount > 0) {
-                // Pick a random line to modify
-                size_t lineIndex = counter % lineCount;
-                
-                // Request to replace the line
-                auto future = buffer.requestReplaceLine(lineIndex, 
-                    "Line " + std::to_string(lineIndex) + " modified by worker thread - " + 
-                    std::to_string(counter++));
-                
-                // Wait for the operation to complete
-                try {
-                    future.wait();
-                    LOG_DEBUG("Modifier thread: Line " + std::to_string(lineIndex) + " modified successfully");
-                }
-                catch (const std::exception& e) {
-                    LOG_ERROR("Modifier thread: Failed to modify line: " + std::string(e.what()));
-                }
-            }
-            
-            // Sleep for a short time
-            std::this_thread::sleep_for(150ms);
-        }
-        
-        LOG_DEBUG("Modifier thread stopped");
-    });
-    
-    // Create a thread that simulates a worker thread deleting lines
-    std::thread deleterThread([&buffer, &stopThreads]() {
-        LOG_DEBUG("Deleter thread started");
-        
-        while (!stopThreads) {
-            // Get the current line count
-            size_t lineCount = buffer.lineCount();
-            
-            if (lineCount > 3) {  // Keep at least 3 lines
-                // Pick a random line to delete
-                size_t lineIndex = rand() % lineCount;
-                
-                // Request to delete the line
-                auto future = buffer.requestDeleteLine(lineIndex);
-                
-                // Wait for the operation to complete
-                try {
-                    future.wait();
-                    LOG_DEBUG("Deleter thread: Line " + std::to_string(lineIndex) + " deleted successfully");
-                }
-                catch (const std::exception& e) {
-                    LOG_ERROR("Deleter thread: Failed to delete line: " + std::string(e.what()));
+
+    // Create a TextBuffer with some initial content
+    auto buffer = std::make_shared<TextBuffer>();
+    buffer->addLine("Line 1 - Initial content");
+    buffer->addLine("Line 2 - Initial content");
+    buffer->addLine("Line 3 - Initial content");
+
+    // Hand the buffer to the owner thread of the pool; from now on only
+    // that thread touches it, and every other thread goes through the queue
+    EditorCoreThreadPool pool(2);
+    pool.start();
+    pool.assignTextBufferOwnership(buffer);
+    TextBufferOperationQueue& queue = pool.textBufferOperations();
+
+    std::vector<std::vector<double>> enqueueLatencies(kProducerThreads);
+    std::atomic<int> failedOperations(0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducerThreads; ++p) {
+        producers.emplace_back([&queue, &enqueueLatencies, &failedOperations, p]() {
+            auto& latencies = enqueueLatencies[p];
+            latencies.reserve(kOperationsPerProducer);
+
+            for (int i = 0; i < kOperationsPerProducer; ++i) {
+                auto enqueueStart = std::chrono::steady_clock::now();
+
+                if (i % kWaitForResultEvery == 0) {
+                    // Occasionally wait for the operation, as an interactive command would
+                    auto future = queue.enqueue([p, i](TextBuffer& buffer) {
+                        buffer.replaceLine(0, "Line 1 - replaced by producer " + std::to_string(p) +
+                                              " at " + std::to_string(i));
+                    });
+                    latencies.push_back(std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - enqueueStart).count());
+                    try {
+                        future.wait();
+                        future.get();
+                    }
+                    catch (const std::exception& e) {
+                        LOG_ERROR("Producer " + std::to_string(p) + ": operation failed: " + std::string(e.what()));
+                        failedOperations++;
+                    }
+                } else {
+                    queue.post([p, i](TextBuffer& buffer) {
+                        buffer.addLine("Line added by producer " + std::to_string(p) + " - " + std::to_string(i));
+                    });
+                    latencies.push_back(std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - enqueueStart).count());
                 }
             }
-            
-            // Sleep for a short time
-            std::this_thread::sleep_for(200ms);
-        }
-        
-        LOG_DEBUG("Deleter thread stopped");
-    });
-    
-    // Main thread processes the operation queue
-    LOG_DEBUG("Main thread processing operation queue");
-    
-    // Run for a few seconds
-    for (int i = 0; i < 50; ++i) {
-        // Process the operation queue
-        size_t processedCount = buffer.processOperationQueue();
-        
-        if (processedCount > 0) {
-            LOG_DEBUG("Main thread processed " + std::to_string(processedCount) + " operations");
-            
-            // Print the current buffer content
-            LOG_DEBUG("Current buffer content:");
-            for (size_t j = 0; j < buffer.lineCount(); ++j) {
-                LOG_DEBUG("  Line " + std::to_string(j) + ": " + buffer.getLine(j));
-            }
-        }
-        
-        // Sleep for a short time
-        std::this_thread::sleep_for(50ms);
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
     }
-    
-    // Signal threads to stop
-    LOG_DEBUG("Signaling threads to stop");
-    stopThreads = true;
-    
-    // Wait for threads to finish
-    adderThread.join();
-    modifierThread.join();
-    deleterThread.join();
-    
-    // Process any remaining operations
-    size_t processedCount = buffer.processOperationQueue();
-    LOG_DEBUG("Processed " + std::to_string(processedCount) + " remaining operations");
-    
-    // Print the final buffer content
-    LOG_DEBUG("Final buffer content:");
-    for (size_t i = 0; i < buffer.lineCount(); ++i) {
-        LOG_DEBUG("  Line " + std::to_string(i) + ": " + buffer.getLine(i));
+    queue.waitUntilEmpty();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> allLatencies;
+    for (const auto& latencies : enqueueLatencies) {
+        allLatencies.insert(allLatencies.end(), latencies.begin(), latencies.end());
     }
-    
+
+    const size_t totalOperations = allLatencies.size();
+    const double p50 = percentile(allLatencies, 0.50);
+    const double p99 = percentile(allLatencies, 0.99);
+    const double maxLatency = allLatencies.empty() ? 0.0 : *std::max_element(allLatencies.begin(), allLatencies.end());
+
+    pool.shutdown();
+
+    std::cout << "TextBuffer operation queue: " << totalOperations << " operations from "
+              << kProducerThreads << " threads in " << elapsed.count() << " s" << std::endl;
+    std::cout << "  Throughput: " << static_cast<size_t>(totalOperations / elapsed.count()) << " ops/s" << std::endl;
+    std::cout << "  Enqueue latency: p50 " << p50 << " ns, p99 " << p99 << " ns, max " << maxLatency << " ns" << std::endl;
+    std::cout << "  Final line count: " << buffer->lineCount() << ", failed operations: "
+              << failedOperations.load() << std::endl;
+
     LOG_DEBUG("TextBuffer queue demo completed");
-    return 0;
-} 
\ No newline at end of file
+    return failedOperations.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "TextBufferSnapshot.h"
+#include "EditorError.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+// Lines per chunk; rebuilt ranges are split into chunks of at most this size
+constexpr size_t kChunkLines = 512;
+
+} // namespace
+
+// Capture the contents of a buffer
+std::shared_ptr<const TextBufferSnapshot> TextBufferSnapshot::capture(const ITextBuffer& buffer, uint64_t version,
+                                                                      const TextBufferSnapshot* previous,
+                                                                      size_t unchangedPrefix, size_t unchangedSuffix)
+{
+    std::shared_ptr<TextBufferSnapshot> snapshot(new TextBufferSnapshot());
+    snapshot->version_ = version;
+    snapshot->lineCount_ = buffer.lineCount();
+
+    const size_t newCount = snapshot->lineCount_;
+    const size_t oldCount = previous ? previous->lineCount_ : 0;
+
+    // Whole chunks inside the unchanged prefix and suffix are reused; the
+    // lines in between are copied from the buffer. Both ranges are in
+    // lines, so lines after the change may have shifted by any amount.
+    size_t headChunks = 0;
+    size_t tailChunk = 0;
+    if (previous) {
+        const size_t prefix = std::min({unchangedPrefix, oldCount, newCount});
+        const size_t suffix = std::min({unchangedSuffix, oldCount - prefix, newCount - prefix});
+        const auto& starts = previous->chunkStarts_;
+
+        // Chunks that end at or before the prefix end
+        headChunks = static_cast<size_t>(std::upper_bound(starts.begin() + 1, starts.end(), prefix) - starts.begin()) - 1;
+        // The first chunk that starts inside the suffix
+        tailChunk = static_cast<size_t>(std::lower_bound(starts.begin(), starts.end() - 1, oldCount - suffix) - starts.begin());
+    }
+
+    const size_t copyBegin = previous ? previous->chunkStarts_[headChunks] : 0;
+    const size_t copyEnd = previous ? previous->chunkStarts_[tailChunk] + newCount - oldCount : newCount;
+
+    auto& chunks = snapshot->chunks_;
+    if (previous) {
+        chunks.assign(previous->chunks_.begin(), previous->chunks_.begin() + headChunks);
+    }
+
+    // Split the copied range into near-equal chunks so chunk sizes stay
+    // between half and all of kChunkLines as the document is edited
+    const size_t copyCount = copyEnd - copyBegin;
+    const size_t pieces = (copyCount + kChunkLines - 1) / kChunkLines;
+    size_t line = copyBegin;
+    for (size_t piece = 0; piece < pieces; ++piece) {
+        const size_t pieceEnd = copyBegin + copyCount * (piece + 1) / pieces;
+        auto chunk = std::make_shared<Chunk>();
+        chunk->lines.reserve(pieceEnd - line);
+        buffer.forEachLine(line, pieceEnd, [&chunk](size_t, std::string_view text) {
+            chunk->lines.emplace_back(text);
+            return true;
+        });
+        chunks.push_back(std::move(chunk));
+        line = pieceEnd;
+    }
+
+    if (previous) {
+        chunks.insert(chunks.end(), previous->chunks_.begin() + tailChunk, previous->chunks_.end());
+    }
+
+    auto& starts = snapshot->chunkStarts_;
+    starts.reserve(chunks.size() + 1);
+    size_t start = 0;
+    for (const auto& chunk : chunks) {
+        starts.push_back(start);
+        start += chunk->lines.size();
+    }
+    starts.push_back(start);
+
+    if (start != newCount) {
+        throw TextBufferException("Snapshot does not match the buffer it was captured from",
+                                  EditorException::Severity::EDITOR_ERROR);
+    }
+
+    return snapshot;
+}
+
+// Get a line
+const std::string& TextBufferSnapshot::getLine(size_t index) const
+{
+    if (index >= lineCount_) {
+        throw TextBufferException("Line index out of range for snapshot", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    const size_t chunk = static_cast<size_t>(std::upper_bound(chunkStarts_.begin(), chunkStarts_.end(), index) -
+                                             chunkStarts_.begin()) - 1;
+    return chunks_[chunk]->lines[index - chunkStarts_[chunk]];
+}
+
+// Visit a range of lines
+size_t TextBufferSnapshot::forEachLine(size_t startLine, size_t endLine, const ITextBuffer::LineVisitor& visitor) const
+{
+    const size_t end = std::min(endLine, lineCount_);
+    if (startLine >= end) {
+        return 0;
+    }
+
+    size_t chunk = static_cast<size_t>(std::upper_bound(chunkStarts_.begin(), chunkStarts_.end(), startLine) -
+                                       chunkStarts_.begin()) - 1;
+    size_t lineIndex = startLine;
+    for (; lineIndex < end; ++chunk) {
+        const auto& lines = chunks_[chunk]->lines;
+        for (size_t i = lineIndex - chunkStarts_[chunk]; i < lines.size() && lineIndex < end; ++i, ++lineIndex) {
+            if (!visitor(lineIndex, lines[i])) {
+                return lineIndex - startLine + 1;
+            }
+        }
+    }
+    return lineIndex - startLine;
+}
+
+// Get all lines
+std::vector<std::string> TextBufferSnapshot::getAllLines() const
+{
+    std::vector<std::string> lines;
+    lines.reserve(lineCount_);
+    for (const auto& chunk : chunks_) {
+        lines.insert(lines.end(), chunk->lines.begin(), chunk->lines.end());
+    }
+    return lines;
+}
+
+// Count the chunks shared with another snapshot
+size_t TextBufferSnapshot::sharedChunkCount(const TextBufferSnapshot& other) const
+{
+    std::unordered_set<const Chunk*> mine;
+    for (const auto& chunk : chunks_) {
+        mine.insert(chunk.get());
+    }
+
+    size_t shared = 0;
+    for (const auto& chunk : other.chunks_) {
+        shared += mine.count(chunk.get());
+    }
+    return shared;
+}
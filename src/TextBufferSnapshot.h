@@ -0,0 +1,88 @@
+#pragma once
+
+#include "interfaces/ITextBuffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Immutable, versioned view of a text buffer
+ *
+ * A snapshot holds the document as a list of immutable chunks of lines.
+ * Capturing a new snapshot from an earlier one reuses every chunk outside
+ * the range of lines that changed in between, so consecutive snapshots of
+ * a large document share almost all of their storage and a capture after
+ * a keystroke copies only one chunk.
+ *
+ * Snapshots never change once captured. Any number of threads may read
+ * one concurrently without locking, and references returned by getLine()
+ * stay valid for as long as the snapshot is alive.
+ */
+class TextBufferSnapshot {
+public:
+    /**
+     * @brief Capture the contents of a buffer
+     *
+     * The caller must keep the buffer from being modified during the call.
+     *
+     * @param buffer The buffer to capture
+     * @param version The document version the snapshot represents
+     * @param previous An earlier snapshot of the same buffer to share chunks with, or nullptr
+     * @param unchangedPrefix Number of leading lines unchanged since previous
+     * @param unchangedSuffix Number of trailing lines unchanged since previous
+     * @return The new snapshot
+     */
+    static std::shared_ptr<const TextBufferSnapshot> capture(const ITextBuffer& buffer, uint64_t version,
+                                                             const TextBufferSnapshot* previous = nullptr,
+                                                             size_t unchangedPrefix = 0, size_t unchangedSuffix = 0);
+
+    /**
+     * @brief Get the document version this snapshot represents
+     */
+    uint64_t version() const { return version_; }
+
+    size_t lineCount() const { return lineCount_; }
+    bool isEmpty() const { return lineCount_ == 0; }
+
+    /**
+     * @brief Get a line
+     *
+     * @param index The line index
+     * @return The line, valid for the lifetime of the snapshot
+     * @throws TextBufferException if the index is out of range
+     */
+    const std::string& getLine(size_t index) const;
+
+    size_t lineLength(size_t index) const { return getLine(index).length(); }
+
+    /**
+     * @brief Visit a range of lines, as ITextBuffer::forEachLine does
+     */
+    size_t forEachLine(size_t startLine, size_t endLine, const ITextBuffer::LineVisitor& visitor) const;
+
+    std::vector<std::string> getAllLines() const;
+
+    /**
+     * @brief Get the number of chunks (for tests and diagnostics)
+     */
+    size_t chunkCount() const { return chunks_.size(); }
+
+    /**
+     * @brief Count the chunks this snapshot shares with another one
+     */
+    size_t sharedChunkCount(const TextBufferSnapshot& other) const;
+
+private:
+    struct Chunk {
+        std::vector<std::string> lines;
+    };
+
+    TextBufferSnapshot() = default;
+
+    std::vector<std::shared_ptr<const Chunk>> chunks_;
+    std::vector<size_t> chunkStarts_;   ///< First line of each chunk, plus lineCount_ at the end
+    size_t lineCount_ = 0;
+    uint64_t version_ = 0;
+};
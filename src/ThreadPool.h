@@ -1,8 +1,13 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <array>
+#include <chrono>
+#include <optional>
+#include <tuple>
+#include <cstddef>
+#include <new>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -21,9 +26,24 @@
  * This thread pool manages a collection of worker threads that process
  * tasks submitted to the pool. Tasks can be submitted with priorities
  * to ensure important tasks are processed first.
+ * 
+ * Each worker has its own queue per priority. Tasks submitted from a worker
+ * go to that worker's queue and other submissions are spread round-robin,
+ * so submitters and workers rarely touch the same lock. A worker runs its
+ * own tasks first and steals from other workers when it runs dry, always
+ * taking the highest priority task it can find anywhere before looking at
+ * lower priorities.
+ * 
+ * Waiting tasks age: once a NORMAL task has waited one aging interval, or a
+ * LOW task two, it runs ahead of fresh work, so a steady stream of HIGH tasks
+ * cannot starve the rest. Tasks may also carry a deadline and a cancellation
+ * token; a task that is past its deadline or cancelled when a worker picks it
+ * up is dropped without running and counted.
  */
 class ThreadPool {
 public:
+    using Clock = std::chrono::steady_clock;
+
     /**
      * @brief Task priority levels
      */
@@ -33,6 +53,158 @@ public:
         LOW = 2      ///< Low priority tasks (processed last)
     };
 
+    /**
+     * @brief Cooperative cancellation flag
+     * 
+     * Copies share one flag, so a submitter keeps a copy and hands another to
+     * the pool with its tasks. Cancelling drops the tasks that have not
+     * started; running tasks may poll isCancelled() to stop early.
+     */
+    class CancellationToken {
+    public:
+        CancellationToken()
+            : cancelled_(std::make_shared<std::atomic<bool>>(false)) {
+        }
+
+        void cancel() const noexcept {
+            cancelled_->store(true, std::memory_order_release);
+        }
+
+        bool isCancelled() const noexcept {
+            return cancelled_->load(std::memory_order_acquire);
+        }
+
+    private:
+        friend class ThreadPool;
+        std::shared_ptr<std::atomic<bool>> cancelled_;
+    };
+
+    /**
+     * @brief Scheduling options for a submitted task
+     * 
+     * A dropped task never runs, so its future reports
+     * std::future_errc::broken_promise.
+     */
+    struct TaskOptions {
+        Priority priority = Priority::NORMAL;
+        Clock::time_point deadline = Clock::time_point::max();  ///< Dropped if not started by then
+        std::optional<CancellationToken> token;                ///< Dropped if cancelled before it starts
+    };
+
+    /**
+     * @brief Move-only type-erased task
+     * 
+     * Callables up to kInlineSize bytes are stored inline, so wrapping one
+     * does not allocate; larger ones are moved to the heap. Unlike
+     * std::function, move-only callables such as std::packaged_task are
+     * accepted.
+     */
+    class Task {
+    public:
+        static constexpr size_t kInlineSize = 48;
+
+        Task() noexcept = default;
+
+        template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+        Task(F&& f) {
+            using Callable = std::decay_t<F>;
+            if constexpr (fitsInline<Callable>()) {
+                new (storage_) Callable(std::forward<F>(f));
+                ops_ = &InlineModel<Callable>::ops;
+            } else {
+                *reinterpret_cast<Callable**>(storage_) = new Callable(std::forward<F>(f));
+                ops_ = &HeapModel<Callable>::ops;
+            }
+        }
+
+        Task(Task&& other) noexcept {
+            moveFrom(other);
+        }
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            reset();
+        }
+
+        explicit operator bool() const noexcept {
+            return ops_ != nullptr;
+        }
+
+        void operator()() {
+            ops_->invoke(storage_);
+        }
+
+    private:
+        struct Ops {
+            void (*invoke)(void* storage);
+            void (*move)(void* from, void* to) noexcept;
+            void (*destroy)(void* storage) noexcept;
+        };
+
+        template<class Callable>
+        static constexpr bool fitsInline() {
+            return sizeof(Callable) <= kInlineSize && alignof(Callable) <= alignof(std::max_align_t) &&
+                   std::is_nothrow_move_constructible_v<Callable>;
+        }
+
+        template<class Callable>
+        struct InlineModel {
+            static void invoke(void* storage) {
+                (*static_cast<Callable*>(storage))();
+            }
+            static void move(void* from, void* to) noexcept {
+                new (to) Callable(std::move(*static_cast<Callable*>(from)));
+                static_cast<Callable*>(from)->~Callable();
+            }
+            static void destroy(void* storage) noexcept {
+                static_cast<Callable*>(storage)->~Callable();
+            }
+            static constexpr Ops ops{&invoke, &move, &destroy};
+        };
+
+        template<class Callable>
+        struct HeapModel {
+            static void invoke(void* storage) {
+                (**static_cast<Callable**>(storage))();
+            }
+            static void move(void* from, void* to) noexcept {
+                *static_cast<Callable**>(to) = *static_cast<Callable**>(from);
+            }
+            static void destroy(void* storage) noexcept {
+                delete *static_cast<Callable**>(storage);
+            }
+            static constexpr Ops ops{&invoke, &move, &destroy};
+        };
+
+        void moveFrom(Task& other) noexcept {
+            if (other.ops_) {
+                other.ops_->move(other.storage_, storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+
+        void reset() noexcept {
+            if (ops_) {
+                ops_->destroy(storage_);
+                ops_ = nullptr;
+            }
+        }
+
+        alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+        const Ops* ops_ = nullptr;
+    };
+
     /**
      * @brief Constructor
      * 
@@ -52,10 +224,15 @@ public:
         
         LOG_DEBUG("Creating ThreadPool with " + std::to_string(numThreads) + " threads");
         
+        // Create the queues before any worker can look at them
+        for (size_t i = 0; i < numThreads; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
+        
         // Create worker threads
         for (size_t i = 0; i < numThreads; ++i) {
-            workers_.emplace_back([this] {
-                workerThread();
+            workers_.emplace_back([this, i] {
+                workerThread(i);
             });
         }
     }
@@ -66,12 +243,7 @@ public:
      * Stops all worker threads and waits for them to finish.
      */
     ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            stop_ = true;
-        }
-        
-        condition_.notify_all();
+        shutdown();
         
         for (std::thread& worker : workers_) {
             if (worker.joinable()) {
@@ -95,32 +267,45 @@ public:
     template<class F, class... Args>
     auto submit(Priority priority, F&& f, Args&&... args) 
         -> std::future<typename std::invoke_result<F, Args...>::type> {
+        TaskOptions options;
+        options.priority = priority;
+        return submit(options, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+    
+    /**
+     * @brief Submit a task with a priority, deadline and cancellation token
+     * 
+     * @param options The scheduling options
+     * @param f The function to execute
+     * @param args The function arguments
+     * @return A future that will contain the function's return value, or
+     *         report broken_promise if the task is dropped
+     */
+    template<class F, class... Args>
+    auto submit(const TaskOptions& options, F&& f, Args&&... args) 
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
         
         using ReturnType = typename std::invoke_result<F, Args...>::type;
         
-        // Create a packaged task with the function and its arguments
-        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
+        // The packaged task owns the function and its arguments and is small
+        // enough to live inline in the Task, so its shared state is the only
+        // allocation. The task runs once, so the arguments are moved into the
+        // call, which also lets move-only arguments be taken by value.
+        std::packaged_task<ReturnType()> task(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> ReturnType {
+                return std::apply(std::move(f), std::move(args));
+            });
         
         // Get future for result
-        std::future<ReturnType> result = task->get_future();
+        std::future<ReturnType> result = task.get_future();
         
-        // Add task to queue
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            
-            // Don't allow enqueueing after stopping the pool
-            if (stop_) {
-                throw std::runtime_error("Cannot enqueue task on stopped ThreadPool");
-            }
-            
-            // Add task to appropriate priority queue
-            tasks_[static_cast<int>(priority)].emplace([task]() { (*task)(); });
+        QueuedTask queued;
+        queued.task = Task(std::move(task));
+        queued.deadline = options.deadline;
+        if (options.token) {
+            queued.cancelled = options.token->cancelled_;
         }
-        
-        // Notify a waiting thread
-        condition_.notify_one();
+        enqueue(options.priority, std::move(queued));
         
         return result;
     }
@@ -148,9 +333,42 @@ public:
      * 
      * @return The total number of queued tasks across all priorities
      */
-    size_t getQueueSize() {
-        std::unique_lock<std::mutex> lock(queueMutex_);
-        return tasks_[0].size() + tasks_[1].size() + tasks_[2].size();
+    size_t getQueueSize() const {
+        return pendingTasks_.load();
+    }
+    
+    /**
+     * @brief Get the number of tasks dropped because they were cancelled
+     */
+    size_t getCancelledTaskCount() const {
+        return cancelledTasks_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Get the number of tasks dropped because their deadline passed
+     */
+    size_t getExpiredTaskCount() const {
+        return expiredTasks_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Get the number of tasks that ran ahead of their priority because they aged
+     */
+    size_t getPromotedTaskCount() const {
+        return promotedTasks_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Set how long a task waits before moving up one priority level
+     * 
+     * @param interval The aging interval; zero disables aging
+     */
+    void setAgingInterval(Clock::duration interval) {
+        agingInterval_.store(interval.count(), std::memory_order_relaxed);
+    }
+    
+    Clock::duration getAgingInterval() const {
+        return Clock::duration(agingInterval_.load(std::memory_order_relaxed));
     }
     
     /**
@@ -161,7 +379,7 @@ public:
      */
     void shutdown() {
         {
-            std::unique_lock<std::mutex> lock(queueMutex_);
+            std::unique_lock<std::mutex> lock(sleepMutex_);
             stop_ = true;
         }
         
@@ -169,58 +387,214 @@ public:
     }
 
 private:
+    static constexpr size_t kPriorityCount = 3;
+    
+    // Default time a task waits before moving up one priority level
+    static constexpr std::chrono::milliseconds kDefaultAgingInterval{100};
+    
+    // A task with its scheduling state
+    struct QueuedTask {
+        Task task;
+        Clock::time_point enqueued;
+        Clock::time_point deadline = Clock::time_point::max();
+        std::shared_ptr<std::atomic<bool>> cancelled;  ///< Null when the task has no token
+    };
+    
+    // One worker's queues, one per priority
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::array<std::deque<QueuedTask>, kPriorityCount> tasks;
+    };
+    
+    /**
+     * @brief Add a task to a worker queue and wake a sleeping worker
+     */
+    void enqueue(Priority priority, QueuedTask task) {
+        // Count the task before publishing it, so the count never drops below
+        // the number of queued tasks and workers do not sleep while it is queued
+        pendingTasks_.fetch_add(1);
+        
+        // Don't allow enqueueing after stopping the pool
+        if (stop_) {
+            pendingTasks_.fetch_sub(1);
+            throw std::runtime_error("Cannot enqueue task on stopped ThreadPool");
+        }
+        
+        // Workers keep their own tasks; other threads spread them round-robin
+        const size_t level = static_cast<size_t>(priority);
+        size_t index = (currentPool_ == this) ? currentWorker_ : nextQueue_.fetch_add(1) % queues_.size();
+        task.enqueued = Clock::now();
+        {
+            WorkerQueue& queue = *queues_[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks[level].push_back(std::move(task));
+            pendingByPriority_[level].fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        // Notify a waiting thread
+        if (sleepingWorkers_.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            condition_.notify_one();
+        }
+    }
+    
+    /**
+     * @brief Take the oldest task that has aged past its priority, if any
+     * 
+     * A task at priority level p has aged once it has waited p aging
+     * intervals. Only the front of each queue is looked at, since tasks
+     * are queued in order. Checks that find nothing are spaced out, so a
+     * busy pool with lower priority work queued does not pay for a full
+     * scan on every task.
+     */
+    bool takeAgedTask(size_t index, QueuedTask& task) {
+        const Clock::rep aging = agingInterval_.load(std::memory_order_relaxed);
+        if (aging <= 0) {
+            return false;
+        }
+        
+        bool waiting = false;
+        for (size_t priority = 1; priority < kPriorityCount; ++priority) {
+            waiting = waiting || pendingByPriority_[priority].load(std::memory_order_relaxed) > 0;
+        }
+        if (!waiting) {
+            return false;
+        }
+        
+        const Clock::time_point now = Clock::now();
+        if (now.time_since_epoch().count() < nextAgingCheck_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        
+        // Lowest priority first, since its tasks have waited the longest to get here
+        const size_t count = queues_.size();
+        for (size_t priority = kPriorityCount - 1; priority > 0; --priority) {
+            if (pendingByPriority_[priority].load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            const Clock::time_point cutoff = now - Clock::duration(aging * static_cast<Clock::rep>(priority));
+            for (size_t offset = 0; offset < count; ++offset) {
+                WorkerQueue& queue = *queues_[(index + offset) % count];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                auto& tasks = queue.tasks[priority];
+                if (tasks.empty() || tasks.front().enqueued > cutoff) {
+                    continue;
+                }
+                
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                pendingByPriority_[priority].fetch_sub(1, std::memory_order_relaxed);
+                pendingTasks_.fetch_sub(1);
+                promotedTasks_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        
+        nextAgingCheck_.store((now + Clock::duration(aging / kAgingChecksPerInterval)).time_since_epoch().count(),
+                              std::memory_order_relaxed);
+        return false;
+    }
+    
+    /**
+     * @brief Take the highest priority task available to a worker
+     * 
+     * Aged tasks come first. Otherwise the worker's own queue wins ties and
+     * the other workers are searched, starting with the next one, before
+     * moving to a lower priority.
+     */
+    bool takeTask(size_t index, QueuedTask& task) {
+        if (takeAgedTask(index, task)) {
+            return true;
+        }
+        
+        const size_t count = queues_.size();
+        for (size_t priority = 0; priority < kPriorityCount; ++priority) {
+            for (size_t offset = 0; offset < count; ++offset) {
+                WorkerQueue& queue = *queues_[(index + offset) % count];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                auto& tasks = queue.tasks[priority];
+                if (tasks.empty()) {
+                    continue;
+                }
+                
+                // Own tasks run in submission order; thieves take the newest
+                // task, which the owner would have reached last
+                if (offset == 0) {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                } else {
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                }
+                pendingByPriority_[priority].fetch_sub(1, std::memory_order_relaxed);
+                pendingTasks_.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * @brief Check whether a task should be dropped rather than run
+     */
+    bool shouldDrop(const QueuedTask& task) {
+        if (task.cancelled && task.cancelled->load(std::memory_order_acquire)) {
+            cancelledTasks_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (task.deadline != Clock::time_point::max() && Clock::now() > task.deadline) {
+            expiredTasks_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+    
     /**
      * @brief Worker thread function
      * 
-     * Continuously pulls tasks from the queue and executes them.
+     * Continuously pulls tasks from the queues and executes them.
      */
-    void workerThread() {
+    void workerThread(size_t index) {
+        currentPool_ = this;
+        currentWorker_ = index;
+        
         try {
             while (true) {
-                std::function<void()> task;
+                QueuedTask task;
                 
-                // Get a task from the queue
-                {
-                    std::unique_lock<std::mutex> lock(queueMutex_);
-                    
-                    // Wait for a task or stop signal
+                if (!takeTask(index, task)) {
+                    // Sleep until a task is submitted or the pool stops; a
+                    // submitter that sees sleepingWorkers_ at zero knows we
+                    // will see its task in pendingTasks_
+                    std::unique_lock<std::mutex> lock(sleepMutex_);
+                    sleepingWorkers_.fetch_add(1);
                     condition_.wait(lock, [this] {
-                        return stop_ || !tasks_[0].empty() || !tasks_[1].empty() || !tasks_[2].empty();
+                        return stop_ || pendingTasks_.load() > 0;
                     });
+                    sleepingWorkers_.fetch_sub(1);
                     
                     // Exit if stopped and no more tasks
-                    if (stop_ && tasks_[0].empty() && tasks_[1].empty() && tasks_[2].empty()) {
+                    if (stop_ && pendingTasks_.load() == 0) {
                         return;
                     }
-                    
-                    // Get highest priority task available
-                    if (!tasks_[0].empty()) {
-                        // High priority
-                        task = std::move(tasks_[0].front());
-                        tasks_[0].pop();
-                    } else if (!tasks_[1].empty()) {
-                        // Normal priority
-                        task = std::move(tasks_[1].front());
-                        tasks_[1].pop();
-                    } else if (!tasks_[2].empty()) {
-                        // Low priority
-                        task = std::move(tasks_[2].front());
-                        tasks_[2].pop();
-                    }
+                    continue;
+                }
+                
+                // Stale work is destroyed unrun, which breaks its promise
+                if (shouldDrop(task)) {
+                    continue;
                 }
                 
                 // Execute the task
-                if (task) {
-                    activeThreads_++;
-                    try {
-                        task();
-                    } catch (const std::exception& e) {
-                        LOG_ERROR("Exception in thread pool task: " + std::string(e.what()));
-                    } catch (...) {
-                        LOG_ERROR("Unknown exception in thread pool task");
-                    }
-                    activeThreads_--;
+                activeThreads_++;
+                try {
+                    task.task();
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Exception in thread pool task: " + std::string(e.what()));
+                } catch (...) {
+                    LOG_ERROR("Unknown exception in thread pool task");
                 }
+                activeThreads_--;
             }
         } catch (const std::exception& e) {
             LOG_ERROR("Exception in worker thread: " + std::string(e.what()));
@@ -235,10 +609,28 @@ private:
     std::atomic<bool> stop_;
     std::atomic<size_t> activeThreads_;
     
-    // Task queues (one for each priority level)
-    std::array<std::queue<std::function<void()>>, 3> tasks_;
+    // Task queues (one set per worker)
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<size_t> pendingTasks_{0};
+    std::array<std::atomic<size_t>, kPriorityCount> pendingByPriority_{};
+    std::atomic<size_t> nextQueue_{0};
+    
+    // Aging, in Clock ticks
+    static constexpr Clock::rep kAgingChecksPerInterval = 8;
+    std::atomic<Clock::rep> agingInterval_{std::chrono::duration_cast<Clock::duration>(kDefaultAgingInterval).count()};
+    std::atomic<Clock::rep> nextAgingCheck_{0};
     
-    // Synchronization
-    std::mutex queueMutex_;
+    // Dropped and promoted task counters
+    std::atomic<size_t> cancelledTasks_{0};
+    std::atomic<size_t> expiredTasks_{0};
+    std::atomic<size_t> promotedTasks_{0};
+    
+    // Synchronization for idle workers
+    std::mutex sleepMutex_;
     std::condition_variable condition_;
-}; 
\ No newline at end of file
+    std::atomic<size_t> sleepingWorkers_{0};
+    
+    // The pool and index of the worker running on this thread, if any
+    static inline thread_local ThreadPool* currentPool_ = nullptr;
+    static inline thread_local size_t currentWorker_ = 0;
+};
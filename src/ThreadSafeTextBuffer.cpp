@@ -1,4 +1,6 @@
 #include "ThreadSafeTextBuffer.h"
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 
 ThreadSafeTextBuffer::ThreadSafeTextBuffer(std::shared_ptr<TextBuffer> buffer)
@@ -23,9 +25,41 @@ void ThreadSafeTextBuffer::lockForWriting() {
 }
 
 void ThreadSafeTextBuffer::unlockWriting() {
+    // Anything may have changed while the lock was held
+    const size_t lineCount = buffer_->lineCount();
+    recordChange(0, lineCount, lineCount);
     mutex_.unlock();
 }
 
+std::shared_ptr<const TextBufferSnapshot> ThreadSafeTextBuffer::snapshot() const {
+    // Concurrent callers are serialized so each change is captured once; the
+    // shared lock only keeps writers out while the changed lines are copied
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex_);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    const uint64_t version = version_.load(std::memory_order_relaxed);
+    if (snapshot_ && snapshot_->version() == version) {
+        return snapshot_;
+    }
+
+    snapshot_ = TextBufferSnapshot::capture(*buffer_, version, snapshot_.get(), unchangedPrefix_, unchangedSuffix_);
+    unchangedPrefix_ = std::numeric_limits<size_t>::max();
+    unchangedSuffix_ = std::numeric_limits<size_t>::max();
+    return snapshot_;
+}
+
+uint64_t ThreadSafeTextBuffer::version() const {
+    return version_.load(std::memory_order_acquire);
+}
+
+// Called with the exclusive lock held after lines [firstLine, endLine) of a
+// buffer that had lineCount lines were changed, inserted at or removed
+void ThreadSafeTextBuffer::recordChange(size_t firstLine, size_t endLine, size_t lineCount) {
+    unchangedPrefix_ = std::min(unchangedPrefix_, firstLine);
+    unchangedSuffix_ = std::min(unchangedSuffix_, lineCount > endLine ? lineCount - endLine : 0);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
 // Read operations with shared locks
 const std::string& ThreadSafeTextBuffer::getLine(size_t index) const {
     std::shared_lock<std::shared_mutex> lock(mutex_);
@@ -57,6 +91,11 @@ std::vector<std::string> ThreadSafeTextBuffer::getAllLines() const {
     return buffer_->getAllLines();
 }
 
+size_t ThreadSafeTextBuffer::forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->forEachLine(startLine, endLine, visitor);
+}
+
 bool ThreadSafeTextBuffer::isValidPosition(size_t lineIndex, size_t colIndex) const {
     std::shared_lock<std::shared_mutex> lock(mutex_);
     return buffer_->isValidPosition(lineIndex, colIndex);
@@ -94,43 +133,57 @@ bool ThreadSafeTextBuffer::isModified() const {
 // Write operations with exclusive locks
 void ThreadSafeTextBuffer::addLine(const std::string& line) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->addLine(line);
+    recordChange(buffer_->lineCount(), buffer_->lineCount(), lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::insertLine(size_t index, const std::string& line) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->insertLine(index, line);
+    recordChange(index, index, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteLine(size_t index) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteLine(index);
+    recordChange(index, index + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::replaceLine(size_t index, const std::string& newLine) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->replaceLine(index, newLine);
+    recordChange(index, index + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::setLine(size_t lineIndex, const std::string& text) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->setLine(lineIndex, text);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteLines(size_t startIndex, size_t endIndex) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteLines(startIndex, endIndex);
+    recordChange(startIndex, endIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::insertLines(size_t index, const std::vector<std::string>& newLines) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->insertLines(index, newLines);
+    recordChange(index, index, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
@@ -145,8 +198,10 @@ bool ThreadSafeTextBuffer::saveToFile(const std::string& filename) const {
 
 bool ThreadSafeTextBuffer::loadFromFile(const std::string& filename) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     bool result = buffer_->loadFromFile(filename);
     if (result) {
+        recordChange(0, lineCount, lineCount);
         modified_.store(false, std::memory_order_release);
     }
     return result;
@@ -154,73 +209,97 @@ bool ThreadSafeTextBuffer::loadFromFile(const std::string& filename) {
 
 void ThreadSafeTextBuffer::insertChar(size_t lineIndex, size_t colIndex, char ch) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->insertChar(lineIndex, colIndex, ch);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteChar(size_t lineIndex, size_t colIndex) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteChar(lineIndex, colIndex);
+    recordChange(lineIndex > 0 ? lineIndex - 1 : 0, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteCharForward(size_t lineIndex, size_t colIndex) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteCharForward(lineIndex, colIndex);
+    recordChange(lineIndex, lineIndex + 2, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol, size_t endCol, const std::string& newText) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->replaceLineSegment(lineIndex, startCol, endCol, newText);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteLineSegment(size_t lineIndex, size_t startCol, size_t endCol) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteLineSegment(lineIndex, startCol, endCol);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::splitLine(size_t lineIndex, size_t colIndex) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->splitLine(lineIndex, colIndex);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::joinLines(size_t lineIndex) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->joinLines(lineIndex);
+    recordChange(lineIndex, lineIndex + 2, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::clear(bool keepEmptyLine) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->clear(keepEmptyLine);
+    recordChange(0, lineCount, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::insertString(size_t lineIndex, size_t colIndex, const std::string& text) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->insertString(lineIndex, colIndex, text);
+    recordChange(lineIndex, lineIndex + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::replaceText(size_t startLine, size_t startCol, size_t endLine, size_t endCol, const std::string& text) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->replaceText(startLine, startCol, endLine, endCol, text);
+    recordChange(startLine, endLine + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::insertText(size_t line, size_t col, const std::string& text) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->insertText(line, col, text);
+    recordChange(line, line + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
 void ThreadSafeTextBuffer::deleteText(size_t startLine, size_t startCol, size_t endLine, size_t endCol) {
     std::unique_lock<std::shared_mutex> lock(mutex_);
+    const size_t lineCount = buffer_->lineCount();
     buffer_->deleteText(startLine, startCol, endLine, endCol);
+    recordChange(startLine, endLine + 1, lineCount);
     modified_.store(true, std::memory_order_release);
 }
 
@@ -235,6 +314,9 @@ std::string& ThreadSafeTextBuffer::getLine(size_t index) {
     // In a truly thread-safe implementation, we would need to return a proxy object or
     // require explicit locking by the caller.
     // For now, we use a unique lock to ensure exclusivity
+    // The caller may write through the reference, so the line counts as changed
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    return buffer_->getLine(index);
+    std::string& line = buffer_->getLine(index);
+    recordChange(index, index + 1, buffer_->lineCount());
+    return line;
 } 
\ No newline at end of file
@@ -2,9 +2,13 @@
 
 #include "interfaces/ITextBuffer.hpp"
 #include "TextBuffer.h"
+#include "TextBufferSnapshot.h"
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <atomic>
+#include <cstdint>
+#include <limits>
 
 /**
  * @brief Thread-safe decorator for TextBuffer
@@ -18,6 +22,9 @@
  *    of the buffer from any thread. Callers must be careful when storing references.
  * 3. For operations that need to be atomic across multiple method calls,
  *    use the lockForReading() and lockForWriting() methods
+ * 4. Background readers that need a consistent multi-line view should take
+ *    a snapshot() instead of holding the read lock: snapshots are immutable,
+ *    so reading one never blocks the writing thread
  */
 class ThreadSafeTextBuffer : public ITextBuffer {
 public:
@@ -43,6 +50,7 @@ public:
     size_t lineLength(size_t lineIndex) const override;
     size_t characterCount() const override;
     std::vector<std::string> getAllLines() const override;
+    size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const override;
     bool isValidPosition(size_t lineIndex, size_t colIndex) const override;
     std::pair<size_t, size_t> clampPosition(size_t lineIndex, size_t colIndex) const override;
     void printToStream(std::ostream& os) const override;
@@ -77,6 +85,33 @@ public:
      */
     std::shared_ptr<TextBuffer> getUnderlyingBuffer() const;
     
+    /**
+     * @brief Get an immutable snapshot of the current document version
+     * 
+     * Repeated calls without intervening changes return the same snapshot.
+     * A new snapshot shares every chunk of lines that did not change with
+     * the previous one, so taking one after a small edit copies only the
+     * lines around the edit; the read lock is held just for that copy.
+     * 
+     * Changes made directly through getUnderlyingBuffer() are not tracked;
+     * make them between lockForWriting() and unlockWriting() instead.
+     * 
+     * @return The snapshot, safe to read from any thread without locking
+     */
+    std::shared_ptr<const TextBufferSnapshot> snapshot() const;
+    
+    /**
+     * @brief Get the current document version
+     * 
+     * The version increases with every change, including every call to the
+     * non-const getLine(), and matches TextBufferSnapshot::version() of a
+     * snapshot taken at that point. Readers can compare the two to decide
+     * whether their snapshot is stale without taking a lock.
+     * 
+     * @return The document version
+     */
+    uint64_t version() const;
+    
     /**
      * @brief Lock for reading
      * 
@@ -134,7 +169,19 @@ public:
     void unlockWriting();
     
 private:
+    // Record a change to lines [firstLine, endLine) of a buffer that had
+    // lineCount lines; the caller holds the exclusive lock
+    void recordChange(size_t firstLine, size_t endLine, size_t lineCount);
+    
     std::shared_ptr<TextBuffer> buffer_;
     mutable std::shared_mutex mutex_;
     mutable std::atomic<bool> modified_{false};
+    
+    // Snapshot state: lines outside the unchanged prefix and suffix have
+    // changed since snapshot_ was captured
+    mutable std::mutex snapshotMutex_;
+    mutable std::shared_ptr<const TextBufferSnapshot> snapshot_;
+    std::atomic<uint64_t> version_{0};
+    mutable size_t unchangedPrefix_ = std::numeric_limits<size_t>::max();
+    mutable size_t unchangedSuffix_ = std::numeric_limits<size_t>::max();
 }; 
\ No newline at end of file
@@ -92,6 +92,20 @@ double ThreadSafeVirtualizedTextBuffer::getCacheHitRate() const
     return buffer_->getCacheHitRate();
 }
 
+// Get the share of cache misses served by the compressed cold tier
+double ThreadSafeVirtualizedTextBuffer::getColdTierHitRate() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->getColdTierHitRate();
+}
+
+// Get the compression ratio of the cold tier
+double ThreadSafeVirtualizedTextBuffer::getCompressionRatio() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->getCompressionRatio();
+}
+
 // Reset the cache statistics
 void ThreadSafeVirtualizedTextBuffer::resetCacheStats()
 {
@@ -99,6 +113,41 @@ void ThreadSafeVirtualizedTextBuffer::resetCacheStats()
     buffer_->resetCacheStats();
 }
 
+// Get cache usage and eviction statistics
+VirtualizedTextBuffer::CacheStats ThreadSafeVirtualizedTextBuffer::getCacheStats() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->getCacheStats();
+}
+
+// Set the memory budget of the page cache
+void ThreadSafeVirtualizedTextBuffer::setCacheByteBudget(size_t bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    buffer_->setCacheByteBudget(bytes);
+}
+
+// Get the memory budget of the page cache
+size_t ThreadSafeVirtualizedTextBuffer::getCacheByteBudget() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->getCacheByteBudget();
+}
+
+// Set the memory budget of the compressed cold tier
+void ThreadSafeVirtualizedTextBuffer::setColdTierByteBudget(size_t bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    buffer_->setColdTierByteBudget(bytes);
+}
+
+// Get the memory budget of the compressed cold tier
+size_t ThreadSafeVirtualizedTextBuffer::getColdTierByteBudget() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->getColdTierByteBudget();
+}
+
 // Prefetch a range of lines
 void ThreadSafeVirtualizedTextBuffer::prefetchLines(size_t startLine, size_t endLine)
 {
@@ -200,6 +249,12 @@ std::vector<std::string> ThreadSafeVirtualizedTextBuffer::getAllLines() const
     return buffer_->getAllLines();
 }
 
+size_t ThreadSafeVirtualizedTextBuffer::forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_->forEachLine(startLine, endLine, visitor);
+}
+
 bool ThreadSafeVirtualizedTextBuffer::isValidPosition(size_t lineIndex, size_t colIndex) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
@@ -54,6 +54,7 @@ public:
     size_t lineLength(size_t lineIndex) const override;
     size_t characterCount() const override;
     std::vector<std::string> getAllLines() const override;
+    size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const override;
     bool isValidPosition(size_t lineIndex, size_t colIndex) const override;
     std::pair<size_t, size_t> clampPosition(size_t lineIndex, size_t colIndex) const override;
     void printToStream(std::ostream& os) const override;
@@ -186,11 +187,58 @@ public:
      */
     double getCacheHitRate() const;
 
+    /**
+     * @brief Get the share of cache misses served by the compressed cold tier
+     * 
+     * @return The cold tier hit rate as a percentage (0-100)
+     */
+    double getColdTierHitRate() const;
+
+    /**
+     * @brief Get the compression ratio of the cold tier
+     * 
+     * @return Uncompressed bytes per compressed byte
+     */
+    double getCompressionRatio() const;
+
     /**
      * @brief Reset the cache statistics
      */
     void resetCacheStats();
 
+    /**
+     * @brief Get cache usage and eviction statistics
+     */
+    VirtualizedTextBuffer::CacheStats getCacheStats() const;
+
+    /**
+     * @brief Set the memory budget of the page cache
+     * 
+     * @param bytes The budget in bytes (0 = limit by page count only)
+     */
+    void setCacheByteBudget(size_t bytes);
+
+    /**
+     * @brief Get the memory budget of the page cache
+     * 
+     * @return The budget in bytes
+     */
+    size_t getCacheByteBudget() const;
+
+    /**
+     * @brief Set the memory budget of the compressed cold tier
+     * 
+     * @param bytes The budget in bytes (0 = keep dirty pages only)
+     */
+    void setColdTierByteBudget(size_t bytes);
+
+    /**
+     * @brief Get the memory budget of the compressed cold tier
+     * 
+     * @return The budget in bytes
+     */
+    size_t getColdTierByteBudget() const;
+
     /**
      * @brief Prefetch a range of lines
      * 
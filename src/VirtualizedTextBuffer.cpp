@@ -2,15 +2,47 @@
 #include "LoggingCompatibility.h"
 #include "EditorError.h"
 #include "AppDebugLog.h"
+#include "LineIndexer.h"
+#include "LineIndexFile.h"
+#include "PageCompressor.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <sstream>
 #include <filesystem>
 #include <cmath>
+#include <cstring>
+#include <iterator>
+#include <tuple>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+void putVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(std::string_view in, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        const unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 // Constructor
 VirtualizedTextBuffer::VirtualizedTextBuffer()
     : isFromFile_(false)
@@ -18,15 +50,9 @@ VirtualizedTextBuffer::VirtualizedTextBuffer()
     , cacheSize_(10)
     , totalLines_(0)
 {
-    // Initialize with one empty page containing one empty line
-    auto page = std::make_shared<Page>();
-    page->lines.resize(1);
-    page->lines[0] = "";
-    page->lastAccessed = std::chrono::steady_clock::now();
-    
-    pageCache_[0] = page;
-    lruList_.push_back(0);
-    totalLines_ = 1;
+    // Initialize with one in-memory page containing one empty line
+    insertLinesInternal(0, {""});
+    setModified(false);
 }
 
 // Constructor with file
@@ -44,79 +70,55 @@ VirtualizedTextBuffer::VirtualizedTextBuffer(const std::string& filename, size_t
 VirtualizedTextBuffer::~VirtualizedTextBuffer()
 {
     LOG_DEBUG("VirtualizedTextBuffer destroyed");
-    
-    // Save any dirty pages
+
+    // Dirty pages are only ever persisted by an explicit saveToFile();
+    // writing them back here would overwrite the source in place.
+    // Pages still referencing the mapping keep it alive on their own.
+    // The prefetch thread installs pages under the shared lock, so it has to
+    // be gone before the lock is taken here.
+    stopPrefetchWorker();
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    for (const auto& pair : pageCache_) {
-        if (pair.second->dirty) {
-            savePage(pair.first, *pair.second);
-        }
-    }
-    
-    // Close the file stream
-    if (fileStream_) {
-        fileStream_->close();
-    }
+    waitForIndexWriter();
+    source_.reset();
 }
 
-// Initialize from file
+// Initialize from file (caller holds the lock)
 void VirtualizedTextBuffer::initFromFile(const std::string& filename)
 {
-    std::unique_lock<std::shared_mutex> lock(mutex_);
-    
     filename_ = filename;
-    
-    // Try to load the index file first
-    if (loadIndexFile()) {
-        // Index file loaded successfully, open the main file
-        fileStream_ = std::make_shared<std::fstream>(filename_, std::ios::in | std::ios::out | std::ios::binary);
-        if (!fileStream_->is_open()) {
-            LOG_ERROR("Failed to open file: " + filename_);
-            throw TextBufferException("Failed to open file: " + filename_, EditorException::Severity::EDITOR_ERROR);
-        }
-    } else {
-        // No index file or invalid, rebuild the index by scanning the file
-        fileStream_ = std::make_shared<std::fstream>(filename_, std::ios::in | std::ios::out | std::ios::binary);
-        if (!fileStream_->is_open()) {
-            LOG_ERROR("Failed to open file: " + filename_);
-            throw TextBufferException("Failed to open file: " + filename_, EditorException::Severity::EDITOR_ERROR);
-        }
-        
+
+    auto source = std::make_shared<MappedFile>();
+    if (!source->open(filename_)) {
+        LOG_ERROR("Failed to open file: " + filename_);
+        throw TextBufferException("Failed to open file: " + filename_, EditorException::Severity::EDITOR_ERROR);
+    }
+    source_ = source;
+
+    // Try to load the index file first, otherwise scan the file
+    if (!loadIndexFile()) {
         rebuildLineIndex();
         updateIndexFile();
     }
-    
-    LOG_DEBUG("Initialized VirtualizedTextBuffer with " + std::to_string(totalLines_) + " lines");
+
+    LOG_DEBUG("Initialized VirtualizedTextBuffer with " + std::to_string(totalLines_) + " lines in " +
+              std::to_string(pages_.size()) + " pages");
 }
 
 // Clear the buffer
 void VirtualizedTextBuffer::clear(bool keepEmptyLine)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    pageCache_.clear();
-    lruList_.clear();
-    lineOffsets_.clear();
+
+    resetPageCache();
+    clearColdTier();
+    pages_.clear();
+    pageLineTree_.clear();
     totalLines_ = 0;
-    
+
     if (keepEmptyLine) {
-        // Add an empty line
-        auto page = std::make_shared<Page>();
-        page->lines.emplace_back("");
-        page->lastAccessed = std::chrono::steady_clock::now();
-        page->dirty = true;
-        
-        pageCache_[0] = page;
-        lruList_.push_back(0);
-        totalLines_ = 1;
-        
-        // Update line offsets if this is a file-backed buffer
-        if (isFromFile_) {
-            lineOffsets_.push_back(0);
-            updateIndexFile();
-        }
+        insertLinesInternal(0, {""});
     }
-    
+
     setModified(true);
 }
 
@@ -124,43 +126,30 @@ void VirtualizedTextBuffer::clear(bool keepEmptyLine)
 bool VirtualizedTextBuffer::loadIndexFile()
 {
     // The index file has the same name as the main file with .idx extension
-    std::string indexFilename = filename_ + ".idx";
-    
-    // Check if the index file exists
-    if (!fs::exists(indexFilename)) {
-        LOG_DEBUG("Index file does not exist: " + indexFilename);
-        return false;
-    }
-    
-    // Check if the index file is newer than the main file
-    auto mainFileTime = fs::last_write_time(filename_);
-    auto indexFileTime = fs::last_write_time(indexFilename);
-    
-    if (indexFileTime < mainFileTime) {
-        LOG_DEBUG("Index file is older than the main file, will rebuild");
+    const std::string indexFilename = filename_ + ".idx";
+
+    auto contents = LineIndexFile::read(indexFilename, LineIndexFile::stamp(filename_, *source_));
+    if (!contents) {
         return false;
     }
-    
-    // Open the index file
-    std::ifstream indexFile(indexFilename, std::ios::binary);
-    if (!indexFile.is_open()) {
-        LOG_ERROR("Failed to open index file: " + indexFilename);
+
+    if (contents->checkpointInterval != pageSize_) {
+        LOG_DEBUG("Index file was written for a different page size, will rebuild");
         return false;
     }
-    
-    // Read the number of lines
-    indexFile.read(reinterpret_cast<char*>(&totalLines_), sizeof(totalLines_));
-    
-    // Read the line offsets
-    lineOffsets_.resize(totalLines_);
-    for (size_t i = 0; i < totalLines_; ++i) {
-        std::streampos offset;
-        indexFile.read(reinterpret_cast<char*>(&offset), sizeof(offset));
-        lineOffsets_[i] = offset;
+
+    std::vector<PageDescriptor> pages;
+    pages.reserve(contents->pages.size());
+    uint64_t offset = 0;
+    for (const auto& page : contents->pages) {
+        pages.push_back({offset, page.length, static_cast<size_t>(page.lineCount), true});
+        offset += page.length;
     }
-    
-    indexFile.close();
-    
+
+    pages_ = std::move(pages);
+    totalLines_ = static_cast<size_t>(contents->lineCount);
+    rebuildPageTree();
+
     LOG_DEBUG("Loaded index file with " + std::to_string(totalLines_) + " lines");
     return true;
 }
@@ -168,303 +157,1120 @@ bool VirtualizedTextBuffer::loadIndexFile()
 // Update the index file
 void VirtualizedTextBuffer::updateIndexFile() const
 {
-    if (!isFromFile_ || filename_.empty()) {
+    if (!isFromFile_ || filename_.empty() || !source_ || !source_->isOpen()) {
         return;
     }
-    
-    // The index file has the same name as the main file with .idx extension
-    std::string indexFilename = filename_ + ".idx";
-    
-    // Open the index file
-    std::ofstream indexFile(indexFilename, std::ios::binary);
-    if (!indexFile.is_open()) {
-        LOG_ERROR("Failed to create index file: " + indexFilename);
+
+    // The index only describes the source file, so it cannot represent edits
+    if (!isSourceIntact()) {
         return;
     }
-    
-    // Write the number of lines
-    indexFile.write(reinterpret_cast<const char*>(&totalLines_), sizeof(totalLines_));
-    
-    // Write the line offsets
-    for (const auto& offset : lineOffsets_) {
-        indexFile.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+
+    LineIndexFile::Contents contents;
+    contents.checkpointInterval = pageSize_;
+    contents.lineCount = totalLines_;
+    contents.pages.reserve(pages_.size());
+    for (const auto& page : pages_) {
+        contents.pages.push_back({page.sourceLength, page.lineCount});
     }
-    
-    indexFile.close();
-    
-    LOG_DEBUG("Updated index file with " + std::to_string(totalLines_) + " lines");
+
+    // The modification time is taken now so that a later change to the file
+    // invalidates the index; fingerprinting and writing happen off this path
+    const std::string filename = filename_;
+    std::error_code ec;
+    const auto writeTime = fs::last_write_time(filename, ec);
+    const int64_t modificationTime = ec ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+    waitForIndexWriter();
+    indexWriter_ = std::thread([source = source_, filename, modificationTime, contents = std::move(contents)]() mutable {
+        contents.stamp = LineIndexFile::stamp(filename, *source);
+        contents.stamp.modificationTime = modificationTime;
+        if (LineIndexFile::write(filename + ".idx", contents)) {
+            LOG_DEBUG("Updated index file with " + std::to_string(contents.lineCount) + " lines");
+        }
+    });
+}
+
+// Wait for a pending background index write
+void VirtualizedTextBuffer::waitForIndexWriter() const
+{
+    if (indexWriter_.joinable()) {
+        indexWriter_.join();
+    }
+}
+
+// Check whether the page directory still describes the source file as is
+bool VirtualizedTextBuffer::isSourceIntact() const
+{
+    if (!source_ || !source_->isOpen()) {
+        return false;
+    }
+
+    // Pages must be unedited and tile the file without gaps (whole pages may have been deleted)
+    uint64_t offset = 0;
+    for (const auto& page : pages_) {
+        if (!page.hasSource || page.sourceOffset != offset) {
+            return false;
+        }
+        offset += page.sourceLength;
+    }
+    return offset == source_->size();
 }
 
-// Rebuild the line index by scanning the file
+// Rebuild the page directory by scanning the file
 void VirtualizedTextBuffer::rebuildLineIndex()
 {
-    if (!fileStream_ || !fileStream_->is_open()) {
-        LOG_ERROR("File stream is not open");
+    if (!source_ || !source_->isOpen()) {
+        LOG_ERROR("Source file is not open");
         return;
     }
-    
+
     LOG_DEBUG("Rebuilding line index for file: " + filename_);
-    
+
     // Clear existing index
-    lineOffsets_.clear();
+    pages_.clear();
     totalLines_ = 0;
-    
-    // Reset file position
-    fileStream_->seekg(0, std::ios::beg);
-    
-    // Scan the file and build the line index
-    std::string line;
-    std::streampos pos = 0;
-    
-    while (std::getline(*fileStream_, line)) {
-        lineOffsets_.push_back(pos);
-        totalLines_++;
-        
-        // Calculate the position of the next line
-        // +1 for the newline character that was consumed by getline
-        pos = fileStream_->tellg();
-        
-        // Show progress for very large files
-        if (totalLines_ % 100000 == 0) {
-            LOG_DEBUG("Indexed " + std::to_string(totalLines_) + " lines so far");
-        }
+
+    // Every pageSize_-th line break closes a page
+    LineIndexer::Result scan;
+    try {
+        scan = LineIndexer::scan(*source_, pageSize_);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to index " + filename_ + ": " + e.what());
+        throw TextBufferException("Failed to index source file: " + filename_, EditorException::Severity::EDITOR_ERROR);
     }
-    
-    // Reset file position
-    fileStream_->clear(); // Clear EOF flag
-    fileStream_->seekg(0, std::ios::beg);
-    
+
+    const uint64_t fileSize = source_->size();
+    pages_.reserve(scan.boundaries.size() + 1);
+
+    uint64_t pageStart = 0;
+    for (uint64_t boundary : scan.boundaries) {
+        pages_.push_back({pageStart, boundary - pageStart, pageSize_, true});
+        pageStart = boundary;
+    }
+
+    // A final line without a terminating newline still counts
+    totalLines_ = static_cast<size_t>(scan.lineBreaks);
+    if (fileSize > 0 && !scan.endsWithLineBreak) {
+        ++totalLines_;
+    }
+
+    const size_t linesInLastPage = totalLines_ - scan.boundaries.size() * pageSize_;
+    if (linesInLastPage > 0) {
+        pages_.push_back({pageStart, fileSize - pageStart, linesInLastPage, true});
+    }
+
+    rebuildPageTree();
+
     LOG_DEBUG("Rebuilt line index with " + std::to_string(totalLines_) + " lines");
 }
 
 // Get the page number for a line index
 size_t VirtualizedTextBuffer::getPageNumber(size_t lineIndex) const
 {
-    return lineIndex / pageSize_;
+    return locateLine(lineIndex).first;
 }
 
-// Get the line index within a page
-size_t VirtualizedTextBuffer::getLineIndexInPage(size_t lineIndex) const
+// Locate a line by descending the Fenwick tree
+std::pair<size_t, size_t> VirtualizedTextBuffer::locateLine(size_t lineIndex) const
 {
-    return lineIndex % pageSize_;
+    const size_t pageCount = pages_.size();
+
+    size_t step = 1;
+    while (step * 2 <= pageCount) {
+        step *= 2;
+    }
+
+    // Find the last page whose first line is <= lineIndex
+    size_t position = 0;
+    size_t remaining = lineIndex;
+    for (; step > 0; step /= 2) {
+        size_t next = position + step;
+        if (next <= pageCount && pageLineTree_[next] <= remaining) {
+            position = next;
+            remaining -= pageLineTree_[next];
+        }
+    }
+
+    return {position, remaining};
 }
 
-// Get a file offset for a line
-std::streampos VirtualizedTextBuffer::getFileOffsetForLine(size_t lineIndex) const
+// Get the global index of the first line of a page
+size_t VirtualizedTextBuffer::pageFirstLine(size_t pageNumber) const
 {
-    if (lineIndex >= lineOffsets_.size()) {
-        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
-        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
+    size_t sum = 0;
+    for (size_t i = pageNumber; i > 0; i -= i & (~i + 1)) {
+        sum += pageLineTree_[i];
     }
-    
-    return lineOffsets_[lineIndex];
+    return sum;
 }
 
-// Load a page from disk
-std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::loadPage(size_t pageNumber) const
+// Rebuild the Fenwick tree from the page directory
+void VirtualizedTextBuffer::rebuildPageTree() const
 {
-    if (!isFromFile_ || !fileStream_ || !fileStream_->is_open()) {
-        LOG_ERROR("Cannot load page: file stream is not open");
-        throw TextBufferException("Cannot load page: file stream is not open", EditorException::Severity::EDITOR_ERROR);
+    cancelPrefetches();
+
+    const size_t pageCount = pages_.size();
+    pageLineTree_.assign(pageCount + 1, 0);
+
+    for (size_t i = 1; i <= pageCount; ++i) {
+        pageLineTree_[i] += pages_[i - 1].lineCount;
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= pageCount) {
+            pageLineTree_[parent] += pageLineTree_[i];
+        }
     }
-    
-    LOG_DEBUG("Loading page " + std::to_string(pageNumber) + " from disk");
-    
-    auto page = std::make_shared<Page>();
-    page->lastAccessed = std::chrono::steady_clock::now();
-    page->dirty = false;
-    
-    // Calculate the range of lines in this page
-    size_t startLine = pageNumber * pageSize_;
-    size_t endLine = std::min(startLine + pageSize_, totalLines_);
-    
-    // Allocate space for the lines
-    page->lines.resize(endLine - startLine);
-    
-    // Load each line in the page
-    for (size_t i = startLine; i < endLine; ++i) {
-        // Seek to the line offset
-        fileStream_->seekg(getFileOffsetForLine(i));
-        
-        // Read the line
-        std::getline(*fileStream_, page->lines[i - startLine]);
+}
+
+// Change the line count of a page and update the prefix sums
+void VirtualizedTextBuffer::adjustPageLineCount(size_t pageNumber, std::ptrdiff_t delta)
+{
+    pages_[pageNumber].lineCount += delta;
+
+    for (size_t i = pageNumber + 1; i < pageLineTree_.size(); i += i & (~i + 1)) {
+        pageLineTree_[i] += delta;
     }
-    
-    cacheMisses_++;
-    return page;
 }
 
-// Get a page from cache or load it from disk
-std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::getPage(size_t pageNumber) const
+// Split an oversized resident page into pages of pageSize_ lines
+void VirtualizedTextBuffer::splitPage(size_t pageNumber)
 {
-    // Check if the page is in cache
     auto it = pageCache_.find(pageNumber);
-    if (it != pageCache_.end()) {
-        // Update the page's access time and position in cache
-        updatePageAccess(pageNumber);
-        
-        // Track access pattern for prefetching
-        updateAccessPattern(pageNumber);
-        
-        // Count as a cache hit
-        cacheHits_++;
-        
-        LOG_DEBUG("Cache hit for page " + std::to_string(pageNumber));
-        
-        return it->second;
+    if (it == pageCache_.end()) {
+        return;
     }
-    
-    // Count as a cache miss
-    cacheMisses_++;
-    
-    LOG_DEBUG("Cache miss for page " + std::to_string(pageNumber));
-    
-    // Page is not in cache, load it from disk
-    auto page = loadPage(pageNumber);
-    
-    // Add the page to cache
-    pageCache_[pageNumber] = page;
-    
-    // Add to appropriate data structure based on eviction policy
-    switch (evictionPolicy_) {
-        case CacheEvictionPolicy::LRU:
-            lruList_.push_back(pageNumber);
-            break;
-            
-        case CacheEvictionPolicy::SLRU:
-            probationarySegment_.push_back(pageNumber);
-            break;
-            
-        case CacheEvictionPolicy::ARC:
-            // Check if this page was in the ghost caches
-            if (ghostRecent_.find(pageNumber) != ghostRecent_.end()) {
-                // Increase p
-                arcP_ = std::min(arcP_ + 1.0, static_cast<double>(cacheSize_));
-                ghostRecent_.erase(pageNumber);
-                frequentlyUsed_.insert(pageNumber);
-            } else if (ghostFrequent_.find(pageNumber) != ghostFrequent_.end()) {
-                // Decrease p
-                arcP_ = std::max(arcP_ - 1.0, 0.0);
-                ghostFrequent_.erase(pageNumber);
-                frequentlyUsed_.insert(pageNumber);
-            } else {
-                recentlyUsed_.insert(pageNumber);
-            }
-            break;
-            
-        case CacheEvictionPolicy::SPATIAL:
-            lruList_.push_back(pageNumber);
-            // New pages get a medium priority
-            spatialScores_[pageNumber] = 0.5;
-            break;
+
+    auto page = it->second;
+    detachPage(*page);
+    scheduleRecharge(page);
+    auto& lines = page->lines;
+
+    // Move everything past the first pageSize_ lines into new pages
+    std::vector<std::shared_ptr<Page>> newPages;
+    for (size_t start = pageSize_; start < lines.size(); start += pageSize_) {
+        size_t end = std::min(start + pageSize_, lines.size());
+
+        auto newPage = std::make_shared<Page>();
+        newPage->lines.assign(std::make_move_iterator(lines.begin() + start),
+                              std::make_move_iterator(lines.begin() + end));
+        newPage->lastAccessed = page->lastAccessed;
+        newPage->dirty = true;
+        newPages.push_back(newPage);
     }
-    
-    // Track access pattern for prefetching
-    updateAccessPattern(pageNumber);
-    
-    // Evict pages if cache is full
-    while (pageCache_.size() > cacheSize_) {
-        evictPage();
+    lines.resize(pageSize_);
+
+    // Update the directory
+    pages_[pageNumber].lineCount = pageSize_;
+    pages_[pageNumber].hasSource = false;
+
+    std::vector<PageDescriptor> descriptors;
+    descriptors.reserve(newPages.size());
+    for (const auto& newPage : newPages) {
+        PageDescriptor descriptor;
+        descriptor.lineCount = newPage->lines.size();
+        descriptors.push_back(descriptor);
     }
-    
-    // Initiate prefetching if appropriate
-    if (prefetchStrategy_ != PrefetchStrategy::NONE) {
-        initiateStrategicPrefetch(pageNumber);
+    pages_.insert(pages_.begin() + pageNumber + 1, descriptors.begin(), descriptors.end());
+
+    renumberPages(pageNumber + 1, static_cast<std::ptrdiff_t>(newPages.size()));
+    rebuildPageTree();
+
+    for (size_t i = 0; i < newPages.size(); ++i) {
+        admitPage(pageNumber + 1 + i, newPages[i], false);
     }
-    
-    return page;
+
+    LOG_DEBUG("Split page " + std::to_string(pageNumber) + " into " + std::to_string(newPages.size() + 1) + " pages");
 }
 
-// Ensure a page is loaded and return a reference to it
-std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::ensurePage(size_t pageNumber, bool forWriting)
+// Remove a run of empty pages from the directory and the cache
+void VirtualizedTextBuffer::removePages(size_t firstPage, size_t count)
 {
-    auto page = getPage(pageNumber);
-    
-    if (forWriting) {
-        markPageDirty(pageNumber);
+    if (count == 0) {
+        return;
     }
-    
-    return page;
+
+    for (size_t i = firstPage; i < firstPage + count; ++i) {
+        forgetPage(i);
+    }
+
+    pages_.erase(pages_.begin() + firstPage, pages_.begin() + firstPage + count);
+    renumberPages(firstPage + count, -static_cast<std::ptrdiff_t>(count));
+    rebuildPageTree();
 }
 
-// Mark a page as dirty
-void VirtualizedTextBuffer::markPageDirty(size_t pageNumber)
+// Shift cached page numbers after pages were added or removed
+void VirtualizedTextBuffer::renumberPages(size_t firstPage, std::ptrdiff_t delta)
 {
-    auto it = pageCache_.find(pageNumber);
-    if (it != pageCache_.end()) {
-        it->second->dirty = true;
-        setModified(true);
+    auto shift = [firstPage, delta](size_t pageNumber) {
+        return pageNumber >= firstPage ? static_cast<size_t>(static_cast<std::ptrdiff_t>(pageNumber) + delta)
+                                       : pageNumber;
+    };
+
+    std::unordered_map<size_t, std::shared_ptr<Page>> cache;
+    cache.reserve(pageCache_.size());
+    for (auto& entry : pageCache_) {
+        cache.emplace(shift(entry.first), std::move(entry.second));
+    }
+    pageCache_ = std::move(cache);
+
+    lruList_.renumber(shift);
+    probationarySegment_.renumber(shift);
+    protectedSegment_.renumber(shift);
+    recentlyUsed_.renumber(shift);
+    frequentlyUsed_.renumber(shift);
+    ghostRecent_.renumber(shift);
+    ghostFrequent_.renumber(shift);
+
+    std::unordered_map<size_t, std::shared_ptr<ColdPage>> coldPages;
+    coldPages.reserve(coldPages_.size());
+    for (auto& entry : coldPages_) {
+        coldPages.emplace(shift(entry.first), std::move(entry.second));
+    }
+    coldPages_ = std::move(coldPages);
+    coldOrder_.renumber(shift);
+
+    std::unordered_map<size_t, SpatialScore> scores;
+    scores.reserve(spatialScores_.size());
+    for (const auto& score : spatialScores_) {
+        scores[shift(score.first)] = score.second;
     }
+    spatialScores_ = std::move(scores);
+
+    // Access history refers to the old numbering; let it rebuild
+    recentAccesses_.clear();
+    transitionCounts_.clear();
+    prefetchQueue_ = std::priority_queue<PrefetchRequest>();
+    cancelPrefetches();
 }
 
-// Save a dirty page to disk
-void VirtualizedTextBuffer::savePage(size_t pageNumber, const Page& page) const
+// Drop every cached page and reset all eviction and prefetch bookkeeping
+void VirtualizedTextBuffer::resetPageCache() const
 {
-    if (!isFromFile_ || !fileStream_ || !fileStream_->is_open()) {
-        LOG_ERROR("Cannot save page: file stream is not open");
-        return;
+    for (auto& entry : pageCache_) {
+        entry.second->charged = false;
+        entry.second->chargedBytes = 0;
+        entry.second->rechargePending = false;
     }
-    
-    if (!page.dirty) {
-        return; // Nothing to save
+    pageCache_.clear();
+    residentBytes_ = 0;
+    unchargedPages_.clear();
+    lruList_.clear();
+    probationarySegment_.clear();
+    protectedSegment_.clear();
+    recentlyUsed_.clear();
+    frequentlyUsed_.clear();
+    ghostRecent_.clear();
+    ghostFrequent_.clear();
+    arcP_ = 0.0;
+    spatialScores_.clear();
+    spatialClock_ = 0;
+    recentAccesses_.clear();
+    transitionCounts_.clear();
+    prefetchQueue_ = std::priority_queue<PrefetchRequest>();
+    cancelPrefetches();
+}
+
+// Drop a page from the cache and all eviction bookkeeping
+void VirtualizedTextBuffer::forgetPage(size_t pageNumber) const
+{
+    uncachePage(pageNumber);
+    lruList_.erase(pageNumber);
+    probationarySegment_.erase(pageNumber);
+    protectedSegment_.erase(pageNumber);
+    recentlyUsed_.erase(pageNumber);
+    frequentlyUsed_.erase(pageNumber);
+    ghostRecent_.erase(pageNumber);
+    ghostFrequent_.erase(pageNumber);
+    spatialScores_.erase(pageNumber);
+    dropColdPage(pageNumber);
+}
+
+// Drop every page of the cold tier, dirty ones included
+void VirtualizedTextBuffer::clearColdTier() const
+{
+    coldPages_.clear();
+    coldOrder_.clear();
+    coldBytes_ = 0;
+    coldRawBytes_ = 0;
+}
+
+// Move an evictable cached page into the cold tier
+void VirtualizedTextBuffer::demotePage(size_t pageNumber) const
+{
+    auto it = pageCache_.find(pageNumber);
+    if (it == pageCache_.end()) {
+        return;
     }
-    
-    LOG_DEBUG("Saving page " + std::to_string(pageNumber) + " to disk");
-    
-    // Calculate the range of lines in this page
-    size_t startLine = pageNumber * pageSize_;
-    size_t endLine = std::min(startLine + pageSize_, totalLines_);
-    
-    // Save each line in the page
-    for (size_t i = startLine; i < endLine; ++i) {
-        // Seek to the line offset
-        fileStream_->seekg(getFileOffsetForLine(i));
-        
-        // Write the line
-        *fileStream_ << page.lines[i - startLine];
-        
-        // Write a newline character if this is not the last line
-        if (i < totalLines_ - 1) {
-            *fileStream_ << '\n';
+
+    // Dirty pages must be kept; clean ones only when the tier has room for them
+    const Page& page = *it->second;
+    if (page.dirty || coldTierByteBudget_ > 0) {
+        auto coldPage = compressPage(page);
+        dropColdPage(pageNumber);
+        coldBytes_ += coldPage->compressed.size();
+        coldRawBytes_ += coldPage->rawSize;
+        if (!coldPage->dirty) {
+            coldOrder_.pushBack(pageNumber);
         }
+        coldPages_[pageNumber] = std::move(coldPage);
     }
-    
-    // Flush the file
-    fileStream_->flush();
+
+    uncachePage(pageNumber);
+    trimColdTier();
 }
 
-// Evict the least recently used page from cache
-void VirtualizedTextBuffer::evictLRUPage() const
+// Compress a page into its cold form
+std::shared_ptr<VirtualizedTextBuffer::ColdPage> VirtualizedTextBuffer::compressPage(const Page& page)
 {
-    if (lruList_.empty()) {
-        return;
+    const size_t lineCount = pageLineCount(page);
+
+    std::string raw;
+    size_t textSize = 0;
+    for (size_t i = 0; i < lineCount; ++i) {
+        textSize += pageLine(page, i).size();
     }
-    
-    // Get the least recently used page
-    size_t pageNumber = lruList_.front();
-    
-    // Remove the page from the LRU list
-    lruList_.erase(lruList_.begin());
-    
-    // Save the page if it's dirty
-    auto it = pageCache_.find(pageNumber);
-    if (it != pageCache_.end() && it->second->dirty) {
-        savePage(pageNumber, *it->second);
+    raw.reserve(lineCount * 2 + textSize);
+
+    for (size_t i = 0; i < lineCount; ++i) {
+        putVarint(raw, pageLine(page, i).size());
     }
-    
-    // Remove the page from cache
-    pageCache_.erase(pageNumber);
-    
-    LOG_DEBUG("Evicted page " + std::to_string(pageNumber) + " from cache");
+    for (size_t i = 0; i < lineCount; ++i) {
+        std::string_view line = pageLine(page, i);
+        raw.append(line.data(), line.size());
+    }
+
+    auto coldPage = std::make_shared<ColdPage>();
+    coldPage->compressed = PageCompressor::compress(raw);
+    coldPage->compressed.shrink_to_fit();
+    coldPage->rawSize = raw.size();
+    coldPage->lineCount = lineCount;
+    coldPage->dirty = page.dirty;
+    return coldPage;
 }
 
-// Update the access time for a page
-void VirtualizedTextBuffer::updatePageAccess(size_t pageNumber) const
+// Rebuild a page from its cold form
+std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::decompressPage(const ColdPage& coldPage,
+                                                                                   size_t pageNumber)
 {
-    // Update the page's access time
-    auto it = pageCache_.find(pageNumber);
-    if (it != pageCache_.end()) {
-        it->second->lastAccessed = std::chrono::steady_clock::now();
+    auto raw = PageCompressor::decompress(coldPage.compressed, coldPage.rawSize);
+
+    auto page = std::make_shared<Page>();
+    page->lastAccessed = std::chrono::steady_clock::now();
+    page->dirty = coldPage.dirty;
+
+    bool valid = raw.has_value();
+    if (valid) {
+        page->storage = std::move(*raw);
+
+        // The line lengths come first, then the lines back to back
+        std::vector<uint64_t> lengths(coldPage.lineCount);
+        size_t pos = 0;
+        for (auto& length : lengths) {
+            if (!getVarint(page->storage, pos, length)) {
+                valid = false;
+                break;
+            }
+        }
+
+        std::string_view text(page->storage);
+        page->views.reserve(coldPage.lineCount);
+        for (size_t i = 0; valid && i < lengths.size(); ++i) {
+            if (lengths[i] > text.size() - pos) {
+                valid = false;
+                break;
+            }
+            page->views.push_back(text.substr(pos, static_cast<size_t>(lengths[i])));
+            pos += static_cast<size_t>(lengths[i]);
+        }
+        valid = valid && pos == text.size();
+    }
+
+    if (!valid) {
+        LOG_ERROR("Compressed copy of page " + std::to_string(pageNumber) + " is corrupt");
+        throw TextBufferException("Compressed page is corrupt", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    page->materialized.store(false, std::memory_order_relaxed);
+    return page;
+}
+
+// Remove a page from the cold tier
+void VirtualizedTextBuffer::dropColdPage(size_t pageNumber) const
+{
+    auto it = coldPages_.find(pageNumber);
+    if (it == coldPages_.end()) {
+        return;
+    }
+
+    coldBytes_ -= it->second->compressed.size();
+    coldRawBytes_ -= it->second->rawSize;
+    coldOrder_.erase(pageNumber);
+    coldPages_.erase(it);
+}
+
+// Drop clean cold pages until the tier fits its budget
+void VirtualizedTextBuffer::trimColdTier() const
+{
+    // Only clean pages are listed in coldOrder_; they can be read from the source again
+    while (coldBytes_ > coldTierByteBudget_ && !coldOrder_.empty()) {
+        dropColdPage(coldOrder_.front());
+    }
+}
+
+// Read a byte range of the source file
+std::string VirtualizedTextBuffer::readSourceRange(uint64_t offset, uint64_t length) const
+{
+    std::string bytes(static_cast<size_t>(length), '\0');
+    if (length == 0) {
+        return bytes;
+    }
+
+    if (!source_->read(offset, bytes.size(), &bytes[0])) {
+        LOG_ERROR("Short read from " + filename_ + " at offset " + std::to_string(offset));
+        throw TextBufferException("Short read from source file: " + filename_, EditorException::Severity::EDITOR_ERROR);
+    }
+
+    return bytes;
+}
+
+// Split a page's byte range into line views
+void VirtualizedTextBuffer::splitIntoViews(std::string_view bytes, std::vector<std::string_view>& views)
+{
+    // Every line in the range ends with '\n' except possibly the last line of the file
+    if (!bytes.empty() && bytes.back() == '\n') {
+        bytes.remove_suffix(1);
+    }
+
+    const char* cursor = bytes.data();
+    const char* end = bytes.data() + bytes.size();
+    while (true) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (!newline) {
+            views.emplace_back(cursor, end - cursor);
+            break;
+        }
+        views.emplace_back(cursor, newline - cursor);
+        cursor = newline + 1;
+    }
+}
+
+// Make sure a page's lines are available as std::string
+bool VirtualizedTextBuffer::materializePage(Page& page)
+{
+    if (page.materialized.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(page.materializeMutex);
+    if (page.materialized.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    page.lines.assign(page.views.begin(), page.views.end());
+    page.materialized.store(true, std::memory_order_release);
+    return true;
+}
+
+// Materialize a page and drop its views (caller holds the unique lock)
+void VirtualizedTextBuffer::detachPage(Page& page)
+{
+    materializePage(page);
+    page.views.clear();
+    page.views.shrink_to_fit();
+    page.source.reset();
+    page.storage.clear();
+    page.storage.shrink_to_fit();
+}
+
+// Get a line of a page without materializing it
+std::string_view VirtualizedTextBuffer::pageLine(const Page& page, size_t lineIndexInPage)
+{
+    if (page.materialized.load(std::memory_order_acquire)) {
+        return page.lines[lineIndexInPage];
+    }
+    return page.views[lineIndexInPage];
+}
+
+// Get the number of lines held by a page
+size_t VirtualizedTextBuffer::pageLineCount(const Page& page)
+{
+    return page.materialized.load(std::memory_order_acquire) ? page.lines.size() : page.views.size();
+}
+
+// Load a page from disk
+std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::loadPage(size_t pageNumber) const
+{
+    if (!isFromFile_ || !source_ || !source_->isOpen()) {
+        LOG_ERROR("Cannot load page: source file is not open");
+        throw TextBufferException("Cannot load page: source file is not open", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    if (pageNumber >= pages_.size() || !pages_[pageNumber].hasSource) {
+        LOG_ERROR("Cannot load page " + std::to_string(pageNumber) + ": it has no source range");
+        throw TextBufferException("Cannot load page: it has no source range", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    return readPage(source_, pages_[pageNumber], pageNumber, filename_);
+}
+
+// Read a page from a source file without touching buffer state
+std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::readPage(const std::shared_ptr<MappedFile>& source,
+                                                                             const PageDescriptor& descriptor,
+                                                                             size_t pageNumber,
+                                                                             const std::string& filename)
+{
+    auto page = std::make_shared<Page>();
+    page->lastAccessed = std::chrono::steady_clock::now();
+    page->dirty = false;
+    page->materialized.store(false, std::memory_order_relaxed);
+    page->views.reserve(descriptor.lineCount);
+
+    // Lines point straight into the mapping; without one the range is read once
+    std::string_view bytes;
+    if (source->isMapped()) {
+        page->source = source;
+        bytes = source->view(descriptor.sourceOffset, descriptor.sourceLength);
+    } else {
+        page->storage.resize(static_cast<size_t>(descriptor.sourceLength));
+        if (!page->storage.empty() && !source->read(descriptor.sourceOffset, page->storage.size(), &page->storage[0])) {
+            LOG_ERROR("Short read from " + filename + " at offset " + std::to_string(descriptor.sourceOffset));
+            throw TextBufferException("Short read from source file: " + filename, EditorException::Severity::EDITOR_ERROR);
+        }
+        bytes = page->storage;
+    }
+
+    if (bytes.size() != descriptor.sourceLength) {
+        LOG_ERROR("Page " + std::to_string(pageNumber) + " lies outside of " + filename);
+        throw TextBufferException("Source file changed since it was indexed: " + filename, EditorException::Severity::EDITOR_ERROR);
+    }
+
+    splitIntoViews(bytes, page->views);
+
+    if (page->views.size() != descriptor.lineCount) {
+        LOG_ERROR("Page " + std::to_string(pageNumber) + " of " + filename + " no longer matches the index");
+        throw TextBufferException("Source file changed since it was indexed: " + filename, EditorException::Severity::EDITOR_ERROR);
+    }
+
+    return page;
+}
+
+// Add a freshly loaded or created page to the cache
+void VirtualizedTextBuffer::admitPage(size_t pageNumber, const std::shared_ptr<Page>& page, bool prefetched) const
+{
+    // ARC learns from a miss on a recently evicted page before it picks a
+    // victim; speculative loads carry no such signal
+    bool arcFrequent = evictionPolicy_ == CacheEvictionPolicy::ARC && !prefetched && adaptARC(pageNumber);
+
+    // Make room first so that the page being admitted is never the victim
+    settleCharges();
+    const size_t incomingBytes = measurePage(*page);
+    while (isOverBudget(incomingBytes) && evictPage()) {
+    }
+
+    pageCache_[pageNumber] = page;
+    page->charged = true;
+    page->chargedBytes = incomingBytes;
+    residentBytes_ += incomingBytes;
+
+    // The resident page is now the only copy
+    dropColdPage(pageNumber);
+
+    // Add to appropriate data structure based on eviction policy. Prefetched
+    // pages enter at the cold end so that speculation never pushes out pages
+    // that were actually requested; a hit moves them to the hot end.
+    switch (evictionPolicy_) {
+        case CacheEvictionPolicy::LRU:
+            if (prefetched) {
+                lruList_.pushFront(pageNumber);
+            } else {
+                lruList_.pushBack(pageNumber);
+            }
+            break;
+
+        case CacheEvictionPolicy::SLRU:
+            if (prefetched) {
+                probationarySegment_.pushFront(pageNumber);
+            } else {
+                probationarySegment_.pushBack(pageNumber);
+            }
+            break;
+
+        case CacheEvictionPolicy::ARC:
+            if (arcFrequent) {
+                frequentlyUsed_.pushBack(pageNumber);
+            } else if (prefetched) {
+                recentlyUsed_.pushFront(pageNumber);
+            } else {
+                recentlyUsed_.pushBack(pageNumber);
+            }
+            trimARCGhosts();
+            break;
+
+        case CacheEvictionPolicy::SPATIAL:
+            if (prefetched) {
+                lruList_.pushFront(pageNumber);
+            } else {
+                lruList_.pushBack(pageNumber);
+            }
+            // New pages get a medium priority
+            setSpatialScore(pageNumber, 0.5);
+            break;
+    }
+}
+
+// Get a page from cache or load it from disk
+std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::getPage(size_t pageNumber) const
+{
+    std::unique_lock<std::mutex> cacheLock(cacheMutex_);
+
+    // Check if the page is in cache
+    auto it = pageCache_.find(pageNumber);
+    if (it != pageCache_.end()) {
+        auto page = it->second;
+
+        // The first request for a prefetched page is what made prefetching it worthwhile
+        if (page->prefetched) {
+            page->prefetched = false;
+            prefetchHits_++;
+        }
+
+        // Update the page's access time and position in cache
+        updatePageAccess(pageNumber);
+
+        // Track access pattern for prefetching
+        trackAccessPinned(pageNumber, *page);
+
+        // Count as a cache hit
+        cacheHits_++;
+
+        return page;
+    }
+
+    // Count as a cache miss
+    cacheMisses_++;
+
+    // Evicted pages are kept compressed; decompressing one beats reading the source
+    std::shared_ptr<ColdPage> coldPage;
+    auto coldIt = coldPages_.find(pageNumber);
+    if (coldIt != coldPages_.end()) {
+        coldPage = coldIt->second;
+        coldHits_++;
+    } else {
+        coldMisses_++;
+    }
+
+    // Page is not in cache, load it. The source is read (or the cold copy
+    // decompressed) without the cache lock so that readers can load
+    // different pages concurrently.
+    cacheLock.unlock();
+    auto page = coldPage ? decompressPage(*coldPage, pageNumber) : loadPage(pageNumber);
+    cacheLock.lock();
+
+    // Another reader or the prefetcher may have loaded the same page in the meantime
+    it = pageCache_.find(pageNumber);
+    if (it != pageCache_.end()) {
+        it->second->prefetched = false;
+        updatePageAccess(pageNumber);
+        return it->second;
+    }
+
+    admitPage(pageNumber, page, false);
+
+    // Track access pattern and initiate prefetching if appropriate
+    trackAccessPinned(pageNumber, *page);
+
+    return page;
+}
+
+// Track an access while keeping the requested page resident
+void VirtualizedTextBuffer::trackAccessPinned(size_t pageNumber, Page& page) const
+{
+    // The requested page must survive the prefetching the access triggers
+    bool wasPinned = page.isPinned;
+    page.isPinned = true;
+    updateAccessPattern(pageNumber);
+    page.isPinned = wasPinned;
+}
+
+// Ensure a page is loaded and return a reference to it
+std::shared_ptr<VirtualizedTextBuffer::Page> VirtualizedTextBuffer::ensurePage(size_t pageNumber, bool forWriting)
+{
+    auto page = getPage(pageNumber);
+
+    if (forWriting) {
+        detachPage(*page);
+        markPageDirty(pageNumber);
+        scheduleRecharge(page);
+    }
+
+    return page;
+}
+
+// Mark a page as dirty
+void VirtualizedTextBuffer::markPageDirty(size_t pageNumber)
+{
+    auto it = pageCache_.find(pageNumber);
+    if (it != pageCache_.end()) {
+        it->second->dirty = true;
+
+        // The source range no longer describes the page; it now lives only in memory
+        pages_[pageNumber].hasSource = false;
+        setModified(true);
+    }
+}
+
+// Get a line for reading (caller holds the lock)
+const std::string& VirtualizedTextBuffer::lineAt(size_t lineIndex) const
+{
+    if (lineIndex >= totalLines_) {
+        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
+        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    auto location = locateLine(lineIndex);
+    auto page = getPage(location.first);
+    if (materializePage(*page)) {
+        // The lines now take memory on top of the views
+        std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+        if (page->charged) {
+            chargePage(*page);
+        }
+    }
+    return page->lines[location.second];
+}
+
+// Get a line for reading without copying it (caller holds the lock)
+std::string_view VirtualizedTextBuffer::lineViewAt(size_t lineIndex, std::shared_ptr<Page>& page) const
+{
+    if (lineIndex >= totalLines_) {
+        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
+        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    auto location = locateLine(lineIndex);
+    page = getPage(location.first);
+    return pageLine(*page, location.second);
+}
+
+// Get a line for writing and mark its page dirty (caller holds the lock)
+std::string& VirtualizedTextBuffer::mutableLineAt(size_t lineIndex)
+{
+    if (lineIndex >= totalLines_) {
+        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
+        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
+    }
+
+    auto location = locateLine(lineIndex);
+    auto page = ensurePage(location.first, true);
+    return page->lines[location.second];
+}
+
+// Insert lines without taking the lock
+void VirtualizedTextBuffer::insertLinesInternal(size_t index, const std::vector<std::string>& newLines)
+{
+    if (newLines.empty()) {
+        return;
+    }
+
+    // An empty buffer gets a fresh in-memory page
+    if (pages_.empty()) {
+        pages_.emplace_back();
+        rebuildPageTree();
+
+        auto page = std::make_shared<Page>();
+        page->lastAccessed = std::chrono::steady_clock::now();
+        page->dirty = true;
+        admitPage(0, page, false);
+    }
+
+    // Appending goes to the end of the last page
+    size_t pageNumber;
+    size_t lineIndexInPage;
+    if (index == totalLines_) {
+        pageNumber = pages_.size() - 1;
+        lineIndexInPage = pages_.back().lineCount;
+    } else {
+        std::tie(pageNumber, lineIndexInPage) = locateLine(index);
+    }
+
+    auto page = ensurePage(pageNumber, true);
+    page->lines.insert(page->lines.begin() + lineIndexInPage, newLines.begin(), newLines.end());
+    adjustPageLineCount(pageNumber, static_cast<std::ptrdiff_t>(newLines.size()));
+    totalLines_ += newLines.size();
+
+    // Keep pages bounded so edits stay local
+    if (pages_[pageNumber].lineCount > 2 * pageSize_) {
+        splitPage(pageNumber);
+    }
+
+    setModified(true);
+}
+
+// Delete the lines [startIndex, endIndex) without taking the lock
+void VirtualizedTextBuffer::deleteLinesInternal(size_t startIndex, size_t endIndex)
+{
+    if (startIndex >= endIndex) {
+        return;
+    }
+
+    size_t remaining = endIndex - startIndex;
+    size_t pageNumber;
+    size_t lineIndexInPage;
+    std::tie(pageNumber, lineIndexInPage) = locateLine(startIndex);
+
+    // Pages that end up empty always form one consecutive run
+    size_t firstEmptied = pages_.size();
+    size_t emptiedCount = 0;
+
+    while (remaining > 0) {
+        const size_t pageLines = pages_[pageNumber].lineCount;
+        const size_t count = std::min(pageLines - lineIndexInPage, remaining);
+
+        if (count == pageLines) {
+            // The whole page goes away; there is no need to load it. Its
+            // source range no longer matches, so it must not be prefetched
+            // while later pages of the range are loaded.
+            adjustPageLineCount(pageNumber, -static_cast<std::ptrdiff_t>(count));
+            pages_[pageNumber].hasSource = false;
+            if (emptiedCount == 0) {
+                firstEmptied = pageNumber;
+            }
+            ++emptiedCount;
+        } else {
+            auto page = ensurePage(pageNumber, true);
+            auto first = page->lines.begin() + lineIndexInPage;
+            page->lines.erase(first, first + count);
+            adjustPageLineCount(pageNumber, -static_cast<std::ptrdiff_t>(count));
+        }
+
+        remaining -= count;
+        ++pageNumber;
+        lineIndexInPage = 0;
+    }
+
+    totalLines_ -= endIndex - startIndex;
+    removePages(firstEmptied, emptiedCount);
+
+    setModified(true);
+}
+
+// Write the whole buffer to a stream
+bool VirtualizedTextBuffer::writeContents(std::ostream& os, std::vector<uint64_t>* pageOffsets) const
+{
+    uint64_t written = 0;
+
+    for (size_t pageNumber = 0; pageNumber < pages_.size(); ++pageNumber) {
+        // Lines are separated, not terminated, by newlines
+        if (pageNumber > 0) {
+            os.put('\n');
+            ++written;
+        }
+
+        if (pageOffsets) {
+            pageOffsets->push_back(written);
+        }
+
+        // Pages edited since the last save are either resident or in the cold tier
+        std::shared_ptr<Page> resident;
+        auto it = pageCache_.find(pageNumber);
+        if (it != pageCache_.end()) {
+            resident = it->second;
+        } else if (!pages_[pageNumber].hasSource) {
+            auto coldIt = coldPages_.find(pageNumber);
+            if (coldIt != coldPages_.end()) {
+                resident = decompressPage(*coldIt->second, pageNumber);
+            }
+        }
+
+        if (resident) {
+            const Page& page = *resident;
+            const size_t lineCount = pageLineCount(page);
+            for (size_t i = 0; i < lineCount; ++i) {
+                if (i > 0) {
+                    os.put('\n');
+                    ++written;
+                }
+                std::string_view line = pageLine(page, i);
+                os.write(line.data(), static_cast<std::streamsize>(line.size()));
+                written += line.size();
+            }
+        } else {
+            // Clean pages are copied straight from the source without parsing
+            const PageDescriptor& descriptor = pages_[pageNumber];
+            std::string bytes;
+            std::string_view range;
+            if (source_->isMapped()) {
+                range = source_->view(descriptor.sourceOffset, descriptor.sourceLength);
+            } else {
+                bytes = readSourceRange(descriptor.sourceOffset, descriptor.sourceLength);
+                range = bytes;
+            }
+            if (!range.empty() && range.back() == '\n') {
+                range.remove_suffix(1);
+            }
+            os.write(range.data(), static_cast<std::streamsize>(range.size()));
+            written += range.size();
+        }
+
+        if (!os) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Evict the least recently used page from cache
+bool VirtualizedTextBuffer::evictLRUPage() const
+{
+    // Get the least recently used unpinned page
+    size_t pageNumber = takeEvictable(lruList_);
+    if (pageNumber == PageList::npos) {
+        return false;
+    }
+
+    demotePage(pageNumber);
+
+    LOG_DEBUG("Evicted page " + std::to_string(pageNumber) + " from cache");
+    return true;
+}
+
+// Remove the coldest evictable page from a policy list
+size_t VirtualizedTextBuffer::takeEvictable(PageList& list) const
+{
+    for (size_t remaining = list.size(); remaining > 0; --remaining) {
+        size_t pageNumber = list.front();
+        if (isEvictable(pageNumber)) {
+            list.erase(pageNumber);
+            return pageNumber;
+        }
+
+        // Pinned pages move to the hot end so that later evictions do
+        // not rescan them
+        list.pushBack(pageNumber);
+    }
+
+    return PageList::npos;
+}
+
+// Estimate the memory held by a page
+size_t VirtualizedTextBuffer::measurePage(const Page& page)
+{
+    // Strings up to this length are stored inside the std::string object
+    static const size_t inlineCapacity = std::string().capacity();
+
+    size_t bytes = sizeof(Page) + page.views.capacity() * sizeof(std::string_view) + page.storage.capacity();
+
+    // Mapped bytes behind the views become resident once they are read
+    if (page.source && !page.views.empty()) {
+        bytes += static_cast<size_t>(page.views.back().data() + page.views.back().size() - page.views.front().data());
+    }
+
+    if (page.materialized.load(std::memory_order_acquire)) {
+        bytes += page.lines.capacity() * sizeof(std::string);
+        for (const auto& line : page.lines) {
+            if (line.capacity() > inlineCapacity) {
+                bytes += line.capacity() + 1;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+// Recompute a cached page's charge and update residentBytes_
+void VirtualizedTextBuffer::chargePage(Page& page) const
+{
+    const size_t bytes = measurePage(page);
+    residentBytes_ = residentBytes_ - page.chargedBytes + bytes;
+    page.chargedBytes = bytes;
+}
+
+// Queue a cached page for recharging once its edit is done
+void VirtualizedTextBuffer::scheduleRecharge(const std::shared_ptr<Page>& page) const
+{
+    if (page->charged && !page->rechargePending) {
+        page->rechargePending = true;
+        unchargedPages_.push_back(page);
+    }
+}
+
+// Recharge pages edited since the last call
+void VirtualizedTextBuffer::settleCharges() const
+{
+    for (const auto& page : unchargedPages_) {
+        page->rechargePending = false;
+        if (page->charged) {
+            chargePage(*page);
+        }
+    }
+    unchargedPages_.clear();
+}
+
+// Remove a page from the cache map and release its charge
+void VirtualizedTextBuffer::uncachePage(size_t pageNumber) const
+{
+    auto it = pageCache_.find(pageNumber);
+    if (it == pageCache_.end()) {
+        return;
+    }
+
+    residentBytes_ -= it->second->chargedBytes;
+    it->second->chargedBytes = 0;
+    it->second->charged = false;
+    pageCache_.erase(it);
+}
+
+// Check whether the cache must shrink before admitting a page
+bool VirtualizedTextBuffer::isOverBudget(size_t incomingBytes) const
+{
+    if (pageCache_.size() >= cacheSize_) {
+        return true;
+    }
+    return cacheByteBudget_ > 0 && residentBytes_ + incomingBytes > cacheByteBudget_;
+}
+
+// Check whether a cached page may be evicted
+bool VirtualizedTextBuffer::isEvictable(size_t pageNumber) const
+{
+    auto it = pageCache_.find(pageNumber);
+    if (it == pageCache_.end() || it->second->isPinned) {
+        return false;
+    }
+
+    // A page read through the non-const getLine() is only dirty if its
+    // content changed; dirty pages are evicted into the cold tier
+    Page& page = *it->second;
+    if (!page.dirty && page.exposed && hashPageContent(page) != page.contentHash) {
+        page.dirty = true;
+        pages_[pageNumber].hasSource = false;
+    }
+
+    return true;
+}
+
+// Hash the content of a page
+uint64_t VirtualizedTextBuffer::hashPageContent(const Page& page)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const size_t lineCount = pageLineCount(page);
+    for (size_t i = 0; i < lineCount; ++i) {
+        if (i > 0) {
+            hash = (hash ^ static_cast<unsigned char>('\n')) * 1099511628211ULL;
+        }
+        for (unsigned char c : pageLine(page, i)) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+// Update the access time for a page
+void VirtualizedTextBuffer::updatePageAccess(size_t pageNumber) const
+{
+    // Update the page's access time
+    auto it = pageCache_.find(pageNumber);
+    if (it != pageCache_.end()) {
+        it->second->lastAccessed = std::chrono::steady_clock::now();
         it->second->accessCount++;
     } else {
         return; // Page not in cache
@@ -473,86 +1279,85 @@ void VirtualizedTextBuffer::updatePageAccess(size_t pageNumber) const
     // Update position in appropriate data structure based on eviction policy
     switch (evictionPolicy_) {
         case CacheEvictionPolicy::LRU:
-            // Move the page to the end of the LRU list
-            {
-                auto lruIt = std::find(lruList_.begin(), lruList_.end(), pageNumber);
-                if (lruIt != lruList_.end()) {
-                    lruList_.erase(lruIt);
-                    lruList_.push_back(pageNumber);
-                }
+            // Move the page to the hot end of the LRU list
+            if (lruList_.contains(pageNumber)) {
+                lruList_.pushBack(pageNumber);
             }
             break;
             
         case CacheEvictionPolicy::SLRU:
-            // If in probationary segment, move to protected segment
+            // If in probationary segment, move to protected segment;
+            // if already protected, move to its hot end
+            if (probationarySegment_.erase(pageNumber) || protectedSegment_.contains(pageNumber)) {
+                protectedSegment_.pushBack(pageNumber);
+            }
+            
+            // Keep the protected segment at most 80% of the cache by demoting
+            // its least recently used pages back to the probationary segment
             {
-                auto probIt = std::find(probationarySegment_.begin(), probationarySegment_.end(), pageNumber);
-                if (probIt != probationarySegment_.end()) {
-                    probationarySegment_.erase(probIt);
-                    protectedSegment_.push_back(pageNumber);
-                } else {
-                    // If already in protected segment, move to the end
-                    auto protIt = std::find(protectedSegment_.begin(), protectedSegment_.end(), pageNumber);
-                    if (protIt != protectedSegment_.end()) {
-                        protectedSegment_.erase(protIt);
-                        protectedSegment_.push_back(pageNumber);
-                    }
+                size_t protectedCapacity = std::max<size_t>(1, cacheSize_ * 4 / 5);
+                while (protectedSegment_.size() > protectedCapacity) {
+                    probationarySegment_.pushBack(protectedSegment_.popFront());
                 }
             }
             break;
             
         case CacheEvictionPolicy::ARC:
-            // If in recently used, move to frequently used
-            if (recentlyUsed_.find(pageNumber) != recentlyUsed_.end()) {
-                recentlyUsed_.erase(pageNumber);
-                frequentlyUsed_.insert(pageNumber);
-            } 
-            // If already in frequently used, it stays there
+            // A hit in T1 or T2 moves the page to the hot end of T2
+            if (recentlyUsed_.erase(pageNumber) || frequentlyUsed_.contains(pageNumber)) {
+                frequentlyUsed_.pushBack(pageNumber);
+            }
             break;
             
         case CacheEvictionPolicy::SPATIAL:
-            // Move the page to the end of the LRU list
-            {
-                auto lruIt = std::find(lruList_.begin(), lruList_.end(), pageNumber);
-                if (lruIt != lruList_.end()) {
-                    lruList_.erase(lruIt);
-                    lruList_.push_back(pageNumber);
-                }
+            // Move the page to the hot end of the LRU list
+            if (lruList_.contains(pageNumber)) {
+                lruList_.pushBack(pageNumber);
             }
             
-            // Increase spatial score for this page and neighbors
-            {
-                double currentScore = spatialScores_[pageNumber];
-                spatialScores_[pageNumber] = std::min(currentScore + 0.2, 1.0);
-                
-                // Boost adjacent pages' scores
-                for (int offset = -2; offset <= 2; ++offset) {
-                    if (offset == 0) continue; // Skip current page
-                    
-                    int neighbor = static_cast<int>(pageNumber) + offset;
-                    if (neighbor >= 0) {
-                        double neighborScore = spatialScores_[neighbor];
-                        double boost = 0.1 / (1.0 + std::abs(offset));
-                        spatialScores_[neighbor] = std::min(neighborScore + boost, 1.0);
-                    }
+            // Increase spatial score for this page and its resident neighbors.
+            // Every other score decays with each access; the decay is applied
+            // lazily when a score is read.
+            spatialClock_++;
+            setSpatialScore(pageNumber, std::min(spatialScore(pageNumber) + 0.2, 1.0));
+            for (int offset = -2; offset <= 2; ++offset) {
+                if (offset == 0 || (offset < 0 && pageNumber < static_cast<size_t>(-offset))) {
+                    continue;
                 }
                 
-                // Decay other pages' scores
-                for (auto& score : spatialScores_) {
-                    if (score.first != pageNumber && 
-                        std::abs(static_cast<int>(score.first) - static_cast<int>(pageNumber)) > 2) {
-                        score.second *= 0.99; // Gentle decay
-                    }
+                size_t neighbor = pageNumber + offset;
+                if (spatialScores_.find(neighbor) != spatialScores_.end()) {
+                    double boost = 0.1 / (1.0 + std::abs(offset));
+                    setSpatialScore(neighbor, std::min(spatialScore(neighbor) + boost, 1.0));
                 }
             }
             break;
     }
 }
 
+// Get the spatial score of a page with pending decay applied
+double VirtualizedTextBuffer::spatialScore(size_t pageNumber) const
+{
+    auto it = spatialScores_.find(pageNumber);
+    if (it == spatialScores_.end()) {
+        return 0.0;
+    }
+    
+    // Gentle decay of 1% per access since the score was last set
+    return it->second.value * std::pow(0.99, static_cast<double>(spatialClock_ - it->second.tick));
+}
+
+// Set the spatial score of a page as of the current access
+void VirtualizedTextBuffer::setSpatialScore(size_t pageNumber, double score) const
+{
+    spatialScores_[pageNumber] = SpatialScore{score, spatialClock_};
+}
+
 // Get the number of pages in memory
 size_t VirtualizedTextBuffer::getPagesInMemory() const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
     return pageCache_.size();
 }
 
@@ -560,6 +1365,7 @@ size_t VirtualizedTextBuffer::getPagesInMemory() const
 double VirtualizedTextBuffer::getCacheHitRate() const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
     
     size_t totalAccesses = cacheHits_ + cacheMisses_;
     if (totalAccesses == 0) {
@@ -569,6 +1375,33 @@ double VirtualizedTextBuffer::getCacheHitRate() const
     return (static_cast<double>(cacheHits_) / totalAccesses) * 100.0;
 }
 
+// Get the share of cache misses served by the compressed cold tier
+double VirtualizedTextBuffer::getColdTierHitRate() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+
+    size_t totalMisses = coldHits_ + coldMisses_;
+    if (totalMisses == 0) {
+        return 0.0;
+    }
+
+    return (static_cast<double>(coldHits_) / totalMisses) * 100.0;
+}
+
+// Get the compression ratio of the cold tier
+double VirtualizedTextBuffer::getCompressionRatio() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+
+    if (coldBytes_ == 0) {
+        return 1.0;
+    }
+
+    return static_cast<double>(coldRawBytes_) / coldBytes_;
+}
+
 // Reset the cache statistics
 void VirtualizedTextBuffer::resetCacheStats()
 {
@@ -576,8 +1409,50 @@ void VirtualizedTextBuffer::resetCacheStats()
     
     cacheHits_ = 0;
     cacheMisses_ = 0;
+    evictions_ = 0;
+    coldHits_ = 0;
+    coldMisses_ = 0;
+    statsResetTime_ = std::chrono::steady_clock::now();
+}
+
+// Get cache usage and eviction statistics
+VirtualizedTextBuffer::CacheStats VirtualizedTextBuffer::getCacheStats() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+
+    settleCharges();
+
+    CacheStats stats;
+    stats.pagesResident = pageCache_.size();
+    stats.bytesResident = residentBytes_;
+    stats.byteBudget = cacheByteBudget_;
+    stats.hits = cacheHits_;
+    stats.misses = cacheMisses_;
+    stats.evictions = evictions_;
+    stats.coldPagesResident = coldPages_.size();
+    stats.coldPagesDirty = coldPages_.size() - coldOrder_.size();
+    stats.coldBytesResident = coldBytes_;
+    stats.coldBytesUncompressed = coldRawBytes_;
+    stats.coldByteBudget = coldTierByteBudget_;
+    stats.coldHits = coldHits_;
+    stats.coldMisses = coldMisses_;
+
+    for (const auto& entry : pageCache_) {
+        if (entry.second->dirty) {
+            stats.bytesDirty += entry.second->chargedBytes;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsResetTime_).count();
+    if (seconds > 0.0) {
+        stats.evictionsPerSecond = static_cast<double>(evictions_) / seconds;
+    }
+
+    return stats;
 }
 
+
 // Set the page size
 void VirtualizedTextBuffer::setPageSize(size_t pageSize)
 {
@@ -594,19 +1469,20 @@ void VirtualizedTextBuffer::setPageSize(size_t pageSize)
     
     LOG_DEBUG("Changing page size from " + std::to_string(pageSize_) + " to " + std::to_string(pageSize));
     
-    // Save all dirty pages before changing the page size
-    for (const auto& pair : pageCache_) {
-        if (pair.second->dirty) {
-            savePage(pair.first, *pair.second);
-        }
-    }
-    
-    // Clear the cache
-    pageCache_.clear();
-    lruList_.clear();
-    
     // Update the page size
     pageSize_ = pageSize;
+    
+    // An unedited file-backed buffer can be re-paged from the source right away;
+    // otherwise the new size applies to pages split from now on
+    for (const auto& entry : pageCache_) {
+        isEvictable(entry.first);
+    }
+    if (isFromFile_ && isSourceIntact()) {
+        resetPageCache();
+        clearColdTier();
+        rebuildLineIndex();
+        updateIndexFile();
+    }
 }
 
 // Set the cache size
@@ -629,11 +1505,48 @@ void VirtualizedTextBuffer::setCacheSize(size_t cacheSize)
     cacheSize_ = cacheSize;
     
     // Evict pages if cache is too large
-    while (pageCache_.size() > cacheSize_) {
-        evictLRUPage();
+    while (pageCache_.size() > cacheSize_ && evictPage()) {
+    }
+}
+
+// Set the memory budget of the page cache
+void VirtualizedTextBuffer::setCacheByteBudget(size_t bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    LOG_DEBUG("Changing cache byte budget from " + std::to_string(cacheByteBudget_) + " to " + std::to_string(bytes));
+    cacheByteBudget_ = bytes;
+
+    // Evict pages if the cache is over the new budget
+    settleCharges();
+    while (cacheByteBudget_ > 0 && residentBytes_ > cacheByteBudget_ && evictPage()) {
     }
 }
 
+// Get the memory budget of the page cache
+size_t VirtualizedTextBuffer::getCacheByteBudget() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return cacheByteBudget_;
+}
+
+// Set the memory budget of the compressed cold tier
+void VirtualizedTextBuffer::setColdTierByteBudget(size_t bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    LOG_DEBUG("Changing cold tier byte budget from " + std::to_string(coldTierByteBudget_) + " to " + std::to_string(bytes));
+    coldTierByteBudget_ = bytes;
+    trimColdTier();
+}
+
+// Get the memory budget of the compressed cold tier
+size_t VirtualizedTextBuffer::getColdTierByteBudget() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return coldTierByteBudget_;
+}
+
 // Get the current page size
 size_t VirtualizedTextBuffer::getPageSize() const
 {
@@ -675,73 +1588,74 @@ void VirtualizedTextBuffer::unlockWriting()
 // Check if memory usage is high
 bool VirtualizedTextBuffer::isMemoryUsageHigh() const
 {
-    // This is a simplified check - in a real implementation,
-    // you might want to use platform-specific APIs to check
-    // actual memory usage.
-    return pageCache_.size() >= cacheSize_;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+
+    settleCharges();
+    if (cacheByteBudget_ == 0) {
+        return pageCache_.size() >= cacheSize_;
+    }
+    return residentBytes_ >= cacheByteBudget_ / 10 * 9;
 }
 
+
 // Prefetch a range of lines
 void VirtualizedTextBuffer::prefetchLines(size_t startLine, size_t endLine)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
+    if (totalLines_ == 0) {
+        return;
+    }
+
     // Clamp to valid range
-    startLine = std::min(startLine, totalLines_ > 0 ? totalLines_ - 1 : 0);
-    endLine = std::min(endLine, totalLines_ > 0 ? totalLines_ - 1 : 0);
-    
+    startLine = std::min(startLine, totalLines_ - 1);
+    endLine = std::min(endLine, totalLines_ - 1);
+
     if (startLine > endLine) {
         return;
     }
-    
+
     LOG_DEBUG("Prefetching lines " + std::to_string(startLine) + " to " + std::to_string(endLine));
-    
+
     // Calculate the range of pages to prefetch
     size_t startPage = getPageNumber(startLine);
     size_t endPage = getPageNumber(endLine);
-    
+
     // Special case: If we're prefetching many pages, temporarily boost prefetch distance
     size_t originalPrefetchDistance = prefetchDistance_;
     if (endPage - startPage > prefetchDistance_ * 2) {
         // Temporarily expand prefetch distance to cover the entire range
         prefetchDistance_ = (endPage - startPage) / 2 + 1;
     }
-    
+
     // Use the strategic prefetching for the first page
     if (prefetchStrategy_ != PrefetchStrategy::NONE) {
         // Mark the middle page as "accessed" to trigger prefetching
         size_t triggerPage = (startPage + endPage) / 2;
-        
+
         // Add to access pattern
         recentAccesses_.push_back(triggerPage);
         if (recentAccesses_.size() > recentAccessesMaxSize_) {
             recentAccesses_.pop_front();
         }
-        
+
         // Initiate strategic prefetching
         initiateStrategicPrefetch(triggerPage);
     } else {
         // Legacy fallback: Prefetch each page in the range
+        std::vector<size_t> pageNumbers;
         for (size_t pageNumber = startPage; pageNumber <= endPage; ++pageNumber) {
-            // Skip if the page is already in cache
-            if (pageCache_.find(pageNumber) != pageCache_.end()) {
+            // Skip if the page is already in cache or cannot be loaded
+            if (pageCache_.find(pageNumber) != pageCache_.end() ||
+                (!pages_[pageNumber].hasSource && coldPages_.find(pageNumber) == coldPages_.end())) {
                 continue;
             }
-            
-            // Check if we need to evict pages
-            if (pageCache_.size() >= cacheSize_) {
-                evictPage();
-            }
-            
-            // Load the page
-            auto page = loadPage(pageNumber);
-            
-            // Add the page to cache
-            pageCache_[pageNumber] = page;
-            lruList_.push_back(pageNumber);
+            pageNumbers.push_back(pageNumber);
         }
+        dispatchPrefetches(pageNumbers);
     }
-    
+
     // Restore original prefetch distance
     prefetchDistance_ = originalPrefetchDistance;
 }
@@ -749,16 +1663,7 @@ void VirtualizedTextBuffer::prefetchLines(size_t startLine, size_t endLine)
 // Load a line to the temporary buffer
 void VirtualizedTextBuffer::loadLineToTemporary(size_t lineIndex) const
 {
-    if (lineIndex >= totalLines_) {
-        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
-        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
-    }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = getPage(pageNumber);
-    temporaryLine_ = page->lines[lineIndexInPage];
+    temporaryLine_ = lineAt(lineIndex);
 }
 
 // ITextBuffer interface implementation
@@ -767,34 +1672,32 @@ void VirtualizedTextBuffer::loadLineToTemporary(size_t lineIndex) const
 const std::string& VirtualizedTextBuffer::getLine(size_t index) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
-    if (index >= totalLines_) {
-        LOG_ERROR("Line index out of range: " + std::to_string(index));
-        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
-    }
-    
-    size_t pageNumber = getPageNumber(index);
-    size_t lineIndexInPage = getLineIndexInPage(index);
-    
-    auto page = getPage(pageNumber);
-    return page->lines[lineIndexInPage];
+    return lineAt(index);
 }
 
 // Get a line (non-const version)
 std::string& VirtualizedTextBuffer::getLine(size_t index)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (index >= totalLines_) {
         LOG_ERROR("Line index out of range: " + std::to_string(index));
         throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(index);
-    size_t lineIndexInPage = getLineIndexInPage(index);
-    
-    auto page = ensurePage(pageNumber, true);
-    return page->lines[lineIndexInPage];
+
+    // Callers may only be reading, so the page is not marked dirty yet;
+    // eviction checks whether anything was written through the reference
+    auto location = locateLine(index);
+    auto page = getPage(location.first);
+    detachPage(*page);
+    scheduleRecharge(page);
+    if (!page->dirty && !page->exposed) {
+        page->contentHash = hashPageContent(*page);
+        page->exposed = true;
+    }
+
+    setModified(true);
+    return page->lines[location.second];
 }
 
 // Get the number of lines
@@ -815,238 +1718,62 @@ bool VirtualizedTextBuffer::isEmpty() const
 size_t VirtualizedTextBuffer::lineLength(size_t lineIndex) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
-    if (lineIndex >= totalLines_) {
-        LOG_ERROR("Line index out of range: " + std::to_string(lineIndex));
-        throw TextBufferException("Line index out of range", EditorException::Severity::EDITOR_ERROR);
-    }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = getPage(pageNumber);
-    return page->lines[lineIndexInPage].length();
+    std::shared_ptr<Page> page;
+    return lineViewAt(lineIndex, page).length();
 }
 
 // Add a line to the end of the buffer
 void VirtualizedTextBuffer::addLine(const std::string& line)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    size_t pageNumber = getPageNumber(totalLines_);
-    size_t lineIndexInPage = getLineIndexInPage(totalLines_);
-    
-    auto page = ensurePage(pageNumber, true);
-    
-    // If this is a new page or the page is not full, add the line to the page
-    if (lineIndexInPage < pageSize_) {
-        if (lineIndexInPage >= page->lines.size()) {
-            page->lines.resize(lineIndexInPage + 1);
-        }
-        page->lines[lineIndexInPage] = line;
-    } else {
-        // Create a new page for this line
-        auto newPage = std::make_shared<Page>();
-        newPage->lines.push_back(line);
-        newPage->lastAccessed = std::chrono::steady_clock::now();
-        newPage->dirty = true;
-        
-        pageCache_[pageNumber] = newPage;
-        lruList_.push_back(pageNumber);
-        
-        // Evict pages if cache is full
-        while (pageCache_.size() > cacheSize_) {
-            evictLRUPage();
-        }
-    }
-    
-    // Update the total line count
-    totalLines_++;
-    
-    // Update line offsets if this is a file-backed buffer
-    if (isFromFile_) {
-        // For simplicity, we'll rebuild the line index after adding a line
-        // In a real implementation, you might want to update the index incrementally
-        rebuildLineIndex();
-        updateIndexFile();
-    }
-    
-    setModified(true);
+    insertLinesInternal(totalLines_, {line});
 }
 
 // Insert a line at the specified index
 void VirtualizedTextBuffer::insertLine(size_t index, const std::string& line)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (index > totalLines_) {
         LOG_ERROR("Line index out of range for insertLine: " + std::to_string(index));
         throw TextBufferException("Line index out of range for insertLine", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    // Special case: inserting at the end is the same as adding a line
-    if (index == totalLines_) {
-        lock.unlock();
-        addLine(line);
-        return;
-    }
-    
-    // We need to shift all lines after the insertion point
-    // For simplicity, we'll rebuild the buffer after inserting a line
-    // In a real implementation, you might want to update the buffer incrementally
-    
-    // Load all lines
-    std::vector<std::string> allLines;
-    allLines.reserve(totalLines_ + 1);
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        if (i == index) {
-            allLines.push_back(line);
-        }
-        
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
-    }
-    
-    // Insert the line at the end if needed
-    if (index == totalLines_) {
-        allLines.push_back(line);
-    }
-    
-    // Update the total line count
-    totalLines_++;
-    
-    // Clear the cache
-    pageCache_.clear();
-    lruList_.clear();
-    
-    // Reload the buffer with the new lines
-    for (size_t i = 0; i < allLines.size(); ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto it = pageCache_.find(pageNumber);
-        if (it == pageCache_.end()) {
-            auto page = std::make_shared<Page>();
-            page->lines.resize(std::min(pageSize_, allLines.size() - pageNumber * pageSize_));
-            page->lastAccessed = std::chrono::steady_clock::now();
-            page->dirty = true;
-            
-            pageCache_[pageNumber] = page;
-            lruList_.push_back(pageNumber);
-        }
-        
-        auto& page = pageCache_[pageNumber];
-        if (lineIndexInPage >= page->lines.size()) {
-            page->lines.resize(lineIndexInPage + 1);
-        }
-        page->lines[lineIndexInPage] = allLines[i];
-    }
-    
-    // Update line offsets if this is a file-backed buffer
-    if (isFromFile_) {
-        rebuildLineIndex();
-        updateIndexFile();
-    }
-    
-    setModified(true);
+
+    // Only the page containing the insertion point is touched
+    insertLinesInternal(index, {line});
 }
 
 // Delete a line at the specified index
 void VirtualizedTextBuffer::deleteLine(size_t index)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (index >= totalLines_) {
         LOG_ERROR("Line index out of range for deleteLine: " + std::to_string(index));
         throw TextBufferException("Line index out of range for deleteLine", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     // Special case: if there's only one line, just clear it
     if (totalLines_ == 1) {
-        auto page = ensurePage(0, true);
-        page->lines[0] = "";
+        mutableLineAt(0).clear();
         return;
     }
-    
-    // We need to shift all lines after the deletion point
-    // For simplicity, we'll rebuild the buffer after deleting a line
-    // In a real implementation, you might want to update the buffer incrementally
-    
-    // Load all lines except the one to delete
-    std::vector<std::string> allLines;
-    allLines.reserve(totalLines_ - 1);
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        if (i == index) {
-            continue;
-        }
-        
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
-    }
-    
-    // Update the total line count
-    totalLines_--;
-    
-    // Clear the cache
-    pageCache_.clear();
-    lruList_.clear();
-    
-    // Reload the buffer with the new lines
-    for (size_t i = 0; i < allLines.size(); ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto it = pageCache_.find(pageNumber);
-        if (it == pageCache_.end()) {
-            auto page = std::make_shared<Page>();
-            page->lines.resize(std::min(pageSize_, allLines.size() - pageNumber * pageSize_));
-            page->lastAccessed = std::chrono::steady_clock::now();
-            page->dirty = true;
-            
-            pageCache_[pageNumber] = page;
-            lruList_.push_back(pageNumber);
-        }
-        
-        auto& page = pageCache_[pageNumber];
-        if (lineIndexInPage >= page->lines.size()) {
-            page->lines.resize(lineIndexInPage + 1);
-        }
-        page->lines[lineIndexInPage] = allLines[i];
-    }
-    
-    // Update line offsets if this is a file-backed buffer
-    if (isFromFile_) {
-        rebuildLineIndex();
-        updateIndexFile();
-    }
-    
-    setModified(true);
+
+    deleteLinesInternal(index, index + 1);
 }
 
 // Replace a line at the specified index
 void VirtualizedTextBuffer::replaceLine(size_t index, const std::string& newLine)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (index >= totalLines_) {
         LOG_ERROR("Line index out of range for replaceLine: " + std::to_string(index));
         throw TextBufferException("Line index out of range for replaceLine", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(index);
-    size_t lineIndexInPage = getLineIndexInPage(index);
-    
-    auto page = ensurePage(pageNumber, true);
-    page->lines[lineIndexInPage] = newLine;
-    
+
+    mutableLineAt(index) = newLine;
+
     setModified(true);
 }
 
@@ -1061,171 +1788,53 @@ void VirtualizedTextBuffer::setLine(size_t lineIndex, const std::string& text)
 void VirtualizedTextBuffer::deleteLines(size_t startIndex, size_t endIndex)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (startIndex >= totalLines_ || startIndex >= endIndex) {
         LOG_ERROR("Invalid range for deleteLines: " + std::to_string(startIndex) + " to " + std::to_string(endIndex));
         throw TextBufferException("Invalid range for deleteLines", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     // Clamp endIndex to the number of lines
-    endIndex = std::min(endIndex, totalLines_);
-    
-    // Special case: if deleting all lines, just clear the buffer
-    if (startIndex == 0 && endIndex == totalLines_) {
-        lock.unlock();
-        clear(true);
-        return;
-    }
-    
-    // Load all lines except the ones to delete
-    std::vector<std::string> allLines;
-    allLines.reserve(totalLines_ - (endIndex - startIndex));
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        if (i >= startIndex && i < endIndex) {
-            continue;
-        }
-        
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
-    }
-    
-    // Update the total line count
-    totalLines_ = allLines.size();
-    
-    // Clear the cache
-    pageCache_.clear();
-    lruList_.clear();
-    
-    // Reload the buffer with the new lines
-    for (size_t i = 0; i < allLines.size(); ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto it = pageCache_.find(pageNumber);
-        if (it == pageCache_.end()) {
-            auto page = std::make_shared<Page>();
-            page->lines.resize(std::min(pageSize_, allLines.size() - pageNumber * pageSize_));
-            page->lastAccessed = std::chrono::steady_clock::now();
-            page->dirty = true;
-            
-            pageCache_[pageNumber] = page;
-            lruList_.push_back(pageNumber);
-        }
-        
-        auto& page = pageCache_[pageNumber];
-        if (lineIndexInPage >= page->lines.size()) {
-            page->lines.resize(lineIndexInPage + 1);
-        }
-        page->lines[lineIndexInPage] = allLines[i];
-    }
-    
-    // Update line offsets if this is a file-backed buffer
-    if (isFromFile_) {
-        rebuildLineIndex();
-        updateIndexFile();
+    endIndex = std::min(endIndex, totalLines_);
+
+    deleteLinesInternal(startIndex, endIndex);
+
+    // Special case: deleting all lines leaves a single empty line, like clear(true)
+    if (totalLines_ == 0) {
+        insertLinesInternal(0, {""});
     }
-    
-    setModified(true);
 }
 
 // Insert multiple lines
 void VirtualizedTextBuffer::insertLines(size_t index, const std::vector<std::string>& newLines)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (index > totalLines_) {
         LOG_ERROR("Line index out of range for insertLines: " + std::to_string(index));
         throw TextBufferException("Line index out of range for insertLines", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    if (newLines.empty()) {
-        return; // Nothing to do
-    }
-    
-    // Load all lines
-    std::vector<std::string> allLines;
-    allLines.reserve(totalLines_ + newLines.size());
-    
-    for (size_t i = 0; i < index; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
-    }
-    
-    // Insert the new lines
-    allLines.insert(allLines.end(), newLines.begin(), newLines.end());
-    
-    // Add the remaining lines
-    for (size_t i = index; i < totalLines_; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
-    }
-    
-    // Update the total line count
-    totalLines_ = allLines.size();
-    
-    // Clear the cache
-    pageCache_.clear();
-    lruList_.clear();
-    
-    // Reload the buffer with the new lines
-    for (size_t i = 0; i < allLines.size(); ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto it = pageCache_.find(pageNumber);
-        if (it == pageCache_.end()) {
-            auto page = std::make_shared<Page>();
-            page->lines.resize(std::min(pageSize_, allLines.size() - pageNumber * pageSize_));
-            page->lastAccessed = std::chrono::steady_clock::now();
-            page->dirty = true;
-            
-            pageCache_[pageNumber] = page;
-            lruList_.push_back(pageNumber);
-        }
-        
-        auto& page = pageCache_[pageNumber];
-        if (lineIndexInPage >= page->lines.size()) {
-            page->lines.resize(lineIndexInPage + 1);
-        }
-        page->lines[lineIndexInPage] = allLines[i];
-    }
-    
-    // Update line offsets if this is a file-backed buffer
-    if (isFromFile_) {
-        rebuildLineIndex();
-        updateIndexFile();
-    }
-    
-    setModified(true);
+
+    insertLinesInternal(index, newLines);
 }
 
 // Get the total number of characters in the buffer
 size_t VirtualizedTextBuffer::characterCount() const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
+
     size_t count = 0;
-    
+
     // We'll need to load all pages to count characters
     // This could be optimized by keeping track of character counts per page
-    for (size_t i = 0; i < totalLines_; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
+    for (size_t pageNumber = 0; pageNumber < pages_.size(); ++pageNumber) {
         auto page = getPage(pageNumber);
-        count += page->lines[lineIndexInPage].length();
+        const size_t lineCount = pageLineCount(*page);
+        for (size_t i = 0; i < lineCount; ++i) {
+            count += pageLine(*page, i).length();
+        }
     }
-    
+
     return count;
 }
 
@@ -1233,76 +1842,91 @@ size_t VirtualizedTextBuffer::characterCount() const
 std::vector<std::string> VirtualizedTextBuffer::getAllLines() const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
+
     // Special case: if there's only one line and it's empty, return an empty vector
-    if (totalLines_ == 1) {
-        size_t pageNumber = getPageNumber(0);
-        size_t lineIndexInPage = getLineIndexInPage(0);
-        
-        auto page = getPage(pageNumber);
-        if (page->lines[lineIndexInPage].empty()) {
-            return std::vector<std::string>();
-        }
+    std::shared_ptr<Page> firstPage;
+    if (totalLines_ == 1 && lineViewAt(0, firstPage).empty()) {
+        return std::vector<std::string>();
     }
-    
+
     // Otherwise, return all lines
     std::vector<std::string> allLines;
     allLines.reserve(totalLines_);
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
+
+    for (size_t pageNumber = 0; pageNumber < pages_.size(); ++pageNumber) {
         auto page = getPage(pageNumber);
-        allLines.push_back(page->lines[lineIndexInPage]);
+        const size_t lineCount = pageLineCount(*page);
+        for (size_t i = 0; i < lineCount; ++i) {
+            allLines.emplace_back(pageLine(*page, i));
+        }
     }
-    
+
     return allLines;
 }
 
+// Visit a range of lines page by page
+size_t VirtualizedTextBuffer::forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    const size_t end = std::min(endLine, totalLines_);
+    if (startLine >= end) {
+        return 0;
+    }
+
+    // Each page is held only while its lines are visited, so a long range
+    // never pins more than one page beyond the cache
+    auto location = locateLine(startLine);
+    size_t lineIndex = startLine;
+    for (size_t pageNumber = location.first; lineIndex < end; ++pageNumber) {
+        auto page = getPage(pageNumber);
+        const size_t lineCount = pageLineCount(*page);
+        for (size_t i = location.second; i < lineCount && lineIndex < end; ++i, ++lineIndex) {
+            if (!visitor(lineIndex, pageLine(*page, i))) {
+                return lineIndex - startLine + 1;
+            }
+        }
+        location.second = 0;
+    }
+
+    return lineIndex - startLine;
+}
+
 // Check if a position is valid
 bool VirtualizedTextBuffer::isValidPosition(size_t lineIndex, size_t colIndex) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
+
     // Empty buffer has no valid positions
     if (totalLines_ == 0) {
         return false;
     }
-    
+
     // Check line index
     if (lineIndex >= totalLines_) {
         return false;
     }
-    
+
     // Check column index (can be at the end of the line, hence <=)
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = getPage(pageNumber);
-    return colIndex <= page->lines[lineIndexInPage].length();
+    return colIndex <= lineAt(lineIndex).length();
 }
 
 // Clamp a position to the buffer bounds
 std::pair<size_t, size_t> VirtualizedTextBuffer::clampPosition(size_t lineIndex, size_t colIndex) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
+
     // Handle empty buffer case
     if (totalLines_ == 0) {
         return {0, 0};
     }
-    
+
     // Clamp line index
     lineIndex = std::min(lineIndex, totalLines_ - 1);
-    
+
     // Clamp column index
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = getPage(pageNumber);
-    colIndex = std::min(colIndex, page->lines[lineIndexInPage].length());
-    
+    colIndex = std::min(colIndex, lineAt(lineIndex).length());
+
     return {lineIndex, colIndex};
 }
 
@@ -1310,17 +1934,16 @@ std::pair<size_t, size_t> VirtualizedTextBuffer::clampPosition(size_t lineIndex,
 void VirtualizedTextBuffer::printToStream(std::ostream& os) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
+
+    for (size_t pageNumber = 0; pageNumber < pages_.size(); ++pageNumber) {
         auto page = getPage(pageNumber);
-        os << page->lines[lineIndexInPage];
-        
-        // Add newline character unless it's the very last line
-        if (i < totalLines_ - 1) {
-            os << '\n';
+        const size_t lineCount = pageLineCount(*page);
+        for (size_t i = 0; i < lineCount; ++i) {
+            // Add newline character unless it's the very first line
+            if (pageNumber > 0 || i > 0) {
+                os << '\n';
+            }
+            os << pageLine(*page, i);
         }
     }
 }
@@ -1328,46 +1951,98 @@ void VirtualizedTextBuffer::printToStream(std::ostream& os) const
 // Save the buffer to a file
 bool VirtualizedTextBuffer::saveToFile(const std::string& filename) const
 {
-    std::shared_lock<std::shared_mutex> lock(mutex_);
-    
-    // If we're saving to the same file we loaded from, just flush all dirty pages
-    if (isFromFile_ && filename == filename_) {
-        for (const auto& pair : pageCache_) {
-            if (pair.second->dirty) {
-                savePage(pair.first, *pair.second);
-            }
+    // Saving back to the source rebases the page directory, so it needs exclusive access
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    std::error_code ec;
+    bool sameFile = isFromFile_ && source_ &&
+                    (filename == filename_ || fs::equivalent(filename, filename_, ec));
+
+    if (!sameFile) {
+        std::ofstream outfile(filename, std::ios::binary);
+        if (!outfile.is_open()) {
+            LOG_ERROR("Could not open file for saving: " + filename);
+            return false;
         }
-        
+
+        if (!writeContents(outfile, nullptr)) {
+            LOG_ERROR("Failed while writing to file: " + filename);
+            outfile.close();
+            return false;
+        }
+
+        outfile.close();
         return true;
     }
-    
-    // Otherwise, create a new file
-    std::ofstream outfile(filename);
-    if (!outfile.is_open()) {
-        LOG_ERROR("Could not open file for saving: " + filename);
+
+    // Write next to the source first: clean pages are still read from it while saving
+    const std::string tempFilename = filename_ + ".tmp";
+    std::vector<uint64_t> pageOffsets;
+    pageOffsets.reserve(pages_.size());
+    {
+        std::ofstream outfile(tempFilename, std::ios::binary);
+        if (!outfile.is_open()) {
+            LOG_ERROR("Could not open file for saving: " + tempFilename);
+            return false;
+        }
+
+        bool written = writeContents(outfile, &pageOffsets);
+        outfile.close();
+        if (!written || outfile.fail()) {
+            LOG_ERROR("Failed while writing to file: " + tempFilename);
+            fs::remove(tempFilename, ec);
+            return false;
+        }
+    }
+
+    // Resident pages stop referencing the old mapping so that the source can
+    // be replaced on every platform; the rest are reloaded from the new file
+    for (auto& entry : pageCache_) {
+        detachPage(*entry.second);
+        chargePage(*entry.second);
+    }
+    cancelPrefetches(true);
+    waitForIndexWriter(); // It fingerprints the mapping about to be closed
+    source_->close();
+
+    fs::rename(tempFilename, filename_, ec);
+    if (ec) {
+        LOG_ERROR("Could not replace " + filename_ + ": " + ec.message());
+        fs::remove(tempFilename, ec);
+        source_->open(filename_);
         return false;
     }
-    
-    for (size_t i = 0; i < totalLines_; ++i) {
-        size_t pageNumber = getPageNumber(i);
-        size_t lineIndexInPage = getLineIndexInPage(i);
-        
-        auto page = getPage(pageNumber);
-        outfile << page->lines[lineIndexInPage];
-        
-        // Add newline character unless it's the very last line
-        if (i < totalLines_ - 1) {
-            outfile << '\n';
+
+    auto source = std::make_shared<MappedFile>();
+    if (!source->open(filename_)) {
+        LOG_ERROR("Failed to reopen file after saving: " + filename_);
+        return false;
+    }
+    source_ = source;
+
+    // Every page now has a source range in the saved file and nothing is dirty
+    const uint64_t fileSize = source_->size();
+    for (size_t pageNumber = 0; pageNumber < pages_.size(); ++pageNumber) {
+        uint64_t end = pageNumber + 1 < pages_.size() ? pageOffsets[pageNumber + 1] : fileSize;
+        pages_[pageNumber].sourceOffset = pageOffsets[pageNumber];
+        pages_[pageNumber].sourceLength = end - pageOffsets[pageNumber];
+        pages_[pageNumber].hasSource = true;
+    }
+    for (auto& entry : pageCache_) {
+        entry.second->dirty = false;
+        if (entry.second->exposed) {
+            entry.second->contentHash = hashPageContent(*entry.second);
         }
     }
-    
-    if (outfile.fail()) {
-        LOG_ERROR("Failed while writing to file: " + filename);
-        outfile.close();
-        return false;
+    for (auto& entry : coldPages_) {
+        if (entry.second->dirty) {
+            entry.second->dirty = false;
+            coldOrder_.pushBack(entry.first);
+        }
     }
-    
-    outfile.close();
+    trimColdTier();
+
+    updateIndexFile();
     return true;
 }
 
@@ -1375,25 +2050,29 @@ bool VirtualizedTextBuffer::saveToFile(const std::string& filename) const
 bool VirtualizedTextBuffer::loadFromFile(const std::string& filename)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     // Clear the current buffer
-    pageCache_.clear();
-    lruList_.clear();
-    lineOffsets_.clear();
+    resetPageCache();
+    clearColdTier();
+    pages_.clear();
+    pageLineTree_.clear();
     totalLines_ = 0;
-    
+
     // Set the new filename
     filename_ = filename;
     isFromFile_ = true;
-    
+
     // Initialize from the file
     try {
         initFromFile(filename);
     } catch (const std::exception& e) {
         LOG_ERROR("Failed to load file: " + std::string(e.what()));
+        pages_.clear();
+        pageLineTree_.clear();
+        totalLines_ = 0;
         return false;
     }
-    
+
     setModified(false);
     return true;
 }
@@ -1402,24 +2081,21 @@ bool VirtualizedTextBuffer::loadFromFile(const std::string& filename)
 void VirtualizedTextBuffer::insertChar(size_t lineIndex, size_t colIndex, char ch)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for insertChar: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for insertChar", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    
-    if (colIndex > page->lines[lineIndexInPage].length()) {
+
+    std::string& line = mutableLineAt(lineIndex);
+
+    if (colIndex > line.length()) {
         LOG_ERROR("Column index out of range for insertChar: " + std::to_string(colIndex));
         throw TextBufferException("Column index out of range for insertChar", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    page->lines[lineIndexInPage].insert(colIndex, 1, ch);
-    
+
+    line.insert(colIndex, 1, ch);
+
     setModified(true);
 }
 
@@ -1427,47 +2103,34 @@ void VirtualizedTextBuffer::insertChar(size_t lineIndex, size_t colIndex, char c
 void VirtualizedTextBuffer::deleteChar(size_t lineIndex, size_t colIndex)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for deleteChar: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for deleteChar", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
     if (colIndex == 0) {
         // Backspace at start of line - join with previous line if possible
         if (lineIndex > 0) {
-            // Get the previous line
-            size_t prevPageNumber = getPageNumber(lineIndex - 1);
-            size_t prevLineIndexInPage = getLineIndexInPage(lineIndex - 1);
-            
-            auto prevPage = ensurePage(prevPageNumber, true);
-            std::string& prevLine = prevPage->lines[prevLineIndexInPage];
-            
-            // Join the lines
-            prevLine += line;
-            
+            std::string line = std::move(mutableLineAt(lineIndex));
+            mutableLineAt(lineIndex - 1) += line;
+
             // Delete the current line
-            lock.unlock();
-            deleteLine(lineIndex);
+            deleteLinesInternal(lineIndex, lineIndex + 1);
         }
-    } else if (colIndex <= line.length()) {
+        return;
+    }
+
+    std::string& line = mutableLineAt(lineIndex);
+
+    if (colIndex <= line.length()) {
         // Normal backspace within a line
-        if (colIndex > 0 && colIndex <= line.length() && line.length() > 0) {
-            line.erase(colIndex - 1, 1);
-            setModified(true);
-        }
-    } else {
+        line.erase(colIndex - 1, 1);
+        setModified(true);
+    } else if (line.length() > 0) {
         // If colIndex is beyond line length, treat as backspace at the end of the line
-        if (line.length() > 0) {
-            line.erase(line.length() - 1, 1);
-            setModified(true);
-        }
+        line.erase(line.length() - 1, 1);
+        setModified(true);
     }
 }
 
@@ -1475,42 +2138,31 @@ void VirtualizedTextBuffer::deleteChar(size_t lineIndex, size_t colIndex)
 void VirtualizedTextBuffer::deleteCharForward(size_t lineIndex, size_t colIndex)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for deleteCharForward: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for deleteCharForward", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
+    std::string& line = mutableLineAt(lineIndex);
+
     if (colIndex > line.length() && (lineIndex == totalLines_ - 1 || colIndex > line.length() + 100)) {
         LOG_ERROR("Column index out of range for deleteCharForward: " + std::to_string(colIndex));
         throw TextBufferException("Column index out of range for deleteCharForward", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     if (colIndex < line.length()) {
         // Normal delete within a line
         line.erase(colIndex, 1);
         setModified(true);
     } else if (lineIndex < totalLines_ - 1) {
-        // Delete at end of line - join with next line
-        // Get the next line
-        size_t nextPageNumber = getPageNumber(lineIndex + 1);
-        size_t nextLineIndexInPage = getLineIndexInPage(lineIndex + 1);
-        
-        auto nextPage = ensurePage(nextPageNumber, true);
-        std::string& nextLine = nextPage->lines[nextLineIndexInPage];
-        
-        // Join the lines
-        line += nextLine;
-        
+        // Delete at end of line - join with next line. Loading the next
+        // page may evict this one, so the reference is not held across it.
+        std::string nextLine = std::move(mutableLineAt(lineIndex + 1));
+        mutableLineAt(lineIndex) += nextLine;
+
         // Delete the next line
-        lock.unlock();
-        deleteLine(lineIndex + 1);
+        deleteLinesInternal(lineIndex + 1, lineIndex + 2);
     }
     // If we're at the end of the last line, do nothing
 }
@@ -1519,26 +2171,22 @@ void VirtualizedTextBuffer::deleteCharForward(size_t lineIndex, size_t colIndex)
 void VirtualizedTextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol, size_t endCol, const std::string& newText)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for replaceLineSegment: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for replaceLineSegment", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
+    std::string& line = mutableLineAt(lineIndex);
+
     // Ensure startCol <= endCol
     if (startCol > endCol) {
         std::swap(startCol, endCol);
     }
-    
+
     // Clamp endCol to line length if it exceeds it
     endCol = std::min(endCol, line.length());
-    
+
     // If startCol is beyond line length, treat as append
     if (startCol >= line.length()) {
         line.append(newText);
@@ -1546,7 +2194,7 @@ void VirtualizedTextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol
         // Replace the segment
         line.replace(startCol, endCol - startCol, newText);
     }
-    
+
     setModified(true);
 }
 
@@ -1554,34 +2202,28 @@ void VirtualizedTextBuffer::replaceLineSegment(size_t lineIndex, size_t startCol
 void VirtualizedTextBuffer::deleteLineSegment(size_t lineIndex, size_t startCol, size_t endCol)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for deleteLineSegment: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for deleteLineSegment", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
     // Ensure startCol <= endCol
     if (startCol > endCol) {
         std::swap(startCol, endCol);
     }
-    
+
     // Clamp endCol to line length if it exceeds it
-    endCol = std::min(endCol, line.length());
-    
+    endCol = std::min(endCol, lineAt(lineIndex).length());
+
     // If startCol is beyond line length or startCol equals endCol, do nothing
-    if (startCol >= line.length() || startCol == endCol) {
+    if (startCol >= endCol) {
         return;
     }
-    
+
     // Delete the segment
-    line.erase(startCol, endCol - startCol);
-    
+    mutableLineAt(lineIndex).erase(startCol, endCol - startCol);
+
     setModified(true);
 }
 
@@ -1589,86 +2231,64 @@ void VirtualizedTextBuffer::deleteLineSegment(size_t lineIndex, size_t startCol,
 void VirtualizedTextBuffer::splitLine(size_t lineIndex, size_t colIndex)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for splitLine: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for splitLine", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
+    std::string& line = mutableLineAt(lineIndex);
+
     if (colIndex > line.length()) {
         LOG_ERROR("Column index out of range for splitLine: " + std::to_string(colIndex));
         throw TextBufferException("Column index out of range for splitLine", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     // Extract the part of the line after the split point
     std::string newLine = line.substr(colIndex);
-    
+
     // Keep only the part before the split point in the original line
     line.erase(colIndex);
-    
+
     // Insert the new line after the current line
-    lock.unlock();
-    insertLine(lineIndex + 1, newLine);
+    insertLinesInternal(lineIndex + 1, {newLine});
 }
 
 // Join a line with the next line
 void VirtualizedTextBuffer::joinLines(size_t lineIndex)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    if (lineIndex >= totalLines_ - 1) {
+
+    if (lineIndex + 1 >= totalLines_) {
         LOG_ERROR("Cannot join last line with next line");
         throw TextBufferException("Cannot join last line with next line", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
-    // Get the next line
-    size_t nextPageNumber = getPageNumber(lineIndex + 1);
-    size_t nextLineIndexInPage = getLineIndexInPage(lineIndex + 1);
-    
-    auto nextPage = ensurePage(nextPageNumber, true);
-    std::string& nextLine = nextPage->lines[nextLineIndexInPage];
-    
+
     // Join the lines
-    line += nextLine;
-    
+    std::string nextLine = std::move(mutableLineAt(lineIndex + 1));
+    mutableLineAt(lineIndex) += nextLine;
+
     // Delete the next line
-    lock.unlock();
-    deleteLine(lineIndex + 1);
+    deleteLinesInternal(lineIndex + 1, lineIndex + 2);
 }
 
 // Insert a string at the specified position
 void VirtualizedTextBuffer::insertString(size_t lineIndex, size_t colIndex, const std::string& text)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for insertString: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for insertString", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& line = page->lines[lineIndexInPage];
-    
+
+    std::string& line = mutableLineAt(lineIndex);
+
     if (colIndex > line.length()) {
         LOG_ERROR("Column index out of range for insertString: " + std::to_string(colIndex));
         throw TextBufferException("Column index out of range for insertString", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     // Check if the text contains newlines
     size_t newlinePos = text.find('\n');
     if (newlinePos == std::string::npos) {
@@ -1677,81 +2297,52 @@ void VirtualizedTextBuffer::insertString(size_t lineIndex, size_t colIndex, cons
         setModified(true);
         return;
     }
-    
-    // The text contains newlines, we need to split it
-    size_t currentPosInInputText = 0;
-    size_t lastNewlinePosInInputText = std::string::npos;
-    
-    for (size_t i = 0; i < text.length(); ++i) {
-        if (text[i] == '\n') {
-            // Get the text after the insertion point in the current line
-            std::string textAfterNewline = line.substr(colIndex + currentPosInInputText);
-            
-            // Truncate the current line at the insertion point
-            line.erase(colIndex + currentPosInInputText);
-            
-            // Append the text up to the newline
-            line += text.substr(lastNewlinePosInInputText == std::string::npos ? 0 : lastNewlinePosInInputText + 1, 
-                                i - (lastNewlinePosInInputText == std::string::npos ? 0 : lastNewlinePosInInputText + 1));
-            
-            // Insert a new line after the current line
-            lock.unlock();
-            insertLine(lineIndex + 1, textAfterNewline);
-            lock.lock();
-            
-            // Update the current line
-            lineIndex++;
-            pageNumber = getPageNumber(lineIndex);
-            lineIndexInPage = getLineIndexInPage(lineIndex);
-            
-            page = ensurePage(pageNumber, true);
-            line = page->lines[lineIndexInPage];
-            
-            colIndex = 0;
-            currentPosInInputText = 0;
-            lastNewlinePosInInputText = i;
-        } else {
-            currentPosInInputText++;
+
+    // The text contains newlines: the first segment ends the current line,
+    // the last one is joined with the text that followed the insertion point
+    std::string textAfterInsertion = line.substr(colIndex);
+    line.erase(colIndex);
+    line.append(text, 0, newlinePos);
+
+    std::vector<std::string> newLines;
+    size_t segmentStart = newlinePos + 1;
+    while (true) {
+        size_t segmentEnd = text.find('\n', segmentStart);
+        if (segmentEnd == std::string::npos) {
+            newLines.push_back(text.substr(segmentStart) + textAfterInsertion);
+            break;
         }
+        newLines.push_back(text.substr(segmentStart, segmentEnd - segmentStart));
+        segmentStart = segmentEnd + 1;
     }
-    
-    // Insert any remaining text
-    std::string remainingTextToInsert = text.substr(lastNewlinePosInInputText == std::string::npos ? 0 : lastNewlinePosInInputText + 1);
-    
-    if (!remainingTextToInsert.empty()) {
-        line.insert(colIndex, remainingTextToInsert);
-    }
-    
-    setModified(true);
+
+    insertLinesInternal(lineIndex + 1, newLines);
 }
 
 // Get a segment of a line
 std::string VirtualizedTextBuffer::getLineSegment(size_t lineIndex, size_t startCol, size_t endCol) const
 {
     std::shared_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (lineIndex >= totalLines_) {
         LOG_ERROR("Line index out of range for getLineSegment: " + std::to_string(lineIndex));
         throw TextBufferException("Line index out of range for getLineSegment", EditorException::Severity::EDITOR_ERROR);
     }
-    
-    size_t pageNumber = getPageNumber(lineIndex);
-    size_t lineIndexInPage = getLineIndexInPage(lineIndex);
-    
-    auto page = getPage(pageNumber);
-    const std::string& line = page->lines[lineIndexInPage];
-    
+
+    std::shared_ptr<Page> page;
+    std::string_view line = lineViewAt(lineIndex, page);
+
     // Validate column indices
     if (startCol > endCol || startCol > line.length()) {
         LOG_ERROR("Invalid column range for getLineSegment: " + std::to_string(startCol) + " to " + std::to_string(endCol));
         throw TextBufferException("Invalid column range for getLineSegment", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     // Clamp endCol to line length
     endCol = std::min(endCol, line.length());
-    
+
     // Return the segment
-    return line.substr(startCol, endCol - startCol);
+    return std::string(line.substr(startCol, endCol - startCol));
 }
 
 // Get the number of lines
@@ -1772,147 +2363,81 @@ std::vector<std::string> VirtualizedTextBuffer::getLines() const
 void VirtualizedTextBuffer::replaceText(size_t startLine, size_t startCol, size_t endLine, size_t endCol, const std::string& text)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (startLine >= totalLines_ || endLine >= totalLines_) {
         LOG_ERROR("Line index out of range for replaceText: " + std::to_string(startLine) + " to " + std::to_string(endLine));
         throw TextBufferException("Line index out of range for replaceText", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     if (startLine == endLine) {
         // Single line replacement
         lock.unlock();
         replaceLineSegment(startLine, startCol, endCol, text);
         return;
     }
-    
+
     // Multi-line replacement
-    
+
     // Store text after endCol in the last line
-    size_t endPageNumber = getPageNumber(endLine);
-    size_t endLineIndexInPage = getLineIndexInPage(endLine);
-    
-    auto endPage = ensurePage(endPageNumber, true);
-    std::string& endLineText = endPage->lines[endLineIndexInPage];
-    
+    const std::string& endLineText = lineAt(endLine);
     std::string endLineRemainder = "";
     if (endCol < endLineText.length()) {
         endLineRemainder = endLineText.substr(endCol);
     }
-    
+
     // Keep text before startCol in the first line
-    size_t startPageNumber = getPageNumber(startLine);
-    size_t startLineIndexInPage = getLineIndexInPage(startLine);
-    
-    auto startPage = ensurePage(startPageNumber, true);
-    std::string& startLineText = startPage->lines[startLineIndexInPage];
-    
-    std::string startLinePrefix = "";
-    if (startCol > 0) {
-        startLinePrefix = startLineText.substr(0, startCol);
-    }
-    
-    // Delete all lines between startLine+1 and endLine (inclusive)
-    for (size_t i = endLine; i > startLine; --i) {
-        lock.unlock();
-        deleteLine(i);
-        lock.lock();
-    }
-    
+    std::string& startLineText = mutableLineAt(startLine);
+    std::string startLinePrefix = startLineText.substr(0, startCol);
+
     // Replace the content of the first line
-    startPage = ensurePage(startPageNumber, true);
     startLineText = startLinePrefix + text + endLineRemainder;
-    
+
+    // Delete all lines between startLine+1 and endLine (inclusive)
+    deleteLinesInternal(startLine + 1, endLine + 1);
+
     setModified(true);
 }
 
 // Insert text at a position
 void VirtualizedTextBuffer::insertText(size_t line, size_t col, const std::string& text)
 {
-    std::unique_lock<std::shared_mutex> lock(mutex_);
-    
-    if (line >= totalLines_) {
-        LOG_ERROR("Line index out of range for insertText: " + std::to_string(line));
-        throw TextBufferException("Line index out of range for insertText", EditorException::Severity::EDITOR_ERROR);
-    }
-    
-    size_t pageNumber = getPageNumber(line);
-    size_t lineIndexInPage = getLineIndexInPage(line);
-    
-    auto page = ensurePage(pageNumber, true);
-    std::string& lineText = page->lines[lineIndexInPage];
-    
-    if (col > lineText.length()) {
-        LOG_ERROR("Column index out of range for insertText: " + std::to_string(col));
-        throw TextBufferException("Column index out of range for insertText", EditorException::Severity::EDITOR_ERROR);
-    }
-    
-    // Check if text contains newlines
-    size_t newlinePos = text.find('\n');
-    if (newlinePos == std::string::npos) {
-        // Simple case: no newlines, just insert the text
-        lineText.insert(col, text);
-        setModified(true);
-    } else {
-        // Text contains newlines, need to split it
-        lock.unlock();
-        insertString(line, col, text);
-    }
+    // insertString handles both single-line and multi-line text
+    insertString(line, col, text);
 }
 
 // Delete a range of text
 void VirtualizedTextBuffer::deleteText(size_t startLine, size_t startCol, size_t endLine, size_t endCol)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
-    
+
     if (startLine >= totalLines_ || endLine >= totalLines_) {
         LOG_ERROR("Line index out of range for deleteText: " + std::to_string(startLine) + " to " + std::to_string(endLine));
         throw TextBufferException("Line index out of range for deleteText", EditorException::Severity::EDITOR_ERROR);
     }
-    
+
     if (startLine == endLine) {
         // Single line deletion
         lock.unlock();
         deleteLineSegment(startLine, startCol, endCol);
         return;
     }
-    
+
     // Multi-line deletion
-    
-    // Keep text before startCol in the first line
-    size_t startPageNumber = getPageNumber(startLine);
-    size_t startLineIndexInPage = getLineIndexInPage(startLine);
-    
-    auto startPage = ensurePage(startPageNumber, true);
-    std::string& startLineText = startPage->lines[startLineIndexInPage];
-    
-    std::string startLinePrefix = "";
-    if (startCol > 0) {
-        startLinePrefix = startLineText.substr(0, startCol);
-    }
-    
+
     // Keep text after endCol in the last line
-    size_t endPageNumber = getPageNumber(endLine);
-    size_t endLineIndexInPage = getLineIndexInPage(endLine);
-    
-    auto endPage = ensurePage(endPageNumber, true);
-    std::string& endLineText = endPage->lines[endLineIndexInPage];
-    
+    const std::string& endLineText = lineAt(endLine);
     std::string endLineSuffix = "";
     if (endCol < endLineText.length()) {
         endLineSuffix = endLineText.substr(endCol);
     }
-    
-    // Combine the remaining parts
-    startPage = ensurePage(startPageNumber, true);
-    startLineText = startLinePrefix + endLineSuffix;
-    
+
+    // Combine the remaining parts into the first line
+    std::string& startLineText = mutableLineAt(startLine);
+    startLineText = startLineText.substr(0, startCol) + endLineSuffix;
+
     // Delete all lines between startLine+1 and endLine (inclusive)
-    for (size_t i = endLine; i > startLine; --i) {
-        lock.unlock();
-        deleteLine(i);
-        lock.lock();
-    }
-    
+    deleteLinesInternal(startLine + 1, endLine + 1);
+
     setModified(true);
 }
 
@@ -1928,7 +2453,6 @@ void VirtualizedTextBuffer::setModified(bool modified)
     modified_.store(modified);
 }
 
-// Set the cache eviction policy
 void VirtualizedTextBuffer::setCacheEvictionPolicy(CacheEvictionPolicy policy)
 {
     std::unique_lock<std::shared_mutex> lock(mutex_);
@@ -1939,15 +2463,18 @@ void VirtualizedTextBuffer::setCacheEvictionPolicy(CacheEvictionPolicy policy)
     
     LOG_DEBUG("Changing cache eviction policy");
     
-    // Initialize data structures for the new policy if needed
-    switch (policy) {
-        case CacheEvictionPolicy::LRU:
-        default:
-            // LRU is already the default, no special initialization needed
-            break;
-    }
+    // Re-admit the resident pages, oldest first, into the new policy's structures
+    std::vector<std::pair<size_t, std::shared_ptr<Page>>> residentPages(pageCache_.begin(), pageCache_.end());
+    std::sort(residentPages.begin(), residentPages.end(), [](const auto& a, const auto& b) {
+        return a.second->lastAccessed < b.second->lastAccessed;
+    });
     
+    resetPageCache();
     evictionPolicy_ = policy;
+    
+    for (const auto& entry : residentPages) {
+        admitPage(entry.first, entry.second, false);
+    }
 } // End of setCacheEvictionPolicy
 
 // Get the current cache eviction policy
@@ -1971,10 +2498,11 @@ void VirtualizedTextBuffer::setPrefetchStrategy(PrefetchStrategy strategy)
     // Initialize data structures for the new strategy if needed
     switch (strategy) {
         case PrefetchStrategy::NONE:
-            // When disabling prefetching, clear the queue
+            // When disabling prefetching, clear the queue and drop pending loads
             while (!prefetchQueue_.empty()) {
                 prefetchQueue_.pop();
             }
+            dispatchPrefetches({});
             break;
         case PrefetchStrategy::ADJACENT:
         case PrefetchStrategy::PREDICTIVE:
@@ -2042,26 +2570,10 @@ void VirtualizedTextBuffer::updateAccessPattern(size_t pageNumber) const
         }
     }
     
-    // If this page was in the prefetch queue and was just accessed,
-    // it's a prefetch hit
-    std::priority_queue<PrefetchRequest> tempQueue;
-    
-    while (!prefetchQueue_.empty()) {
-        PrefetchRequest req = prefetchQueue_.top();
-        prefetchQueue_.pop();
-        
-        if (req.pageNumber == pageNumber) {
-            prefetchHits_++;
-        } else {
-            tempQueue.push(req);
-        }
-    }
-    
-    // Restore the queue without the hit page
-    prefetchQueue_ = std::move(tempQueue);
-    
-    // Initiate prefetching based on this access
-    if (prefetchStrategy_ != PrefetchStrategy::NONE) {
+    // Initiate prefetching when the access moved to another page; reads
+    // within the same page have nothing new to prefetch
+    bool samePage = recentAccesses_.size() >= 2 && recentAccesses_[recentAccesses_.size() - 2] == pageNumber;
+    if (prefetchStrategy_ != PrefetchStrategy::NONE && !samePage) {
         initiateStrategicPrefetch(pageNumber);
     }
 }
@@ -2107,8 +2619,11 @@ void VirtualizedTextBuffer::prefetchAdjacentPages(size_t pageNumber) const
     size_t startPage = (pageNumber > prefetchDistance_) ? 
                         pageNumber - prefetchDistance_ : 0;
     
-    size_t endPage = std::min(pageNumber + prefetchDistance_, 
-                             (totalLines_ / pageSize_) + (totalLines_ % pageSize_ > 0 ? 1 : 0) - 1);
+    if (pages_.empty()) {
+        return;
+    }
+    
+    size_t endPage = std::min(pageNumber + prefetchDistance_, pages_.size() - 1);
     
     // Queue pages for prefetching, prioritizing closer pages
     for (size_t page = startPage; page <= endPage; ++page) {
@@ -2204,13 +2719,9 @@ double VirtualizedTextBuffer::calculatePrefetchPriority(size_t pageNumber, size_
         }
     }
     
-    // Reduce priority for pages that are likely to be evicted soon
-    if (evictionPolicy_ == CacheEvictionPolicy::LRU) {
-        auto lruPos = std::find(lruList_.begin(), lruList_.end(), pageNumber);
-        if (lruPos != lruList_.end()) {
-            double lruFactor = static_cast<double>(std::distance(lruList_.begin(), lruPos)) / lruList_.size();
-            priority *= (1.0 - lruFactor);
-        }
+    // Resident pages need no prefetching
+    if (pageCache_.find(pageNumber) != pageCache_.end()) {
+        priority = 0.0;
     }
     
     return priority;
@@ -2273,240 +2784,328 @@ void VirtualizedTextBuffer::queueForPrefetch(size_t pageNumber, double priority)
 // Process the prefetch queue
 void VirtualizedTextBuffer::processPrefetchQueue(size_t maxPages) const
 {
-    size_t processedPages = 0;
+    std::vector<size_t> pageNumbers;
     
-    // Limit the number of pages to prefetch at once
-    while (processedPages < maxPages && !prefetchQueue_.empty()) {
-        // Get the highest priority request
+    // Hand the highest priority requests to the background prefetcher
+    while (pageNumbers.size() < maxPages && !prefetchQueue_.empty()) {
         PrefetchRequest req = prefetchQueue_.top();
         prefetchQueue_.pop();
         
-        // Skip if already in cache
-        if (pageCache_.find(req.pageNumber) != pageCache_.end()) {
+        // Skip if already in cache, not loadable or no longer part of the buffer
+        if (req.pageNumber >= pages_.size() || pageCache_.find(req.pageNumber) != pageCache_.end() ||
+            (!pages_[req.pageNumber].hasSource && coldPages_.find(req.pageNumber) == coldPages_.end())) {
             continue;
         }
         
-        // Ensure we have space in cache
-        while (pageCache_.size() >= cacheSize_) {
-            evictPage();
+        LOG_DEBUG("Prefetching page " + std::to_string(req.pageNumber) + " with priority " + std::to_string(req.priority));
+        pageNumbers.push_back(req.pageNumber);
+    }
+    
+    dispatchPrefetches(pageNumbers);
+}
+
+// Replace the background prefetcher's pending tasks
+void VirtualizedTextBuffer::dispatchPrefetches(const std::vector<size_t>& pageNumbers) const
+{
+    std::lock_guard<std::mutex> lock(prefetchMutex_);
+
+    pendingPrefetches_.clear();
+    const bool sourceOpen = source_ && source_->isOpen();
+
+    for (size_t pageNumber : pageNumbers) {
+        PrefetchTask task;
+        task.pageNumber = pageNumber;
+        task.generation = prefetchGeneration_;
+
+        // Pages in the cold tier are decompressed rather than read
+        auto coldIt = coldPages_.find(pageNumber);
+        if (coldIt != coldPages_.end()) {
+            task.coldPage = coldIt->second;
+        } else if (sourceOpen && pages_[pageNumber].hasSource) {
+            task.descriptor = pages_[pageNumber];
+            task.source = source_;
+            task.filename = filename_;
+        } else {
+            continue;
         }
-        
-        // Load the page
+        pendingPrefetches_.push_back(std::move(task));
+    }
+    if (pendingPrefetches_.empty()) {
+        return;
+    }
+
+    // The worker is started on first use; most buffers never prefetch
+    if (!prefetchWorker_.joinable()) {
+        prefetchWorker_ = std::thread([this] { prefetchWorkerLoop(); });
+    }
+    prefetchCondition_.notify_all();
+}
+
+// Cancel pending prefetches and discard the results of running ones
+void VirtualizedTextBuffer::cancelPrefetches(bool waitForLoad) const
+{
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+    pendingPrefetches_.clear();
+    prefetchGeneration_++;
+
+    if (waitForLoad) {
+        prefetchCondition_.wait(lock, [this] { return !prefetchLoading_; });
+    }
+}
+
+// Body of the background prefetch thread
+void VirtualizedTextBuffer::prefetchWorkerLoop() const
+{
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+
+    while (true) {
+        prefetchCondition_.wait(lock, [this] { return stopPrefetching_ || !pendingPrefetches_.empty(); });
+        if (stopPrefetching_) {
+            return;
+        }
+
+        PrefetchTask task = std::move(pendingPrefetches_.front());
+        pendingPrefetches_.pop_front();
+        prefetchLoading_ = true;
+        lock.unlock();
+
+        // The page is read without holding any buffer lock, so readers and
+        // writers are never blocked behind prefetch I/O
+        std::shared_ptr<Page> page;
         try {
-            LOG_DEBUG("Prefetching page " + std::to_string(req.pageNumber) + " with priority " + std::to_string(req.priority));
-            
-            auto page = loadPage(req.pageNumber);
-            
-            // Add the page to cache
-            pageCache_[req.pageNumber] = page;
-            
-            // Add to appropriate structure based on eviction policy
-            switch (evictionPolicy_) {
-                case CacheEvictionPolicy::LRU:
-                    lruList_.push_back(req.pageNumber);
-                    break;
-                    
-                case CacheEvictionPolicy::SLRU:
-                    probationarySegment_.push_back(req.pageNumber);
-                    break;
-                    
-                case CacheEvictionPolicy::ARC:
-                    recentlyUsed_.insert(req.pageNumber);
-                    break;
-                    
-                case CacheEvictionPolicy::SPATIAL:
-                    lruList_.push_back(req.pageNumber);
-                    spatialScores_[req.pageNumber] = 0.5; // Middle priority for prefetched pages
-                    break;
-            }
-            
-            processedPages++;
-            
-            // Count as a miss for now (will be counted as a hit if accessed)
-            prefetchMisses_++;
-            
+            page = task.coldPage ? decompressPage(*task.coldPage, task.pageNumber)
+                                 : readPage(task.source, task.descriptor, task.pageNumber, task.filename);
         } catch (const std::exception& e) {
-            LOG_ERROR("Error prefetching page " + std::to_string(req.pageNumber) + ": " + e.what());
+            LOG_ERROR("Error prefetching page " + std::to_string(task.pageNumber) + ": " + e.what());
+        }
+
+        lock.lock();
+        prefetchLoading_ = false;
+        prefetchInstalling_ = page != nullptr;
+        prefetchCondition_.notify_all();
+        lock.unlock();
+
+        if (page) {
+            installPrefetchedPage(task, page);
+        }
+
+        lock.lock();
+        prefetchInstalling_ = false;
+        prefetchCondition_.notify_all();
+    }
+}
+
+// Add a page loaded by the prefetcher to the cache
+void VirtualizedTextBuffer::installPrefetchedPage(const PrefetchTask& task, const std::shared_ptr<Page>& page) const
+{
+    // Writers hold the buffer lock exclusively, so the page directory cannot
+    // change while the page is added
+    std::shared_lock<std::shared_mutex> bufferLock(mutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        if (task.generation != prefetchGeneration_) {
+            return;
         }
     }
+
+    if (task.pageNumber >= pages_.size() || pageCache_.find(task.pageNumber) != pageCache_.end()) {
+        return;
+    }
+
+    // The page may have been loaded, edited and evicted again while it was
+    // read; only the copy the task started from may be installed
+    auto coldIt = coldPages_.find(task.pageNumber);
+    if (task.coldPage ? coldIt == coldPages_.end() || coldIt->second != task.coldPage
+                      : coldIt != coldPages_.end() || !pages_[task.pageNumber].hasSource) {
+        return;
+    }
+
+    page->prefetched = true;
+    admitPage(task.pageNumber, page, true);
+
+    // Count as a miss for now (will be counted as a hit if accessed)
+    prefetchMisses_++;
+}
+
+// Wait until the background prefetcher is idle
+void VirtualizedTextBuffer::waitForPrefetches() const
+{
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+    prefetchCondition_.wait(lock, [this] {
+        return pendingPrefetches_.empty() && !prefetchLoading_ && !prefetchInstalling_;
+    });
+}
+
+// Stop and join the background prefetch thread
+void VirtualizedTextBuffer::stopPrefetchWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(prefetchMutex_);
+        stopPrefetching_ = true;
+        pendingPrefetches_.clear();
+    }
+    prefetchCondition_.notify_all();
+
+    if (prefetchWorker_.joinable()) {
+        prefetchWorker_.join();
+    }
 }
 
 // Evict a page from cache according to current policy
-void VirtualizedTextBuffer::evictPage() const
+bool VirtualizedTextBuffer::evictPage() const
 {
+    bool evicted;
     switch (evictionPolicy_) {
         case CacheEvictionPolicy::SLRU:
-            evictSLRUPage();
+            evicted = evictSLRUPage();
             break;
             
         case CacheEvictionPolicy::ARC:
-            evictARCPage();
+            evicted = evictARCPage();
             break;
             
         case CacheEvictionPolicy::SPATIAL:
-            evictSpatialPage();
+            evicted = evictSpatialPage();
             break;
             
         case CacheEvictionPolicy::LRU:
         default:
-            evictLRUPage();
+            evicted = evictLRUPage();
             break;
     }
+    
+    if (evicted) {
+        evictions_++;
+    }
+    return evicted;
 }
 
 // Evict a page using the Segmented LRU policy
-void VirtualizedTextBuffer::evictSLRUPage() const
+bool VirtualizedTextBuffer::evictSLRUPage() const
 {
-    // If both segments are empty, there's nothing to evict
-    if (probationarySegment_.empty() && protectedSegment_.empty()) {
-        return;
-    }
-    
     // Always evict from probationary segment if possible
-    if (!probationarySegment_.empty()) {
-        size_t pageNumber = probationarySegment_.front();
-        probationarySegment_.pop_front();
-        
-        // Save the page if it's dirty
-        auto it = pageCache_.find(pageNumber);
-        if (it != pageCache_.end() && it->second->dirty) {
-            savePage(pageNumber, *it->second);
-        }
-        
-        // Remove the page from cache
-        pageCache_.erase(pageNumber);
+    size_t pageNumber = takeEvictable(probationarySegment_);
+    if (pageNumber != PageList::npos) {
+        demotePage(pageNumber);
         
         LOG_DEBUG("Evicted page " + std::to_string(pageNumber) + " from probationary segment");
-        
-    } else {
-        // If probationary segment is empty, evict from protected segment
-        size_t pageNumber = protectedSegment_.front();
-        protectedSegment_.pop_front();
-        
-        // Save the page if it's dirty
-        auto it = pageCache_.find(pageNumber);
-        if (it != pageCache_.end() && it->second->dirty) {
-            savePage(pageNumber, *it->second);
-        }
-        
-        // Remove the page from cache
-        pageCache_.erase(pageNumber);
+        return true;
+    }
+    
+    // If probationary segment has nothing to evict, evict from protected segment
+    pageNumber = takeEvictable(protectedSegment_);
+    if (pageNumber != PageList::npos) {
+        demotePage(pageNumber);
         
         LOG_DEBUG("Evicted page " + std::to_string(pageNumber) + " from protected segment");
+        return true;
     }
+    
+    return false;
 }
 
 // Evict a page using the Adaptive Replacement Cache policy
-void VirtualizedTextBuffer::evictARCPage() const
+bool VirtualizedTextBuffer::evictARCPage() const
 {
-    // If both segments are empty, there's nothing to evict
-    if (recentlyUsed_.empty() && frequentlyUsed_.empty()) {
-        return;
-    }
-    
-    // Decide which list to evict from based on the adaptive parameter p
-    size_t pageNumber;
-    bool fromRecent = true;
+    // REPLACE from the ARC paper: evict from T1 while it exceeds its target size p
+    bool fromRecent = !recentlyUsed_.empty() && static_cast<double>(recentlyUsed_.size()) > arcP_;
     
-    if (recentlyUsed_.size() > static_cast<size_t>(arcP_) && !recentlyUsed_.empty()) {
-        // Evict from recently used
-        pageNumber = *recentlyUsed_.begin();
-        recentlyUsed_.erase(recentlyUsed_.begin());
-        
-        // Add to ghost cache
-        ghostRecent_.insert(pageNumber);
-        
-        // Limit ghost cache size
-        if (ghostRecent_.size() > cacheSize_) {
-            ghostRecent_.erase(ghostRecent_.begin());
-        }
-        
-    } else if (!frequentlyUsed_.empty()) {
-        // Evict from frequently used
-        pageNumber = *frequentlyUsed_.begin();
-        frequentlyUsed_.erase(frequentlyUsed_.begin());
-        
-        // Add to ghost cache
-        ghostFrequent_.insert(pageNumber);
-        
-        // Limit ghost cache size
-        if (ghostFrequent_.size() > cacheSize_) {
-            ghostFrequent_.erase(ghostFrequent_.begin());
-        }
-        
-        fromRecent = false;
-    } else {
-        // Fall back to evicting from recently used
-        pageNumber = *recentlyUsed_.begin();
-        recentlyUsed_.erase(recentlyUsed_.begin());
-        
-        // Add to ghost cache
-        ghostRecent_.insert(pageNumber);
-        
-        // Limit ghost cache size
-        if (ghostRecent_.size() > cacheSize_) {
-            ghostRecent_.erase(ghostRecent_.begin());
-        }
+    size_t pageNumber = takeEvictable(fromRecent ? recentlyUsed_ : frequentlyUsed_);
+    if (pageNumber == PageList::npos) {
+        // Everything in the preferred list is pinned
+        fromRecent = !fromRecent;
+        pageNumber = takeEvictable(fromRecent ? recentlyUsed_ : frequentlyUsed_);
     }
-    
-    // Save the page if it's dirty
-    auto it = pageCache_.find(pageNumber);
-    if (it != pageCache_.end() && it->second->dirty) {
-        savePage(pageNumber, *it->second);
+    if (pageNumber == PageList::npos) {
+        return false;
     }
     
-    // Remove the page from cache
-    pageCache_.erase(pageNumber);
+    // Remember the page in the matching ghost list
+    (fromRecent ? ghostRecent_ : ghostFrequent_).pushBack(pageNumber);
+    demotePage(pageNumber);
+    trimARCGhosts();
     
     LOG_DEBUG("Evicted page " + std::to_string(pageNumber) + " from " + 
              (fromRecent ? "recently used" : "frequently used") + " segment");
+    return true;
 }
 
-// Evict a page using the Spatial locality aware policy
-void VirtualizedTextBuffer::evictSpatialPage() const
+// Adapt the ARC target size on a miss and consume the page's ghost entry
+bool VirtualizedTextBuffer::adaptARC(size_t pageNumber) const
 {
-    // If LRU list is empty, there's nothing to evict
-    if (lruList_.empty()) {
-        return;
+    const double recentGhosts = static_cast<double>(ghostRecent_.size());
+    const double frequentGhosts = static_cast<double>(ghostFrequent_.size());
+    
+    if (ghostRecent_.erase(pageNumber)) {
+        // T1 was too small: grow its target
+        arcP_ = std::min(arcP_ + std::max(1.0, frequentGhosts / recentGhosts), static_cast<double>(cacheSize_));
+        return true;
+    }
+    
+    if (ghostFrequent_.erase(pageNumber)) {
+        // T2 was too small: shrink the target of T1
+        arcP_ = std::max(arcP_ - std::max(1.0, recentGhosts / frequentGhosts), 0.0);
+        return true;
     }
     
-    // Find the page with the lowest spatial score
-    size_t lowestScorePage = lruList_.front();
-    double lowestScore = spatialScores_.count(lowestScorePage) ? 
-                         spatialScores_.at(lowestScorePage) : 0.0;
+    return false;
+}
+
+// Bound the ARC ghost lists to the cache size
+void VirtualizedTextBuffer::trimARCGhosts() const
+{
+    // |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+    while (!ghostRecent_.empty() && recentlyUsed_.size() + ghostRecent_.size() > cacheSize_) {
+        ghostRecent_.popFront();
+    }
+    while (!ghostFrequent_.empty() &&
+           recentlyUsed_.size() + frequentlyUsed_.size() + ghostRecent_.size() + ghostFrequent_.size() > 2 * cacheSize_) {
+        ghostFrequent_.popFront();
+    }
+}
+
+// Evict a page using the Spatial locality aware policy
+bool VirtualizedTextBuffer::evictSpatialPage() const
+{
+    // Among the few least recently used clean pages, evict the one with the
+    // lowest spatial score; looking at a bounded window keeps eviction O(1)
+    const size_t candidateWindow = 8;
+    size_t lowestScorePage = PageList::npos;
+    double lowestScore = 0.0;
+    size_t candidates = 0;
     
-    for (const auto& pageNumber : lruList_) {
-        double score = spatialScores_.count(pageNumber) ? 
-                      spatialScores_.at(pageNumber) : 0.0;
+    size_t pageNumber = lruList_.front();
+    for (size_t remaining = lruList_.size(); remaining > 0 && candidates < candidateWindow; --remaining) {
+        const size_t nextPage = lruList_.next(pageNumber);
         
-        // Skip pinned pages
-        auto it = pageCache_.find(pageNumber);
-        if (it != pageCache_.end() && it->second->isPinned) {
-            continue;
+        if (!isEvictable(pageNumber)) {
+            // Dirty and pinned pages move to the hot end so that later
+            // evictions do not rescan them
+            lruList_.pushBack(pageNumber);
+        } else {
+            double score = spatialScore(pageNumber);
+            if (lowestScorePage == PageList::npos || score < lowestScore) {
+                lowestScore = score;
+                lowestScorePage = pageNumber;
+            }
+            ++candidates;
         }
         
-        if (score < lowestScore) {
-            lowestScore = score;
-            lowestScorePage = pageNumber;
-        }
-    }
-    
-    // Remove the page from the LRU list
-    auto lruIt = std::find(lruList_.begin(), lruList_.end(), lowestScorePage);
-    if (lruIt != lruList_.end()) {
-        lruList_.erase(lruIt);
+        pageNumber = nextPage;
     }
     
-    // Save the page if it's dirty
-    auto it = pageCache_.find(lowestScorePage);
-    if (it != pageCache_.end() && it->second->dirty) {
-        savePage(lowestScorePage, *it->second);
+    // If there is no candidate, there's nothing to evict
+    if (lowestScorePage == PageList::npos) {
+        return false;
     }
     
-    // Remove the page from cache
-    pageCache_.erase(lowestScorePage);
+    lruList_.erase(lowestScorePage);
+    demotePage(lowestScorePage);
     spatialScores_.erase(lowestScorePage);
     
     LOG_DEBUG("Evicted page " + std::to_string(lowestScorePage) + " with spatial score " + 
              std::to_string(lowestScore));
-} 
+    return true;
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "interfaces/ITextBuffer.hpp"
+#include "MappedFile.h"
+#include "PageList.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <memory>
@@ -12,9 +15,12 @@
 #include <optional>
 #include <atomic>
 #include <deque>
-#include <unordered_set>
 #include <queue>
 #include <functional>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
 
 /**
  * @brief A text buffer implementation optimized for large files
@@ -23,6 +29,27 @@
  * for handling large files efficiently. It uses a paging mechanism
  * to load only portions of the file into memory as needed, and
  * maintains an LRU cache to manage memory usage.
+ *
+ * The buffer is described by a page directory: each page records the
+ * byte range it was loaded from and its current line count, and a
+ * Fenwick tree over those counts maps line numbers to pages in
+ * O(log pages). Pages grow and shrink independently as lines are
+ * inserted or deleted and are split or dropped when they become too
+ * large or empty, so structural edits only touch the pages they hit.
+ * Edited (dirty) pages are kept in memory and never written back into
+ * the source file; saveToFile() streams clean ranges straight from the
+ * source and dirty pages from memory.
+ *
+ * Evicted pages move to a compressed cold tier (LZ4 block format) so that
+ * revisiting them costs a decompression instead of a read. Dirty pages
+ * stay there until they are saved; clean ones are dropped when the tier
+ * exceeds its budget.
+ *
+ * The source file is memory-mapped (with a pread fallback). A clean page
+ * is loaded by scanning its byte range for newlines and holds its lines
+ * as views into the mapping; std::string copies are only made when a
+ * caller needs a std::string reference or the page is edited. Page loads
+ * do not hold the cache lock, so readers can load pages concurrently.
  */
 class VirtualizedTextBuffer : public ITextBuffer {
 public:
@@ -50,6 +77,39 @@ public:
         ADAPTIVE    ///< Dynamically adjust prefetching based on hit rate and access patterns
     };
 
+    /**
+     * @brief Snapshot of page cache usage
+     */
+    struct CacheStats {
+        size_t pagesResident = 0;        ///< Pages in the cache
+        size_t bytesResident = 0;        ///< Memory charged to the cached pages
+        size_t bytesDirty = 0;           ///< Part of bytesResident held by unsaved pages
+        size_t byteBudget = 0;           ///< Configured byte budget (0 = no limit)
+        size_t hits = 0;                 ///< Cache hits since the last reset
+        size_t misses = 0;               ///< Cache misses since the last reset
+        size_t evictions = 0;            ///< Pages evicted since the last reset
+        double evictionsPerSecond = 0.0; ///< Eviction rate since the last reset
+
+        // Compressed cold tier
+        size_t coldPagesResident = 0;    ///< Evicted pages kept compressed
+        size_t coldPagesDirty = 0;       ///< Part of coldPagesResident with unsaved edits
+        size_t coldBytesResident = 0;    ///< Compressed size of the cold pages
+        size_t coldBytesUncompressed = 0; ///< Size of the cold pages before compression
+        size_t coldByteBudget = 0;       ///< Configured cold tier budget (0 = dirty pages only)
+        size_t coldHits = 0;             ///< Cache misses served by the cold tier since the last reset
+        size_t coldMisses = 0;           ///< Cache misses read from the source since the last reset
+    };
+
+    /**
+     * @brief Default memory budget of the page cache
+     */
+    static constexpr size_t kDefaultCacheByteBudget = 256 * 1024 * 1024;
+
+    /**
+     * @brief Default memory budget of the compressed cold tier
+     */
+    static constexpr size_t kDefaultColdTierByteBudget = 64 * 1024 * 1024;
+
     /**
      * @brief Constructor
      * 
@@ -90,6 +150,7 @@ public:
     size_t lineLength(size_t lineIndex) const override;
     size_t characterCount() const override;
     std::vector<std::string> getAllLines() const override;
+    size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const override;
     bool isValidPosition(size_t lineIndex, size_t colIndex) const override;
     std::pair<size_t, size_t> clampPosition(size_t lineIndex, size_t colIndex) const override;
     void printToStream(std::ostream& os) const override;
@@ -127,6 +188,38 @@ public:
      */
     void setCacheSize(size_t cacheSize);
 
+    /**
+     * @brief Set the memory budget of the page cache
+     *
+     * Pages are evicted until the memory charged to the cache fits the
+     * budget. A page is charged for its source bytes, its line views and
+     * its materialized lines. Evicted dirty pages are kept compressed in
+     * the cold tier, which has its own budget.
+     *
+     * @param bytes The budget in bytes (0 = limited by page count only)
+     */
+    void setCacheByteBudget(size_t bytes);
+
+    /**
+     * @brief Get the memory budget of the page cache
+     *
+     * @return The budget in bytes (0 = limited by page count only)
+     */
+    size_t getCacheByteBudget() const;
+
+    /**
+     * @brief Get cache usage and eviction statistics
+     */
+    CacheStats getCacheStats() const;
+
+    /**
+     * @brief Check if memory usage is high
+     *
+     * @return True if the cache uses at least 90% of its byte budget (or
+     *         holds its maximum number of pages when there is no budget)
+     */
+    bool isMemoryUsageHigh() const;
+
     /**
      * @brief Get the current page size
      * 
@@ -155,6 +248,41 @@ public:
      */
     double getCacheHitRate() const;
 
+    /**
+     * @brief Get the share of cache misses served by the compressed cold tier
+     * 
+     * @return The cold tier hit rate as a percentage (0-100)
+     */
+    double getColdTierHitRate() const;
+
+    /**
+     * @brief Get the compression ratio of the cold tier
+     * 
+     * @return Uncompressed bytes per compressed byte (1.0 when the tier is empty)
+     */
+    double getCompressionRatio() const;
+
+    /**
+     * @brief Set the memory budget of the compressed cold tier
+     * 
+     * Evicted pages are compressed into the cold tier so that revisiting
+     * them costs a decompression rather than a read from the source. Clean
+     * pages are dropped from the tier, least recently evicted first, to
+     * stay within the budget. Dirty pages always stay until they are saved
+     * and may exceed it: evicting them is how unsaved edits leave the hot
+     * cache without touching the source file.
+     * 
+     * @param bytes The budget in bytes (0 = keep dirty pages only)
+     */
+    void setColdTierByteBudget(size_t bytes);
+
+    /**
+     * @brief Get the memory budget of the compressed cold tier
+     * 
+     * @return The budget in bytes
+     */
+    size_t getColdTierByteBudget() const;
+
     /**
      * @brief Reset the cache statistics
      */
@@ -194,7 +322,8 @@ public:
      * @brief Prefetch a range of lines
      * 
      * This method can be used to proactively load pages that will be needed soon,
-     * for example when scrolling through a file.
+     * for example when scrolling through a file. The pages are loaded on a
+     * background thread; the call does not wait for them.
      * 
      * @param startLine The first line to prefetch
      * @param endLine The last line to prefetch
@@ -255,12 +384,22 @@ public:
      */
     void setMaxPrefetchQueueSize(size_t size);
 
+    /**
+     * @brief Wait until the background prefetcher is idle
+     *
+     * Prefetched pages are loaded on a background I/O thread and appear in
+     * the cache some time after the access that requested them. This is
+     * mostly useful for tests and benchmarks that need deterministic cache
+     * contents. Must not be called while holding the buffer lock.
+     */
+    void waitForPrefetches() const;
+
 private:
     /**
      * @brief A page of text data
      */
     struct Page {
-        std::vector<std::string> lines;
+        std::vector<std::string> lines;   // Valid once the page is materialized
         std::chrono::steady_clock::time_point lastAccessed;
         bool dirty = false;
         
@@ -268,6 +407,56 @@ private:
         size_t accessCount = 0;       // For frequency-based policies
         bool isPinned = false;        // Pinned pages are not evicted
         double priority = 0.0;        // For priority-based eviction
+
+        // Pages read through the non-const getLine() may have been written
+        // through the returned reference; their content is compared against
+        // this hash before they are treated as clean again
+        bool exposed = false;         // A mutable line reference was handed out
+        uint64_t contentHash = 0;     // Hash of the content when it was exposed
+
+        bool prefetched = false;      // Loaded by the prefetcher and not requested yet
+
+        // Memory accounting
+        size_t chargedBytes = 0;      // Bytes counted in residentBytes_ for this page
+        bool charged = false;         // Whether the page is counted in residentBytes_
+        bool rechargePending = false; // Queued in unchargedPages_ after an edit
+
+        // Clean pages loaded from the source keep their lines as views into
+        // the mapped file (or into storage when it could not be mapped)
+        // until a std::string is needed. Pages created in memory start out
+        // materialized.
+        std::vector<std::string_view> views;
+        std::shared_ptr<const MappedFile> source; // Keeps the mapping behind views alive
+        std::string storage;                      // Bytes behind views when not mapped
+        std::atomic<bool> materialized{true};
+        std::mutex materializeMutex;              // Serializes materialization by readers
+    };
+
+    /**
+     * @brief An evicted page kept compressed in memory
+     *
+     * The uncompressed form is the varint length of every line followed by
+     * the lines themselves, so lines may contain any byte.
+     */
+    struct ColdPage {
+        std::string compressed;
+        size_t rawSize = 0;
+        size_t lineCount = 0;
+        bool dirty = false;           // Holds edits that exist nowhere else
+    };
+
+    /**
+     * @brief Page directory entry
+     *
+     * Describes where a page comes from and how many lines it currently
+     * holds. Pages created by edits have no source range and must stay
+     * resident until the buffer is saved.
+     */
+    struct PageDescriptor {
+        uint64_t sourceOffset = 0;    ///< Byte offset of the page's first line in the source file
+        uint64_t sourceLength = 0;    ///< Bytes spanned in the source file, line terminators included
+        size_t lineCount = 0;         ///< Current number of lines in the page
+        bool hasSource = false;       ///< False for pages that only exist in memory
     };
 
     /**
@@ -283,6 +472,20 @@ private:
         }
     };
 
+    /**
+     * @brief A page load handed to the background prefetcher
+     *
+     * Carries everything needed to read the page without the buffer lock.
+     */
+    struct PrefetchTask {
+        size_t pageNumber = 0;
+        PageDescriptor descriptor;
+        std::shared_ptr<MappedFile> source;
+        std::string filename;
+        std::shared_ptr<ColdPage> coldPage; ///< Decompressed instead of read from the source when set
+        uint64_t generation = 0;      ///< prefetchGeneration_ when the task was created
+    };
+
     /**
      * @brief Get the page number for a line index
      * 
@@ -292,12 +495,213 @@ private:
     size_t getPageNumber(size_t lineIndex) const;
 
     /**
-     * @brief Get the line index within a page
-     * 
+     * @brief Locate a line in the page directory
+     *
+     * @param lineIndex The global line index (must be < totalLines_)
+     * @return The page number and the line index within that page
+     */
+    std::pair<size_t, size_t> locateLine(size_t lineIndex) const;
+
+    /**
+     * @brief Get the global index of the first line of a page
+     *
+     * @param pageNumber The page number
+     * @return The number of lines in all pages before pageNumber
+     */
+    size_t pageFirstLine(size_t pageNumber) const;
+
+    /**
+     * @brief Rebuild the Fenwick tree from the page directory
+     */
+    void rebuildPageTree() const;
+
+    /**
+     * @brief Change the line count of a page and update the prefix sums
+     *
+     * @param pageNumber The page number
+     * @param delta The number of lines added (negative when removing)
+     */
+    void adjustPageLineCount(size_t pageNumber, std::ptrdiff_t delta);
+
+    /**
+     * @brief Split an oversized resident page into pages of pageSize_ lines
+     *
+     * @param pageNumber The page number to split
+     */
+    void splitPage(size_t pageNumber);
+
+    /**
+     * @brief Remove a run of empty pages from the directory and the cache
+     *
+     * @param firstPage The first page number to remove
+     * @param count The number of consecutive pages to remove
+     */
+    void removePages(size_t firstPage, size_t count);
+
+    /**
+     * @brief Shift cached page numbers after pages were added or removed
+     *
+     * @param firstPage The first page number affected
+     * @param delta The amount to add to every page number >= firstPage
+     */
+    void renumberPages(size_t firstPage, std::ptrdiff_t delta);
+
+    /**
+     * @brief Drop every cached page and reset all eviction and prefetch bookkeeping
+     */
+    void resetPageCache() const;
+
+    /**
+     * @brief Drop a page from the cache and all eviction bookkeeping
+     *
+     * @param pageNumber The page number to forget
+     */
+    void forgetPage(size_t pageNumber) const;
+
+    /**
+     * @brief Drop every page of the cold tier, dirty ones included
+     */
+    void clearColdTier() const;
+
+    /**
+     * @brief Move an evictable cached page into the cold tier
+     *
+     * Policy lists are left to the caller.
+     *
+     * @param pageNumber The page to demote
+     */
+    void demotePage(size_t pageNumber) const;
+
+    /**
+     * @brief Compress a page into its cold form
+     */
+    static std::shared_ptr<ColdPage> compressPage(const Page& page);
+
+    /**
+     * @brief Rebuild a page from its cold form
+     *
+     * The lines become views into the page's storage.
+     *
+     * @throws TextBufferException if the compressed data is corrupt
+     */
+    static std::shared_ptr<Page> decompressPage(const ColdPage& coldPage, size_t pageNumber);
+
+    /**
+     * @brief Remove a page from the cold tier
+     */
+    void dropColdPage(size_t pageNumber) const;
+
+    /**
+     * @brief Drop clean cold pages until the tier fits its budget
+     */
+    void trimColdTier() const;
+
+    /**
+     * @brief Add a freshly loaded or created page to the cache
+     *
+     * @param pageNumber The page number
+     * @param page The page
+     * @param prefetched Whether the page was loaded by the prefetcher
+     */
+    void admitPage(size_t pageNumber, const std::shared_ptr<Page>& page, bool prefetched) const;
+
+    /**
+     * @brief Get a line for reading (caller holds the lock)
+     *
      * @param lineIndex The global line index
-     * @return The line index within the page
+     * @return A reference to the line, valid until the page is evicted
      */
-    size_t getLineIndexInPage(size_t lineIndex) const;
+    const std::string& lineAt(size_t lineIndex) const;
+
+    /**
+     * @brief Get a line for writing and mark its page dirty (caller holds the lock)
+     *
+     * @param lineIndex The global line index
+     * @return A reference to the line
+     */
+    std::string& mutableLineAt(size_t lineIndex);
+
+    /**
+     * @brief Insert lines without taking the lock
+     *
+     * @param index The index at which to insert (may equal totalLines_)
+     * @param newLines The lines to insert
+     */
+    void insertLinesInternal(size_t index, const std::vector<std::string>& newLines);
+
+    /**
+     * @brief Delete the lines [startIndex, endIndex) without taking the lock
+     *
+     * @param startIndex The first line to delete
+     * @param endIndex One past the last line to delete (must be <= totalLines_)
+     */
+    void deleteLinesInternal(size_t startIndex, size_t endIndex);
+
+    /**
+     * @brief Read a byte range of the source file
+     *
+     * @param offset The byte offset
+     * @param length The number of bytes to read
+     * @return The bytes read
+     */
+    std::string readSourceRange(uint64_t offset, uint64_t length) const;
+
+    /**
+     * @brief Split a page's byte range into line views
+     *
+     * @param bytes The bytes of the page, including line terminators
+     * @param views Receives one view per line
+     */
+    static void splitIntoViews(std::string_view bytes, std::vector<std::string_view>& views);
+
+    /**
+     * @brief Make sure a page's lines are available as std::string
+     *
+     * Safe to call concurrently from readers holding the shared lock.
+     *
+     * @return True if this call materialized the page
+     */
+    static bool materializePage(Page& page);
+
+    /**
+     * @brief Materialize a page and drop its views (caller holds the unique lock)
+     */
+    static void detachPage(Page& page);
+
+    /**
+     * @brief Get a line of a page without materializing it
+     */
+    static std::string_view pageLine(const Page& page, size_t lineIndexInPage);
+
+    /**
+     * @brief Get the number of lines held by a page
+     */
+    static size_t pageLineCount(const Page& page);
+
+    /**
+     * @brief Get a line for reading without copying it (caller holds the lock)
+     *
+     * Concurrent readers may evict the page at any time, and pages restored
+     * from the cold tier own the bytes behind their views, so the caller
+     * keeps the page alive for as long as it uses the view.
+     *
+     * @param lineIndex The line to get
+     * @param page Receives the page holding the line
+     * @return A view that stays valid while page is held and not edited
+     */
+    std::string_view lineViewAt(size_t lineIndex, std::shared_ptr<Page>& page) const;
+
+    /**
+     * @brief Write the whole buffer to a stream
+     *
+     * Clean pages are copied from the source file without being parsed
+     * or cached; resident pages are written from memory.
+     *
+     * @param os The stream to write to
+     * @param pageOffsets If not null, receives the byte offset at which each page starts
+     * @return True if every page was written
+     */
+    bool writeContents(std::ostream& os, std::vector<uint64_t>* pageOffsets) const;
 
     /**
      * @brief Load a page from disk
@@ -307,6 +711,20 @@ private:
      */
     std::shared_ptr<Page> loadPage(size_t pageNumber) const;
 
+    /**
+     * @brief Read a page from a source file without touching buffer state
+     *
+     * Safe to call without the buffer lock; used by the prefetch thread.
+     *
+     * @param source The source file
+     * @param descriptor Where the page lies in the source file
+     * @param pageNumber The page number (for error messages)
+     * @param filename The source file name (for error messages)
+     * @return A shared pointer to the loaded page
+     */
+    static std::shared_ptr<Page> readPage(const std::shared_ptr<MappedFile>& source, const PageDescriptor& descriptor,
+                                          size_t pageNumber, const std::string& filename);
+
     /**
      * @brief Get a page from cache or load it from disk
      * 
@@ -331,38 +749,131 @@ private:
      */
     void markPageDirty(size_t pageNumber);
 
-    /**
-     * @brief Save a dirty page to disk
-     * 
-     * @param pageNumber The page number to save
-     * @param page The page to save
-     */
-    void savePage(size_t pageNumber, const Page& page) const;
-
     /**
      * @brief Evict a page from cache according to current policy
+     *
+     * The evicted page is demoted to the cold tier.
+     *
+     * @return True if a page was evicted, false if every cached page is pinned
      */
-    void evictPage() const;
+    bool evictPage() const;
 
     /**
      * @brief Evict the least recently used page from cache
+     *
+     * @return True if a page was evicted
      */
-    void evictLRUPage() const;
+    bool evictLRUPage() const;
 
     /**
      * @brief Evict a page using the Segmented LRU policy
+     *
+     * @return True if a page was evicted
      */
-    void evictSLRUPage() const;
+    bool evictSLRUPage() const;
 
     /**
      * @brief Evict a page using the Adaptive Replacement Cache policy
+     *
+     * @return True if a page was evicted
      */
-    void evictARCPage() const;
+    bool evictARCPage() const;
 
     /**
      * @brief Evict a page using the Spatial locality aware policy
+     *
+     * @return True if a page was evicted
+     */
+    bool evictSpatialPage() const;
+
+    /**
+     * @brief Check whether a cached page may be evicted
+     *
+     * Exposed pages whose content changed are marked dirty here.
+     *
+     * @param pageNumber The page number
+     * @return True if the page is not pinned
+     */
+    bool isEvictable(size_t pageNumber) const;
+
+    /**
+     * @brief Remove the coldest evictable page from a policy list
+     *
+     * Pages that cannot be evicted are moved to the hot end on the way, so
+     * repeated evictions do not rescan them.
+     *
+     * @param list The policy list
+     * @return The removed page number, or PageList::npos if none is evictable
+     */
+    size_t takeEvictable(PageList& list) const;
+
+    /**
+     * @brief Estimate the memory held by a page
+     *
+     * @param page The page
+     * @return Bytes for the page object, its source bytes, views and lines
+     */
+    static size_t measurePage(const Page& page);
+
+    /**
+     * @brief Recompute a cached page's charge and update residentBytes_
+     */
+    void chargePage(Page& page) const;
+
+    /**
+     * @brief Queue a cached page for recharging once its edit is done
      */
-    void evictSpatialPage() const;
+    void scheduleRecharge(const std::shared_ptr<Page>& page) const;
+
+    /**
+     * @brief Recharge pages edited since the last call
+     */
+    void settleCharges() const;
+
+    /**
+     * @brief Remove a page from the cache map and release its charge
+     *
+     * Policy lists are left to the caller.
+     */
+    void uncachePage(size_t pageNumber) const;
+
+    /**
+     * @brief Check whether the cache must shrink before admitting a page
+     *
+     * @param incomingBytes The charge of the page about to be admitted
+     */
+    bool isOverBudget(size_t incomingBytes) const;
+
+    /**
+     * @brief Adapt the ARC target size on a miss and consume the page's ghost entry
+     *
+     * @param pageNumber The page being admitted
+     * @return True if the page was remembered by a ghost list and belongs in T2
+     */
+    bool adaptARC(size_t pageNumber) const;
+
+    /**
+     * @brief Bound the ARC ghost lists to the cache size
+     */
+    void trimARCGhosts() const;
+
+    /**
+     * @brief Get the spatial score of a page with pending decay applied
+     */
+    double spatialScore(size_t pageNumber) const;
+
+    /**
+     * @brief Set the spatial score of a page as of the current access
+     */
+    void setSpatialScore(size_t pageNumber, double score) const;
+
+    /**
+     * @brief Hash the content of a page
+     *
+     * @param page The page
+     * @return A 64-bit FNV-1a hash of the lines joined with '\n'
+     */
+    static uint64_t hashPageContent(const Page& page);
 
     /**
      * @brief Update the access time and other metrics for a page
@@ -378,6 +889,14 @@ private:
      */
     void updateAccessPattern(size_t pageNumber) const;
 
+    /**
+     * @brief Update the access pattern tracking with the accessed page pinned
+     *
+     * @param pageNumber The page number that was accessed
+     * @param page The accessed page
+     */
+    void trackAccessPinned(size_t pageNumber, Page& page) const;
+
     /**
      * @brief Initiate prefetching based on current strategy and recent accesses
      * 
@@ -442,6 +961,44 @@ private:
      */
     void processPrefetchQueue(size_t maxPages = 2) const;
 
+    /**
+     * @brief Replace the background prefetcher's pending tasks
+     *
+     * Tasks still pending from an earlier access are cancelled: they were
+     * chosen for where the viewport was, not where it is.
+     *
+     * @param pageNumbers The pages to load, most important first
+     */
+    void dispatchPrefetches(const std::vector<size_t>& pageNumbers) const;
+
+    /**
+     * @brief Cancel pending prefetches and discard the results of running ones
+     *
+     * Called whenever page numbers or source ranges change.
+     *
+     * @param waitForLoad Also wait for a running load, so that the source
+     *                    file it reads from can be closed
+     */
+    void cancelPrefetches(bool waitForLoad = false) const;
+
+    /**
+     * @brief Body of the background prefetch thread
+     */
+    void prefetchWorkerLoop() const;
+
+    /**
+     * @brief Add a page loaded by the prefetcher to the cache
+     *
+     * The page is dropped if the buffer changed since the task was created
+     * or if a reader loaded the page in the meantime.
+     */
+    void installPrefetchedPage(const PrefetchTask& task, const std::shared_ptr<Page>& page) const;
+
+    /**
+     * @brief Stop and join the background prefetch thread
+     */
+    void stopPrefetchWorker();
+
     /**
      * @brief Initialize from file
      * 
@@ -451,35 +1008,35 @@ private:
 
     /**
      * @brief Load the index file
-     * 
+     *
+     * The index is only used if it was written for the current content of
+     * the source file and the current page size.
+     *
      * @return True if the index file was loaded successfully, false otherwise
      */
     bool loadIndexFile();
 
     /**
      * @brief Update the index file
+     *
+     * The index is fingerprinted and written on a background thread.
      */
     void updateIndexFile() const;
 
     /**
-     * @brief Rebuild the line index by scanning the file
+     * @brief Wait for a pending background index write
      */
-    void rebuildLineIndex();
+    void waitForIndexWriter() const;
 
     /**
-     * @brief Get the file offset for a line
-     * 
-     * @param lineIndex The line index
-     * @return The file offset
+     * @brief Check whether the page directory still describes the source file as is
      */
-    std::streampos getFileOffsetForLine(size_t lineIndex) const;
+    bool isSourceIntact() const;
 
     /**
-     * @brief Check if memory usage is high
-     * 
-     * @return True if memory usage is high, false otherwise
+     * @brief Rebuild the page directory by scanning the file
      */
-    bool isMemoryUsageHigh() const;
+    void rebuildLineIndex();
 
     /**
      * @brief Load a line to the temporary buffer
@@ -491,8 +1048,12 @@ private:
     // File-related members
     bool isFromFile_ = false;                          ///< Whether the buffer is backed by a file
     std::string filename_;                           ///< The file backing the buffer
-    std::shared_ptr<std::fstream> fileStream_;       ///< The file stream for file operations
-    std::vector<std::streampos> lineOffsets_;         ///< The file offsets for each line
+    mutable std::shared_ptr<MappedFile> source_;     ///< The mapped source file (remapped by saveToFile())
+    mutable std::thread indexWriter_;                ///< Background writer of the index file
+
+    // Page directory (mutable so that saveToFile() can rebase it onto the saved file)
+    mutable std::vector<PageDescriptor> pages_;       ///< Pages in document order
+    mutable std::vector<size_t> pageLineTree_;        ///< Fenwick tree over pages_[i].lineCount
 
     // Buffer state
     size_t pageSize_;                                 ///< The number of lines per page
@@ -503,21 +1064,26 @@ private:
 
     // Caching
     mutable std::unordered_map<size_t, std::shared_ptr<Page>> pageCache_; ///< The page cache
-    mutable std::vector<size_t> lruList_;             ///< List of page numbers in LRU order
+    mutable PageList lruList_;                        ///< Page numbers in LRU order (LRU and SPATIAL)
 
     // New caching members for SLRU
-    mutable std::deque<size_t> probationarySegment_;  ///< Probationary segment for SLRU
-    mutable std::deque<size_t> protectedSegment_;     ///< Protected segment for SLRU
+    mutable PageList probationarySegment_;            ///< Probationary segment for SLRU
+    mutable PageList protectedSegment_;               ///< Protected segment for SLRU
     
     // New caching members for ARC
-    mutable std::unordered_set<size_t> recentlyUsed_; ///< Recently used pages for ARC
-    mutable std::unordered_set<size_t> frequentlyUsed_; ///< Frequently used pages for ARC
-    mutable std::unordered_set<size_t> ghostRecent_;  ///< Ghost cache of recently evicted pages
-    mutable std::unordered_set<size_t> ghostFrequent_; ///< Ghost cache of frequently used pages
-    mutable double arcP_ = 0.0;                       ///< Adaptive size parameter for ARC
+    mutable PageList recentlyUsed_;                   ///< T1: resident pages seen once recently
+    mutable PageList frequentlyUsed_;                 ///< T2: resident pages seen at least twice
+    mutable PageList ghostRecent_;                    ///< B1: pages recently evicted from T1
+    mutable PageList ghostFrequent_;                  ///< B2: pages recently evicted from T2
+    mutable double arcP_ = 0.0;                       ///< Adaptive target size of T1
 
     // New caching members for Spatial
-    mutable std::unordered_map<size_t, double> spatialScores_; ///< Spatial locality scores
+    struct SpatialScore {
+        double value = 0.0;
+        uint64_t tick = 0;                            ///< spatialClock_ when value was set
+    };
+    mutable std::unordered_map<size_t, SpatialScore> spatialScores_; ///< Spatial locality scores of resident pages
+    mutable uint64_t spatialClock_ = 0;               ///< Accesses seen by the spatial policy
 
     // Access pattern tracking
     mutable std::deque<size_t> recentAccesses_;       ///< Queue of recently accessed pages
@@ -530,6 +1096,16 @@ private:
     mutable size_t prefetchDistance_ = 1;             ///< How many pages to prefetch in each direction
     mutable size_t prefetchHits_ = 0;                 ///< Number of cache hits on prefetched pages
     mutable size_t prefetchMisses_ = 0;               ///< Number of prefetched pages that weren't used
+
+    // Background prefetching (lock order: mutex_, cacheMutex_, prefetchMutex_)
+    mutable std::thread prefetchWorker_;              ///< I/O thread loading prefetched pages
+    mutable std::mutex prefetchMutex_;                ///< Guards the members below
+    mutable std::condition_variable prefetchCondition_; ///< Signals new tasks, idleness and shutdown
+    mutable std::deque<PrefetchTask> pendingPrefetches_; ///< Tasks not started yet, most important first
+    mutable bool prefetchLoading_ = false;            ///< Whether the worker is reading a page
+    mutable bool prefetchInstalling_ = false;         ///< Whether the worker is adding a page to the cache
+    mutable bool stopPrefetching_ = false;            ///< Tells the worker to exit
+    mutable uint64_t prefetchGeneration_ = 0;         ///< Bumped when page numbers or source ranges change
     
     // Cache policy settings
     CacheEvictionPolicy evictionPolicy_ = CacheEvictionPolicy::LRU; ///< Current cache eviction policy
@@ -538,7 +1114,24 @@ private:
     // Statistics
     mutable size_t cacheHits_ = 0;                    ///< Number of cache hits
     mutable size_t cacheMisses_ = 0;                  ///< Number of cache misses
+    mutable size_t evictions_ = 0;                    ///< Number of pages evicted
+    mutable std::chrono::steady_clock::time_point statsResetTime_ = std::chrono::steady_clock::now(); ///< Start of the statistics window
+
+    // Memory accounting
+    size_t cacheByteBudget_ = kDefaultCacheByteBudget; ///< Memory budget of the cache (0 = none)
+    mutable size_t residentBytes_ = 0;                ///< Memory charged to cached pages
+    mutable std::vector<std::shared_ptr<Page>> unchargedPages_; ///< Edited pages awaiting a recharge
+
+    // Compressed cold tier
+    mutable std::unordered_map<size_t, std::shared_ptr<ColdPage>> coldPages_; ///< Evicted pages by page number
+    mutable PageList coldOrder_;                      ///< Cold page numbers, least recently evicted first
+    size_t coldTierByteBudget_ = kDefaultColdTierByteBudget; ///< Budget for clean cold pages
+    mutable size_t coldBytes_ = 0;                    ///< Compressed bytes in the cold tier
+    mutable size_t coldRawBytes_ = 0;                 ///< Uncompressed bytes in the cold tier
+    mutable size_t coldHits_ = 0;                     ///< Misses served by the cold tier
+    mutable size_t coldMisses_ = 0;                   ///< Misses read from the source
 
     // Thread safety
     mutable std::shared_mutex mutex_;                 ///< Mutex for thread safety
+    mutable std::mutex cacheMutex_;                   ///< Guards the cache, policy state and statistics for readers
 }; 
\ No newline at end of file
@@ -11,13 +11,15 @@ using json = nlohmann::json;
 
 CollaborativeClient::CollaborativeClient(
     std::shared_ptr<IWebSocketClient> webSocketClient,
-    std::shared_ptr<ICRDT> crdt)
+    std::shared_ptr<ICRDT> crdt,
+    std::shared_ptr<Executor> executor)
     : webSocketClient_(webSocketClient),
       crdt_(crdt),
       documentChangeCallback_(nullptr),
       cursorChangeCallback_(nullptr),
       selectionChangeCallback_(nullptr),
       presenceChangeCallback_(nullptr),
+      executor_(executor ? std::move(executor) : Executor::shared()),
       heartbeatRunning_(false),
       heartbeatInterval_(std::chrono::milliseconds(30000)),  // 30 seconds
       wasConnected_(false) {
@@ -489,9 +491,18 @@ void CollaborativeClient::startHeartbeat() {
     }
     
     heartbeatRunning_ = true;
-    
-    heartbeatThread_ = std::thread([this]() {
-        while (heartbeatRunning_ && webSocketClient_ && webSocketClient_->isConnected()) {
+    heartbeat_ = std::make_shared<HeartbeatState>();
+    scheduleHeartbeat(heartbeat_, std::chrono::milliseconds(0));
+}
+
+void CollaborativeClient::scheduleHeartbeat(std::shared_ptr<HeartbeatState> state, std::chrono::milliseconds delay) {
+    try {
+        executor_->schedule(Executor::Lane::IO, delay, [this, state]() {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->running || !webSocketClient_ || !webSocketClient_->isConnected()) {
+                return;
+            }
+            
             // Send ping message
             WebSocketMessage pingMessage;
             pingMessage.type = WebSocketMessageType::PING;
@@ -500,18 +511,23 @@ void CollaborativeClient::startHeartbeat() {
             pingMessage.userId = userId_;
             webSocketClient_->send(pingMessage);
             
-            // Sleep for heartbeat interval
-            std::this_thread::sleep_for(heartbeatInterval_);
-        }
-    });
+            // Send the next one after the heartbeat interval
+            scheduleHeartbeat(state, heartbeatInterval_);
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to schedule heartbeat: " << e.what() << std::endl;
+    }
 }
 
 void CollaborativeClient::stopHeartbeat() {
     heartbeatRunning_ = false;
     
-    if (heartbeatThread_.joinable()) {
-        heartbeatThread_.join();
+    // Waits for a tick that is sending right now; later ticks do nothing
+    if (heartbeat_) {
+        std::lock_guard<std::mutex> lock(heartbeat_->mutex);
+        heartbeat_->running = false;
     }
+    heartbeat_.reset();
 }
 
 } // namespace ai_editor 
\ No newline at end of file
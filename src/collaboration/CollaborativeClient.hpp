@@ -4,6 +4,7 @@
 #include "interfaces/IWebSocketClient.hpp"
 #include "interfaces/IWebSocketCallback.hpp"
 #include "interfaces/ICRDT.hpp"
+#include "Executor.h"
 
 #include <memory>
 #include <string>
@@ -31,10 +32,12 @@ public:
      * @brief Constructor
      * @param webSocketClient The WebSocket client to use for communication
      * @param crdt The CRDT to use for conflict-free editing
+     * @param executor Executor that sends the heartbeat; defaults to the process-wide one
      */
     CollaborativeClient(
         std::shared_ptr<IWebSocketClient> webSocketClient,
-        std::shared_ptr<ICRDT> crdt = nullptr);
+        std::shared_ptr<ICRDT> crdt = nullptr,
+        std::shared_ptr<Executor> executor = nullptr);
     
     /**
      * @brief Destructor
@@ -77,6 +80,14 @@ private:
     void startHeartbeat();
     void stopHeartbeat();
     
+    // Shared by the ticks of one heartbeat; a tick holds the mutex while it
+    // uses the client, so none does once stopHeartbeat() has cleared running
+    struct HeartbeatState {
+        std::mutex mutex;
+        bool running = true;
+    };
+    void scheduleHeartbeat(std::shared_ptr<HeartbeatState> state, std::chrono::milliseconds delay);
+    
     // Member variables
     std::shared_ptr<IWebSocketClient> webSocketClient_;
     std::shared_ptr<ICRDT> crdt_;
@@ -95,10 +106,11 @@ private:
     std::unordered_map<std::string, RemoteUser> connectedUsers_;
     mutable std::mutex usersMutex_;
     
-    // Heartbeat
+    // Heartbeat, sent by self-rescheduling ticks on the executor's IO lane
+    std::shared_ptr<Executor> executor_;
     std::atomic<bool> heartbeatRunning_;
     std::chrono::milliseconds heartbeatInterval_;
-    std::thread heartbeatThread_;
+    std::shared_ptr<HeartbeatState> heartbeat_;
     
     // For detecting reconnection
     bool wasConnected_;
@@ -14,7 +14,9 @@ using json = nlohmann::json;
 WebSocketClient::WebSocketClient()
     : callback_(nullptr),
       connectionId_(boost::uuids::to_string(boost::uuids::random_generator()())),
+      work_guard_(boost::asio::make_work_guard(io_context_)),
       resolver_(io_context_),
+      reconnect_timer_(io_context_),
       connected_(false),
       connecting_(false),
       stopping_(false),
@@ -27,7 +29,9 @@ WebSocketClient::~WebSocketClient() {
     stopping_ = true;
     disconnect();
     
-    // Wait for IO thread to exit
+    // Wait for the event loop to exit
+    work_guard_.reset();
+    io_context_.stop();
     if (io_thread_.joinable()) {
         io_thread_.join();
     }
@@ -47,7 +51,7 @@ bool WebSocketClient::connect(
     // Parse URL
     parseUrl(url, host_, port_, path_);
     
-    // Start IO thread if not already running
+    // Start the event loop if not already running
     if (!io_thread_.joinable()) {
         io_thread_ = std::thread(&WebSocketClient::runIoContext, this);
     }
@@ -198,28 +202,17 @@ std::string WebSocketClient::getServerUrl() const {
 }
 
 void WebSocketClient::runIoContext() {
+    // The work guard keeps run() waiting for handlers while the client is
+    // idle, so it only returns once the destructor stops the context
     while (!stopping_) {
         try {
-            // Reset any state
-            io_context_.restart();
-            
-            // Run the IO context
             io_context_.run();
-            
-            // If we get here, the IO context has no more work to do
-            if (should_reconnect_ && !stopping_) {
-                handleReconnect();
-            } else {
-                // Sleep a bit before checking again
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
+            return;
         } catch (const std::exception& e) {
+            // A handler threw; keep serving the remaining ones
             if (callback_) {
                 callback_->onError(connectionId_, "IO thread exception: " + std::string(e.what()));
             }
-            
-            // Sleep a bit before trying again
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
 }
@@ -399,25 +392,14 @@ void WebSocketClient::scheduleReconnect() {
     // Increment attempt counter
     reconnect_attempts_++;
     
-    // Schedule reconnect
-    std::thread([this, delay]() {
-        std::this_thread::sleep_for(delay);
-        
-        if (!stopping_ && should_reconnect_) {
+    // Schedule reconnect on the event loop, which the destructor waits for
+    reconnect_timer_.expires_after(delay);
+    reconnect_timer_.async_wait([this](boost::beast::error_code ec) {
+        if (!ec && !stopping_ && should_reconnect_) {
             // Try to reconnect
             connect(serverUrl_);
         }
-    }).detach();
-}
-
-void WebSocketClient::handleReconnect() {
-    if (stopping_ || connected_ || connecting_) {
-        return;
-    }
-    
-    // Try to reconnect
-    should_reconnect_ = false;
-    connect(serverUrl_);
+    });
 }
 
 // Static method to implement WebSocketMessage::fromJson
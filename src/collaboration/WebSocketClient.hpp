@@ -3,6 +3,7 @@
 #include "interfaces/IWebSocketCommunication.hpp"
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <queue>
@@ -19,6 +20,8 @@ namespace ai_editor {
  * 
  * This class provides a WebSocket client implementation using the Boost.Beast library.
  * It handles connection management, message sending/receiving, and reconnection logic.
+ * The event loop runs on a thread owned by the client from the first connect() until
+ * destruction, rather than on a shared executor lane it would occupy for that long.
  */
 class WebSocketClient : public IWebSocketClient {
 public:
@@ -113,7 +116,6 @@ private:
     void onWrite(error_code ec, std::size_t bytes_transferred);
     void parseUrl(const std::string& url, std::string& host, std::string& port, std::string& path);
     void scheduleReconnect();
-    void handleReconnect();
     
     // Member variables
     std::shared_ptr<IWebSocketCallback> callback_;
@@ -125,11 +127,13 @@ private:
     
     // Boost.Asio and Beast objects
     boost::asio::io_context io_context_;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_;  // Keeps run() waiting while idle
     std::unique_ptr<websocket> ws_;
     boost::asio::ip::tcp::resolver resolver_;
+    boost::asio::steady_timer reconnect_timer_;
     
     // Threading and synchronization
-    std::thread io_thread_;
+    std::thread io_thread_;  // Runs the event loop
     std::mutex write_mutex_;
     std::queue<std::string> write_queue_;
     std::condition_variable write_cv_;
@@ -28,6 +28,7 @@
 #include "../EditorErrorReporter.h"
 #include "../EditorServices.h"
 #include "../EditorCoreThreadPool.h"
+#include "../Executor.h"
 #include "../AppDebugLog.h"
 #include "../plugins/PluginManager.hpp"
 #include "../plugins/CommandRegistry.hpp"
@@ -66,6 +67,7 @@ public:
      */
     static void registerAll(ServiceCollection& services) {
         // Register core services
+        registerExecutor(services);
         registerTextBuffer(services);
         registerSyntaxHighlightingManager(services);
         registerCommandManager(services);
@@ -92,6 +94,15 @@ public:
         registerApplication(services);
     }
     
+    /**
+     * @brief Register the process-wide executor
+     * 
+     * @param services The service collection to register with
+     */
+    static void registerExecutor(ServiceCollection& services) {
+        services.addSingleton<Executor>(Executor::shared());
+    }
+    
     /**
      * @brief Register the text buffer factory
      * 
@@ -118,8 +129,8 @@ public:
      * @param services The service collection to register with
      */
     static void registerSyntaxHighlightingManager(ServiceCollection& services) {
-        services.addSingleton<ISyntaxHighlightingManager>([](){ 
-            return std::make_shared<SyntaxHighlightingManager>();
+        services.addSingleton<ISyntaxHighlightingManager>([](std::shared_ptr<DIFramework> provider){ 
+            return std::make_shared<SyntaxHighlightingManager>(provider->get<Executor>());
         });
     }
     
@@ -162,8 +173,8 @@ public:
      * @param services The service collection to register with
      */
     static void registerEditorCoreThreadPool(ServiceCollection& services) {
-        services.addSingleton<IEditorCoreThreadPool>([](){ 
-            return std::make_shared<EditorCoreThreadPool>();
+        services.addSingleton<IEditorCoreThreadPool>([](std::shared_ptr<DIFramework> provider){ 
+            return std::make_shared<EditorCoreThreadPool>(provider->get<Executor>());
         });
     }
     
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Injector.hpp"
+#include "../Executor.h"
 #include <iostream>
 
 namespace di {
@@ -93,6 +94,11 @@ public:
             return std::make_shared<ConsoleLogger>();
         });
         
+        // Every component shares one executor rather than starting threads of its own
+        injector.registerFactory<Executor>([]() {
+            return Executor::shared();
+        });
+        
         // Here we would register other core services
         
         std::cout << "CoreModule configured successfully" << std::endl;
@@ -23,8 +23,9 @@ public:
      * 2. Default text buffer provider based on configuration and file size
      * 3. Basic text buffer provider (non-thread-safe)
      * 4. Thread-safe text buffer provider
-     * 5. Virtualized text buffer provider (for large files)
-     * 6. Thread-safe virtualized text buffer provider
+     * 5. Piece-table text buffer provider
+     * 6. Virtualized text buffer provider (for large files)
+     * 7. Thread-safe virtualized text buffer provider
      * 
      * @param injector The DI injector to register components with
      */
@@ -51,6 +52,11 @@ public:
             return TextBufferFactory::createThreadSafeTextBuffer();
         }, di::Lifetime::Transient);
         
+        // Piece-table text buffer (non-thread-safe, O(log n) edits)
+        injector.registerFactory<ITextBuffer>("piece_table", [](const di::Injector& inj) {
+            return TextBufferFactory::createPieceTableTextBuffer();
+        }, di::Lifetime::Transient);
+        
         // Virtualized text buffer for large files
         injector.registerFactory<ITextBuffer>("virtualized", [](const di::Injector& inj) {
             auto config = inj.get<TextBufferConfig>();
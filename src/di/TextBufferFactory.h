@@ -5,6 +5,7 @@
 #include <fstream>
 #include "interfaces/ITextBuffer.hpp"
 #include "TextBuffer.h"
+#include "PieceTableTextBuffer.h"
 #include "ThreadSafeTextBuffer.h"
 #include "VirtualizedTextBuffer.h"
 #include "ThreadSafeVirtualizedTextBuffer.h"
@@ -15,6 +16,7 @@
  * 
  * This factory provides methods to create various text buffer implementations:
  * - Basic TextBuffer: Simple in-memory buffer, not thread-safe
+ * - PieceTableTextBuffer: Piece-table buffer with O(log n) edits, not thread-safe
  * - ThreadSafeTextBuffer: Basic buffer with thread safety
  * - VirtualizedTextBuffer: Performance-optimized buffer for large files
  * - ThreadSafeVirtualizedTextBuffer: Thread-safe version of the virtualized buffer
@@ -34,6 +36,23 @@ public:
         }
     }
 
+    /**
+     * @brief Create a piece-table text buffer
+     * 
+     * Edits cost O(log n) regardless of file size, which makes this buffer a better
+     * fit than TextBuffer for editing large files that still fit in memory.
+     * 
+     * @param filename Optional filename to load
+     * @return A shared pointer to an ITextBuffer implementation
+     */
+    static std::shared_ptr<ITextBuffer> createPieceTableTextBuffer(const std::string& filename = "") {
+        if (filename.empty()) {
+            return std::make_shared<PieceTableTextBuffer>();
+        } else {
+            return std::make_shared<PieceTableTextBuffer>(filename);
+        }
+    }
+
     /**
      * @brief Create a thread-safe text buffer
      * @param filename Optional filename to load
@@ -3,6 +3,7 @@
 #include <memory>
 #include "Injector.hpp"
 #include "../TextBuffer.h"
+#include "../PieceTableTextBuffer.h"
 #include "../interfaces/ITextBuffer.hpp"
 #include "../AppDebugLog.h"
 
@@ -35,4 +36,22 @@ public:
         
         return textBuffer;
     }
+    
+    /**
+     * @brief Create a new PieceTableTextBuffer instance
+     * 
+     * Register this in place of create() to run the Editor on the piece-table
+     * buffer, which keeps edits O(log n) on very large documents.
+     * 
+     * @param injector The dependency injector
+     * @return A shared pointer to a PieceTableTextBuffer instance, as an ITextBuffer
+     */
+    static std::shared_ptr<ITextBuffer> createPieceTable(di::Injector& injector) {
+        // The default constructor already provides the single empty line
+        auto textBuffer = std::make_shared<PieceTableTextBuffer>();
+        
+        LOG_DEBUG("Created new PieceTableTextBuffer instance");
+        
+        return textBuffer;
+    }
 }; 
\ No newline at end of file
@@ -1,11 +1,19 @@
 #include "DiffMergeFactory.h"
 #include "MyersDiff.h"
+#include "HistogramDiff.h"
 #include "MergeEngine.h"
 #include "AppDebugLog.h"
 
-IDiffEnginePtr DiffMergeFactory::createDiffEngine() {
+IDiffEnginePtr DiffMergeFactory::createDiffEngine(DiffAlgorithm algorithm, std::shared_ptr<Executor> executor) {
     LOG_DEBUG("Creating new diff engine");
-    return std::make_shared<MyersDiff>();
+    std::shared_ptr<MyersDiff> engine;
+    if (algorithm == DiffAlgorithm::HISTOGRAM) {
+        engine = std::make_shared<HistogramDiff>();
+    } else {
+        engine = std::make_shared<MyersDiff>();
+    }
+    engine->setParallelExecutor(std::move(executor));
+    return engine;
 }
 
 IMergeEnginePtr DiffMergeFactory::createMergeEngine(IDiffEnginePtr diffEngine) {
@@ -2,8 +2,17 @@
 
 #include "interfaces/IDiffEngine.hpp"
 #include "interfaces/IMergeEngine.hpp"
+#include "Executor.h"
 #include <memory>
 
+/**
+ * @brief Line diff algorithms available from DiffMergeFactory
+ */
+enum class DiffAlgorithm {
+    MYERS,      ///< Shortest edit script (MyersDiff)
+    HISTOGRAM   ///< Anchors on unique and rare lines first (HistogramDiff)
+};
+
 /**
  * @class DiffMergeFactory
  * @brief Factory for creating diff and merge engines
@@ -16,9 +25,14 @@ public:
     /**
      * @brief Create a diff engine
      * 
+     * @param algorithm The line diff algorithm the engine should use
+     * @param executor Executor to diff very large inputs on in parallel, or null to diff serially.
+     *                 The parallel mode trades the shortest edit script for speed; see
+     *                 MyersDiff::setParallelExecutor()
      * @return A shared pointer to an IDiffEngine
      */
-    static IDiffEnginePtr createDiffEngine();
+    static IDiffEnginePtr createDiffEngine(DiffAlgorithm algorithm = DiffAlgorithm::MYERS,
+                                           std::shared_ptr<Executor> executor = nullptr);
     
     /**
      * @brief Create a merge engine
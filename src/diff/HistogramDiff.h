@@ -0,0 +1,265 @@
+#pragma once
+
+#include "MyersDiff.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class HistogramDiff
+ * @brief Line diff that aligns on rare lines before minimizing edits
+ *
+ * Myers finds a shortest edit script, but on source files many lines
+ * (braces, blank lines, "return true;") occur everywhere, and a shortest
+ * script happily matches them across unrelated hunks. This engine splits
+ * each range at anchors instead, in the spirit of git's histogram diff:
+ *
+ * - lines that occur exactly once on both sides, aligned by their longest
+ *   increasing subsequence (patience diff);
+ * - failing that, the longest common run around the least frequent line
+ *   that occurs at most MAX_CHAIN_LENGTH times (histogram diff), unless
+ *   the run is shorter than its displacement between the two sides;
+ * - failing that, the range is left to Myers.
+ *
+ * The anchors cut the problem into small independent ranges. Character-level
+ * diffs and formatting are inherited from MyersDiff.
+ */
+class HistogramDiff : public MyersDiff {
+public:
+    /**
+     * @brief Constructor
+     */
+    HistogramDiff() {
+        LOG_DEBUG("HistogramDiff created");
+    }
+
+    /**
+     * @brief Destructor
+     */
+    ~HistogramDiff() override = default;
+
+protected:
+    void appendLineEditScript(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        size_t offset,
+        std::vector<EditScriptItem>& script) override {
+
+        const size_t first = script.size();
+        Scratch scratch(ids1, ids2);
+
+        // Ranges are processed from an explicit stack rather than by
+        // recursion, since one anchor per level can nest as deep as the file
+        std::vector<Task> tasks;
+        tasks.push_back({Task::RANGE, 0, ids1.size(), 0, ids2.size()});
+        while (!tasks.empty()) {
+            const Task task = tasks.back();
+            tasks.pop_back();
+            if (task.kind == Task::KEEP) {
+                for (size_t i = 0; i < task.hi1 - task.lo1; ++i) {
+                    script.push_back({EditOp::KEEP, task.lo1 + i, task.lo2 + i});
+                }
+            } else {
+                splitRange(ids1, ids2, task, scratch, tasks, script);
+            }
+        }
+
+        for (size_t i = first; i < script.size(); ++i) {
+            script[i].idx1 += offset;
+            script[i].idx2 += offset;
+        }
+        groupDeletesBeforeInserts(script, first);
+    }
+
+private:
+    // Lines occurring more often than this are never used as anchors
+    static constexpr uint32_t MAX_CHAIN_LENGTH = 64;
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /**
+     * @brief A range still to diff, or a run of matched lines to emit
+     */
+    struct Task {
+        enum Kind { RANGE, KEEP } kind;
+        size_t lo1, hi1;
+        size_t lo2, hi2;
+    };
+
+    /**
+     * @brief Per-line-id tables, allocated once and left cleared between ranges
+     */
+    struct Scratch : AnchorScratch {
+        std::vector<uint32_t> next;  // Next position with the same id, per position in ids1
+        std::vector<std::pair<size_t, size_t>> anchors;
+
+        Scratch(const std::vector<uint32_t>& ids1, const std::vector<uint32_t>& ids2)
+            : AnchorScratch(ids1, ids2) {
+            next.assign(ids1.size(), NONE);
+        }
+    };
+
+    static size_t absDifference(size_t a, size_t b) {
+        return a > b ? a - b : b - a;
+    }
+
+    /**
+     * @brief Diff one range, emitting what it can and pushing the rest as tasks
+     */
+    void splitRange(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        Task range,
+        Scratch& scratch,
+        std::vector<Task>& tasks,
+        std::vector<EditScriptItem>& script) {
+
+        // Trim the common prefix and suffix
+        while (range.lo1 < range.hi1 && range.lo2 < range.hi2 && ids1[range.lo1] == ids2[range.lo2]) {
+            script.push_back({EditOp::KEEP, range.lo1, range.lo2});
+            ++range.lo1;
+            ++range.lo2;
+        }
+        size_t suffix = 0;
+        while (range.lo1 < range.hi1 - suffix && range.lo2 < range.hi2 - suffix &&
+               ids1[range.hi1 - 1 - suffix] == ids2[range.hi2 - 1 - suffix]) {
+            ++suffix;
+        }
+        if (suffix > 0) {
+            tasks.push_back({Task::KEEP, range.hi1 - suffix, range.hi1, range.hi2 - suffix, range.hi2});
+            range.hi1 -= suffix;
+            range.hi2 -= suffix;
+        }
+
+        if (range.lo1 == range.hi1) {
+            for (size_t j = range.lo2; j < range.hi2; ++j) {
+                script.push_back({EditOp::INSERT, range.lo1, j});
+            }
+        } else if (range.lo2 == range.hi2) {
+            for (size_t i = range.lo1; i < range.hi1; ++i) {
+                script.push_back({EditOp::DELETE, i, range.lo2});
+            }
+        } else if (!splitAtUniqueLines(ids1, ids2, range, scratch, tasks) &&
+                   !splitAtRarestRun(ids1, ids2, range, scratch, tasks)) {
+            appendRangeEditScript(ids1, ids2, range.lo1, range.hi1, range.lo2, range.hi2, script);
+        }
+    }
+
+    /**
+     * @brief Patience step: anchor on lines unique to both sides
+     *
+     * @return False if no line is unique to both sides
+     */
+    bool splitAtUniqueLines(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        const Task& range,
+        Scratch& scratch,
+        std::vector<Task>& tasks) {
+
+        findUniqueAnchors(ids1, ids2, range.lo1, range.hi1, range.lo2, range.hi2, scratch, scratch.anchors);
+        if (scratch.anchors.empty()) {
+            return false;
+        }
+
+        // Push the gaps and anchors last to first, so they pop in order
+        size_t hi1 = range.hi1;
+        size_t hi2 = range.hi2;
+        for (size_t k = scratch.anchors.size(); k-- > 0;) {
+            const size_t anchor1 = scratch.anchors[k].first;
+            const size_t anchor2 = scratch.anchors[k].second;
+            tasks.push_back({Task::RANGE, anchor1 + 1, hi1, anchor2 + 1, hi2});
+            tasks.push_back({Task::KEEP, anchor1, anchor1 + 1, anchor2, anchor2 + 1});
+            hi1 = anchor1;
+            hi2 = anchor2;
+        }
+        tasks.push_back({Task::RANGE, range.lo1, hi1, range.lo2, hi2});
+        return true;
+    }
+
+    /**
+     * @brief Histogram step: anchor on the longest common run around the rarest line
+     *
+     * @return False if every common line occurs more than MAX_CHAIN_LENGTH times
+     */
+    bool splitAtRarestRun(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        const Task& range,
+        Scratch& scratch,
+        std::vector<Task>& tasks) {
+
+        // Chain the positions of each line in ids1, in increasing order
+        for (size_t i = range.hi1; i-- > range.lo1;) {
+            ++scratch.count1[ids1[i]];
+            scratch.next[i] = scratch.head[ids1[i]];
+            scratch.head[ids1[i]] = static_cast<uint32_t>(i);
+        }
+
+        size_t best1 = 0;
+        size_t best2 = 0;
+        size_t bestLength = 0;
+        uint32_t bestCount = MAX_CHAIN_LENGTH + 1;
+
+        for (size_t j = range.lo2; j < range.hi2;) {
+            size_t nextJ = j + 1;
+            const uint32_t count = scratch.count1[ids2[j]];
+            if (count == 0 || count > bestCount) {
+                j = nextJ;
+                continue;
+            }
+
+            for (uint32_t i = scratch.head[ids2[j]]; i != NONE; i = scratch.next[i]) {
+                // Grow the match both ways, tracking its rarest line
+                size_t start1 = i;
+                size_t start2 = j;
+                size_t end1 = i + 1;
+                size_t end2 = j + 1;
+                uint32_t rarest = count;
+                while (start1 > range.lo1 && start2 > range.lo2 && ids1[start1 - 1] == ids2[start2 - 1]) {
+                    --start1;
+                    --start2;
+                    rarest = std::min(rarest, scratch.count1[ids1[start1]]);
+                }
+                while (end1 < range.hi1 && end2 < range.hi2 && ids1[end1] == ids2[end2]) {
+                    rarest = std::min(rarest, scratch.count1[ids1[end1]]);
+                    ++end1;
+                    ++end2;
+                }
+
+                // Skip runs that keep fewer lines than the shift between
+                // their position in ids1 and in ids2 forces out; in repetitive
+                // text those are one copy of a block matched to another
+                const size_t length = end1 - start1;
+                const size_t shift = absDifference(start1 - range.lo1, start2 - range.lo2) +
+                                     absDifference(range.hi1 - end1, range.hi2 - end2);
+                if (shift > length) {
+                    continue;
+                }
+
+                nextJ = std::max(nextJ, end2);
+                if (length > bestLength || rarest < bestCount) {
+                    best1 = start1;
+                    best2 = start2;
+                    bestLength = length;
+                    bestCount = rarest;
+                }
+            }
+            j = nextJ;
+        }
+
+        for (size_t i = range.lo1; i < range.hi1; ++i) {
+            scratch.count1[ids1[i]] = 0;
+            scratch.head[ids1[i]] = NONE;
+        }
+
+        if (bestLength == 0) {
+            return false;
+        }
+
+        tasks.push_back({Task::RANGE, best1 + bestLength, range.hi1, best2 + bestLength, range.hi2});
+        tasks.push_back({Task::KEEP, best1, best1 + bestLength, best2, best2 + bestLength});
+        tasks.push_back({Task::RANGE, range.lo1, best1, range.lo2, best2});
+        return true;
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @class LineInterner
+ * @brief Maps lines to dense integer ids, equal ids meaning equal lines
+ *
+ * Diff algorithms compare every line many times; interning once lets them
+ * compare integers instead of strings. Lines are bucketed by a 64-bit hash in
+ * an open-addressing table and each hash match is verified against the first
+ * line interned with that id, so a collision cannot make two different lines
+ * compare equal.
+ *
+ * The interner keeps pointers to the interned strings; they must outlive it.
+ */
+class LineInterner {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param expectedLines Number of lines expected, to size the table up front
+     */
+    explicit LineInterner(size_t expectedLines = 0) {
+        size_t capacity = 16;
+        while (capacity < expectedLines * 2) {
+            capacity *= 2;
+        }
+        slots_.assign(capacity, Slot());
+    }
+
+    /**
+     * @brief Get the id of a line, assigning the next free one if it is new
+     */
+    uint32_t intern(const std::string& line) {
+        const uint64_t hash = hashLine(line.data(), line.size());
+        const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        size_t index = static_cast<size_t>(hash) & (slots_.size() - 1);
+
+        while (slots_[index].id != EMPTY) {
+            const Slot& slot = slots_[index];
+            if (slot.tag == tag && hashes_[slot.id] == hash && *lines_[slot.id] == line) {
+                return slot.id;
+            }
+            index = (index + 1) & (slots_.size() - 1);
+        }
+
+        const uint32_t id = static_cast<uint32_t>(lines_.size());
+        slots_[index] = {tag, id};
+        lines_.push_back(&line);
+        hashes_.push_back(hash);
+        if (lines_.size() * 2 > slots_.size()) {
+            grow();
+        }
+        return id;
+    }
+
+    /**
+     * @brief Number of distinct lines interned so far
+     */
+    size_t size() const {
+        return lines_.size();
+    }
+
+    /**
+     * @brief 64-bit hash of a line
+     *
+     * FNV-1a over 8-byte words rather than single bytes, with a final mix so
+     * that both halves of the result depend on every input bit.
+     */
+    static uint64_t hashLine(const char* data, size_t length) {
+        uint64_t hash = 14695981039346656037ULL ^ length;
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ULL;
+            hash ^= hash >> 29;
+        }
+        for (; i < length; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        hash ^= hash >> 32;
+        hash *= 0xd6e8feb86659fd93ULL;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    // Upper half of the hash, to skip most mismatches without touching hashes_
+    struct Slot {
+        uint32_t tag = 0;
+        uint32_t id = EMPTY;
+    };
+
+    void grow() {
+        std::vector<Slot> old(slots_.size() * 2, Slot());
+        old.swap(slots_);
+        for (const Slot& slot : old) {
+            if (slot.id == EMPTY) {
+                continue;
+            }
+            size_t index = static_cast<size_t>(hashes_[slot.id]) & (slots_.size() - 1);
+            while (slots_[index].id != EMPTY) {
+                index = (index + 1) & (slots_.size() - 1);
+            }
+            slots_[index] = slot;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<const std::string*> lines_;  // First line seen for each id
+    std::vector<uint64_t> hashes_;           // Hash of each id's line
+};
@@ -16,4 +16,7 @@ template std::vector<MyersDiff::EditScriptItem> MyersDiff::computeEditScript<std
 
 template std::vector<MyersDiff::EditScriptItem> MyersDiff::computeEditScript<char>(
     const std::vector<char>& seq1, 
-    const std::vector<char>& seq2);
\ No newline at end of file
+    const std::vector<char>& seq2);
+template std::vector<MyersDiff::EditScriptItem> MyersDiff::computeEditScript<uint32_t>(
+    const std::vector<uint32_t>& seq1, 
+    const std::vector<uint32_t>& seq2);
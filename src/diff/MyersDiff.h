@@ -2,18 +2,43 @@
 
 #include "interfaces/IDiffEngine.hpp"
 #include "AppDebugLog.h"
+#include "LineInterner.h"
+#include "Executor.h"
+#include "UnifiedDiffBuilder.h"
 #include <string>
 #include <vector>
 #include <memory>
 #include <algorithm>
-#include <unordered_map>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MYERS_DIFF_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 /**
  * @class MyersDiff
  * @brief Implementation of the Myers diff algorithm
  * 
  * This class implements the Myers diff algorithm, which is an efficient algorithm
- * for computing the shortest edit script between two sequences.
+ * for computing the shortest edit script between two sequences. It uses the
+ * linear-space refinement: the sequences are split recursively at a middle
+ * snake, so memory stays O(N + M) however many edits there are. Lines are
+ * interned to integer ids first, so the inner loop never compares strings.
+ * 
+ * Very large inputs can optionally be split at unique lines and diffed on
+ * several threads; see setParallelExecutor(). Character-level diffs take a
+ * byte-oriented path of their own; see computeStringDiff().
  * 
  * Reference: "An O(ND) Difference Algorithm and Its Variations" by Eugene W. Myers
  */
@@ -31,6 +56,57 @@ public:
      */
     ~MyersDiff() override = default;
     
+    /**
+     * @brief Diff very large inputs on several threads
+     * 
+     * When at least minLines lines, counting both texts, remain after the
+     * common prefix and suffix are trimmed, the texts are cut at the lines
+     * that occur exactly once in each (the patience diff anchors) and the
+     * regions between the cuts are diffed concurrently on the executor's
+     * background lane, each with this engine's own line alignment. The cuts
+     * depend only on the texts, so the changes are the same for any number
+     * of threads, but like patience diff they are no longer guaranteed to be
+     * a shortest edit script. Engines diff serially until this is called.
+     * 
+     * @param executor Executor to diff regions on, or null to diff on the calling thread only
+     * @param minLines Smallest input, in lines, worth splitting
+     * @param chunkLines Fewest lines, counting both texts, grouped into one task
+     */
+    void setParallelExecutor(std::shared_ptr<Executor> executor, size_t minLines = PARALLEL_MIN_LINES,
+                             size_t chunkLines = PARALLEL_CHUNK_LINES) {
+        executor_ = std::move(executor);
+        parallelMinLines_ = minLines;
+        parallelChunkLines_ = std::max<size_t>(chunkLines, 1);
+    }
+    
+    /**
+     * @brief Get the number of tasks the last line diff was split into
+     * 
+     * Mostly useful for tests and benchmarks; 0 when the last line diff ran
+     * serially. When several threads share the engine, this is the count of
+     * whichever line diff finished last.
+     * 
+     * @return The number of concurrently diffed chunks
+     */
+    size_t getLastParallelChunkCount() const {
+        return lastParallelChunkCount_.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief Limit the work spent on a single character-level diff
+     * 
+     * Diffing two strings takes time proportional to the number of edited
+     * characters, times the length in the worst case. When more than
+     * maxEdits characters differ, the part between the common prefix and
+     * suffix is reported as one replacement instead; this keeps heavily
+     * rewritten minified lines from stalling the diff.
+     * 
+     * @param maxEdits Most inserted plus deleted characters diffed character by character
+     */
+    void setStringDiffEditLimit(size_t maxEdits) {
+        stringDiffMaxEdits_ = std::max<size_t>(maxEdits, 1);
+    }
+    
     /**
      * @brief Compute line-level differences between two texts
      * 
@@ -42,8 +118,45 @@ public:
         const std::vector<std::string>& text1,
         const std::vector<std::string>& text2) override {
         
-        // Use Myers algorithm to compute the shortest edit script
-        auto script = computeEditScript(text1, text2);
+        // Lines shared at both ends are kept without hashing them
+        size_t prefix = 0;
+        while (prefix < text1.size() && prefix < text2.size() && text1[prefix] == text2[prefix]) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while (suffix < text1.size() - prefix && suffix < text2.size() - prefix &&
+               text1[text1.size() - 1 - suffix] == text2[text2.size() - 1 - suffix]) {
+            ++suffix;
+        }
+        
+        // Compare the remaining lines by id rather than by content
+        LineInterner interner(text1.size() + text2.size() - 2 * (prefix + suffix));
+        std::vector<uint32_t> ids1;
+        std::vector<uint32_t> ids2;
+        ids1.reserve(text1.size() - prefix - suffix);
+        ids2.reserve(text2.size() - prefix - suffix);
+        for (size_t i = prefix; i < text1.size() - suffix; ++i) {
+            ids1.push_back(interner.intern(text1[i]));
+        }
+        for (size_t i = prefix; i < text2.size() - suffix; ++i) {
+            ids2.push_back(interner.intern(text2[i]));
+        }
+        
+        // Align the remaining lines
+        std::vector<EditScriptItem> script;
+        script.reserve(std::max(text1.size(), text2.size()));
+        for (size_t i = 0; i < prefix; ++i) {
+            script.push_back({EditOp::KEEP, i, i});
+        }
+        if (executor_ && ids1.size() + ids2.size() >= parallelMinLines_) {
+            appendParallelEditScript(ids1, ids2, prefix, script);
+        } else {
+            lastParallelChunkCount_.store(0, std::memory_order_relaxed);
+            appendLineEditScript(ids1, ids2, prefix, script);
+        }
+        for (size_t i = suffix; i > 0; --i) {
+            script.push_back({EditOp::KEEP, text1.size() - i, text2.size() - i});
+        }
         
         // Convert edit script to diff changes
         return convertScriptToChanges(script, text1, text2, true);
@@ -116,6 +229,12 @@ public:
     /**
      * @brief Compute differences between two strings
      * 
+     * The common prefix and suffix are trimmed with SIMD compares. The rest
+     * is diffed with a bit-parallel LCS when either side fits in a machine
+     * word, and with linear-space Myers over the raw bytes otherwise; both
+     * give a shortest edit script. Above the edit limit the rest becomes a
+     * single replacement (see setStringDiffEditLimit()).
+     * 
      * @param str1 First string
      * @param str2 Second string
      * @return Vector of character-level diff changes
@@ -124,15 +243,45 @@ public:
         const std::string& str1, 
         const std::string& str2) override {
         
-        // Convert strings to vectors of characters
-        std::vector<char> chars1(str1.begin(), str1.end());
-        std::vector<char> chars2(str2.begin(), str2.end());
+        const std::string_view seq1(str1);
+        const std::string_view seq2(str2);
+        const size_t prefix = commonPrefixLength(seq1.data(), seq2.data(), std::min(seq1.size(), seq2.size()));
+        const size_t suffix = commonSuffixLength(seq1.data() + prefix, seq1.size() - prefix,
+                                                 seq2.data() + prefix, seq2.size() - prefix);
+        const size_t hi1 = seq1.size() - suffix;
+        const size_t hi2 = seq2.size() - suffix;
         
-        // Use Myers algorithm to compute the shortest edit script
-        auto script = computeEditScript(chars1, chars2);
+        std::vector<DiffChange> changes;
+        if (prefix > 0) {
+            changes.push_back(makeCharChange(DiffChange::ChangeType::EQUAL, 0, prefix, 0, prefix));
+        }
         
-        // Convert edit script to diff changes (character level)
-        auto changes = convertScriptToChanges(script, chars1, chars2, false);
+        if (prefix < hi1 || prefix < hi2) {
+            std::vector<EditScriptItem> script;
+            bool diffed;
+            if (std::min(hi1, hi2) - prefix <= BIT_PARALLEL_MAX_LENGTH) {
+                diffed = appendBitParallelEditScript(seq1, seq2, prefix, hi1, prefix, hi2, stringDiffMaxEdits_, script);
+            } else {
+                diffed = appendLimitedEditScript(seq1, seq2, prefix, hi1, prefix, hi2, stringDiffMaxEdits_, script);
+            }
+            
+            if (diffed) {
+                groupDeletesBeforeInserts(script, 0);
+                auto middle = convertScriptToChanges(script, seq1, seq2, false);
+                changes.insert(changes.end(), middle.begin(), middle.end());
+            } else {
+                LOG_DEBUG("String diff over edit limit, replacing " + std::to_string(hi1 + hi2 - 2 * prefix) +
+                          " characters");
+                const auto type = prefix == hi1 ? DiffChange::ChangeType::INSERT
+                                : prefix == hi2 ? DiffChange::ChangeType::DELETE
+                                                : DiffChange::ChangeType::REPLACE;
+                changes.push_back(makeCharChange(type, prefix, hi1 - prefix, prefix, hi2 - prefix));
+            }
+        }
+        
+        if (suffix > 0) {
+            changes.push_back(makeCharChange(DiffChange::ChangeType::EQUAL, hi1, suffix, hi2, suffix));
+        }
         
         // Set line information for character-level changes
         for (auto& change : changes) {
@@ -149,6 +298,9 @@ public:
     /**
      * @brief Format changes as a unified diff
      * 
+     * Runs between the given changes that are not covered by an equal
+     * change are treated as equal; character-level changes are skipped.
+     * 
      * @param changes Vector of diff changes
      * @param text1 First text (lines)
      * @param text2 Second text (lines)
@@ -161,132 +313,46 @@ public:
         const std::vector<std::string>& text2,
         size_t contextLines = 3) override {
         
-        if (changes.empty()) {
-            return ""; // No changes
-        }
-        
-        std::string result;
-        
-        // Group changes that are close together
-        std::vector<std::pair<size_t, size_t>> hunks; // start, end indices in changes
-        
-        size_t startIdx = 0;
-        size_t endIdx = 0;
-        
-        for (size_t i = 1; i < changes.size(); ++i) {
-            const auto& prevChange = changes[endIdx];
-            const auto& currChange = changes[i];
-            
-            // If current change is far from previous change, start a new hunk
-            bool farApart = false;
-            
-            if (prevChange.isLineLevel && currChange.isLineLevel) {
-                size_t prevEnd1 = prevChange.startLine1 + prevChange.lineCount1;
-                size_t currStart1 = currChange.startLine1;
-                
-                farApart = (currStart1 > prevEnd1 + contextLines * 2);
+        UnifiedDiffBuilder output(contextLines);
+        size_t line1 = 0;
+        size_t line2 = 0;
+        auto addEqualUpTo = [&](size_t end1) {
+            if (end1 > line1) {
+                output.addEqual(text1.data() + line1, end1 - line1);
+                line2 += end1 - line1;
+                line1 = end1;
             }
-            
-            if (farApart) {
-                hunks.emplace_back(startIdx, endIdx);
-                startIdx = i;
-            }
-            
-            endIdx = i;
-        }
-        
-        // Add the last hunk
-        hunks.emplace_back(startIdx, endIdx);
+        };
         
-        // Format each hunk
-        for (const auto& [hunkStart, hunkEnd] : hunks) {
-            const auto& firstChange = changes[hunkStart];
-            const auto& lastChange = changes[hunkEnd];
-            
-            // Determine hunk range
-            size_t hunkStartLine1 = firstChange.startLine1;
-            size_t hunkEndLine1 = lastChange.startLine1 + lastChange.lineCount1;
-            
-            size_t hunkStartLine2 = firstChange.startLine2;
-            size_t hunkEndLine2 = lastChange.startLine2 + lastChange.lineCount2;
-            
-            // Adjust for context lines
-            hunkStartLine1 = (hunkStartLine1 >= contextLines) ? hunkStartLine1 - contextLines : 0;
-            hunkEndLine1 = std::min(hunkEndLine1 + contextLines, text1.size());
-            
-            hunkStartLine2 = (hunkStartLine2 >= contextLines) ? hunkStartLine2 - contextLines : 0;
-            hunkEndLine2 = std::min(hunkEndLine2 + contextLines, text2.size());
-            
-            // Write hunk header
-            result += "@@ -" + std::to_string(hunkStartLine1 + 1) + "," 
-                   + std::to_string(hunkEndLine1 - hunkStartLine1) + " +" 
-                   + std::to_string(hunkStartLine2 + 1) + "," 
-                   + std::to_string(hunkEndLine2 - hunkStartLine2) + " @@\n";
-            
-            // Write hunk content
-            size_t line1 = hunkStartLine1;
-            size_t line2 = hunkStartLine2;
-            
-            while (line1 < hunkEndLine1 || line2 < hunkEndLine2) {
-                // Find the change that contains this line
-                bool foundChange = false;
-                
-                for (size_t i = hunkStart; i <= hunkEnd; ++i) {
-                    const auto& change = changes[i];
-                    
-                    if (!change.isLineLevel) {
-                        continue; // Skip character-level changes
-                    }
-                    
-                    // Check if this change contains the current line
-                    if (line1 >= change.startLine1 && line1 < change.startLine1 + change.lineCount1) {
-                        foundChange = true;
-                        
-                        if (change.isEqual()) {
-                            // Equal lines
-                            result += " " + text1[line1] + "\n";
-                            ++line1;
-                            ++line2;
-                        } else if (change.isDelete()) {
-                            // Deleted lines
-                            result += "-" + text1[line1] + "\n";
-                            ++line1;
-                        } else if (change.isInsert()) {
-                            // Inserted lines
-                            result += "+" + text2[line2] + "\n";
-                            ++line2;
-                        } else if (change.isReplace()) {
-                            // Replaced lines - show as delete then insert
-                            if (line1 < change.startLine1 + change.lineCount1) {
-                                result += "-" + text1[line1] + "\n";
-                                ++line1;
-                            } else if (line2 < change.startLine2 + change.lineCount2) {
-                                result += "+" + text2[line2] + "\n";
-                                ++line2;
-                            }
-                        }
-                        
-                        break;
-                    }
-                }
-                
-                if (!foundChange) {
-                    // Context line
-                    if (line1 < text1.size() && line1 < hunkEndLine1) {
-                        result += " " + text1[line1] + "\n";
-                        ++line1;
-                        ++line2;
-                    } else {
-                        break;
-                    }
-                }
+        for (const auto& change : changes) {
+            if (!change.isLineLevel) {
+                continue; // Skip character-level changes
             }
+            addEqualUpTo(change.startLine1);
+            output.add(change, text1.data() + change.startLine1, text2.data() + change.startLine2);
+            line1 = change.startLine1 + change.lineCount1;
+            line2 = change.startLine2 + change.lineCount2;
         }
+        // Only the trailing context can make it into the output
+        addEqualUpTo(std::min(text1.size(), line1 + contextLines));
+        output.finish();
         
-        return result;
+        return output.str();
     }
     
-private:
+protected:
+    // Inputs smaller than this, in lines, are not worth splitting across threads
+    static constexpr size_t PARALLEL_MIN_LINES = 200000;
+    
+    // Regions are grouped into tasks of at least this many lines
+    static constexpr size_t PARALLEL_CHUNK_LINES = 32768;
+    
+    // Character-level diffs with more edits than this become one replacement
+    static constexpr size_t STRING_DIFF_MAX_EDITS = 4096;
+    
+    // Longest string the bit-parallel LCS keeps in one machine word
+    static constexpr size_t BIT_PARALLEL_MAX_LENGTH = 64;
+    
     /**
      * @brief EditOp enumeration for edit script operations
      */
@@ -306,13 +372,325 @@ private:
     };
     
     /**
-     * @brief Point struct for the Myers algorithm
+     * @brief Scratch space for the middle snake search, shared by all recursion levels
+     */
+    struct SnakeBuffers {
+        std::vector<ptrdiff_t> forward;   // Furthest x reached on each diagonal from the start
+        std::vector<ptrdiff_t> backward;  // Furthest x reached on each diagonal from the end
+        ptrdiff_t offset;                 // Index of diagonal 0
+    };
+    
+    /**
+     * @brief Append the edit script of two texts given as interned line ids
+     * 
+     * Engines that align lines differently override this; everything else,
+     * including the character-level diffs, is shared.
+     * 
+     * @param ids1 Line ids of the first text
+     * @param ids2 Line ids of the second text
+     * @param offset Added to the indices of the appended items
+     * @param script Script to append to
+     */
+    virtual void appendLineEditScript(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        size_t offset,
+        std::vector<EditScriptItem>& script) {
+        
+        // Use Myers algorithm to compute the shortest edit script
+        appendEditScript(ids1, ids2, offset, script);
+    }
+    
+    /**
+     * @brief Per-line-id tables for finding unique lines, left cleared between ranges
      */
-    struct Point {
-        int x;
-        int y;
+    struct AnchorScratch {
+        std::vector<uint32_t> count1;  // Occurrences of each id in the current range of ids1
+        std::vector<uint32_t> count2;  // Occurrences of each id in the current range of ids2
+        std::vector<uint32_t> head;    // Position of each id in the current range of ids1
+        
+        // Candidate anchors and their longest increasing subsequence
+        std::vector<std::pair<size_t, size_t>> candidates;
+        std::vector<size_t> tails;
+        std::vector<size_t> previous;
+        
+        AnchorScratch(const std::vector<uint32_t>& ids1, const std::vector<uint32_t>& ids2) {
+            uint32_t idCount = 0;
+            for (uint32_t id : ids1) {
+                idCount = std::max(idCount, id + 1);
+            }
+            for (uint32_t id : ids2) {
+                idCount = std::max(idCount, id + 1);
+            }
+            count1.assign(idCount, 0);
+            count2.assign(idCount, 0);
+            head.assign(idCount, UINT32_MAX);
+        }
     };
     
+    /**
+     * @brief Find the patience diff anchors of ids1[lo1, hi1) against ids2[lo2, hi2)
+     * 
+     * The anchors are the lines occurring exactly once in both ranges,
+     * restricted to the longest run whose positions increase on both sides.
+     * 
+     * @param anchors Receives the (position in ids1, position in ids2) pairs, in order
+     */
+    static void findUniqueAnchors(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        size_t lo1, size_t hi1,
+        size_t lo2, size_t hi2,
+        AnchorScratch& scratch,
+        std::vector<std::pair<size_t, size_t>>& anchors) {
+        
+        anchors.clear();
+        for (size_t i = lo1; i < hi1; ++i) {
+            ++scratch.count1[ids1[i]];
+            scratch.head[ids1[i]] = static_cast<uint32_t>(i);
+        }
+        for (size_t j = lo2; j < hi2; ++j) {
+            ++scratch.count2[ids2[j]];
+        }
+        
+        // Unique lines in the order they appear in ids2
+        auto& candidates = scratch.candidates;
+        candidates.clear();
+        for (size_t j = lo2; j < hi2; ++j) {
+            const uint32_t id = ids2[j];
+            if (scratch.count1[id] == 1 && scratch.count2[id] == 1) {
+                candidates.emplace_back(scratch.head[id], j);
+            }
+        }
+        
+        for (size_t i = lo1; i < hi1; ++i) {
+            scratch.count1[ids1[i]] = 0;
+            scratch.head[ids1[i]] = UINT32_MAX;
+        }
+        for (size_t j = lo2; j < hi2; ++j) {
+            scratch.count2[ids2[j]] = 0;
+        }
+        
+        if (candidates.empty()) {
+            return;
+        }
+        
+        // Longest subsequence of candidates whose ids1 positions increase too
+        scratch.tails.clear();
+        scratch.previous.assign(candidates.size(), SIZE_MAX);
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            auto pos = std::lower_bound(scratch.tails.begin(), scratch.tails.end(), candidates[c].first,
+                [&](size_t tail, size_t position) { return candidates[tail].first < position; });
+            if (pos != scratch.tails.begin()) {
+                scratch.previous[c] = *(pos - 1);
+            }
+            if (pos == scratch.tails.end()) {
+                scratch.tails.push_back(c);
+            } else {
+                *pos = c;
+            }
+        }
+        
+        anchors.resize(scratch.tails.size());
+        size_t c = scratch.tails.back();
+        for (size_t k = anchors.size(); k-- > 0; c = scratch.previous[c]) {
+            anchors[k] = candidates[c];
+        }
+    }
+    
+    /**
+     * @brief Append the edit script of two large id sequences, diffing regions concurrently
+     * 
+     * The regions between unique-line anchors are grouped into chunks of at
+     * least parallelChunkLines_ lines, each diffed into its own script. Every
+     * region goes through appendLineEditScript, so engines that override it
+     * keep their alignment. The grouping does not depend on the thread count
+     * and every region is diffed on its own, so neither changes the result.
+     */
+    void appendParallelEditScript(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        size_t offset,
+        std::vector<EditScriptItem>& script) {
+        
+        const size_t first = script.size();
+        std::vector<std::pair<size_t, size_t>> anchors;
+        {
+            AnchorScratch scratch(ids1, ids2);
+            findUniqueAnchors(ids1, ids2, 0, ids1.size(), 0, ids2.size(), scratch, anchors);
+        }
+        
+        // Region r lies between anchors r - 1 and r
+        const size_t regionCount = anchors.size() + 1;
+        auto regionStart = [&](size_t r) -> std::pair<size_t, size_t> {
+            if (r == 0) {
+                return {0, 0};
+            }
+            return {anchors[r - 1].first + 1, anchors[r - 1].second + 1};
+        };
+        auto regionEnd = [&](size_t r) -> std::pair<size_t, size_t> {
+            if (r == anchors.size()) {
+                return {ids1.size(), ids2.size()};
+            }
+            return anchors[r];
+        };
+        
+        std::vector<size_t> chunkStarts{0};
+        size_t pending = 0;
+        for (size_t r = 0; r + 1 < regionCount; ++r) {
+            pending += regionEnd(r).first - regionStart(r).first + regionEnd(r).second - regionStart(r).second + 1;
+            if (pending >= parallelChunkLines_) {
+                chunkStarts.push_back(r + 1);
+                pending = 0;
+            }
+        }
+        
+        uint32_t idCount = 0;
+        for (uint32_t id : ids1) {
+            idCount = std::max(idCount, id + 1);
+        }
+        for (uint32_t id : ids2) {
+            idCount = std::max(idCount, id + 1);
+        }
+        
+        // Each chunk ends with the anchor after its last region, if any
+        std::vector<std::vector<EditScriptItem>> chunkScripts(chunkStarts.size());
+        auto diffChunk = [&](size_t chunk) {
+            const size_t end = chunk + 1 < chunkStarts.size() ? chunkStarts[chunk + 1] : regionCount;
+            std::vector<uint32_t> renumbered(idCount, UINT32_MAX);
+            for (size_t r = chunkStarts[chunk]; r < end; ++r) {
+                const auto start = regionStart(r);
+                const auto stop = regionEnd(r);
+                if (start.first < stop.first || start.second < stop.second) {
+                    appendRegionEditScript(ids1, ids2, start.first, stop.first, start.second, stop.second,
+                                           renumbered, chunkScripts[chunk]);
+                }
+                if (r < anchors.size()) {
+                    chunkScripts[chunk].push_back({EditOp::KEEP, anchors[r].first, anchors[r].second});
+                }
+            }
+        };
+        runConcurrently(chunkStarts.size(), diffChunk);
+        lastParallelChunkCount_.store(chunkStarts.size(), std::memory_order_relaxed);
+        
+        LOG_DEBUG("Parallel diff split " + std::to_string(ids1.size() + ids2.size()) + " lines at " +
+                  std::to_string(anchors.size()) + " anchors into " + std::to_string(chunkStarts.size()) + " chunks");
+        
+        for (auto& chunkScript : chunkScripts) {
+            for (EditScriptItem item : chunkScript) {
+                item.idx1 += offset;
+                item.idx2 += offset;
+                script.push_back(item);
+            }
+            std::vector<EditScriptItem>().swap(chunkScript);
+        }
+        groupDeletesBeforeInserts(script, first);
+    }
+    
+    /**
+     * @brief Append the line edit script of ids1[lo1, hi1) against ids2[lo2, hi2)
+     * 
+     * The region is copied with its ids renumbered from 0, so that the
+     * per-id tables of appendLineEditScript overrides are sized by the
+     * region rather than by the whole input. Items keep the sequences' own
+     * indices.
+     * 
+     * @param renumbered One UINT32_MAX entry per line id; left that way on return
+     */
+    void appendRegionEditScript(
+        const std::vector<uint32_t>& ids1,
+        const std::vector<uint32_t>& ids2,
+        size_t lo1, size_t hi1,
+        size_t lo2, size_t hi2,
+        std::vector<uint32_t>& renumbered,
+        std::vector<EditScriptItem>& script) {
+        
+        uint32_t nextId = 0;
+        auto renumber = [&](uint32_t id) {
+            if (renumbered[id] == UINT32_MAX) {
+                renumbered[id] = nextId++;
+            }
+            return renumbered[id];
+        };
+        std::vector<uint32_t> region1;
+        std::vector<uint32_t> region2;
+        region1.reserve(hi1 - lo1);
+        region2.reserve(hi2 - lo2);
+        for (size_t i = lo1; i < hi1; ++i) {
+            region1.push_back(renumber(ids1[i]));
+        }
+        for (size_t j = lo2; j < hi2; ++j) {
+            region2.push_back(renumber(ids2[j]));
+        }
+        for (size_t i = lo1; i < hi1; ++i) {
+            renumbered[ids1[i]] = UINT32_MAX;
+        }
+        for (size_t j = lo2; j < hi2; ++j) {
+            renumbered[ids2[j]] = UINT32_MAX;
+        }
+        
+        const size_t first = script.size();
+        appendLineEditScript(region1, region2, 0, script);
+        for (size_t i = first; i < script.size(); ++i) {
+            script[i].idx1 += lo1;
+            script[i].idx2 += lo2;
+        }
+    }
+    
+    /**
+     * @brief Run task(index) for every index in [0, count) on the executor's background lane
+     * 
+     * The calling thread claims indices too, so the work completes even when
+     * every executor thread is busy. Helpers that start after all indices are
+     * claimed return without touching the task. The first exception thrown
+     * by the task is rethrown once every claimed index has finished.
+     */
+    template<typename Task>
+    void runConcurrently(size_t count, Task& task) {
+        struct Progress {
+            std::atomic<size_t> next{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t done = 0;
+            std::exception_ptr failure;
+        };
+        auto progress = std::make_shared<Progress>();
+        
+        auto work = [progress, &task, count]() {
+            for (size_t index = progress->next++; index < count; index = progress->next++) {
+                std::exception_ptr failure;
+                try {
+                    task(index);
+                } catch (...) {
+                    failure = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(progress->mutex);
+                if (failure && !progress->failure) {
+                    progress->failure = failure;
+                }
+                if (++progress->done == count) {
+                    progress->finished.notify_all();
+                }
+            }
+        };
+        
+        const size_t threads = std::min(count, executor_->threadCount(Executor::Lane::Background) + 1);
+        try {
+            for (size_t i = 1; i < threads; ++i) {
+                executor_->submit(Executor::Lane::Background, work);
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("Diffing on the calling thread only: " + std::string(e.what()));
+        }
+        work();
+        
+        std::unique_lock<std::mutex> lock(progress->mutex);
+        progress->finished.wait(lock, [&] { return progress->done == count; });
+        if (progress->failure) {
+            std::rethrow_exception(progress->failure);
+        }
+    }
+    
     /**
      * @brief Compute the shortest edit script between two sequences using Myers algorithm
      * 
@@ -326,145 +704,494 @@ private:
         const std::vector<T>& seq1,
         const std::vector<T>& seq2) {
         
-        int n = static_cast<int>(seq1.size());
-        int m = static_cast<int>(seq2.size());
-        
         std::vector<EditScriptItem> script;
+        script.reserve(std::max(seq1.size(), seq2.size()));
+        appendEditScript(seq1, seq2, 0, script);
+        return script;
+    }
+    
+    /**
+     * @brief Append the shortest edit script between two sequences to a script
+     * 
+     * @param offset Added to the indices of the appended items, for sequences
+     *               that start after an already scripted common prefix
+     */
+    template<typename T>
+    void appendEditScript(
+        const std::vector<T>& seq1,
+        const std::vector<T>& seq2,
+        size_t offset,
+        std::vector<EditScriptItem>& script) {
+        
+        const size_t first = script.size();
+        appendRangeEditScript(seq1, seq2, 0, seq1.size(), 0, seq2.size(), script);
         
-        // Handle special cases
-        if (n == 0 && m == 0) {
-            return script;
+        for (size_t i = first; i < script.size(); ++i) {
+            script[i].idx1 += offset;
+            script[i].idx2 += offset;
         }
+        groupDeletesBeforeInserts(script, first);
+    }
+    
+    /**
+     * @brief Append the shortest edit script of seq1[lo1, hi1) against seq2[lo2, hi2)
+     * 
+     * Items keep the sequences' own indices. Deletes and inserts are not
+     * grouped; callers finish with groupDeletesBeforeInserts.
+     */
+    template<typename Seq>
+    void appendRangeEditScript(
+        const Seq& seq1,
+        const Seq& seq2,
+        size_t lo1, size_t hi1,
+        size_t lo2, size_t hi2,
+        std::vector<EditScriptItem>& script) {
         
-        if (n == 0) {
-            // First sequence is empty, insert all elements from second sequence
-            for (int j = 0; j < m; ++j) {
-                script.push_back({EditOp::INSERT, 0, static_cast<size_t>(j)});
-            }
-            return script;
+        // A sub-problem of size N + M never needs more than (N + M + 1) / 2
+        // diagonals on either side of diagonal 0, plus one for the k +/- 1 reads
+        SnakeBuffers buffers;
+        buffers.offset = static_cast<ptrdiff_t>((hi1 - lo1 + hi2 - lo2 + 1) / 2 + 1);
+        buffers.forward.resize(2 * buffers.offset + 1);
+        buffers.backward.resize(2 * buffers.offset + 1);
+        
+        diffRange(seq1, seq2, static_cast<ptrdiff_t>(lo1), static_cast<ptrdiff_t>(hi1),
+                  static_cast<ptrdiff_t>(lo2), static_cast<ptrdiff_t>(hi2), buffers, script);
+    }
+    
+    /**
+     * @brief Append the edit script of seq1[lo1, hi1) against seq2[lo2, hi2)
+     */
+    template<typename Seq>
+    void diffRange(
+        const Seq& seq1,
+        const Seq& seq2,
+        ptrdiff_t lo1, ptrdiff_t hi1,
+        ptrdiff_t lo2, ptrdiff_t hi2,
+        SnakeBuffers& buffers,
+        std::vector<EditScriptItem>& script) {
+        
+        // Trim the common prefix and suffix; edits usually touch a small part
+        const ptrdiff_t prefix = matchForward(seq1, lo1, seq2, lo2, std::min(hi1 - lo1, hi2 - lo2));
+        for (ptrdiff_t i = 0; i < prefix; ++i) {
+            script.push_back({EditOp::KEEP, static_cast<size_t>(lo1 + i), static_cast<size_t>(lo2 + i)});
         }
+        lo1 += prefix;
+        lo2 += prefix;
+        const ptrdiff_t suffix = matchBackward(seq1, hi1, seq2, hi2, std::min(hi1 - lo1, hi2 - lo2));
+        hi1 -= suffix;
+        hi2 -= suffix;
         
-        if (m == 0) {
-            // Second sequence is empty, delete all elements from first sequence
-            for (int i = 0; i < n; ++i) {
-                script.push_back({EditOp::DELETE, static_cast<size_t>(i), 0});
+        if (lo1 == hi1) {
+            for (ptrdiff_t j = lo2; j < hi2; ++j) {
+                script.push_back({EditOp::INSERT, static_cast<size_t>(lo1), static_cast<size_t>(j)});
+            }
+        } else if (lo2 == hi2) {
+            for (ptrdiff_t i = lo1; i < hi1; ++i) {
+                script.push_back({EditOp::DELETE, static_cast<size_t>(i), static_cast<size_t>(lo2)});
             }
-            return script;
+        } else {
+            // After trimming at least two edits remain, so both halves are
+            // strictly smaller than this range
+            ptrdiff_t splitX = 0;
+            ptrdiff_t splitY = 0;
+            findMiddleSnake(seq1, seq2, lo1, hi1, lo2, hi2, buffers, splitX, splitY);
+            diffRange(seq1, seq2, lo1, splitX, lo2, splitY, buffers, script);
+            diffRange(seq1, seq2, splitX, hi1, splitY, hi2, buffers, script);
         }
         
-        // Myers algorithm
-        int max = n + m;
-        std::vector<int> v(2 * max + 1, 0);
-        std::vector<std::unordered_map<int, Point>> trace;
+        for (ptrdiff_t i = 0; i < suffix; ++i) {
+            script.push_back({EditOp::KEEP, static_cast<size_t>(hi1 + i), static_cast<size_t>(hi2 + i)});
+        }
+    }
+    
+    /**
+     * @brief Find a point on an optimal path through seq1[lo1, hi1) and seq2[lo2, hi2)
+     * 
+     * Runs the greedy search from both corners at once until the two
+     * frontiers overlap, which happens after about half the edits. The end
+     * of the overlapping snake splits the range into two halves that each
+     * need roughly half the edits.
+     * 
+     * @param maxEdits Give up once the shortest path is known to need more edits than this
+     * @return false if the search gave up
+     */
+    template<typename Seq>
+    bool findMiddleSnake(
+        const Seq& seq1,
+        const Seq& seq2,
+        ptrdiff_t lo1, ptrdiff_t hi1,
+        ptrdiff_t lo2, ptrdiff_t hi2,
+        SnakeBuffers& buffers,
+        ptrdiff_t& splitX,
+        ptrdiff_t& splitY,
+        ptrdiff_t maxEdits = PTRDIFF_MAX) {
         
-        int x, y;
+        // Coordinates are relative to (lo1, lo2); diagonal k holds the points with x - y == k
+        const ptrdiff_t n = hi1 - lo1;
+        const ptrdiff_t m = hi2 - lo2;
+        const ptrdiff_t delta = n - m;
+        const bool odd = (delta & 1) != 0;
+        const bool limited = maxEdits / 2 + maxEdits % 2 < (n + m + 1) / 2;
+        const ptrdiff_t maxD = limited ? maxEdits / 2 + maxEdits % 2 : (n + m + 1) / 2;
+        ptrdiff_t* forward = buffers.forward.data() + buffers.offset;
+        ptrdiff_t* backward = buffers.backward.data() + buffers.offset - delta;
         
-        for (int d = 0; d <= max; ++d) {
-            trace.push_back({});
-            
-            for (int k = -d; k <= d; k += 2) {
-                if (k == -d || (k != d && v[k - 1 + max] < v[k + 1 + max])) {
-                    x = v[k + 1 + max];
-                } else {
-                    x = v[k - 1 + max] + 1;
-                }
-                
-                y = x - k;
+        forward[1] = 0;
+        backward[delta - 1] = n;
+        
+        for (ptrdiff_t d = 0; d <= maxD; ++d) {
+            for (ptrdiff_t k = -d; k <= d; k += 2) {
+                ptrdiff_t x = (k == -d || (k != d && forward[k - 1] < forward[k + 1]))
+                    ? forward[k + 1] : forward[k - 1] + 1;
+                ptrdiff_t y = x - k;
+                const ptrdiff_t snake = matchForward(seq1, lo1 + x, seq2, lo2 + y, std::min(n - x, m - y));
+                x += snake;
+                y += snake;
+                forward[k] = x;
                 
-                // Save the point we came from
-                if (k == -d || (k != d && v[k - 1 + max] < v[k + 1 + max])) {
-                    trace[d][k] = {x, y - 1}; // Came from below (insertion)
-                } else {
-                    trace[d][k] = {x - 1, y}; // Came from left (deletion)
+                if (odd && k >= delta - (d - 1) && k <= delta + (d - 1) && x >= backward[k]) {
+                    splitX = lo1 + x;
+                    splitY = lo2 + y;
+                    return true;
                 }
+            }
+            
+            for (ptrdiff_t k = delta - d; k <= delta + d; k += 2) {
+                ptrdiff_t x = (k == delta + d || (k != delta - d && backward[k - 1] < backward[k + 1]))
+                    ? backward[k - 1] : backward[k + 1] - 1;
+                ptrdiff_t y = x - k;
+                const ptrdiff_t snake = matchBackward(seq1, lo1 + x, seq2, lo2 + y, std::min(x, y));
+                x -= snake;
+                y -= snake;
+                backward[k] = x;
                 
-                // Follow diagonal as far as possible
-                while (x < n && y < m && seq1[x] == seq2[y]) {
-                    ++x;
-                    ++y;
-                }
-                
-                v[k + max] = x;
-                
-                if (x >= n && y >= m) {
-                    // Found the end
-                    
-                    // Backtrack to construct the edit script
-                    std::vector<EditScriptItem> backScript;
-                    
-                    int curX = n;
-                    int curY = m;
-                    
-                    for (int i = d; i > 0; --i) {
-                        int curK = curX - curY;
-                        Point prev = trace[i][curK];
-                        
-                        if (prev.x < curX && prev.y < curY) {
-                            // Diagonal move (keep)
-                            while (curX > prev.x && curY > prev.y) {
-                                --curX;
-                                --curY;
-                                backScript.push_back({EditOp::KEEP, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                            }
-                        } else if (prev.x < curX) {
-                            // Horizontal move (delete)
-                            --curX;
-                            backScript.push_back({EditOp::DELETE, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                        } else {
-                            // Vertical move (insert)
-                            --curY;
-                            backScript.push_back({EditOp::INSERT, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                        }
-                        
-                        curX = prev.x;
-                        curY = prev.y;
-                    }
-                    
-                    // Include any initial diagonal
-                    while (curX > 0 && curY > 0) {
-                        --curX;
-                        --curY;
-                        backScript.push_back({EditOp::KEEP, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                    }
-                    
-                    while (curX > 0) {
-                        --curX;
-                        backScript.push_back({EditOp::DELETE, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                    }
-                    
-                    while (curY > 0) {
-                        --curY;
-                        backScript.push_back({EditOp::INSERT, static_cast<size_t>(curX), static_cast<size_t>(curY)});
-                    }
-                    
-                    // Reverse the script to get the correct order
-                    std::reverse(backScript.begin(), backScript.end());
-                    
-                    return backScript;
+                if (!odd && k >= -d && k <= d && x <= forward[k]) {
+                    splitX = lo1 + x;
+                    splitY = lo2 + y;
+                    return true;
                 }
             }
         }
         
-        // Should not reach here
-        LOG_ERROR("Myers diff algorithm failed to find a solution");
-        return script;
+        // Without a limit the frontiers always meet by maxD
+        if (!limited) {
+            LOG_ERROR("Myers diff algorithm failed to find a middle snake");
+        }
+        splitX = lo1 + n / 2;
+        splitY = lo2 + m / 2;
+        return false;
+    }
+    
+    /**
+     * @brief Length of the run of equal elements starting at seq1[pos1] and seq2[pos2]
+     */
+    template<typename Seq>
+    static ptrdiff_t matchForward(const Seq& seq1, ptrdiff_t pos1, const Seq& seq2, ptrdiff_t pos2, ptrdiff_t limit) {
+        ptrdiff_t length = 0;
+        while (length < limit && seq1[pos1 + length] == seq2[pos2 + length]) {
+            ++length;
+        }
+        return length;
+    }
+    
+    static ptrdiff_t matchForward(std::string_view seq1, ptrdiff_t pos1, std::string_view seq2, ptrdiff_t pos2,
+                                  ptrdiff_t limit) {
+        // Diagonals beyond the edit graph give a negative limit, which the
+        // generic loop above treats as no match
+        if (limit <= 0) {
+            return 0;
+        }
+        return static_cast<ptrdiff_t>(commonPrefixLength(seq1.data() + pos1, seq2.data() + pos2,
+                                                         static_cast<size_t>(limit)));
+    }
+    
+    /**
+     * @brief Length of the run of equal elements ending just before seq1[end1] and seq2[end2]
+     */
+    template<typename Seq>
+    static ptrdiff_t matchBackward(const Seq& seq1, ptrdiff_t end1, const Seq& seq2, ptrdiff_t end2, ptrdiff_t limit) {
+        ptrdiff_t length = 0;
+        while (length < limit && seq1[end1 - 1 - length] == seq2[end2 - 1 - length]) {
+            ++length;
+        }
+        return length;
+    }
+    
+    static ptrdiff_t matchBackward(std::string_view seq1, ptrdiff_t end1, std::string_view seq2, ptrdiff_t end2,
+                                   ptrdiff_t limit) {
+        if (limit <= 0) {
+            return 0;
+        }
+        return static_cast<ptrdiff_t>(commonSuffixLength(seq1.data() + end1 - limit, static_cast<size_t>(limit),
+                                                         seq2.data() + end2 - limit, static_cast<size_t>(limit)));
+    }
+    
+    /**
+     * @brief Number of equal leading bytes of a[0, length) and b[0, length), 16 at a time where SSE2 is available
+     */
+    static size_t commonPrefixLength(const char* a, const char* b, size_t length) {
+        size_t i = 0;
+#ifdef MYERS_DIFF_SSE2
+        for (; i + 16 <= length; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const unsigned differ = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+            if (differ != 0) {
+                return i + countTrailingZeros(differ);
+            }
+        }
+#endif
+        while (i < length && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+    
+    /**
+     * @brief Number of equal trailing bytes of a[0, length1) and b[0, length2)
+     */
+    static size_t commonSuffixLength(const char* a, size_t length1, const char* b, size_t length2) {
+        const size_t length = std::min(length1, length2);
+        const char* endA = a + length1;
+        const char* endB = b + length2;
+        size_t i = 0;
+#ifdef MYERS_DIFF_SSE2
+        for (; i + 16 <= length; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(endA - i - 16));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(endB - i - 16));
+            const unsigned differ = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+            if (differ != 0) {
+                // Bit 15 is the byte nearest the end
+                return i + 15 - highestBit(differ);
+            }
+        }
+#endif
+        while (i < length && endA[-1 - static_cast<ptrdiff_t>(i)] == endB[-1 - static_cast<ptrdiff_t>(i)]) {
+            ++i;
+        }
+        return i;
+    }
+    
+    static unsigned countTrailingZeros(unsigned value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctz(value));
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        unsigned index = 0;
+        while (!(value & 1u)) {
+            value >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+    
+    static unsigned highestBit(unsigned value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 31u - static_cast<unsigned>(__builtin_clz(value));
+#elif defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        unsigned index = 0;
+        while (value >>= 1) {
+            ++index;
+        }
+        return index;
+#endif
+    }
+    
+    /**
+     * @brief Append the shortest edit script of seq1[lo1, hi1) against seq2[lo2, hi2) unless it is too long
+     * 
+     * The first middle snake search stops after about maxEdits edits; once it
+     * succeeds, the halves cannot need more.
+     * 
+     * @return false, with nothing appended, if the script would exceed maxEdits
+     */
+    bool appendLimitedEditScript(
+        std::string_view seq1,
+        std::string_view seq2,
+        size_t lo1, size_t hi1,
+        size_t lo2, size_t hi2,
+        size_t maxEdits,
+        std::vector<EditScriptItem>& script) {
+        
+        // The searches never pass diagonal +/-(maxD + 1) of their own range
+        const size_t length = hi1 - lo1 + hi2 - lo2;
+        const size_t maxD = std::min((length + 1) / 2, maxEdits / 2 + maxEdits % 2);
+        SnakeBuffers buffers;
+        buffers.offset = static_cast<ptrdiff_t>(maxD + 2);
+        buffers.forward.resize(2 * buffers.offset + 1);
+        buffers.backward.resize(2 * buffers.offset + 1);
+        
+        ptrdiff_t splitX = 0;
+        ptrdiff_t splitY = 0;
+        if (!findMiddleSnake(seq1, seq2, static_cast<ptrdiff_t>(lo1), static_cast<ptrdiff_t>(hi1),
+                             static_cast<ptrdiff_t>(lo2), static_cast<ptrdiff_t>(hi2), buffers, splitX, splitY,
+                             static_cast<ptrdiff_t>(std::min<size_t>(maxEdits, PTRDIFF_MAX)))) {
+            return false;
+        }
+        diffRange(seq1, seq2, static_cast<ptrdiff_t>(lo1), splitX, static_cast<ptrdiff_t>(lo2), splitY, buffers, script);
+        diffRange(seq1, seq2, splitX, static_cast<ptrdiff_t>(hi1), splitY, static_cast<ptrdiff_t>(hi2), buffers, script);
+        return true;
+    }
+    
+    /**
+     * @brief Append the shortest edit script of two byte ranges, one at most BIT_PARALLEL_MAX_LENGTH long
+     * 
+     * Computes the LCS table one column per byte of the longer range, each
+     * column packed into a word with a bit per byte of the shorter range
+     * (Hyyro's bit-vector LCS), then walks it back from the end.
+     * 
+     * @return false, with nothing appended, if the script would exceed maxEdits
+     */
+    static bool appendBitParallelEditScript(
+        std::string_view seq1,
+        std::string_view seq2,
+        size_t lo1, size_t hi1,
+        size_t lo2, size_t hi2,
+        size_t maxEdits,
+        std::vector<EditScriptItem>& script) {
+        
+        // Bits follow the short range, columns the long one
+        const bool shortIsFirst = hi1 - lo1 <= hi2 - lo2;
+        const std::string_view shortSeq = shortIsFirst ? seq1.substr(lo1, hi1 - lo1) : seq2.substr(lo2, hi2 - lo2);
+        const std::string_view longSeq = shortIsFirst ? seq2.substr(lo2, hi2 - lo2) : seq1.substr(lo1, hi1 - lo1);
+        const size_t m = shortSeq.size();
+        const size_t n = longSeq.size();
+        
+        uint64_t matches[256] = {};
+        for (size_t i = 0; i < m; ++i) {
+            matches[static_cast<unsigned char>(shortSeq[i])] |= uint64_t{1} << i;
+        }
+        
+        // A zero bit i in column j means LCS(short[0, i + 1), long[0, j)) exceeds LCS(short[0, i), long[0, j))
+        std::vector<uint64_t> columns(n + 1);
+        uint64_t column = ~uint64_t{0};
+        columns[0] = column;
+        for (size_t j = 0; j < n; ++j) {
+            const uint64_t u = column & matches[static_cast<unsigned char>(longSeq[j])];
+            column = (column + u) | (column - u);
+            columns[j + 1] = column;
+        }
+        
+        auto lcs = [&](size_t i, size_t j) {
+            const uint64_t below = i == 64 ? ~uint64_t{0} : (uint64_t{1} << i) - 1;
+            return popcount64(~columns[j] & below);
+        };
+        if (m + n - 2 * lcs(m, n) > maxEdits) {
+            return false;
+        }
+        
+        const size_t first = script.size();
+        size_t i = m;
+        size_t j = n;
+        while (i > 0 || j > 0) {
+            if (i > 0 && j > 0 && shortSeq[i - 1] == longSeq[j - 1]) {
+                --i;
+                --j;
+                script.push_back(shortIsFirst ? EditScriptItem{EditOp::KEEP, lo1 + i, lo2 + j}
+                                              : EditScriptItem{EditOp::KEEP, lo1 + j, lo2 + i});
+            } else if (i > 0 && (j == 0 || lcs(i - 1, j) == lcs(i, j))) {
+                --i;
+                script.push_back(shortIsFirst ? EditScriptItem{EditOp::DELETE, lo1 + i, lo2 + j}
+                                              : EditScriptItem{EditOp::INSERT, lo1 + j, lo2 + i});
+            } else {
+                --j;
+                script.push_back(shortIsFirst ? EditScriptItem{EditOp::INSERT, lo1 + i, lo2 + j}
+                                              : EditScriptItem{EditOp::DELETE, lo1 + j, lo2 + i});
+            }
+        }
+        std::reverse(script.begin() + first, script.end());
+        return true;
+    }
+    
+    static size_t popcount64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_popcountll(value));
+#else
+        size_t count = 0;
+        for (; value; value &= value - 1) {
+            ++count;
+        }
+        return count;
+#endif
+    }
+    
+    /**
+     * @brief Build a character-level change
+     */
+    static DiffChange makeCharChange(DiffChange::ChangeType type, size_t start1, size_t count1,
+                                     size_t start2, size_t count2) {
+        DiffChange change;
+        change.type = type;
+        change.startLine1 = 0;
+        change.lineCount1 = 1;
+        change.startLine2 = 0;
+        change.lineCount2 = 1;
+        change.startChar1 = start1;
+        change.charCount1 = count1;
+        change.startChar2 = start2;
+        change.charCount2 = count2;
+        change.isLineLevel = false;
+        return change;
+    }
+    
+    /**
+     * @brief Order every run of edits between two kept elements as deletes then inserts
+     * 
+     * Splitting at middle snakes can interleave the deletes and inserts of
+     * one hunk; grouping them makes each hunk a single replace.
+     */
+    static void groupDeletesBeforeInserts(std::vector<EditScriptItem>& script, size_t first) {
+        size_t runStart = first;
+        while (runStart < script.size()) {
+            if (script[runStart].op == EditOp::KEEP) {
+                ++runStart;
+                continue;
+            }
+            size_t runEnd = runStart;
+            while (runEnd < script.size() && script[runEnd].op != EditOp::KEEP) {
+                ++runEnd;
+            }
+            
+            const size_t start1 = script[runStart].idx1;
+            const size_t start2 = script[runStart].idx2;
+            auto inserts = std::stable_partition(script.begin() + runStart, script.begin() + runEnd,
+                [](const EditScriptItem& item) { return item.op == EditOp::DELETE; });
+            const size_t deletes = static_cast<size_t>(inserts - (script.begin() + runStart));
+            
+            for (size_t i = runStart; i < runEnd; ++i) {
+                if (script[i].op == EditOp::DELETE) {
+                    script[i].idx2 = start2;
+                } else {
+                    script[i].idx1 = start1 + deletes;
+                }
+            }
+            runStart = runEnd;
+        }
     }
     
     /**
      * @brief Convert an edit script to diff changes
      * 
-     * @tparam T Type of sequence elements
+     * @tparam Seq Sequence type
      * @param script Edit script
      * @param seq1 First sequence
      * @param seq2 Second sequence
      * @param isLineLevel Whether this is a line-level diff
      * @return Vector of diff changes
      */
-    template<typename T>
+    template<typename Seq>
     std::vector<DiffChange> convertScriptToChanges(
         const std::vector<EditScriptItem>& script,
-        const std::vector<T>& seq1,
-        const std::vector<T>& seq2,
+        const Seq& seq1,
+        const Seq& seq2,
         bool isLineLevel) {
         
         std::vector<DiffChange> changes;
@@ -697,4 +1424,11 @@ private:
         
         return processedChanges;
     }
+    
+private:
+    std::shared_ptr<Executor> executor_;  // Runs regions of large diffs; null to diff serially
+    size_t parallelMinLines_ = PARALLEL_MIN_LINES;
+    size_t parallelChunkLines_ = PARALLEL_CHUNK_LINES;
+    std::atomic<size_t> lastParallelChunkCount_{0};  // Chunks of the last line diff; 0 if it ran serially
+    size_t stringDiffMaxEdits_ = STRING_DIFF_MAX_EDITS;
 }; 
\ No newline at end of file
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "interfaces/IDiffEngine.hpp"
+#include "interfaces/ITextBuffer.hpp"
+#include "MappedFile.h"
+#include "MyersDiff.h"
+#include "UnifiedDiffBuilder.h"
+#include "AppDebugLog.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @class LineSource
+ * @brief Sequential reader of the lines StreamingDiff compares
+ */
+class LineSource {
+public:
+    virtual ~LineSource() = default;
+
+    /**
+     * @brief Read the next line
+     *
+     * @param line Receives the line, without its line break
+     * @return false once every line has been read
+     */
+    virtual bool nextLine(std::string& line) = 0;
+};
+
+/**
+ * @class MappedFileLineSource
+ * @brief Lines of a MappedFile, split at '\n' the way std::getline splits them
+ *
+ * Mapped files are scanned in place; otherwise the file is read a block at
+ * a time, so only one block is ever held in memory.
+ */
+class MappedFileLineSource : public LineSource {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param file An open file; it must outlive the source
+     * @param blockSize Bytes read at a time when the file is not mapped
+     */
+    explicit MappedFileLineSource(const MappedFile& file, size_t blockSize = 1 << 20)
+        : file_(file), blockSize_(std::max<size_t>(blockSize, 1)) {
+    }
+
+    bool nextLine(std::string& line) override {
+        line.clear();
+        bool found = false;
+        while (true) {
+            if (cursor_ == end_ && !loadBlock()) {
+                return found;
+            }
+            found = true;
+            const char* newline = static_cast<const char*>(std::memchr(cursor_, '\n', end_ - cursor_));
+            if (newline) {
+                line.append(cursor_, newline);
+                cursor_ = newline + 1;
+                return true;
+            }
+            line.append(cursor_, end_);
+            cursor_ = end_;
+        }
+    }
+
+private:
+    bool loadBlock() {
+        if (offset_ >= file_.size()) {
+            return false;
+        }
+        if (file_.isMapped()) {
+            cursor_ = file_.data() + offset_;
+            end_ = file_.data() + file_.size();
+            offset_ = file_.size();
+            return true;
+        }
+
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(blockSize_, file_.size() - offset_));
+        block_.resize(length);
+        if (!file_.read(offset_, length, block_.data())) {
+            throw std::runtime_error("Short read while diffing at offset " + std::to_string(offset_));
+        }
+        cursor_ = block_.data();
+        end_ = block_.data() + length;
+        offset_ += length;
+        return true;
+    }
+
+    const MappedFile& file_;
+    size_t blockSize_;
+    uint64_t offset_ = 0;      // File offset of the next block
+    std::vector<char> block_;  // Current block when the file is not mapped
+    const char* cursor_ = nullptr;
+    const char* end_ = nullptr;
+};
+
+/**
+ * @class TextBufferLineSource
+ * @brief Lines of a text buffer, copied out a batch at a time
+ *
+ * Works with any ITextBuffer; a VirtualizedTextBuffer only pages in the
+ * lines of the current batch.
+ */
+class TextBufferLineSource : public LineSource {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param buffer The buffer to read; it must outlive the source and not change while it is read
+     * @param batchLines Lines copied out of the buffer per call to forEachLine
+     */
+    explicit TextBufferLineSource(const ITextBuffer& buffer, size_t batchLines = 4096)
+        : buffer_(buffer), batchLines_(std::max<size_t>(batchLines, 1)) {
+    }
+
+    bool nextLine(std::string& line) override {
+        if (batchPos_ == batch_.size()) {
+            batch_.clear();
+            batchPos_ = 0;
+            const size_t end = std::min(nextIndex_ + batchLines_, buffer_.lineCount());
+            buffer_.forEachLine(nextIndex_, end, [this](size_t, std::string_view text) {
+                batch_.emplace_back(text);
+                return true;
+            });
+            nextIndex_ = end;
+            if (batch_.empty()) {
+                return false;
+            }
+        }
+        line = std::move(batch_[batchPos_++]);
+        return true;
+    }
+
+private:
+    const ITextBuffer& buffer_;
+    size_t batchLines_;
+    size_t nextIndex_ = 0;  // Buffer index of the next batch
+    std::vector<std::string> batch_;
+    size_t batchPos_ = 0;
+};
+
+/**
+ * @class StreamingDiff
+ * @brief Line diff of two line sources that never holds either one whole
+ *
+ * Up to windowLines lines of each source are held at a time. Each round
+ * diffs the two windows with the diff engine and reports the changes up to
+ * and including the last run of equal lines; the lines after it stay in
+ * the windows, which are then refilled for the next round. Memory therefore
+ * depends on the window size, not on the length of the sources.
+ *
+ * When a round finds too little in common to move forward, which happens
+ * inside a change longer than a window, the rest of one window is reported
+ * as inserted (or deleted) on its own. The side alternates with a doubling
+ * budget, so the windows line up again after a long insertion or deletion
+ * at the cost of a bounded multiple of its length in spurious edits.
+ *
+ * The result is a valid diff but, unlike diffing the whole texts, not
+ * necessarily a shortest one. A run of equal lines, or a change longer than
+ * a window, may be reported in several consecutive pieces.
+ */
+class StreamingDiff {
+public:
+    static constexpr size_t DEFAULT_WINDOW_LINES = 32768;
+
+    /**
+     * @brief The lines a reported change covers, valid only during the callback
+     */
+    struct ChangeText {
+        const std::string* lines1;    ///< change.lineCount1 lines of the first source
+        const std::string* lines2;    ///< change.lineCount2 lines of the second source
+    };
+
+    /**
+     * @brief Receives each change in order; return false to stop the diff
+     */
+    using ChangeCallback = std::function<bool(const DiffChange& change, const ChangeText& text)>;
+
+    /**
+     * @brief Constructor
+     *
+     * @param engine Engine that diffs each pair of windows; defaults to MyersDiff
+     * @param windowLines Lines held from each source at a time
+     */
+    explicit StreamingDiff(IDiffEnginePtr engine = nullptr, size_t windowLines = DEFAULT_WINDOW_LINES)
+        : engine_(engine ? std::move(engine) : std::make_shared<MyersDiff>()),
+          windowLines_(std::max<size_t>(windowLines, 2)) {
+    }
+
+    /**
+     * @brief Diff two sources, reporting changes through a callback as they are found
+     *
+     * @return false if the callback stopped the diff early
+     */
+    bool run(LineSource& source1, LineSource& source2, const ChangeCallback& callback) {
+        std::vector<std::string> window1;
+        std::vector<std::string> window2;
+        size_t base1 = 0;  // Line number of window1[0] in source1
+        size_t base2 = 0;
+        bool done1 = false;
+        bool done2 = false;
+
+        // Which side to skip when the windows have too little in common
+        bool skipInserts = true;
+        size_t skipBudget = windowLines_;
+        size_t skipped = 0;
+        size_t rounds = 0;
+
+        while (true) {
+            fill(source1, window1, done1);
+            fill(source2, window2, done2);
+            if (window1.empty() && window2.empty()) {
+                LOG_DEBUG("Streaming diff compared " + std::to_string(base1) + " and " +
+                          std::to_string(base2) + " lines in " + std::to_string(rounds) + " rounds");
+                return true;
+            }
+            ++rounds;
+
+            auto changes = engine_->computeLineDiff(window1, window2);
+
+            // Report everything up to the end of the last equal run; at the
+            // end of both sources, report everything
+            size_t cut = changes.size();
+            size_t end1 = window1.size();
+            size_t end2 = window2.size();
+            if (!(done1 && done2)) {
+                cut = 0;
+                end1 = 0;
+                end2 = 0;
+                for (size_t i = changes.size(); i-- > 0;) {
+                    if (changes[i].isEqual()) {
+                        cut = i + 1;
+                        end1 = changes[i].startLine1 + changes[i].lineCount1;
+                        end2 = changes[i].startLine2 + changes[i].lineCount2;
+                        break;
+                    }
+                }
+            }
+            for (size_t i = 0; i < cut; ++i) {
+                if (!report(changes[i], window1, window2, base1, base2, callback)) {
+                    return false;
+                }
+            }
+
+            if (end1 + end2 >= windowLines_ / 2 || (done1 && done2)) {
+                skipInserts = true;
+                skipBudget = windowLines_;
+                skipped = 0;
+            } else {
+                // Too little in common: pass over the rest of one window
+                const bool insert = end1 == window1.size() || (skipInserts && end2 < window2.size());
+                DiffChange change;
+                if (insert) {
+                    change = makeChange(DiffChange::ChangeType::INSERT, end1, 0, end2, window2.size() - end2);
+                    end2 = window2.size();
+                    skipped += change.lineCount2;
+                } else {
+                    change = makeChange(DiffChange::ChangeType::DELETE, end1, window1.size() - end1, end2, 0);
+                    end1 = window1.size();
+                    skipped += change.lineCount1;
+                }
+                if (!report(change, window1, window2, base1, base2, callback)) {
+                    return false;
+                }
+
+                if (skipped >= skipBudget) {
+                    skipInserts = !skipInserts;
+                    skipBudget *= 2;
+                    skipped = 0;
+                }
+            }
+
+            window1.erase(window1.begin(), window1.begin() + end1);
+            window2.erase(window2.begin(), window2.begin() + end2);
+            base1 += end1;
+            base2 += end2;
+        }
+    }
+
+private:
+    void fill(LineSource& source, std::vector<std::string>& window, bool& done) {
+        std::string line;
+        while (!done && window.size() < windowLines_) {
+            if (source.nextLine(line)) {
+                window.push_back(std::move(line));
+            } else {
+                done = true;
+            }
+        }
+    }
+
+    static DiffChange makeChange(DiffChange::ChangeType type, size_t start1, size_t count1,
+                                 size_t start2, size_t count2) {
+        DiffChange change;
+        change.type = type;
+        change.startLine1 = start1;
+        change.lineCount1 = count1;
+        change.startLine2 = start2;
+        change.lineCount2 = count2;
+        change.startChar1 = 0;
+        change.charCount1 = 0;
+        change.startChar2 = 0;
+        change.charCount2 = 0;
+        change.isLineLevel = true;
+        return change;
+    }
+
+    // Report a change given in window coordinates, translated to source line numbers
+    static bool report(DiffChange change,
+                       const std::vector<std::string>& window1,
+                       const std::vector<std::string>& window2,
+                       size_t base1, size_t base2,
+                       const ChangeCallback& callback) {
+        const ChangeText text{window1.data() + change.startLine1, window2.data() + change.startLine2};
+        change.startLine1 += base1;
+        change.startLine2 += base2;
+        return callback(change, text);
+    }
+
+    IDiffEnginePtr engine_;
+    size_t windowLines_;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "interfaces/IDiffEngine.hpp"
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @class UnifiedDiffBuilder
+ * @brief Formats a sequence of line changes as unified diff hunks
+ *
+ * Changes are added in order, each with the text it covers. Holds at most
+ * twice the context of equal lines at a time, so the size of the output,
+ * not of the input, determines its memory use. Equal runs reported in
+ * several pieces are treated as one.
+ *
+ * This is the single unified diff formatter: IDiffEngine implementations
+ * use it for formatUnifiedDiff(), and StreamingDiff results are fed to it
+ * directly.
+ */
+class UnifiedDiffBuilder {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param contextLines Equal lines shown around each change
+     */
+    explicit UnifiedDiffBuilder(size_t contextLines = 3)
+        : contextLines_(contextLines) {
+    }
+
+    /**
+     * @brief Add the next line-level change
+     *
+     * @param change The change, in source line numbers
+     * @param lines1 The change's lines of the first text, starting at startLine1
+     * @param lines2 The change's lines of the second text, starting at startLine2
+     */
+    void add(const DiffChange& change, const std::string* lines1, const std::string* lines2) {
+        if (change.isEqual()) {
+            addEqual(lines1, change.lineCount1);
+            return;
+        }
+
+        // Equal lines since the last change become leading context, or join
+        // the open hunk if the run was short enough to bridge
+        if (!inHunk_) {
+            inHunk_ = true;
+            hunkStart1_ = change.startLine1 - equal_.size();
+            hunkStart2_ = change.startLine2 - equal_.size();
+            hunkCount1_ = 0;
+            hunkCount2_ = 0;
+        }
+        appendContext(equal_.size());
+
+        for (size_t i = 0; i < change.lineCount1; ++i) {
+            body_.push_back("-" + lines1[i]);
+        }
+        for (size_t i = 0; i < change.lineCount2; ++i) {
+            body_.push_back("+" + lines2[i]);
+        }
+        hunkCount1_ += change.lineCount1;
+        hunkCount2_ += change.lineCount2;
+    }
+
+    /**
+     * @brief Add a run of lines that are equal in both texts
+     *
+     * @param lines The run's lines
+     * @param count Number of lines in the run
+     */
+    void addEqual(const std::string* lines, size_t count) {
+        size_t i = 0;
+        while (i < count) {
+            if (!inHunk_ && count - i > contextLines_) {
+                // Outside a hunk only the last context lines of the run can
+                // end up in the output
+                equal_.clear();
+                i = count - contextLines_;
+                continue;
+            }
+            addEqualLine(lines[i++]);
+        }
+    }
+
+    /**
+     * @brief Close the last hunk; call once after the last change
+     */
+    void finish() {
+        if (inHunk_) {
+            appendContext(std::min(contextLines_, equal_.size()));
+            closeHunk();
+        }
+        equal_.clear();
+    }
+
+    /**
+     * @brief The formatted diff, one output line per entry
+     */
+    const std::vector<std::string>& lines() const {
+        return lines_;
+    }
+
+    /**
+     * @brief The formatted diff as text, each line terminated by '\n'
+     */
+    std::string str() const {
+        size_t size = 0;
+        for (const auto& line : lines_) {
+            size += line.size() + 1;
+        }
+        std::string result;
+        result.reserve(size);
+        for (const auto& line : lines_) {
+            result += line;
+            result += '\n';
+        }
+        return result;
+    }
+
+private:
+    void addEqualLine(const std::string& line) {
+        equal_.push_back(line);
+        if (inHunk_ && equal_.size() > 2 * contextLines_) {
+            // Too long to bridge: end the hunk with trailing context
+            appendContext(contextLines_);
+            closeHunk();
+        }
+        if (!inHunk_ && equal_.size() > contextLines_) {
+            equal_.pop_front();
+        }
+    }
+
+    // Move the first count held equal lines into the open hunk
+    void appendContext(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            body_.push_back(" " + equal_.front());
+            equal_.pop_front();
+        }
+        hunkCount1_ += count;
+        hunkCount2_ += count;
+    }
+
+    void closeHunk() {
+        lines_.push_back("@@ -" + std::to_string(hunkStart1_ + 1) + "," + std::to_string(hunkCount1_) +
+                         " +" + std::to_string(hunkStart2_ + 1) + "," + std::to_string(hunkCount2_) + " @@");
+        for (auto& line : body_) {
+            lines_.push_back(std::move(line));
+        }
+        body_.clear();
+        inHunk_ = false;
+    }
+
+    size_t contextLines_;
+    std::deque<std::string> equal_;     // Equal lines since the last change, up to twice the context
+    std::vector<std::string> lines_;
+    std::vector<std::string> body_;     // Lines of the open hunk
+    bool inHunk_ = false;
+    size_t hunkStart1_ = 0;
+    size_t hunkStart2_ = 0;
+    size_t hunkCount1_ = 0;
+    size_t hunkCount2_ = 0;
+};
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <utility>
 #include <iosfwd>
 #include <functional>
+#include <string_view>
 
 /**
  * @interface ITextBuffer
@@ -129,6 +131,40 @@ public:
      * @return A vector of all lines
      */
     virtual std::vector<std::string> getAllLines() const = 0;
+
+    /**
+     * @brief Callback for forEachLine
+     *
+     * Receives the line index and a view of the line text. The view is only
+     * valid for the duration of the call; copy it to keep the text. Return
+     * false to stop the iteration.
+     */
+    using LineVisitor = std::function<bool(size_t lineIndex, std::string_view line)>;
+
+    /**
+     * @brief Visit a range of lines without copying them
+     *
+     * Lines [startLine, endLine) are passed to the visitor in order; endLine
+     * is clamped to the line count. Implementations may hold a read lock for
+     * the whole iteration, so the visitor must not modify this buffer.
+     *
+     * @param startLine The first line to visit
+     * @param endLine One past the last line to visit
+     * @param visitor The callback for each line
+     * @return The number of lines visited
+     */
+    virtual size_t forEachLine(size_t startLine, size_t endLine, const LineVisitor& visitor) const
+    {
+        const size_t end = std::min(endLine, lineCount());
+        size_t visited = 0;
+        for (size_t i = startLine; i < end; ++i) {
+            ++visited;
+            if (!visitor(i, getLine(i))) {
+                break;
+            }
+        }
+        return visited;
+    }
     
     // Safety improvements
     /**
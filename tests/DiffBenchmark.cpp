@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/diff/MyersDiff.h"
+#include "../src/diff/HistogramDiff.h"
+#include "../src/Executor.h"
+
+namespace {
+
+struct RevisionPair {
+    std::string name;
+    std::vector<std::string> oldLines;
+    std::vector<std::string> newLines;
+};
+
+struct DiffResult {
+    double milliseconds = 0.0;
+    size_t editedLines = 0;  // Deleted plus inserted lines
+    size_t hunks = 0;
+    bool valid = true;
+};
+
+// Synthetic revision pairs, generated from fixed seeds so every run
+// diffs the same texts. Files are built from functions that repeat what
+// real code repeats (braces, blank lines, early returns, locking) around
+// mostly unique statements, which is where line-matching heuristics differ.
+using Function = std::vector<std::string>;
+
+Function generateFunction(std::mt19937& rng, size_t id)
+{
+    static const char* const common[] = {
+        "    if (!request.valid()) {", "        return false;", "    }", "",
+        "    std::lock_guard<std::mutex> lock(mutex_);", "    ++counter_;",
+        "    LOG_DEBUG(\"handled\");", "    return result;"};
+
+    const std::string name = std::to_string(id);
+    Function lines = {"bool Component::handle" + name + "(const Request& request) {"};
+    const size_t statements = 4 + rng() % 16;
+    for (size_t i = 0; i < statements; ++i) {
+        if (rng() % 3 == 0) {
+            lines.push_back(common[rng() % std::size(common)]);
+        } else {
+            lines.push_back("    auto value" + std::to_string(i) + " = compute" + name + "(request, " +
+                            std::to_string(rng() % 1000) + ");");
+        }
+    }
+    lines.push_back("    return true;");
+    lines.push_back("}");
+    lines.push_back("");
+    return lines;
+}
+
+std::vector<std::string> flatten(const std::vector<Function>& functions)
+{
+    std::vector<std::string> lines = {"#include \"Component.h\"", "", "namespace app {", ""};
+    for (const auto& function : functions) {
+        lines.insert(lines.end(), function.begin(), function.end());
+    }
+    lines.push_back("} // namespace app");
+    return lines;
+}
+
+// Edits a revision typically makes, in the given mix out of 100
+struct EditMix {
+    int changeLines;     // Rewrite a few statements inside a function
+    int addFunction;     // Add a new function
+    int removeFunction;  // Remove a function
+    int moveFunction;    // Move a function elsewhere in the file
+};
+
+RevisionPair generatePair(const std::string& name, uint32_t seed, size_t functionCount, int edits, EditMix mix)
+{
+    std::mt19937 rng(seed);
+    std::vector<Function> functions;
+    size_t nextId = 0;
+    for (size_t i = 0; i < functionCount; ++i) {
+        functions.push_back(generateFunction(rng, nextId++));
+    }
+    std::vector<std::string> oldLines = flatten(functions);
+
+    for (int edit = 0; edit < edits; ++edit) {
+        const int kind = static_cast<int>(rng() % 100);
+        const size_t at = rng() % functions.size();
+        if (kind < mix.changeLines) {
+            Function& function = functions[at];
+            const size_t line = 1 + rng() % (function.size() - 3);
+            function[line] = "    auto changed" + std::to_string(edit) + " = update(request);";
+        } else if (kind < mix.changeLines + mix.addFunction) {
+            functions.insert(functions.begin() + static_cast<std::ptrdiff_t>(at), generateFunction(rng, nextId++));
+        } else if (kind < mix.changeLines + mix.addFunction + mix.removeFunction) {
+            if (functions.size() > 1) {
+                functions.erase(functions.begin() + static_cast<std::ptrdiff_t>(at));
+            }
+        } else {
+            Function moved = std::move(functions[at]);
+            functions.erase(functions.begin() + static_cast<std::ptrdiff_t>(at));
+            functions.insert(functions.begin() + static_cast<std::ptrdiff_t>(rng() % (functions.size() + 1)),
+                             std::move(moved));
+        }
+    }
+    return {name, std::move(oldLines), flatten(functions)};
+}
+
+std::vector<RevisionPair> generateCorpus()
+{
+    return {
+        generatePair("small fix-ups", 1, 40, 5, {100, 0, 0, 0}),
+        generatePair("new functions", 2, 60, 8, {20, 80, 0, 0}),
+        generatePair("removed functions", 3, 80, 10, {20, 0, 80, 0}),
+        generatePair("moved functions", 4, 80, 6, {0, 0, 0, 100}),
+        generatePair("mixed refactor", 5, 150, 40, {55, 15, 15, 15}),
+        generatePair("large file, scattered edits", 6, 600, 60, {70, 10, 10, 10}),
+        generatePair("large rewrite", 7, 200, 150, {60, 20, 20, 0}),
+    };
+}
+
+// Best of several runs, plus a check that the changes rebuild both texts
+DiffResult runDiff(IDiffEngine& engine, const std::vector<std::string>& text1,
+                   const std::vector<std::string>& text2, int repetitions)
+{
+    DiffResult result;
+    std::vector<DiffChange> changes;
+    for (int run = 0; run < repetitions; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        changes = engine.computeLineDiff(text1, text2);
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.milliseconds = run == 0 ? ms : std::min(result.milliseconds, ms);
+    }
+
+    size_t line1 = 0;
+    size_t line2 = 0;
+    for (const auto& change : changes) {
+        result.valid = result.valid && change.startLine1 == line1 && change.startLine2 == line2;
+        if (change.isEqual()) {
+            for (size_t i = 0; i < change.lineCount1 && result.valid; ++i) {
+                result.valid = line1 + i < text1.size() && line2 + i < text2.size() &&
+                               text1[line1 + i] == text2[line2 + i];
+            }
+        } else {
+            result.editedLines += change.lineCount1 + change.lineCount2;
+            ++result.hunks;
+        }
+        line1 += change.lineCount1;
+        line2 += change.lineCount2;
+    }
+    result.valid = result.valid && line1 == text1.size() && line2 == text2.size();
+    return result;
+}
+
+void printRow(const std::string& name, size_t lines, const DiffResult& myers, const DiffResult& histogram)
+{
+    std::cout << std::left << std::setw(44) << name << std::right << std::setw(8) << lines
+              << std::fixed << std::setprecision(3)
+              << std::setw(11) << myers.milliseconds << std::setw(7) << myers.hunks << std::setw(7) << myers.editedLines
+              << std::setw(11) << histogram.milliseconds << std::setw(7) << histogram.hunks << std::setw(7) << histogram.editedLines
+              << std::endl;
+}
+
+void printHeader()
+{
+    std::cout << std::left << std::setw(44) << "pair" << std::right << std::setw(8) << "lines"
+              << std::setw(11) << "myers ms" << std::setw(7) << "hunks" << std::setw(7) << "edits"
+              << std::setw(11) << "hist ms" << std::setw(7) << "hunks" << std::setw(7) << "edits"
+              << std::endl;
+}
+
+// The generic element-by-element Myers, as character diffs ran before they
+// got a byte path of their own
+class GenericCharDiff : public MyersDiff {
+public:
+    size_t editCount(const std::string& str1, const std::string& str2) {
+        std::vector<char> chars1(str1.begin(), str1.end());
+        std::vector<char> chars2(str2.begin(), str2.end());
+        size_t edits = 0;
+        for (const auto& item : computeEditScript(chars1, chars2)) {
+            edits += item.op != EditOp::KEEP;
+        }
+        return edits;
+    }
+};
+
+struct StringPair {
+    std::string str1;
+    std::string str2;
+};
+
+// Megabytes of both strings diffed per second, best of several runs
+template<typename Diff>
+double charDiffThroughput(const std::vector<StringPair>& pairs, int repetitions, Diff diff)
+{
+    size_t bytes = 0;
+    for (const auto& pair : pairs) {
+        bytes += pair.str1.size() + pair.str2.size();
+    }
+    double best = 0.0;
+    for (int run = 0; run < repetitions; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& pair : pairs) {
+            diff(pair.str1, pair.str2);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        best = std::max(best, bytes / 1e6 / seconds);
+    }
+    return best;
+}
+
+size_t editedChars(const std::vector<DiffChange>& changes)
+{
+    size_t edits = 0;
+    for (const auto& change : changes) {
+        if (!change.isEqual()) {
+            edits += change.charCount1 + change.charCount2;
+        }
+    }
+    return edits;
+}
+
+} // namespace
+
+TEST(DiffBenchmark, CompareEnginesOnRevisionCorpus)
+{
+    auto corpus = generateCorpus();
+
+    MyersDiff myers;
+    HistogramDiff histogram;
+    double myersTotal = 0.0;
+    double histogramTotal = 0.0;
+
+    printHeader();
+    for (const auto& pair : corpus) {
+        DiffResult myersResult = runDiff(myers, pair.oldLines, pair.newLines, 20);
+        DiffResult histogramResult = runDiff(histogram, pair.oldLines, pair.newLines, 20);
+        EXPECT_TRUE(myersResult.valid) << pair.name;
+        EXPECT_TRUE(histogramResult.valid) << pair.name;
+
+        // Myers is minimal; anchoring on rare lines may cost a few extra
+        // edited lines but should never blow up the diff
+        EXPECT_LE(myersResult.editedLines, histogramResult.editedLines) << pair.name;
+        EXPECT_LE(histogramResult.editedLines, myersResult.editedLines * 2) << pair.name;
+
+        printRow(pair.name, std::max(pair.oldLines.size(), pair.newLines.size()), myersResult, histogramResult);
+        myersTotal += myersResult.milliseconds;
+        histogramTotal += histogramResult.milliseconds;
+    }
+    std::cout << "Total: Myers " << myersTotal << " ms, Histogram " << histogramTotal << " ms" << std::endl;
+}
+
+TEST(DiffBenchmark, CompareEnginesOnLargeFile)
+{
+    // The corpus files concatenated into one large source file, with edits
+    // scattered through it the way a long-lived branch accumulates them
+    auto corpus = generateCorpus();
+
+    std::vector<std::string> text1;
+    while (text1.size() < 200000) {
+        for (const auto& pair : corpus) {
+            text1.insert(text1.end(), pair.newLines.begin(), pair.newLines.end());
+        }
+    }
+    std::vector<std::string> text2 = text1;
+    std::mt19937 rng(42);
+    for (int edit = 0; edit < 2000; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, "    // inserted " + std::to_string(edit)); break;
+            default: text2[line] += " // changed"; break;
+        }
+    }
+
+    MyersDiff myers;
+    HistogramDiff histogram;
+    DiffResult myersResult = runDiff(myers, text1, text2, 3);
+    DiffResult histogramResult = runDiff(histogram, text1, text2, 3);
+    EXPECT_TRUE(myersResult.valid);
+    EXPECT_TRUE(histogramResult.valid);
+    EXPECT_LE(histogramResult.editedLines, myersResult.editedLines * 2);
+
+    printHeader();
+    printRow("concatenated corpus, 2000 edits", text1.size(), myersResult, histogramResult);
+}
+
+TEST(DiffBenchmark, ParallelDiffScaling)
+{
+    // A generated file of mostly unique lines, the case the parallel mode is
+    // for; the changes must not depend on the number of threads
+    std::vector<std::string> text1;
+    text1.reserve(2000000);
+    for (size_t i = 0; i < 2000000; ++i) {
+        text1.push_back(i % 4 == 0 ? "    }" : "    record_" + std::to_string(i) + " = load(" + std::to_string(i % 97) + ");");
+    }
+    std::vector<std::string> text2 = text1;
+    std::mt19937 rng(7);
+    for (int edit = 0; edit < 20000; ++edit) {
+        text2[rng() % text2.size()] += " // changed";
+    }
+
+    MyersDiff serial;
+    DiffResult serialResult = runDiff(serial, text1, text2, 1);
+    EXPECT_TRUE(serialResult.valid);
+    std::cout << "serial: " << serialResult.milliseconds << " ms, " << serialResult.hunks << " hunks" << std::endl;
+
+    std::vector<DiffChange> reference;
+    for (size_t threads : {1, 2, 4, 8}) {
+        MyersDiff parallel;
+        parallel.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, threads, 1}));
+        DiffResult result = runDiff(parallel, text1, text2, 1);
+        EXPECT_TRUE(result.valid);
+
+        auto changes = parallel.computeLineDiff(text1, text2);
+        if (reference.empty()) {
+            reference = changes;
+        }
+        ASSERT_EQ(changes.size(), reference.size()) << threads << " threads";
+        for (size_t i = 0; i < changes.size(); ++i) {
+            ASSERT_EQ(changes[i].startLine1, reference[i].startLine1);
+            ASSERT_EQ(changes[i].startLine2, reference[i].startLine2);
+            ASSERT_EQ(changes[i].lineCount1, reference[i].lineCount1);
+            ASSERT_EQ(changes[i].lineCount2, reference[i].lineCount2);
+        }
+        std::cout << threads << " background threads: " << result.milliseconds << " ms, "
+                  << result.hunks << " hunks" << std::endl;
+    }
+}
+
+TEST(DiffBenchmark, CharacterDiffThroughput)
+{
+    auto corpus = generateCorpus();
+    std::mt19937 rng(3);
+
+    // Source lines with a small edit each, mostly short enough for the bit-parallel path
+    std::vector<StringPair> sourceLines;
+    for (const auto& pair : corpus) {
+        for (const auto& line : pair.newLines) {
+            std::string edited = line;
+            edited.insert(rng() % (edited.size() + 1), "x");
+            sourceLines.push_back({line, edited});
+        }
+    }
+    std::vector<StringPair> minifiedLines;
+
+    // A 1 MB minified line with scattered edits
+    std::string minified;
+    for (size_t i = 0; minified.size() < (1 << 20); ++i) {
+        minified += "function f" + std::to_string(i) + "(a,b){return a[" + std::to_string(i % 13) + "]+b;}";
+    }
+    std::string minifiedEdited = minified;
+    for (int edit = 0; edit < 200; ++edit) {
+        minifiedEdited[rng() % minifiedEdited.size()] = '#';
+    }
+    minifiedLines.push_back({minified, minifiedEdited});
+
+    // The same line rewritten throughout, which the edit limit turns into one replacement
+    std::string rewritten = minified;
+    for (size_t i = 0; i < rewritten.size(); i += 40) {
+        rewritten.replace(i, 8, "g(c,d);;");
+    }
+    const std::vector<StringPair> rewrittenLines = {{minified, rewritten}};
+
+    MyersDiff bytes;
+    GenericCharDiff generic;
+    for (const auto* pairs : {&sourceLines, &minifiedLines}) {
+        for (const auto& pair : *pairs) {
+            ASSERT_EQ(editedChars(bytes.computeStringDiff(pair.str1, pair.str2)), generic.editCount(pair.str1, pair.str2));
+        }
+    }
+    auto rewrittenChanges = bytes.computeStringDiff(minified, rewritten);
+    EXPECT_TRUE(std::any_of(rewrittenChanges.begin(), rewrittenChanges.end(),
+                            [](const DiffChange& change) { return change.isReplace(); }));
+
+    auto byteDiff = [&bytes](const std::string& str1, const std::string& str2) { bytes.computeStringDiff(str1, str2); };
+    auto genericDiff = [&generic](const std::string& str1, const std::string& str2) { generic.editCount(str1, str2); };
+    const double sourceBytes = charDiffThroughput(sourceLines, 5, byteDiff);
+    const double sourceGeneric = charDiffThroughput(sourceLines, 5, genericDiff);
+    const double minifiedBytes = charDiffThroughput(minifiedLines, 5, byteDiff);
+    const double minifiedGeneric = charDiffThroughput(minifiedLines, 1, genericDiff);
+    const double rewrittenBytes = charDiffThroughput(rewrittenLines, 5, byteDiff);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << std::left << std::setw(28) << "case" << std::right << std::setw(12) << "byte MB/s"
+              << std::setw(14) << "generic MB/s" << std::endl;
+    std::cout << std::left << std::setw(28) << "source lines, 1 edit" << std::right
+              << std::setw(12) << sourceBytes << std::setw(14) << sourceGeneric << std::endl;
+    std::cout << std::left << std::setw(28) << "1 MB line, 200 edits" << std::right
+              << std::setw(12) << minifiedBytes << std::setw(14) << minifiedGeneric << std::endl;
+    std::cout << std::left << std::setw(28) << "1 MB line, rewritten" << std::right
+              << std::setw(12) << rewrittenBytes << std::setw(14) << "-" << std::endl;
+}
@@ -0,0 +1,232 @@
+#include "gtest/gtest.h"
+#include "Executor.h"
+#include "EditorCoreThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+Executor::Options smallOptions()
+{
+    Executor::Options options;
+    options.interactiveThreads = 2;
+    options.backgroundThreads = 1;
+    options.ioThreads = 2;
+    return options;
+}
+
+} // namespace
+
+TEST(ExecutorTest, SizesLanesFromOptionsAndCpuCount)
+{
+    Executor sized(smallOptions());
+    EXPECT_EQ(sized.threadCount(Executor::Lane::Interactive), 2u);
+    EXPECT_EQ(sized.threadCount(Executor::Lane::Background), 1u);
+    EXPECT_EQ(sized.threadCount(Executor::Lane::IO), 2u);
+
+    // The CPU lanes together never exceed the CPU count (but have a thread each)
+    Executor automatic;
+    const size_t cpus = std::max<size_t>(2, std::thread::hardware_concurrency());
+    const size_t cpuLanes = automatic.threadCount(Executor::Lane::Interactive) +
+                            automatic.threadCount(Executor::Lane::Background);
+    EXPECT_GE(automatic.threadCount(Executor::Lane::Interactive), 1u);
+    EXPECT_GE(automatic.threadCount(Executor::Lane::Background), 1u);
+    EXPECT_LE(cpuLanes, cpus);
+    EXPECT_GE(automatic.threadCount(Executor::Lane::IO), 1u);
+}
+
+TEST(ExecutorTest, LanesRunTasksOnSeparateThreads)
+{
+    Executor executor(smallOptions());
+
+    std::mutex mutex;
+    std::set<std::thread::id> interactiveThreads;
+    std::set<std::thread::id> backgroundThreads;
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 50; ++i) {
+        results.push_back(executor.submit(Executor::Lane::Interactive, [&, i]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            interactiveThreads.insert(std::this_thread::get_id());
+            return i;
+        }));
+        results.push_back(executor.submit(Executor::Lane::Background, ThreadPool::Priority::LOW, [&](int value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            backgroundThreads.insert(std::this_thread::get_id());
+            return value * 2;
+        }, i));
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(results[2 * i].get(), i);
+        EXPECT_EQ(results[2 * i + 1].get(), i * 2);
+    }
+
+    // No thread serves two lanes
+    for (const auto& id : backgroundThreads) {
+        EXPECT_EQ(interactiveThreads.count(id), 0u);
+    }
+}
+
+TEST(ExecutorTest, BusyLaneDoesNotDelayOtherLanes)
+{
+    Executor executor(smallOptions());
+
+    // Fill the single background thread with slow work
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::future<void>> backlog;
+    for (int i = 0; i < 10; ++i) {
+        backlog.push_back(executor.submit(Executor::Lane::Background, [released]() { released.wait(); }));
+    }
+
+    auto interactive = executor.submit(Executor::Lane::Interactive, []() { return 42; });
+    ASSERT_EQ(interactive.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(interactive.get(), 42);
+
+    auto metrics = executor.metrics(Executor::Lane::Background);
+    EXPECT_EQ(metrics.threadCount, 1u);
+    EXPECT_GE(metrics.queueDepth, 8u);
+
+    release.set_value();
+    for (auto& task : backlog) {
+        task.get();
+    }
+}
+
+TEST(ExecutorTest, ReportsLaneMetrics)
+{
+    Executor executor(smallOptions());
+
+    std::vector<std::future<void>> tasks;
+    for (int i = 0; i < 20; ++i) {
+        tasks.push_back(executor.submit(Executor::Lane::IO, []() { std::this_thread::sleep_for(1ms); }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    // Completion is recorded as the task returns, just after its future is ready
+    Executor::LaneMetrics metrics = executor.metrics(Executor::Lane::IO);
+    for (int i = 0; i < 500 && metrics.completed < 20; ++i) {
+        std::this_thread::sleep_for(1ms);
+        metrics = executor.metrics(Executor::Lane::IO);
+    }
+
+    EXPECT_EQ(metrics.submitted, 20u);
+    EXPECT_EQ(metrics.completed, 20u);
+    EXPECT_EQ(metrics.queueDepth, 0u);
+    EXPECT_GE(metrics.averageRun, 1ms);
+
+    // With two threads and 1 ms tasks, the later tasks waited in the queue
+    EXPECT_GT(metrics.maxWait, 1ms);
+    EXPECT_GT(metrics.averageWait, 0ns);
+    EXPECT_LE(metrics.averageWait, metrics.maxWait);
+    EXPECT_GT(metrics.p99Wait, 0ns);
+    EXPECT_LE(metrics.p99Wait, metrics.maxWait);
+
+    // Other lanes are untouched
+    EXPECT_EQ(executor.metrics(Executor::Lane::Interactive).submitted, 0u);
+    EXPECT_STREQ(Executor::laneName(Executor::Lane::IO), "io");
+}
+
+TEST(ExecutorTest, CountsDroppedTasksPerLane)
+{
+    Executor executor(smallOptions());
+
+    ThreadPool::TaskOptions expired;
+    expired.deadline = Executor::Clock::now() - 1ms;
+    auto late = executor.submit(Executor::Lane::Background, expired, []() {});
+
+    ThreadPool::CancellationToken token;
+    token.cancel();
+    ThreadPool::TaskOptions cancelled;
+    cancelled.token = token;
+    auto stale = executor.submit(Executor::Lane::Background, cancelled, []() {});
+
+    EXPECT_THROW(late.get(), std::future_error);
+    EXPECT_THROW(stale.get(), std::future_error);
+
+    const auto metrics = executor.metrics(Executor::Lane::Background);
+    EXPECT_EQ(metrics.submitted, 2u);
+    EXPECT_EQ(metrics.completed, 0u);
+    EXPECT_EQ(metrics.expired, 1u);
+    EXPECT_EQ(metrics.cancelled, 1u);
+}
+
+TEST(ExecutorTest, ScheduledTasksRunAfterTheirDelay)
+{
+    Executor executor(smallOptions());
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::promise<void> done;
+
+    const auto start = Executor::Clock::now();
+    executor.schedule(Executor::Lane::IO, 60ms, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(2);
+        done.set_value();
+    });
+    executor.schedule(Executor::Lane::Interactive, 20ms, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(1);
+    });
+
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_GE(Executor::Clock::now() - start, 60ms);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST(ExecutorTest, ShutdownDropsPendingTimersAndRejectsWork)
+{
+    auto ran = std::make_shared<std::atomic<bool>>(false);
+    {
+        Executor executor(smallOptions());
+        executor.schedule(Executor::Lane::IO, 10s, [ran]() { *ran = true; });
+        executor.shutdown();
+
+        EXPECT_THROW(executor.submit(Executor::Lane::Interactive, []() {}), std::runtime_error);
+        EXPECT_THROW(executor.schedule(Executor::Lane::IO, 0ms, []() {}), std::runtime_error);
+        EXPECT_EQ(executor.metrics(Executor::Lane::Interactive).submitted, 0u);
+    }
+    EXPECT_FALSE(ran->load());
+}
+
+TEST(ExecutorTest, SharedInstanceIsProcessWide)
+{
+    auto first = Executor::shared();
+    auto second = Executor::shared();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->submit(Executor::Lane::Background, []() { return 7; }).get(), 7);
+}
+
+TEST(ExecutorTest, EditorCoreThreadPoolRunsTasksOnTheExecutor)
+{
+    auto executor = std::make_shared<Executor>(smallOptions());
+    EditorCoreThreadPool pool(executor);
+    pool.start();
+
+    // Only the TextBuffer owner thread belongs to the pool
+    EXPECT_EQ(pool.threadCount(), 1u);
+
+    std::promise<bool> onPoolThread;
+    pool.submitTask([&pool, &onPoolThread]() { onPoolThread.set_value(pool.isPoolThread()); });
+    auto result = onPoolThread.get_future();
+    ASSERT_EQ(result.wait_for(5s), std::future_status::ready);
+    EXPECT_FALSE(result.get());
+    EXPECT_EQ(executor->metrics(Executor::Lane::Interactive).submitted, 1u);
+
+    pool.shutdown();
+}
@@ -0,0 +1,194 @@
+#include "gtest/gtest.h"
+#include "diff/HistogramDiff.h"
+#include "Executor.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Check that the changes walk both texts in order and that every equal run
+// really is equal; returns the number of inserted plus deleted lines
+size_t expectValidChanges(const std::vector<DiffChange>& changes,
+                          const std::vector<std::string>& text1,
+                          const std::vector<std::string>& text2)
+{
+    size_t line1 = 0;
+    size_t line2 = 0;
+    size_t edits = 0;
+    for (const auto& change : changes) {
+        EXPECT_EQ(change.startLine1, line1);
+        EXPECT_EQ(change.startLine2, line2);
+        if (change.isEqual()) {
+            EXPECT_EQ(change.lineCount1, change.lineCount2);
+            for (size_t i = 0; i < change.lineCount1 && line1 + i < text1.size() && line2 + i < text2.size(); ++i) {
+                EXPECT_EQ(text1[line1 + i], text2[line2 + i]);
+            }
+        } else {
+            edits += change.lineCount1 + change.lineCount2;
+        }
+        line1 += change.lineCount1;
+        line2 += change.lineCount2;
+    }
+    EXPECT_EQ(line1, text1.size());
+    EXPECT_EQ(line2, text2.size());
+    return edits;
+}
+
+// Whether line1 of text1 is reported as equal to line2 of text2
+bool isKept(const std::vector<DiffChange>& changes, size_t line1, size_t line2)
+{
+    for (const auto& change : changes) {
+        if (change.isEqual() && line1 >= change.startLine1 && line1 < change.startLine1 + change.lineCount1) {
+            return line2 - line1 == change.startLine2 - change.startLine1;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> randomLines(std::mt19937& rng, size_t count, int alphabet)
+{
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back("line " + std::to_string(rng() % alphabet));
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(HistogramDiffTest, AlignsFunctionsOnUniqueLines)
+{
+    // A function inserted above a modified one: the braces and blank lines
+    // repeat everywhere, so only the signature lines say what matches what
+    std::vector<std::string> text1 = {
+        "#include <stdio.h>", "",
+        "// Frobs foo heartily", "int frobnitz(int foo)", "{", "    int i;",
+        "    for(i = 0; i < 10; i++)", "    {", "        printf(\"Your answer is: \");",
+        "        printf(\"%d\\n\", foo);", "    }", "}", "",
+        "int fact(int n)", "{", "    if(n > 1)", "    {", "        return fact(n-1) * n;", "    }",
+        "    return 1;", "}", "",
+        "int main(int argc, char **argv)", "{", "    frobnitz(fact(10));", "}"};
+    std::vector<std::string> text2 = {
+        "#include <stdio.h>", "",
+        "int fib(int n)", "{", "    if(n > 2)", "    {", "        return fib(n-1) + fib(n-2);", "    }",
+        "    return 1;", "}", "",
+        "// Frobs foo heartily", "int frobnitz(int foo)", "{", "    int i;",
+        "    for(i = 0; i < 10; i++)", "    {", "        printf(\"%d\\n\", foo);", "    }", "}", "",
+        "int main(int argc, char **argv)", "{", "    frobnitz(fib(10));", "}"};
+
+    HistogramDiff diff;
+    auto changes = diff.computeLineDiff(text1, text2);
+    expectValidChanges(changes, text1, text2);
+    EXPECT_TRUE(isKept(changes, 2, 11));
+    EXPECT_TRUE(isKept(changes, 3, 12));
+    EXPECT_TRUE(isKept(changes, 22, 21));
+    EXPECT_FALSE(isKept(changes, 13, 2));
+}
+
+TEST(HistogramDiffTest, ProducesValidChanges)
+{
+    HistogramDiff diff;
+    std::mt19937 rng(17);
+    for (int round = 0; round < 2000; ++round) {
+        const int alphabet = 2 + static_cast<int>(rng() % 30);
+        auto text1 = randomLines(rng, rng() % 60, alphabet);
+        auto text2 = text1;
+        if (rng() % 2) {
+            text2 = randomLines(rng, rng() % 60, alphabet);
+        } else {
+            for (int edit = static_cast<int>(rng() % 6); edit >= 0; --edit) {
+                const size_t line = rng() % (text2.size() + 1);
+                if (line < text2.size() && rng() % 2) {
+                    text2.erase(text2.begin() + line);
+                } else {
+                    text2.insert(text2.begin() + line, "line " + std::to_string(rng() % alphabet));
+                }
+            }
+        }
+
+        auto changes = diff.computeLineDiff(text1, text2);
+        expectValidChanges(changes, text1, text2);
+        for (size_t i = 0; i + 1 < changes.size(); ++i) {
+            EXPECT_TRUE(changes[i].isEqual() || changes[i + 1].isEqual());
+        }
+    }
+}
+
+TEST(HistogramDiffTest, FindsShortestEditScriptForUniqueLines)
+{
+    // With no repeated lines every common line is an anchor, and the longest
+    // increasing run of anchors is the longest common subsequence
+    HistogramDiff diff;
+    std::mt19937 rng(23);
+    for (int round = 0; round < 500; ++round) {
+        std::vector<std::string> lines;
+        for (int value = 0; value < 200; ++value) {
+            lines.push_back("line " + std::to_string(value));
+        }
+        std::shuffle(lines.begin(), lines.end(), rng);
+
+        // Delete, insert fresh lines and swap a few, keeping every line unique
+        std::vector<std::string> text1(lines.begin(), lines.begin() + 80);
+        std::vector<std::string> text2 = text1;
+        for (size_t fresh = 80; fresh < 100; ++fresh) {
+            text2.erase(text2.begin() + rng() % text2.size());
+            text2.insert(text2.begin() + rng() % (text2.size() + 1), lines[fresh]);
+        }
+        for (int swap = 0; swap < 5; ++swap) {
+            std::swap(text2[rng() % text2.size()], text2[rng() % text2.size()]);
+        }
+
+        std::vector<std::vector<size_t>> lcs(text1.size() + 1, std::vector<size_t>(text2.size() + 1, 0));
+        for (size_t i = text1.size(); i-- > 0;) {
+            for (size_t j = text2.size(); j-- > 0;) {
+                lcs[i][j] = text1[i] == text2[j] ? lcs[i + 1][j + 1] + 1 : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+            }
+        }
+
+        auto changes = diff.computeLineDiff(text1, text2);
+        EXPECT_EQ(expectValidChanges(changes, text1, text2), text1.size() + text2.size() - 2 * lcs[0][0]);
+    }
+}
+
+TEST(HistogramDiffTest, ParallelDiffKeepsHistogramAlignment)
+{
+    // Brace-heavy functions, each opened by a unique signature. The parallel
+    // split uses the same unique lines as the first histogram step, so every
+    // region diffed with the histogram alignment gives the serial result
+    std::mt19937 rng(29);
+    std::vector<std::string> text1;
+    for (int function = 0; function < 300; ++function) {
+        text1.push_back("int function_" + std::to_string(function) + "(int n)");
+        for (const char* line : {"{", "    if(n > 1)", "    {", "        return n;", "    }", "    return 1;", "}", ""}) {
+            text1.push_back(line);
+        }
+    }
+    std::vector<std::string> text2 = text1;
+    for (int edit = 0; edit < 200; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, {"    {", "        n--;", "    }"}); break;
+            default: text2[line] = "    return " + std::to_string(rng() % 10) + ";"; break;
+        }
+    }
+
+    HistogramDiff serial;
+    const auto expected = serial.computeLineDiff(text1, text2);
+
+    HistogramDiff parallel;
+    parallel.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, 4, 1}), 0, 64);
+    const auto changes = parallel.computeLineDiff(text1, text2);
+    expectValidChanges(changes, text1, text2);
+    EXPECT_GT(parallel.getLastParallelChunkCount(), 1u);
+    ASSERT_EQ(changes.size(), expected.size());
+    for (size_t i = 0; i < changes.size(); ++i) {
+        EXPECT_EQ(changes[i].type, expected[i].type) << "change " << i;
+        EXPECT_EQ(changes[i].startLine1, expected[i].startLine1) << "change " << i;
+        EXPECT_EQ(changes[i].lineCount1, expected[i].lineCount1) << "change " << i;
+        EXPECT_EQ(changes[i].startLine2, expected[i].startLine2) << "change " << i;
+        EXPECT_EQ(changes[i].lineCount2, expected[i].lineCount2) << "change " << i;
+    }
+}
@@ -0,0 +1,130 @@
+#include "gtest/gtest.h"
+#include "LineIndexFile.h"
+#include "MappedFile.h"
+#include "VirtualizedTextBuffer.h"
+#include <cstdio>       // For std::remove
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// Test fixture for LineIndexFile tests
+class LineIndexFileTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::remove(testFilename.c_str());
+        std::remove(indexFilename.c_str());
+    }
+
+    void writeLines(const std::string& prefix, size_t count) {
+        std::ofstream out(testFilename, std::ios::binary);
+        for (size_t i = 0; i < count; ++i) {
+            out << prefix << i << '\n';
+        }
+    }
+
+    static LineIndexFile::Contents sampleContents() {
+        LineIndexFile::Contents contents;
+        contents.stamp = {12345, 987654321, 0xABCDEF};
+        contents.checkpointInterval = 1000;
+        contents.pages = {{4000, 1000}, {5000, 1000}, {3000, 1999}, {345, 7}};
+        contents.stamp.fileSize = 4000 + 5000 + 3000 + 345;
+        contents.lineCount = 1000 + 1000 + 1999 + 7;
+        return contents;
+    }
+
+    const std::string testFilename = "line_index_file_test.txt";
+    const std::string indexFilename = "line_index_file_test.txt.idx";
+};
+
+TEST_F(LineIndexFileTest, RoundTripsCompactly) {
+    const auto contents = sampleContents();
+    const std::string bytes = LineIndexFile::encode(contents);
+
+    // Uniform pages cost a few bytes each on top of the fixed header and checksum
+    EXPECT_LE(bytes.size(), 56u + 8u + 4u * contents.pages.size());
+
+    auto decoded = LineIndexFile::decode(bytes);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->stamp, contents.stamp);
+    EXPECT_EQ(decoded->checkpointInterval, 1000u);
+    EXPECT_EQ(decoded->lineCount, contents.lineCount);
+    ASSERT_EQ(decoded->pages.size(), contents.pages.size());
+    for (size_t i = 0; i < contents.pages.size(); ++i) {
+        EXPECT_EQ(decoded->pages[i].length, contents.pages[i].length);
+        EXPECT_EQ(decoded->pages[i].lineCount, contents.pages[i].lineCount);
+    }
+}
+
+TEST_F(LineIndexFileTest, RejectsCorruptAndInconsistentIndexes) {
+    std::string bytes = LineIndexFile::encode(sampleContents());
+
+    std::string flipped = bytes;
+    flipped[60] ^= 0x01;
+    EXPECT_FALSE(LineIndexFile::decode(flipped).has_value());
+    EXPECT_FALSE(LineIndexFile::decode(bytes.substr(0, bytes.size() - 1)).has_value());
+
+    // Pages that do not tile the file are rejected even with a valid checksum
+    auto contents = sampleContents();
+    contents.stamp.fileSize += 1;
+    EXPECT_FALSE(LineIndexFile::decode(LineIndexFile::encode(contents)).has_value());
+}
+
+TEST_F(LineIndexFileTest, StampDetectsContentChanges) {
+    writeLines("line ", 1000);
+    MappedFile original;
+    ASSERT_TRUE(original.open(testFilename));
+    const auto before = LineIndexFile::stamp(testFilename, original);
+
+    // Same size, same modification time, different bytes
+    const auto writeTime = fs::last_write_time(testFilename);
+    writeLines("LINE ", 1000);
+    fs::last_write_time(testFilename, writeTime);
+
+    MappedFile changed;
+    ASSERT_TRUE(changed.open(testFilename));
+    const auto after = LineIndexFile::stamp(testFilename, changed);
+    EXPECT_EQ(after.fileSize, before.fileSize);
+    EXPECT_EQ(after.modificationTime, before.modificationTime);
+    EXPECT_NE(after.fingerprint, before.fingerprint);
+}
+
+TEST_F(LineIndexFileTest, VirtualizedBufferRejectsStaleIndex) {
+    writeLines("line ", 5000);
+    {
+        VirtualizedTextBuffer buffer(testFilename, 100, 4);
+        EXPECT_EQ(buffer.lineCount(), 5000u);
+    }
+    ASSERT_TRUE(fs::exists(indexFilename));
+
+    // Rewrite the file with different line lengths behind the index's back
+    const auto writeTime = fs::last_write_time(testFilename);
+    writeLines("a much longer line than before ", 3000);
+    fs::last_write_time(testFilename, writeTime);
+
+    VirtualizedTextBuffer reopened(testFilename, 100, 4);
+    const VirtualizedTextBuffer& view = reopened;
+    EXPECT_EQ(reopened.lineCount(), 3000u);
+    EXPECT_EQ(view.getLine(2999), "a much longer line than before 2999");
+}
+
+TEST_F(LineIndexFileTest, VirtualizedBufferReusesValidIndex) {
+    writeLines("line ", 5000);
+    {
+        VirtualizedTextBuffer buffer(testFilename, 100, 4);
+    }
+
+    auto contents = LineIndexFile::decode([this]() {
+        std::ifstream in(indexFilename, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }());
+    ASSERT_TRUE(contents.has_value());
+    EXPECT_EQ(contents->pages.size(), 50u);
+    EXPECT_EQ(contents->lineCount, 5000u);
+
+    VirtualizedTextBuffer reopened(testFilename, 100, 4);
+    const VirtualizedTextBuffer& view = reopened;
+    EXPECT_EQ(reopened.lineCount(), 5000u);
+    EXPECT_EQ(view.getLine(4321), "line 4321");
+}
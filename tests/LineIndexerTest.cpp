@@ -0,0 +1,146 @@
+#include "gtest/gtest.h"
+#include "LineIndexer.h"
+#include "MappedFile.h"
+#include <cstdio>       // For std::remove
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Test fixture for LineIndexer tests
+class LineIndexerTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        LineIndexer::setSimdLevel(LineIndexer::SimdLevel::AVX2); // Back to the best supported level
+        std::remove(testFilename.c_str());
+    }
+
+    void writeFile(const std::string& contents) {
+        std::ofstream out(testFilename, std::ios::binary);
+        out << contents;
+    }
+
+    // Reference result computed byte by byte
+    static LineIndexer::Result reference(const std::string& contents, size_t interval) {
+        LineIndexer::Result result;
+        for (size_t i = 0; i < contents.size(); ++i) {
+            if (contents[i] == '\n') {
+                ++result.lineBreaks;
+                if (result.lineBreaks % interval == 0) {
+                    result.boundaries.push_back(i + 1);
+                }
+            }
+        }
+        result.endsWithLineBreak = !contents.empty() && contents.back() == '\n';
+        return result;
+    }
+
+    static std::string randomText(size_t length, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::string text(length, 'x');
+        for (auto& c : text) {
+            unsigned roll = rng() % 100;
+            c = roll < 8 ? '\n' : roll < 10 ? '\r' : static_cast<char>('a' + roll % 26);
+        }
+        return text;
+    }
+
+    const std::string testFilename = "line_indexer_test.txt";
+};
+
+TEST_F(LineIndexerTest, KernelsAgreeWithScalar) {
+    const std::string text = randomText(100003, 7);
+
+    for (auto level : {LineIndexer::SimdLevel::SCALAR, LineIndexer::SimdLevel::SSE2, LineIndexer::SimdLevel::AVX2}) {
+        LineIndexer::setSimdLevel(level);
+        SCOPED_TRACE(LineIndexer::simdLevelName(LineIndexer::simdLevel()));
+
+        // Unaligned starts and odd lengths exercise the scalar tails
+        for (size_t offset : {0u, 1u, 15u, 33u}) {
+            const std::string slice = text.substr(offset, 9999 + offset);
+            const auto expected = reference(slice, 17);
+            EXPECT_EQ(LineIndexer::countLineBreaks(slice.data(), slice.size()), expected.lineBreaks);
+
+            std::vector<uint64_t> found;
+            LineIndexer::findLineBreaks(slice.data(), slice.size(), 16, 17, 0, found);
+            EXPECT_EQ(found, expected.boundaries);
+        }
+    }
+}
+
+TEST_F(LineIndexerTest, ScanIsIndependentOfChunkingAndThreads) {
+    const std::string text = randomText(1 << 20, 11) + "tail without newline";
+    writeFile(text);
+    const auto expected = reference(text, 100);
+
+    MappedFile mapped;
+    MappedFile unmapped;
+    ASSERT_TRUE(mapped.open(testFilename));
+    ASSERT_TRUE(unmapped.open(testFilename, false));
+
+    for (size_t chunkSize : {4096u, 65536u, 1u << 24}) {
+        for (size_t threads : {1u, 3u, 8u}) {
+            LineIndexer::Options options;
+            options.chunkSize = chunkSize;
+            options.threadCount = threads;
+
+            for (const MappedFile* file : {&mapped, &unmapped}) {
+                auto result = LineIndexer::scan(*file, 100, options);
+                EXPECT_EQ(result.lineBreaks, expected.lineBreaks) << chunkSize << "/" << threads;
+                EXPECT_EQ(result.boundaries, expected.boundaries) << chunkSize << "/" << threads;
+                EXPECT_FALSE(result.endsWithLineBreak);
+            }
+        }
+    }
+}
+
+TEST_F(LineIndexerTest, SplitLinesMatchesGetline) {
+    const std::string text = randomText(1 << 20, 13) + "\n\nlast line";
+    writeFile(text);
+
+    std::vector<std::string> expected;
+    std::ifstream in(testFilename, std::ios::binary);
+    for (std::string line; std::getline(in, line);) {
+        expected.push_back(line);
+    }
+
+    MappedFile mapped;
+    MappedFile unmapped;
+    ASSERT_TRUE(mapped.open(testFilename));
+    ASSERT_TRUE(unmapped.open(testFilename, false));
+
+    for (size_t threads : {1u, 4u}) {
+        LineIndexer::Options options;
+        options.chunkSize = 65536;
+        options.threadCount = threads;
+        EXPECT_EQ(LineIndexer::splitLines(mapped, options), expected) << threads;
+        EXPECT_EQ(LineIndexer::splitLines(unmapped, options), expected) << threads;
+    }
+}
+
+TEST_F(LineIndexerTest, SplitLinesHandlesEdges) {
+    for (const std::string& text : {std::string(), std::string("\n"), std::string("a"), std::string("a\n\nb\n")}) {
+        writeFile(text);
+        MappedFile file;
+        ASSERT_TRUE(file.open(testFilename));
+
+        std::vector<std::string> expected;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);) {
+            expected.push_back(line);
+        }
+        EXPECT_EQ(LineIndexer::splitLines(file), expected) << text.size();
+    }
+}
+
+TEST_F(LineIndexerTest, EveryLineBreakCanBeABoundary) {
+    writeFile("a\n\nbc\n");
+    MappedFile file;
+    ASSERT_TRUE(file.open(testFilename));
+
+    auto result = LineIndexer::scan(file, 1);
+    EXPECT_EQ(result.lineBreaks, 3u);
+    EXPECT_EQ(result.boundaries, (std::vector<uint64_t>{2, 3, 6}));
+    EXPECT_TRUE(result.endsWithLineBreak);
+}
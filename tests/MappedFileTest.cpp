@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include "MappedFile.h"
+#include <cstdio>       // For std::remove
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Test fixture for MappedFile tests
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::ofstream out(testFilename, std::ios::binary);
+        for (int i = 0; i < 5000; ++i) {
+            out << "line " << i << '\n';
+            contents += "line " + std::to_string(i) + '\n';
+        }
+    }
+
+    void TearDown() override {
+        std::remove(testFilename.c_str());
+        std::remove(emptyFilename.c_str());
+    }
+
+    const std::string testFilename = "mapped_file_test.txt";
+    const std::string emptyFilename = "mapped_file_empty.txt";
+    std::string contents;
+};
+
+TEST_F(MappedFileTest, MapsWholeFile) {
+    MappedFile file;
+    ASSERT_TRUE(file.open(testFilename));
+    EXPECT_TRUE(file.isMapped());
+    ASSERT_EQ(file.size(), contents.size());
+    EXPECT_EQ(file.view(0, file.size()), contents);
+    EXPECT_EQ(file.view(5, 3), contents.substr(5, 3));
+
+    // Views are clamped to the end of the file
+    EXPECT_EQ(file.view(file.size() - 2, 100), contents.substr(contents.size() - 2));
+}
+
+TEST_F(MappedFileTest, PositionalReadsMatchMapping) {
+    MappedFile mapped;
+    MappedFile unmapped;
+    ASSERT_TRUE(mapped.open(testFilename));
+    ASSERT_TRUE(unmapped.open(testFilename, false));
+    EXPECT_FALSE(unmapped.isMapped());
+    EXPECT_EQ(unmapped.view(0, 10), "");
+
+    std::vector<char> fromMapping(1000);
+    std::vector<char> fromRead(1000);
+    ASSERT_TRUE(mapped.read(1234, fromMapping.size(), fromMapping.data()));
+    ASSERT_TRUE(unmapped.read(1234, fromRead.size(), fromRead.data()));
+    EXPECT_EQ(fromMapping, fromRead);
+    EXPECT_EQ(std::string(fromRead.begin(), fromRead.end()), contents.substr(1234, 1000));
+
+    // Reads past the end fail instead of returning partial data
+    EXPECT_FALSE(unmapped.read(unmapped.size() - 10, 20, fromRead.data()));
+    EXPECT_FALSE(mapped.read(mapped.size() - 10, 20, fromMapping.data()));
+}
+
+TEST_F(MappedFileTest, EmptyAndMissingFiles) {
+    { std::ofstream out(emptyFilename); }
+
+    MappedFile empty;
+    ASSERT_TRUE(empty.open(emptyFilename));
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_FALSE(empty.isMapped());
+    EXPECT_TRUE(empty.view(0, 10).empty());
+
+    MappedFile missing;
+    EXPECT_FALSE(missing.open("mapped_file_does_not_exist.txt"));
+    EXPECT_FALSE(missing.isOpen());
+}
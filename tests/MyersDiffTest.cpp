@@ -0,0 +1,385 @@
+#include "gtest/gtest.h"
+#include "diff/MyersDiff.h"
+#include "Executor.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Check that the changes walk both texts in order and that every equal run
+// really is equal; returns the number of inserted plus deleted lines
+size_t expectValidChanges(const std::vector<DiffChange>& changes,
+                          const std::vector<std::string>& text1,
+                          const std::vector<std::string>& text2)
+{
+    size_t line1 = 0;
+    size_t line2 = 0;
+    size_t edits = 0;
+    for (const auto& change : changes) {
+        EXPECT_EQ(change.startLine1, line1);
+        EXPECT_EQ(change.startLine2, line2);
+        if (change.isEqual()) {
+            EXPECT_EQ(change.lineCount1, change.lineCount2);
+            for (size_t i = 0; i < change.lineCount1 && line1 + i < text1.size() && line2 + i < text2.size(); ++i) {
+                EXPECT_EQ(text1[line1 + i], text2[line2 + i]);
+            }
+        } else {
+            edits += change.lineCount1 + change.lineCount2;
+        }
+        line1 += change.lineCount1;
+        line2 += change.lineCount2;
+    }
+    EXPECT_EQ(line1, text1.size());
+    EXPECT_EQ(line2, text2.size());
+    return edits;
+}
+
+// Edit distance from the longest common subsequence, by dynamic programming
+size_t referenceEdits(const std::vector<std::string>& text1, const std::vector<std::string>& text2)
+{
+    std::vector<std::vector<size_t>> lcs(text1.size() + 1, std::vector<size_t>(text2.size() + 1, 0));
+    for (size_t i = text1.size(); i-- > 0;) {
+        for (size_t j = text2.size(); j-- > 0;) {
+            lcs[i][j] = text1[i] == text2[j] ? lcs[i + 1][j + 1] + 1 : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+        }
+    }
+    return text1.size() + text2.size() - 2 * lcs[0][0];
+}
+
+// The same checks for a character-level diff of two strings
+size_t expectValidStringChanges(const std::vector<DiffChange>& changes,
+                                const std::string& str1,
+                                const std::string& str2)
+{
+    size_t char1 = 0;
+    size_t char2 = 0;
+    size_t edits = 0;
+    for (const auto& change : changes) {
+        EXPECT_FALSE(change.isLineLevel);
+        EXPECT_EQ(change.startChar1, char1);
+        EXPECT_EQ(change.startChar2, char2);
+        if (change.isEqual()) {
+            EXPECT_EQ(change.charCount1, change.charCount2);
+            EXPECT_EQ(str1.substr(char1, change.charCount1), str2.substr(char2, change.charCount2));
+        } else {
+            edits += change.charCount1 + change.charCount2;
+        }
+        char1 += change.charCount1;
+        char2 += change.charCount2;
+    }
+    EXPECT_EQ(char1, str1.size());
+    EXPECT_EQ(char2, str2.size());
+    return edits;
+}
+
+std::vector<std::string> randomLines(std::mt19937& rng, size_t count, int alphabet)
+{
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back("line " + std::to_string(rng() % alphabet));
+    }
+    return lines;
+}
+
+// Diff on four threads with every anchor closing a task of chunkLines
+// lines, and expect exactly the changes of a serial Myers diff; returns
+// the number of chunks the diff was split into
+size_t expectSplitMatchesSerial(const std::vector<std::string>& text1,
+                                const std::vector<std::string>& text2,
+                                size_t chunkLines)
+{
+    MyersDiff serial;
+    const auto expected = serial.computeLineDiff(text1, text2);
+    EXPECT_EQ(serial.getLastParallelChunkCount(), 0u);
+
+    MyersDiff parallel;
+    parallel.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, 4, 1}), 0, chunkLines);
+    const auto changes = parallel.computeLineDiff(text1, text2);
+    expectValidChanges(changes, text1, text2);
+    EXPECT_EQ(changes.size(), expected.size()) << "chunk lines " << chunkLines;
+    for (size_t i = 0; i < std::min(changes.size(), expected.size()); ++i) {
+        EXPECT_EQ(changes[i].type, expected[i].type) << "change " << i;
+        EXPECT_EQ(changes[i].startLine1, expected[i].startLine1) << "change " << i;
+        EXPECT_EQ(changes[i].lineCount1, expected[i].lineCount1) << "change " << i;
+        EXPECT_EQ(changes[i].startLine2, expected[i].startLine2) << "change " << i;
+        EXPECT_EQ(changes[i].lineCount2, expected[i].lineCount2) << "change " << i;
+    }
+    return parallel.getLastParallelChunkCount();
+}
+
+std::vector<std::string> uniqueLines(size_t count)
+{
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back("    line_" + std::to_string(i) + "();");
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(MyersDiffTest, ReplacesModifiedLine)
+{
+    MyersDiff diff;
+    std::vector<std::string> text1 = {"Line 1", "Line 2", "Line 3"};
+    std::vector<std::string> text2 = {"Line 1", "Line 2 modified", "Line 3", "Line 4"};
+
+    auto changes = diff.computeLineDiff(text1, text2);
+    ASSERT_EQ(changes.size(), 4u);
+    EXPECT_TRUE(changes[0].isEqual());
+    EXPECT_TRUE(changes[1].isReplace());
+    EXPECT_EQ(changes[1].startLine1, 1u);
+    EXPECT_EQ(changes[1].startLine2, 1u);
+    EXPECT_TRUE(changes[2].isEqual());
+    EXPECT_TRUE(changes[3].isInsert());
+    EXPECT_EQ(changes[3].startLine2, 3u);
+
+    EXPECT_TRUE(diff.computeLineDiff({}, {}).empty());
+    EXPECT_EQ(expectValidChanges(diff.computeLineDiff({}, text2), {}, text2), text2.size());
+    EXPECT_EQ(expectValidChanges(diff.computeLineDiff(text1, {}), text1, {}), text1.size());
+}
+
+TEST(MyersDiffTest, FindsShortestEditScript)
+{
+    MyersDiff diff;
+    std::mt19937 rng(11);
+    for (int round = 0; round < 2000; ++round) {
+        const int alphabet = 2 + static_cast<int>(rng() % 6);
+        auto text1 = randomLines(rng, rng() % 40, alphabet);
+        auto text2 = randomLines(rng, rng() % 40, alphabet);
+
+        auto changes = diff.computeLineDiff(text1, text2);
+        ASSERT_EQ(expectValidChanges(changes, text1, text2), referenceEdits(text1, text2));
+
+        // Each hunk between equal runs is reported as one change
+        for (size_t i = 0; i + 1 < changes.size(); ++i) {
+            EXPECT_TRUE(changes[i].isEqual() || changes[i + 1].isEqual());
+        }
+    }
+}
+
+TEST(MyersDiffTest, DiffsLargeFilesInLinearSpace)
+{
+    // 200k lines with scattered edits used to need a hash map entry per
+    // diagonal per edit, quadratic in the number of edits
+    MyersDiff diff;
+    std::mt19937 rng(5);
+    std::vector<std::string> text1;
+    for (size_t i = 0; i < 200000; ++i) {
+        text1.push_back("    value_" + std::to_string(i) + " = compute(value_" + std::to_string(i / 2) + ");");
+    }
+    std::vector<std::string> text2 = text1;
+    for (int edit = 0; edit < 2000; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, "    // inserted " + std::to_string(edit)); break;
+            default: text2[line] += " // changed"; break;
+        }
+    }
+
+    auto changes = diff.computeLineDiff(text1, text2);
+    const size_t edits = expectValidChanges(changes, text1, text2);
+    EXPECT_GT(edits, 0u);
+    EXPECT_LE(edits, 4000u);
+}
+
+TEST(MyersDiffTest, DiffsStrings)
+{
+    MyersDiff diff;
+    auto changes = diff.computeStringDiff("the quick brown fox", "the quack brown box");
+
+    std::string rebuilt;
+    const std::string target = "the quack brown box";
+    for (const auto& change : changes) {
+        EXPECT_FALSE(change.isLineLevel);
+        rebuilt += target.substr(change.startChar2, change.charCount2);
+    }
+    EXPECT_EQ(rebuilt, target);
+    ASSERT_FALSE(changes.empty());
+    EXPECT_TRUE(changes.front().isEqual());
+    EXPECT_EQ(changes.front().charCount1, 6u);
+}
+
+TEST(MyersDiffTest, FindsShortestStringEditScript)
+{
+    // Lengths on both sides of the 64 characters the bit-parallel path takes
+    MyersDiff diff;
+    std::mt19937 rng(13);
+    for (int round = 0; round < 1000; ++round) {
+        const char alphabet = static_cast<char>(2 + rng() % 8);
+        auto randomString = [&](size_t length) {
+            std::string text;
+            for (size_t i = 0; i < length; ++i) {
+                text += static_cast<char>('a' + rng() % alphabet);
+            }
+            return text;
+        };
+        const std::string common = randomString(rng() % 40);
+        const std::string str1 = common + randomString(rng() % 120) + common;
+        const std::string str2 = common + randomString(rng() % 120) + common;
+
+        std::vector<std::string> chars1;
+        std::vector<std::string> chars2;
+        for (char c : str1) {
+            chars1.emplace_back(1, c);
+        }
+        for (char c : str2) {
+            chars2.emplace_back(1, c);
+        }
+        auto changes = diff.computeStringDiff(str1, str2);
+        ASSERT_EQ(expectValidStringChanges(changes, str1, str2), referenceEdits(chars1, chars2))
+            << str1 << " / " << str2;
+    }
+}
+
+TEST(MyersDiffTest, ReplacesStringsOverEditLimit)
+{
+    std::string str1 = "var a=1;";
+    std::string str2 = str1;
+    for (int i = 0; i < 500; ++i) {
+        str1 += "f(" + std::to_string(i) + ");";
+        str2 += "g(" + std::to_string(i * 7) + ");";
+    }
+    str1 += "return a;";
+    str2 += "return a;";
+
+    MyersDiff diff;
+    diff.setStringDiffEditLimit(SIZE_MAX);
+    EXPECT_GT(diff.computeStringDiff(str1, str2).size(), 3u);
+
+    // Above the limit the middle becomes one replacement between the common ends
+    diff.setStringDiffEditLimit(1000);
+    auto changes = diff.computeStringDiff(str1, str2);
+    expectValidStringChanges(changes, str1, str2);
+    ASSERT_EQ(changes.size(), 3u);
+    EXPECT_TRUE(changes[0].isEqual());
+    EXPECT_TRUE(changes[1].isReplace());
+    EXPECT_EQ(changes[2].charCount1, 11u);
+
+    // Small diffs stay exact under the same limit
+    std::string str3 = str1;
+    str3[100] = '#';
+    EXPECT_EQ(expectValidStringChanges(diff.computeStringDiff(str1, str3), str1, str3), 2u);
+}
+
+TEST(MyersDiffTest, ParallelDiffIsIndependentOfThreadCount)
+{
+    std::mt19937 rng(9);
+    std::vector<std::string> text1;
+    for (size_t i = 0; i < 150000; ++i) {
+        // Mostly unique lines with the usual repeated braces in between
+        text1.push_back(i % 5 == 0 ? "}" : "    item_" + std::to_string(i) + " = next();");
+    }
+    std::vector<std::string> text2 = text1;
+    for (int edit = 0; edit < 3000; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, "}"); break;
+            default: text2[line] += " // changed"; break;
+        }
+    }
+
+    MyersDiff single;
+    single.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, 1, 1}), 0);
+    const auto expected = single.computeLineDiff(text1, text2);
+    const size_t edits = expectValidChanges(expected, text1, text2);
+
+    for (size_t threads : {2, 3, 8}) {
+        MyersDiff parallel;
+        parallel.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, threads, 1}), 0);
+        auto changes = parallel.computeLineDiff(text1, text2);
+        ASSERT_EQ(changes.size(), expected.size()) << threads << " threads";
+        for (size_t i = 0; i < changes.size(); ++i) {
+            ASSERT_EQ(changes[i].type, expected[i].type) << "change " << i;
+            ASSERT_EQ(changes[i].startLine1, expected[i].startLine1) << "change " << i;
+            ASSERT_EQ(changes[i].lineCount1, expected[i].lineCount1) << "change " << i;
+            ASSERT_EQ(changes[i].startLine2, expected[i].startLine2) << "change " << i;
+            ASSERT_EQ(changes[i].lineCount2, expected[i].lineCount2) << "change " << i;
+        }
+    }
+
+    // Splitting costs at most a few edits over the shortest script
+    MyersDiff minimal;
+    EXPECT_LE(edits, expectValidChanges(minimal.computeLineDiff(text1, text2), text1, text2) * 11 / 10);
+}
+
+TEST(MyersDiffTest, ParallelDiffSplitsIntoSeveralRegions)
+{
+    std::mt19937 rng(17);
+    const auto text1 = uniqueLines(3000);
+    auto text2 = text1;
+    for (int edit = 0; edit < 60; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, "    added_" + std::to_string(edit) + "();"); break;
+            default: text2[line] += " // changed"; break;
+        }
+    }
+
+    EXPECT_GT(expectSplitMatchesSerial(text1, text2, 1), 50u);
+    EXPECT_GT(expectSplitMatchesSerial(text1, text2, 500), 5u);
+}
+
+TEST(MyersDiffTest, ParallelDiffHandlesEditsAtRegionBoundaries)
+{
+    const auto text1 = uniqueLines(100);
+    auto text2 = text1;
+    text2.push_back("    appended();");                           // After the last anchor
+    text2.insert(text2.begin() + 31, {"    a();", "    b();"});  // Right after anchor 30
+    text2.erase(text2.begin() + 29);                              // Right before anchor 30
+    text2[10] = "    replaced();";                                // Between anchors 9 and 11
+    text2.insert(text2.begin() + 60, text1[70]);                  // Line 70 is no longer unique
+    text2.insert(text2.begin(), "    prepended();");              // Before the first anchor
+
+    // Every chunk size puts the boundaries at different anchors
+    for (size_t chunkLines : {1, 2, 3, 5, 1000}) {
+        EXPECT_GE(expectSplitMatchesSerial(text1, text2, chunkLines), 1u);
+    }
+    EXPECT_GT(expectSplitMatchesSerial(text1, text2, 1), 90u);
+}
+
+TEST(MyersDiffTest, ParallelDiffWithoutUniqueLines)
+{
+    // Only repeated lines: there is nothing to split at
+    std::vector<std::string> text1;
+    for (size_t i = 0; i < 600; ++i) {
+        static const char* const lines[] = {"{", "}", "", "return;"};
+        text1.push_back(lines[i % 4]);
+    }
+    auto text2 = text1;
+    text2.erase(text2.begin() + 100, text2.begin() + 103);
+    text2.insert(text2.begin() + 300, {"}", "}"});
+    text2[450] = "{";
+
+    EXPECT_EQ(expectSplitMatchesSerial(text1, text2, 1), 1u);
+}
+
+TEST(MyersDiffTest, SharedEngineDiffsOnSeveralThreads)
+{
+    // One engine, as handed out by the factory, diffing large inputs in
+    // parallel and small ones serially at the same time
+    auto text1 = uniqueLines(2000);
+    auto text2 = text1;
+    text2.erase(text2.begin() + 500, text2.begin() + 510);
+    text2.insert(text2.begin() + 1500, "    inserted();");
+    const std::vector<std::string> small1 = {"a", "b", "c"};
+    const std::vector<std::string> small2 = {"a", "c", "d"};
+
+    MyersDiff engine;
+    engine.setParallelExecutor(std::make_shared<Executor>(Executor::Options{1, 2, 1}), 100, 100);
+    std::thread large([&] {
+        for (int round = 0; round < 20; ++round) {
+            EXPECT_EQ(expectValidChanges(engine.computeLineDiff(text1, text2), text1, text2), 11u);
+        }
+    });
+    for (int round = 0; round < 200; ++round) {
+        EXPECT_EQ(expectValidChanges(engine.computeLineDiff(small1, small2), small1, small2), 2u);
+    }
+    large.join();
+}
@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include "PageCompressor.h"
+#include <random>
+#include <string>
+
+namespace {
+
+std::string sampleText(size_t lineCount)
+{
+    std::string text;
+    for (size_t i = 0; i < lineCount; ++i) {
+        text += "    value_" + std::to_string(i) + " = compute(value_" + std::to_string(i / 2) + ", options);\n";
+    }
+    return text;
+}
+
+void expectRoundTrip(const std::string& input)
+{
+    std::string block = PageCompressor::compress(input);
+    auto output = PageCompressor::decompress(block, input.size());
+    ASSERT_TRUE(output.has_value()) << "input size " << input.size();
+    EXPECT_EQ(*output, input);
+}
+
+} // namespace
+
+TEST(PageCompressorTest, RoundTripsText)
+{
+    const std::string text = sampleText(2000);
+    std::string block = PageCompressor::compress(text);
+
+    // Source code is repetitive; LZ4-style matching should at least halve it
+    EXPECT_LT(block.size(), text.size() / 2);
+    expectRoundTrip(text);
+}
+
+TEST(PageCompressorTest, RoundTripsEdgeCases)
+{
+    expectRoundTrip("");
+    expectRoundTrip("a");
+    expectRoundTrip("abcdabcdabcd");
+    expectRoundTrip("abcdabcdabcdabcdabcd");
+
+    // Long runs produce matches that overlap their own output and lengths past 255
+    expectRoundTrip(std::string(100000, 'x'));
+    expectRoundTrip("header" + std::string(70000, '-') + "footer");
+
+    // Incompressible input must survive too
+    std::mt19937 rng(7);
+    std::string noise(50000, '\0');
+    for (char& c : noise) {
+        c = static_cast<char>(rng());
+    }
+    expectRoundTrip(noise);
+
+    // Matches further back than the 64 KiB window
+    std::string distant = sampleText(100) + noise + sampleText(100);
+    expectRoundTrip(distant);
+}
+
+TEST(PageCompressorTest, RejectsMalformedBlocks)
+{
+    const std::string text = sampleText(200);
+    std::string block = PageCompressor::compress(text);
+
+    EXPECT_FALSE(PageCompressor::decompress(block, text.size() - 1).has_value());
+    EXPECT_FALSE(PageCompressor::decompress(block, text.size() + 1).has_value());
+    EXPECT_FALSE(PageCompressor::decompress(block.substr(0, block.size() / 2), text.size()).has_value());
+
+    // A match reaching before the start of the output
+    std::string badOffset = "\x10" "a" "\x10\x00";
+    EXPECT_FALSE(PageCompressor::decompress(badOffset, 5).has_value());
+}
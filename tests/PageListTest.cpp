@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include "PageList.h"
+#include <vector>
+
+static std::vector<size_t> contents(const PageList& list) {
+    std::vector<size_t> pages;
+    for (size_t page = list.front(); page != PageList::npos; page = list.next(page)) {
+        pages.push_back(page);
+    }
+    return pages;
+}
+
+TEST(PageListTest, KeepsRecencyOrder) {
+    PageList list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.front(), PageList::npos);
+
+    list.pushBack(1);
+    list.pushBack(2);
+    list.pushBack(3);
+    list.pushFront(0);
+    EXPECT_EQ(contents(list), (std::vector<size_t>{0, 1, 2, 3}));
+
+    // Pushing a present page moves it
+    list.pushBack(1);
+    EXPECT_EQ(contents(list), (std::vector<size_t>{0, 2, 3, 1}));
+    list.pushFront(3);
+    EXPECT_EQ(contents(list), (std::vector<size_t>{3, 0, 2, 1}));
+    EXPECT_EQ(list.size(), 4u);
+    EXPECT_EQ(list.back(), 1u);
+}
+
+TEST(PageListTest, EraseAndPop) {
+    PageList list;
+    for (size_t page = 0; page < 5; ++page) {
+        list.pushBack(page);
+    }
+
+    EXPECT_TRUE(list.erase(2));
+    EXPECT_FALSE(list.erase(2));
+    EXPECT_FALSE(list.contains(2));
+    EXPECT_TRUE(list.erase(4));
+    EXPECT_EQ(list.back(), 3u);
+    EXPECT_EQ(list.popFront(), 0u);
+    EXPECT_EQ(contents(list), (std::vector<size_t>{1, 3}));
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.popFront(), PageList::npos);
+    EXPECT_EQ(list.back(), PageList::npos);
+}
+
+TEST(PageListTest, RenumberKeepsOrder) {
+    PageList list;
+    list.pushBack(7);
+    list.pushBack(2);
+    list.pushBack(5);
+
+    list.renumber([](size_t page) { return page >= 5 ? page + 10 : page; });
+    EXPECT_EQ(contents(list), (std::vector<size_t>{17, 2, 15}));
+    EXPECT_TRUE(list.contains(15));
+    EXPECT_FALSE(list.contains(5));
+}
@@ -0,0 +1,244 @@
+#include "gtest/gtest.h"
+#include "PieceTableTextBuffer.h"
+#include "TextBuffer.h"
+#include "EditorError.h"
+#include <cstdio>       // For std::remove
+#include <fstream>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Test fixture for PieceTableTextBuffer tests
+class PieceTableTextBufferTest : public ::testing::Test {
+protected:
+    PieceTableTextBuffer buffer; // Starts with one empty line, like TextBuffer
+};
+
+TEST_F(PieceTableTextBufferTest, StartsWithOneEmptyLine) {
+    EXPECT_FALSE(buffer.isEmpty());
+    EXPECT_EQ(buffer.lineCount(), 1);
+    EXPECT_EQ(buffer.getLine(0), "");
+    EXPECT_TRUE(buffer.getAllLines().empty());
+}
+
+TEST_F(PieceTableTextBufferTest, AddAndInsertLines) {
+    buffer.addLine("Line 1");               // ["", "Line 1"]
+    buffer.insertLine(0, "First");          // ["First", "", "Line 1"]
+    buffer.insertLine(3, "Last");           // ["First", "", "Line 1", "Last"]
+    buffer.insertLines(2, {"A", "B"});      // ["First", "", "A", "B", "Line 1", "Last"]
+
+    std::vector<std::string> expected = {"First", "", "A", "B", "Line 1", "Last"};
+    EXPECT_EQ(buffer.getLines(), expected);
+    EXPECT_EQ(buffer.characterCount(), 17u);
+}
+
+TEST_F(PieceTableTextBufferTest, DeleteLines) {
+    buffer.insertLines(0, {"zero", "one", "two", "three"}); // [..., ""]
+    buffer.deleteLine(4);                   // ["zero", "one", "two", "three"]
+    buffer.deleteLines(1, 3);               // ["zero", "three"]
+
+    std::vector<std::string> expected = {"zero", "three"};
+    EXPECT_EQ(buffer.getLines(), expected);
+
+    buffer.deleteLine(0);
+    buffer.deleteLine(0);                   // Deleting the only line leaves it empty
+    EXPECT_EQ(buffer.lineCount(), 1);
+    EXPECT_EQ(buffer.getLine(0), "");
+}
+
+TEST_F(PieceTableTextBufferTest, CharacterEditingSplitsAndJoinsLines) {
+    buffer.setLine(0, "HelloWorld");
+    buffer.splitLine(0, 5);                 // ["Hello", "World"]
+    ASSERT_EQ(buffer.lineCount(), 2);
+    EXPECT_EQ(buffer.getLine(1), "World");
+
+    buffer.deleteChar(1, 0);                // Backspace at line start joins
+    EXPECT_EQ(buffer.lineCount(), 1);
+    EXPECT_EQ(buffer.getLine(0), "HelloWorld");
+
+    buffer.insertChar(0, 5, ',');
+    buffer.deleteCharForward(0, 0);
+    EXPECT_EQ(buffer.getLine(0), "ello,World");
+}
+
+TEST_F(PieceTableTextBufferTest, MultiLineTextOperations) {
+    buffer.setLine(0, "abcdef");
+    buffer.insertText(0, 3, "X\nY\nZ");     // ["abcX", "Y", "Zdef"]
+    std::vector<std::string> expected = {"abcX", "Y", "Zdef"};
+    EXPECT_EQ(buffer.getLines(), expected);
+    EXPECT_TRUE(buffer.isModified());
+
+    buffer.deleteText(0, 3, 2, 1);          // ["abcdef"]
+    EXPECT_EQ(buffer.lineCount(), 1);
+    EXPECT_EQ(buffer.getLine(0), "abcdef");
+
+    buffer.replaceText(0, 1, 0, 5, "--");
+    EXPECT_EQ(buffer.getLine(0), "a--f");
+    EXPECT_EQ(buffer.getLineSegment(0, 1, 3), "--");
+}
+
+TEST_F(PieceTableTextBufferTest, WritesThroughNonConstGetLineAreKept) {
+    buffer.insertLines(0, {"first", "second"});
+    buffer.getLine(0) += "!";
+    EXPECT_EQ(buffer.lineLength(0), 6u);
+
+    // The pending write must survive a structural edit elsewhere
+    buffer.insertLine(1, "middle");
+    std::vector<std::string> expected = {"first!", "middle", "second", ""};
+    EXPECT_EQ(buffer.getLines(), expected);
+}
+
+TEST_F(PieceTableTextBufferTest, ConstGetLineKeepsRecentReferences) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 10000; ++i) {
+        lines.push_back("line " + std::to_string(i));
+    }
+    buffer.insertLines(0, lines);
+    buffer.getLine(0) = "written"; // Pending writes outlive any number of reads
+    const PieceTableTextBuffer& view = buffer;
+
+    // Scanning the whole buffer releases old copies, but the most recent
+    // reads stay valid together
+    std::vector<const std::string*> recent;
+    for (size_t i = 1; i < lines.size(); ++i) {
+        const std::string& line = view.getLine(i);
+        ASSERT_EQ(line, lines[i]);
+        if (i + 1000 >= lines.size()) {
+            recent.push_back(&line);
+        }
+    }
+    for (size_t k = 0; k < recent.size(); ++k) {
+        EXPECT_EQ(*recent[k], lines[lines.size() - recent.size() + k]);
+    }
+    EXPECT_EQ(view.getLine(0), "written");
+}
+
+TEST_F(PieceTableTextBufferTest, ConcurrentConstReaders) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 2000; ++i) {
+        lines.push_back("row " + std::to_string(i));
+    }
+    buffer.insertLines(0, lines);
+    buffer.getLine(5) = "written"; // Pending write must be visible to readers
+    lines[5] = "written";
+    const PieceTableTextBuffer& view = buffer;
+
+    std::vector<std::thread> readers;
+    std::vector<int> mismatches(4, 0);
+    for (size_t t = 0; t < mismatches.size(); ++t) {
+        readers.emplace_back([&, t]() {
+            for (size_t i = t; i < lines.size(); i += 3) {
+                if (view.getLine(i) != lines[i] || view.lineLength(i) != lines[i].size()) {
+                    ++mismatches[t];
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (int count : mismatches) {
+        EXPECT_EQ(count, 0);
+    }
+}
+
+TEST_F(PieceTableTextBufferTest, ForEachLineMatchesGetLinesAcrossPieces) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 200; ++i) {
+        lines.push_back("line " + std::to_string(i));
+    }
+    buffer.insertLines(0, lines);
+    // Fragment the table so lines span several pieces
+    for (size_t i = 0; i < 200; i += 7) {
+        buffer.insertString(i, 2, "<>");
+        buffer.insertChar(i, buffer.lineLength(i), '!');
+    }
+    buffer.getLine(3) = "pending write";
+    const std::vector<std::string> expected = buffer.getLines();
+    ASSERT_GT(buffer.getPieceCount(), 100u);
+
+    const std::pair<size_t, size_t> ranges[] = {{0, 1000}, {0, 1}, {7, 8}, {50, 120}, {199, 201}, {201, 300}};
+    for (const auto& range : ranges) {
+        std::vector<std::string> visited;
+        const size_t count = buffer.forEachLine(range.first, range.second, [&](size_t index, std::string_view line) {
+            EXPECT_EQ(index, range.first + visited.size());
+            visited.emplace_back(line);
+            return true;
+        });
+        const size_t end = std::min(range.second, expected.size());
+        const size_t begin = std::min(range.first, end);
+        EXPECT_EQ(count, end - begin);
+        EXPECT_EQ(visited, std::vector<std::string>(expected.begin() + begin, expected.begin() + end));
+    }
+
+    // Returning false stops the walk after the current line
+    size_t calls = 0;
+    EXPECT_EQ(buffer.forEachLine(10, 100, [&](size_t, std::string_view) { return ++calls < 3; }), 3u);
+    EXPECT_EQ(calls, 3u);
+}
+
+TEST_F(PieceTableTextBufferTest, ForEachLineHandsOutViewsIntoThePieces) {
+    buffer.insertLines(0, {"alpha", "beta", "gamma"});
+    const char* first = nullptr;
+    const char* second = nullptr;
+    buffer.forEachLine(1, 2, [&](size_t, std::string_view line) { first = line.data(); return true; });
+    buffer.forEachLine(1, 2, [&](size_t, std::string_view line) { second = line.data(); return true; });
+    EXPECT_EQ(first, second); // Same bytes in the add buffer, not a fresh copy
+}
+
+TEST_F(PieceTableTextBufferTest, OutOfRangeThrows) {
+    EXPECT_THROW(buffer.getLine(1), TextBufferException);
+    EXPECT_THROW(buffer.insertLine(2, "x"), TextBufferException);
+    EXPECT_THROW(buffer.insertChar(0, 1, 'x'), TextBufferException);
+    EXPECT_THROW(buffer.joinLines(0), TextBufferException);
+}
+
+TEST_F(PieceTableTextBufferTest, SaveAndLoadRoundTrip) {
+    const std::string filename = "piece_table_roundtrip.txt";
+    {
+        std::ofstream out(filename);
+        out << "alpha\nbeta\n\ngamma\n";
+    }
+
+    ASSERT_TRUE(buffer.loadFromFile(filename));
+    std::vector<std::string> expected = {"alpha", "beta", "", "gamma"};
+    EXPECT_EQ(buffer.getLines(), expected);
+
+    buffer.insertText(1, 4, "!");
+    ASSERT_TRUE(buffer.saveToFile(filename));
+
+    TextBuffer reference;
+    ASSERT_TRUE(reference.loadFromFile(filename));
+    EXPECT_EQ(reference.getLines(), buffer.getLines());
+
+    std::remove(filename.c_str());
+}
+
+// Random edit sequences must leave both implementations with identical content
+TEST_F(PieceTableTextBufferTest, MatchesTextBufferOnRandomEdits) {
+    TextBuffer reference;
+    std::mt19937 rng(1234);
+
+    for (int step = 0; step < 2000; ++step) {
+        const size_t lines = reference.lineCount();
+        const size_t line = rng() % lines;
+        const size_t col = rng() % (reference.lineLength(line) + 1);
+        const std::string text = "t" + std::to_string(step);
+
+        switch (rng() % 7) {
+            case 0: reference.insertLine(line, text); buffer.insertLine(line, text); break;
+            case 1: reference.deleteLine(line); buffer.deleteLine(line); break;
+            case 2: reference.insertText(line, col, text); buffer.insertText(line, col, text); break;
+            case 3: reference.splitLine(line, col); buffer.splitLine(line, col); break;
+            case 4: reference.deleteChar(line, col); buffer.deleteChar(line, col); break;
+            case 5: reference.deleteCharForward(line, col); buffer.deleteCharForward(line, col); break;
+            case 6: reference.replaceLine(line, text); buffer.replaceLine(line, text); break;
+        }
+
+        ASSERT_EQ(buffer.lineCount(), reference.lineCount()) << "step " << step;
+        ASSERT_EQ(buffer.characterCount(), reference.characterCount()) << "step " << step;
+    }
+    EXPECT_EQ(buffer.getLines(), reference.getLines());
+}
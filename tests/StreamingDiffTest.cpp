@@ -0,0 +1,279 @@
+#include "gtest/gtest.h"
+#include "diff/StreamingDiff.h"
+#include "diff/HistogramDiff.h"
+#include "TextBuffer.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+class VectorLineSource : public LineSource {
+public:
+    explicit VectorLineSource(const std::vector<std::string>& lines)
+        : lines_(lines) {
+    }
+
+    bool nextLine(std::string& line) override {
+        if (next_ == lines_.size()) {
+            return false;
+        }
+        line = lines_[next_++];
+        return true;
+    }
+
+private:
+    const std::vector<std::string>& lines_;
+    size_t next_ = 0;
+};
+
+// Stream text1 against text2 and check that the changes walk both texts in
+// order, that equal runs are equal and that the reported text matches;
+// returns the number of inserted plus deleted lines
+size_t expectValidStream(const std::vector<std::string>& text1,
+                         const std::vector<std::string>& text2,
+                         size_t windowLines)
+{
+    VectorLineSource source1(text1);
+    VectorLineSource source2(text2);
+    StreamingDiff diff(nullptr, windowLines);
+
+    size_t line1 = 0;
+    size_t line2 = 0;
+    size_t edits = 0;
+    bool finished = diff.run(source1, source2, [&](const DiffChange& change, const StreamingDiff::ChangeText& text) {
+        EXPECT_EQ(change.startLine1, line1);
+        EXPECT_EQ(change.startLine2, line2);
+        EXPECT_TRUE(change.lineCount1 > 0 || change.lineCount2 > 0);
+        for (size_t i = 0; i < change.lineCount1; ++i) {
+            EXPECT_EQ(text.lines1[i], text1[line1 + i]);
+        }
+        for (size_t i = 0; i < change.lineCount2; ++i) {
+            EXPECT_EQ(text.lines2[i], text2[line2 + i]);
+        }
+        if (change.isEqual()) {
+            EXPECT_EQ(change.lineCount1, change.lineCount2);
+            for (size_t i = 0; i < change.lineCount1; ++i) {
+                EXPECT_EQ(text1[line1 + i], text2[line2 + i]);
+            }
+        } else {
+            edits += change.lineCount1 + change.lineCount2;
+        }
+        line1 += change.lineCount1;
+        line2 += change.lineCount2;
+        return !::testing::Test::HasFailure();
+    });
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(line1, text1.size());
+    EXPECT_EQ(line2, text2.size());
+    return edits;
+}
+
+std::vector<std::string> numberedLines(size_t count, const std::string& prefix)
+{
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back(prefix + std::to_string(i));
+    }
+    return lines;
+}
+
+std::string writeTempFile(const std::string& name, const std::string& contents)
+{
+    std::ofstream file(name, std::ios::binary);
+    file << contents;
+    return name;
+}
+
+} // namespace
+
+TEST(StreamingDiffTest, MatchesWholeTextDiffOnScatteredEdits)
+{
+    std::mt19937 rng(3);
+    auto text1 = numberedLines(5000, "line ");
+    for (size_t i = 0; i < text1.size(); i += 7) {
+        text1[i] = "}";
+    }
+    auto text2 = text1;
+    for (int edit = 0; edit < 100; ++edit) {
+        const size_t line = rng() % text2.size();
+        switch (rng() % 3) {
+            case 0: text2.erase(text2.begin() + line); break;
+            case 1: text2.insert(text2.begin() + line, "inserted " + std::to_string(edit)); break;
+            default: text2[line] += " changed"; break;
+        }
+    }
+
+    MyersDiff whole;
+    size_t shortest = 0;
+    for (const auto& change : whole.computeLineDiff(text1, text2)) {
+        if (!change.isEqual()) {
+            shortest += change.lineCount1 + change.lineCount2;
+        }
+    }
+
+    // Edits far apart relative to the window are found exactly
+    EXPECT_EQ(expectValidStream(text1, text2, 1024), shortest);
+    EXPECT_LE(expectValidStream(text1, text2, 64), shortest * 2);
+    expectValidStream(text1, {}, 64);
+    expectValidStream({}, text2, 64);
+    expectValidStream({}, {}, 64);
+}
+
+TEST(StreamingDiffTest, ResynchronizesAfterChangesLongerThanWindow)
+{
+    const size_t window = 100;
+    auto text1 = numberedLines(3000, "line ");
+    auto inserted = numberedLines(730, "new ");
+
+    // Long insertions, deletions and replacements are passed at the cost of
+    // a bounded multiple of their length, and the windows line up after them
+    auto text2 = text1;
+    text2.insert(text2.begin() + 1000, inserted.begin(), inserted.end());
+    EXPECT_LE(expectValidStream(text1, text2, window), 8 * inserted.size());
+    EXPECT_LE(expectValidStream(text2, text1, window), 8 * inserted.size());
+
+    auto replaced = text1;
+    std::copy(inserted.begin(), inserted.end(), replaced.begin() + 1000);
+    EXPECT_LE(expectValidStream(text1, replaced, window), 8 * 2 * inserted.size());
+
+    // Shorter than a window, an insertion is found exactly
+    text2.erase(text2.begin() + 1050, text2.begin() + 1000 + inserted.size());
+    EXPECT_EQ(expectValidStream(text1, text2, window), 50u);
+}
+
+TEST(StreamingDiffTest, StopsWhenCallbackReturnsFalse)
+{
+    auto text1 = numberedLines(1000, "a ");
+    auto text2 = numberedLines(1000, "b ");
+    VectorLineSource source1(text1);
+    VectorLineSource source2(text2);
+    StreamingDiff diff(nullptr, 50);
+
+    size_t calls = 0;
+    EXPECT_FALSE(diff.run(source1, source2, [&](const DiffChange&, const StreamingDiff::ChangeText&) {
+        return ++calls < 3;
+    }));
+    EXPECT_EQ(calls, 3u);
+}
+
+TEST(StreamingDiffTest, ReadsLinesFromFilesAndBuffers)
+{
+    const std::string contents = "first\n\nthird line\r\nlast without newline";
+    const std::string path = writeTempFile("streaming_diff_test.txt", contents);
+    const std::vector<std::string> expected = {"first", "", "third line\r", "last without newline"};
+
+    for (bool allowMapping : {true, false}) {
+        MappedFile file;
+        ASSERT_TRUE(file.open(path, allowMapping));
+        MappedFileLineSource source(file, 4);
+        std::vector<std::string> lines;
+        std::string line;
+        while (source.nextLine(line)) {
+            lines.push_back(line);
+        }
+        EXPECT_EQ(lines, expected) << "allowMapping " << allowMapping;
+    }
+
+    TextBuffer buffer;
+    buffer.clear(false);
+    for (const auto& line : expected) {
+        buffer.addLine(line);
+    }
+    TextBufferLineSource bufferSource(buffer, 3);
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    MappedFileLineSource fileSource(file);
+
+    UnifiedDiffBuilder output;
+    StreamingDiff diff;
+    EXPECT_TRUE(diff.run(bufferSource, fileSource, [&](const DiffChange& change, const StreamingDiff::ChangeText& text) {
+        output.add(change, text.lines1, text.lines2);
+        return true;
+    }));
+    output.finish();
+    EXPECT_TRUE(output.lines().empty());
+    std::remove(path.c_str());
+}
+
+TEST(StreamingDiffTest, FormatsUnifiedHunks)
+{
+    auto text1 = numberedLines(40, "line ");
+    auto text2 = text1;
+    text2[5] = "changed 5";
+    text2[9] = "changed 9";
+    text2.erase(text2.begin() + 30);
+
+    VectorLineSource source1(text1);
+    VectorLineSource source2(text2);
+    UnifiedDiffBuilder output;
+    StreamingDiff(nullptr, 8).run(source1, source2, [&](const DiffChange& change, const StreamingDiff::ChangeText& text) {
+        output.add(change, text.lines1, text.lines2);
+        return true;
+    });
+    output.finish();
+
+    // The first two changes share a hunk; the deletion gets its own
+    const std::vector<std::string> expected = {
+        "@@ -3,11 +3,11 @@",
+        " line 2", " line 3", " line 4", "-line 5", "+changed 5", " line 6", " line 7", " line 8",
+        "-line 9", "+changed 9", " line 10", " line 11", " line 12",
+        "@@ -28,7 +28,6 @@",
+        " line 27", " line 28", " line 29", "-line 30", " line 31", " line 32", " line 33"};
+    EXPECT_EQ(output.lines(), expected);
+}
+
+// Editor::showDiff formats through IDiffEngine::formatUnifiedDiff and
+// Editor::diffWithFile streams into a UnifiedDiffBuilder; both must agree
+TEST(StreamingDiffTest, FormatUnifiedDiffMatchesStreamingOutput)
+{
+    const auto base = numberedLines(60, "line ");
+    std::vector<std::pair<std::vector<std::string>, std::vector<std::string>>> cases;
+    cases.emplace_back(base, base);
+    cases.emplace_back(std::vector<std::string>(), base);
+    cases.emplace_back(base, std::vector<std::string>());
+
+    auto edited = base;
+    edited.insert(edited.begin(), "new first");
+    edited[20] = "changed";
+    edited.insert(edited.begin() + 24, {"a", "b"});
+    edited.erase(edited.begin() + 40, edited.begin() + 43);
+    edited.push_back("new last");
+    cases.emplace_back(base, edited);
+    cases.emplace_back(edited, base);
+
+    std::mt19937 rng(7);
+    auto random = base;
+    for (int i = 0; i < 15; ++i) {
+        const size_t at = rng() % random.size();
+        if (rng() % 2) {
+            random[at] = "random " + std::to_string(i);
+        } else {
+            random.erase(random.begin() + static_cast<std::ptrdiff_t>(at));
+        }
+    }
+    cases.emplace_back(base, random);
+
+    for (size_t contextLines : {0u, 1u, 3u}) {
+        for (const auto& engine : {IDiffEnginePtr(std::make_shared<MyersDiff>()),
+                                   IDiffEnginePtr(std::make_shared<HistogramDiff>())}) {
+            for (size_t i = 0; i < cases.size(); ++i) {
+                const auto& [text1, text2] = cases[i];
+                const std::string whole = engine->formatUnifiedDiff(engine->computeLineDiff(text1, text2),
+                                                                    text1, text2, contextLines);
+
+                VectorLineSource source1(text1);
+                VectorLineSource source2(text2);
+                UnifiedDiffBuilder output(contextLines);
+                StreamingDiff(engine).run(source1, source2, [&](const DiffChange& change, const StreamingDiff::ChangeText& text) {
+                    output.add(change, text.lines1, text.lines2);
+                    return true;
+                });
+                output.finish();
+                EXPECT_EQ(whole, output.str()) << "case " << i << ", context " << contextLines;
+            }
+        }
+    }
+}
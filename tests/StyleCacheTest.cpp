@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+#include "StyleCache.h"
+#include <vector>
+
+namespace {
+
+std::vector<SyntaxStyle> sampleStyles(size_t line, size_t count)
+{
+    std::vector<SyntaxStyle> styles;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t start = i * 8 + line % 4;
+        styles.emplace_back(start, start + 5, static_cast<SyntaxColor>((line + i) % 10));
+    }
+    return styles;
+}
+
+void expectStyles(const std::vector<SyntaxStyle>& actual, const std::vector<SyntaxStyle>& expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].startCol, expected[i].startCol) << "span " << i;
+        EXPECT_EQ(actual[i].endCol, expected[i].endCol) << "span " << i;
+        EXPECT_EQ(actual[i].color, expected[i].color) << "span " << i;
+    }
+}
+
+LexerState commentState()
+{
+    LexerState state;
+    state.set(LexerState::IN_BLOCK_COMMENT, true);
+    return state;
+}
+
+} // namespace
+
+TEST(StyleCacheTest, RoundTripsStylesAndStates)
+{
+    StyleCache cache;
+    for (size_t line = 0; line < 3000; line += 3) {
+        cache.store(line, sampleStyles(line, line % 7), LexerState(), line % 2 ? commentState() : LexerState());
+    }
+
+    EXPECT_EQ(cache.cachedLineCount(), 1000u);
+    EXPECT_EQ(cache.validLineCount(), 1000u);
+    for (size_t line = 0; line < 3000; ++line) {
+        if (line % 3 != 0) {
+            EXPECT_FALSE(cache.contains(line));
+            EXPECT_TRUE(cache.styles(line).empty());
+            continue;
+        }
+        ASSERT_TRUE(cache.isValid(line));
+        expectStyles(cache.styles(line), sampleStyles(line, line % 7));
+        EXPECT_EQ(cache.endState(line), line % 2 ? commentState() : LexerState());
+        EXPECT_EQ(cache.startState(line), LexerState());
+    }
+    EXPECT_FALSE(cache.contains(1000000));
+}
+
+TEST(StyleCacheTest, KeepsWideLinesUnpacked)
+{
+    StyleCache cache;
+    std::vector<SyntaxStyle> wide{{10, 20, SyntaxColor::Keyword}, {70000, 70100, SyntaxColor::String}};
+    cache.store(5, wide, LexerState(), LexerState());
+    cache.store(6, sampleStyles(6, 3), LexerState(), LexerState());
+
+    expectStyles(cache.styles(5), wide);
+    expectStyles(cache.styles(6), sampleStyles(6, 3));
+
+    // Storing a packable line over a wide one moves it back into the arena
+    cache.store(5, sampleStyles(5, 2), LexerState(), LexerState());
+    expectStyles(cache.styles(5), sampleStyles(5, 2));
+    EXPECT_EQ(cache.cachedLineCount(), 2u);
+}
+
+TEST(StyleCacheTest, InvalidatesByGeneration)
+{
+    StyleCache cache;
+    for (size_t line = 0; line < 100; ++line) {
+        cache.store(line, sampleStyles(line, 2), LexerState(), LexerState());
+    }
+
+    cache.invalidate(10);
+    EXPECT_FALSE(cache.isValid(10));
+    EXPECT_TRUE(cache.contains(10));
+    EXPECT_EQ(cache.validLineCount(), 99u);
+
+    cache.invalidateAll();
+    EXPECT_EQ(cache.validLineCount(), 0u);
+    EXPECT_EQ(cache.cachedLineCount(), 100u);
+
+    // Stale lines keep their states, so re-lexing can stop where they match
+    cache.store(20, sampleStyles(20, 1), LexerState(), commentState());
+    EXPECT_TRUE(cache.isValid(20));
+    EXPECT_FALSE(cache.isValid(21));
+    EXPECT_EQ(cache.endState(20), commentState());
+    expectStyles(cache.styles(21), sampleStyles(21, 2));
+}
+
+TEST(StyleCacheTest, ReusesArenaWhenLinesAreRehighlighted)
+{
+    StyleCache cache;
+    for (size_t line = 0; line < 1000; ++line) {
+        cache.store(line, sampleStyles(line, 8), LexerState(), LexerState());
+    }
+    const size_t baseline = cache.memoryUsage();
+
+    // Shrinking lines in place and growing them again must not let the arena
+    // grow without bound; dead spans are compacted once they match the live
+    // ones, so the arena peaks at twice its size plus vector growth slack
+    for (int round = 0; round < 50; ++round) {
+        for (size_t line = 0; line < 1000; ++line) {
+            cache.store(line, sampleStyles(line, round % 2 ? 8 : 4), LexerState(), LexerState());
+        }
+    }
+    EXPECT_LE(cache.memoryUsage(), baseline * 5);
+    for (size_t line = 0; line < 1000; ++line) {
+        expectStyles(cache.styles(line), sampleStyles(line, 8));
+    }
+}
+
+TEST(StyleCacheTest, EvictsWithClockAndKeepsRange)
+{
+    StyleCache cache;
+    for (size_t line = 0; line < 5000; ++line) {
+        cache.store(line, sampleStyles(line, 3), LexerState(), LexerState());
+    }
+
+    // Every line was just stored, so the first sweep only clears their bits
+    // before the second one drops lines
+    const size_t dropped = cache.evict(2000, 4000, 4499);
+    EXPECT_EQ(dropped, 3000u);
+    EXPECT_EQ(cache.cachedLineCount(), 2000u);
+    for (size_t line = 4000; line < 4500; ++line) {
+        ASSERT_TRUE(cache.isValid(line)) << line;
+        expectStyles(cache.styles(line), sampleStyles(line, 3));
+    }
+
+    // A line read since the last sweep gets a second chance
+    size_t survivor = 0;
+    while (!cache.contains(survivor)) {
+        ++survivor;
+    }
+    cache.touch(survivor);
+    cache.evict(1999, 4000, 4499);
+    EXPECT_TRUE(cache.contains(survivor));
+    EXPECT_EQ(cache.cachedLineCount(), 1999u);
+
+    cache.evict(0, 1, 0);
+    EXPECT_EQ(cache.cachedLineCount(), 0u);
+    EXPECT_EQ(cache.validLineCount(), 0u);
+}
@@ -10,6 +10,9 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <future>
+#include <cctype>
+#include <regex>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -22,6 +25,8 @@
 
 #include "gtest/gtest.h"
 #include "../src/TextBuffer.h"
+#include "../src/ThreadPool.h"
+#include "../src/SyntaxHighlightingManager.h"
 
 // Define our own min/max functions to avoid issues with Windows macros
 template<typename T>
@@ -512,4 +517,473 @@ TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkConcurrentAccess) {
     // Ensure results are reasonable
     ASSERT_GT(combinedResult.totalTimeMs, 0);
     ASSERT_GT(combinedResult.totalStyles, 0);
-} 
\ No newline at end of file
+} 
+// Highlighting and indexing submit bursts of tiny tasks to the ThreadPool;
+// this measures how fast the pool gets through them
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkThreadPoolTaskBursts) {
+    const size_t lineCount = 2000;
+    const size_t burstCount = 50;
+    
+    HighlightingBenchmark::generateRandomFile(*buffer_, lineCount, 80);
+    ThreadPool pool(4);
+    
+    // One task per line, each counting the identifier characters in it, the
+    // way a per-line highlight task scans its line
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t totalCount = 0;
+    for (size_t burst = 0; burst < burstCount; ++burst) {
+        std::vector<std::future<size_t>> futures;
+        futures.reserve(lineCount);
+        for (size_t line = 0; line < lineCount; ++line) {
+            futures.push_back(pool.submit(ThreadPool::Priority::NORMAL, [this, line]() {
+                const std::string& text = buffer_->getLine(line);
+                return static_cast<size_t>(std::count_if(text.begin(), text.end(), [](char c) {
+                    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+                }));
+            }));
+        }
+        for (auto& future : futures) {
+            totalCount += future.get();
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    
+    const double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+    const double tasks = static_cast<double>(lineCount * burstCount);
+    std::cout << "ThreadPool bursts: " << static_cast<size_t>(tasks) << " tasks in " << totalMs << " ms ("
+              << std::fixed << std::setprecision(0) << tasks / (totalMs / 1000.0) << " tasks/s, "
+              << std::setprecision(2) << totalMs * 1000000.0 / tasks << " ns/task)" << std::endl;
+    
+    ASSERT_GT(totalCount, 0u);
+    EXPECT_EQ(pool.getQueueSize(), 0u);
+}
+
+// Benchmark how long LOW tasks wait while HIGH tasks keep the pool saturated,
+// as background indexing does while the user holds page-down
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkLowPriorityLatencyUnderHighLoad) {
+    const auto loadDuration = std::chrono::milliseconds(600);
+    const size_t lowTaskCount = 10;
+    const size_t highTaskChains = 8;
+    
+    auto run = [&](std::chrono::milliseconds agingInterval) {
+        ThreadPool pool(2);
+        pool.setAgingInterval(agingInterval);
+        
+        // Each HIGH task spins for about 50 us, like highlighting one line,
+        // then queues its successor, so HIGH work never runs out until the
+        // load stops no matter how the submitting thread is scheduled
+        const auto start = std::chrono::steady_clock::now();
+        std::function<void()> highTask = [&]() {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+            if (std::chrono::steady_clock::now() - start < loadDuration) {
+                pool.submit(ThreadPool::Priority::HIGH, highTask);
+            }
+        };
+        for (size_t i = 0; i < highTaskChains; ++i) {
+            pool.submit(ThreadPool::Priority::HIGH, highTask);
+        }
+        
+        std::vector<std::future<double>> lowTasks;
+        for (size_t i = 0; i < lowTaskCount; ++i) {
+            lowTasks.push_back(pool.submit(ThreadPool::Priority::LOW, [start]() {
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }));
+        }
+        
+        double worstMs = 0.0;
+        for (auto& task : lowTasks) {
+            worstMs = std::max(worstMs, task.get());
+        }
+        
+        // Let the chains run out before the pool goes away
+        while (std::chrono::steady_clock::now() - start < loadDuration || pool.getQueueSize() > 0 ||
+               pool.getActiveThreadCount() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return worstMs;
+    };
+    
+    const double withAging = run(std::chrono::milliseconds(100));
+    const double withoutAging = run(std::chrono::milliseconds(0));
+    std::cout << "LOW task latency under HIGH load: " << std::fixed << std::setprecision(1)
+              << withAging << " ms with 100 ms aging, " << withoutAging << " ms without aging" << std::endl;
+    
+    // Without aging the LOW tasks only run once the load stops
+    EXPECT_LT(withAging, static_cast<double>(loadDuration.count()));
+    EXPECT_GE(withoutAging, static_cast<double>(loadDuration.count()));
+}
+
+// Highlighter that spins for a while per line and records whether each line
+// it was asked for was near the visible range at the time
+class ScrollTrackingHighlighter : public SyntaxHighlighter {
+public:
+    std::atomic<size_t> visibleStart{0};
+    std::atomic<size_t> visibleEnd{0};
+    size_t contextLines = SyntaxHighlightingManager::DEFAULT_CONTEXT_LINES;
+    mutable std::atomic<size_t> linesHighlighted{0};
+    mutable std::atomic<size_t> linesOffscreen{0};
+    
+    std::unique_ptr<std::vector<SyntaxStyle>> highlightLine(const std::string& line, size_t lineIndex) const override {
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        
+        linesHighlighted++;
+        if (lineIndex + contextLines < visibleStart.load() || lineIndex > visibleEnd.load() + contextLines) {
+            linesOffscreen++;
+        }
+        
+        auto styles = std::make_unique<std::vector<SyntaxStyle>>();
+        styles->emplace_back(0, line.size(), SyntaxColor::Default);
+        return styles;
+    }
+    
+    std::vector<std::vector<SyntaxStyle>> highlightBuffer(const ITextBuffer&) const override {
+        return {};
+    }
+    
+    std::vector<std::string> getSupportedExtensions() const override {
+        return {"scroll"};
+    }
+    
+    std::string getLanguageName() const override {
+        return "ScrollTracking";
+    }
+};
+
+// Benchmark how much background highlighting is spent on lines that have
+// already scrolled out of view when the user flings through a large file
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkWastedWorkWhileScrolling) {
+    const size_t lineCount = 20000;
+    const size_t viewportLines = 50;
+    const size_t scrollStep = 40;
+    const size_t scrollSteps = 300;
+    
+    HighlightingBenchmark::generateRandomFile(*buffer_, lineCount, 80);
+    auto highlighter = std::make_shared<ScrollTrackingHighlighter>();
+    
+    Executor::Options options;
+    options.interactiveThreads = 1;
+    options.backgroundThreads = 1;
+    options.ioThreads = 1;
+    
+    auto executor = std::make_shared<Executor>(options);
+    SyntaxHighlightingManager::BackgroundStats stats;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        SyntaxHighlightingManager manager(executor);
+        manager.setHighlighter(highlighter);
+        manager.setBuffer(buffer_.get());
+        
+        // One viewport step every 500 us, faster than a viewport can be highlighted
+        size_t top = 0;
+        for (size_t step = 0; step < scrollSteps; ++step) {
+            top = (step * scrollStep) % (lineCount - viewportLines);
+            highlighter->visibleStart = top;
+            highlighter->visibleEnd = top + viewportLines - 1;
+            manager.setVisibleRange(top, top + viewportLines - 1);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        
+        // Let the background work finish before the manager goes away
+        auto busy = [&executor]() {
+            auto metrics = executor->metrics(Executor::Lane::Interactive);
+            return metrics.queueDepth > 0 || metrics.activeThreads > 0;
+        };
+        while (busy()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stats = manager.getBackgroundStats();
+    }
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    const size_t highlighted = highlighter->linesHighlighted.load();
+    const size_t offscreen = highlighter->linesOffscreen.load();
+    const double wastedPercent = highlighted > 0 ? 100.0 * static_cast<double>(offscreen) / highlighted : 0.0;
+    
+    std::cout << "Scrolling " << scrollSteps << " viewports through " << lineCount << " lines: "
+              << highlighted << " lines highlighted, " << offscreen << " off screen ("
+              << std::fixed << std::setprecision(1) << wastedPercent << "% wasted) in " << elapsedMs << " ms" << std::endl;
+    std::cout << "  Range tasks: " << stats.rangeTasksSubmitted << " submitted, " << stats.rangeTasksDeduplicated
+              << " deduplicated, " << stats.rangeTasksCoalesced << " coalesced, " << stats.rangeTasksCancelled
+              << " cancelled" << std::endl;
+    
+    ASSERT_GT(highlighted, 0u);
+    EXPECT_EQ(stats.linesHighlighted, highlighted);
+    EXPECT_GT(stats.rangeTasksCoalesced + stats.rangeTasksCancelled, 0u);
+    EXPECT_LT(wastedPercent, 50.0);
+}
+
+// C++ highlighter that counts the lines it lexes
+class CountingCppHighlighter : public CppHighlighter {
+public:
+    mutable std::atomic<size_t> linesLexed{0};
+    
+    std::unique_ptr<std::vector<SyntaxStyle>> highlightLineFrom(
+        const std::string& line, size_t lineIndex, LexerState& state) const override {
+        linesLexed++;
+        return CppHighlighter::highlightLineFrom(line, lineIndex, state);
+    }
+};
+
+// Benchmark how many lines are re-lexed per keystroke in a large C++ file,
+// and how far an edit that opens or closes a block comment reaches
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkIncrementalRelexOnEdit) {
+    const size_t lineCount = 50000;
+    const size_t cachedLines = 2000;
+    const size_t editLine = 1000;
+    const size_t keystrokes = 100;
+    
+    buffer_->clear(false);
+    for (size_t i = 0; i < lineCount; ++i) {
+        buffer_->addLine("    int value" + std::to_string(i) + " = compute(" + std::to_string(i) + "); // step");
+    }
+    
+    auto highlighter = std::make_shared<CountingCppHighlighter>();
+    SyntaxHighlightingManager manager;
+    manager.setHighlighter(highlighter);
+    manager.setBuffer(buffer_.get());
+    manager.setContextLines(0);
+    manager.setHighlightingTimeout(10000);
+    
+    // Highlight the top of the file so the lines after the edit are cached
+    manager.getHighlightingStyles(0, cachedLines - 1);
+    const size_t initialLines = highlighter->linesLexed.exchange(0);
+    
+    auto viewport = [&]() {
+        return manager.getHighlightingStyles(editLine - 30, editLine + 30);
+    };
+    
+    // Type characters into one line
+    std::string text = buffer_->getLine(editLine);
+    const auto typingStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keystrokes; ++i) {
+        text.insert(4, 1, 'x');
+        buffer_->replaceLine(editLine, text);
+        manager.invalidateLine(editLine);
+        viewport();
+    }
+    const double typingMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - typingStart).count();
+    const size_t typingLines = highlighter->linesLexed.exchange(0);
+    
+    // Open a block comment, then close it again
+    buffer_->replaceLine(editLine, "/* " + text);
+    manager.invalidateLine(editLine);
+    viewport();
+    const size_t openLines = highlighter->linesLexed.exchange(0);
+    auto commented = manager.getHighlightingStyles(cachedLines - 1, cachedLines - 1);
+    
+    buffer_->replaceLine(editLine, text);
+    manager.invalidateLine(editLine);
+    viewport();
+    const size_t closeLines = highlighter->linesLexed.exchange(0);
+    auto uncommented = manager.getHighlightingStyles(cachedLines - 1, cachedLines - 1);
+    
+    std::cout << "Incremental re-lexing in a " << lineCount << "-line C++ file (" << cachedLines
+              << " lines cached, " << initialLines << " lexed initially):" << std::endl;
+    std::cout << "  Typing: " << std::fixed << std::setprecision(2)
+              << static_cast<double>(typingLines) / keystrokes << " lines re-lexed per keystroke, "
+              << typingMs / keystrokes << " ms per keystroke" << std::endl;
+    std::cout << "  Opening a block comment: " << openLines << " lines re-lexed" << std::endl;
+    std::cout << "  Closing it again: " << closeLines << " lines re-lexed" << std::endl;
+    
+    EXPECT_EQ(typingLines, keystrokes);
+    EXPECT_EQ(openLines, cachedLines - editLine);
+    EXPECT_EQ(closeLines, cachedLines - editLine);
+    
+    // Lines far below the edit follow the comment state
+    ASSERT_EQ(commented.size(), 1u);
+    ASSERT_FALSE(commented[0].empty());
+    EXPECT_EQ(commented[0][0].color, SyntaxColor::Comment);
+    ASSERT_EQ(uncommented.size(), 1u);
+    ASSERT_FALSE(uncommented[0].empty());
+    EXPECT_NE(uncommented[0][0].color, SyntaxColor::Comment);
+}
+
+// The C++ patterns as std::regex, applied the way PatternBasedHighlighter
+// applied them before its rules were compiled into scanners
+class RegexCppPatterns {
+public:
+    RegexCppPatterns() {
+        add("\\b(if|else|for|while|do|switch|case|default|break|continue|return|goto|try|catch|throw|new|delete|operator|template|typename|this|friend|explicit|inline|virtual|static|const|constexpr|volatile|mutable|extern|auto|decltype|namespace|using|asm|typedef|sizeof|alignas|alignof|noexcept|static_assert|thread_local)\\b", SyntaxColor::Keyword);
+        add("\\b(void|bool|char|char16_t|char32_t|wchar_t|short|int|long|float|double|signed|unsigned)\\b", SyntaxColor::Type);
+        add("\\b(class|struct|enum|union)\\b", SyntaxColor::Type);
+        add("\\b([0-9]+(\\.[0-9]*)?|\\.[0-9]+)([uUlLfF]|[eE][-+]?[0-9]+)?\\b", SyntaxColor::Number);
+        add(R"(\'(?:[^\'\\]|\\.)*\')", SyntaxColor::String);
+        add(R"(\"(?:[^\"\\]|\\.)*\")", SyntaxColor::String);
+        add("\\b(true|false|nullptr)\\b", SyntaxColor::Keyword);
+        add("^\\s*#\\s*(define|include|if|ifdef|ifndef|else|elif|endif|pragma|line|error|warning)(?:\\b|\\s|$)", SyntaxColor::Preprocessor);
+        add("\\b([a-zA-Z_][a-zA-Z0-9_]*)(?=\\s*\\()", SyntaxColor::Function);
+        add("[a-zA-Z_][a-zA-Z0-9_]*", SyntaxColor::Identifier);
+    }
+    
+    std::vector<SyntaxStyle> highlightLine(const std::string& line) const {
+        std::vector<SyntaxStyle> styles;
+        std::vector<bool> positionStyled(line.length(), false);
+        for (const auto& pattern : patterns_) {
+            for (std::sregex_iterator it(line.begin(), line.end(), pattern.first), end; it != end; ++it) {
+                const size_t startCol = it->position();
+                const size_t endCol = startCol + it->length();
+                if (startCol == endCol ||
+                    std::find(positionStyled.begin() + startCol, positionStyled.begin() + endCol, true) != positionStyled.begin() + endCol) {
+                    continue;
+                }
+                styles.emplace_back(startCol, endCol, pattern.second);
+                std::fill(positionStyled.begin() + startCol, positionStyled.begin() + endCol, true);
+            }
+        }
+        std::sort(styles.begin(), styles.end(), [](const SyntaxStyle& a, const SyntaxStyle& b) {
+            return a.startCol < b.startCol;
+        });
+        return styles;
+    }
+    
+private:
+    void add(const std::string& pattern, SyntaxColor color) {
+        patterns_.emplace_back(std::regex(pattern), color);
+    }
+    
+    std::vector<std::pair<std::regex, SyntaxColor>> patterns_;
+};
+
+// Benchmark the compiled keyword tables and scanners against the regexes
+// they replace: same styles, at least ten times the lines per second
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkScannerVersusRegex) {
+    const size_t lineCount = 4000;
+    
+    // Half C++-like lines, half random printable text for the edge cases
+    std::vector<std::string> lines;
+    std::mt19937 gen(7);
+    const std::vector<std::string> templates = {
+        "    for (int i = 0; i < count; ++i) {",
+        "    static constexpr double scale = 1.5e-3;",
+        "#include <vector>",
+        "  #  define MAX_ITEMS 128u",
+        "    const char* name = \"value \\\"quoted\\\"\"; char c = '\\n';",
+        "    if (ptr != nullptr && flags & 0x1F) return false;",
+        "class Widget : public Base { virtual void draw() const override; };",
+        "    auto result = compute(value, .25f, 3.) + helper (x1, y_2);",
+    };
+    for (size_t i = 0; i < lineCount / 2; ++i) {
+        lines.push_back(templates[gen() % templates.size()] + " // " + std::to_string(i));
+    }
+    HighlightingBenchmark::generateRandomFile(*buffer_, lineCount / 2, 80);
+    for (size_t i = 0; i < buffer_->lineCount(); ++i) {
+        lines.push_back(buffer_->getLine(i));
+    }
+    
+    RegexCppPatterns regexPatterns;
+    CppHighlighter scanner;
+    
+    std::vector<std::vector<SyntaxStyle>> expected;
+    expected.reserve(lines.size());
+    const auto regexStart = std::chrono::steady_clock::now();
+    for (const auto& line : lines) {
+        expected.push_back(regexPatterns.highlightLine(line));
+    }
+    const double regexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - regexStart).count();
+    
+    std::vector<std::vector<SyntaxStyle>> actual;
+    actual.reserve(lines.size());
+    const auto scannerStart = std::chrono::steady_clock::now();
+    for (const auto& line : lines) {
+        actual.push_back(std::move(*scanner.PatternBasedHighlighter::highlightLine(line, 0)));
+    }
+    const double scannerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scannerStart).count();
+    
+    const auto fullStart = std::chrono::steady_clock::now();
+    LexerState state;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        scanner.highlightLineFrom(lines[i], i, state);
+    }
+    const double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fullStart).count();
+    
+    const double regexRate = lines.size() / regexSeconds;
+    const double scannerRate = lines.size() / scannerSeconds;
+    std::cout << "Highlighting " << lines.size() << " lines: regex patterns " << std::fixed << std::setprecision(0)
+              << regexRate << " lines/s, compiled scanner " << scannerRate << " lines/s ("
+              << std::setprecision(1) << scannerRate / regexRate << "x), full C++ highlighter "
+              << std::setprecision(0) << lines.size() / fullSeconds << " lines/s" << std::endl;
+    
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        ASSERT_EQ(actual[i].size(), expected[i].size()) << "line: " << lines[i];
+        for (size_t j = 0; j < expected[i].size(); ++j) {
+            EXPECT_EQ(actual[i][j].startCol, expected[i][j].startCol) << "line: " << lines[i];
+            EXPECT_EQ(actual[i][j].endCol, expected[i][j].endCol) << "line: " << lines[i];
+            EXPECT_EQ(actual[i][j].color, expected[i][j].color) << "line: " << lines[i];
+        }
+    }
+    EXPECT_GE(scannerRate / regexRate, 10.0);
+}
+
+// Memory held by the style cache per highlighted line
+TEST_F(SyntaxHighlightingBenchmarkTest, BenchmarkStyleCacheMemoryPerLine) {
+    const size_t lineCount = static_cast<size_t>(SyntaxHighlightingManager::MAX_CACHE_LINES *
+                                                 SyntaxHighlightingManager::CACHE_CLEANUP_RATIO);
+    const size_t chunk = 500;
+    
+    // A mix resembling ordinary source: mostly statements with a span or
+    // two, some braces, blank lines and comments
+    const std::vector<std::string> templates = {
+        "#include <vector>",
+        "",
+        "// Compute the total of the selected values",
+        "double Accumulator::total(const std::vector<double>& values) const",
+        "{",
+        "    double sum = 0;",
+        "    for (size_t i = 0; i < values.size(); ++i) {",
+        "        if (selected_[i]) {",
+        "            sum += values[i] * weight_;",
+        "        }",
+        "    }",
+        "    log(\"total\", sum);",
+        "    return sum;",
+        "}",
+        "",
+        "    result = first.combine(second);",
+    };
+    buffer_->clear(false);
+    for (size_t i = 0; i < 2 * lineCount; ++i) {
+        buffer_->addLine(templates[i % templates.size()]);
+    }
+    
+    SyntaxHighlightingManager manager;
+    manager.setHighlighter(std::make_shared<CppHighlighter>());
+    manager.setBuffer(buffer_.get());
+    manager.setContextLines(0);
+    manager.setHighlightingTimeout(10000);
+    
+    for (size_t line = 0; line < lineCount; line += chunk) {
+        manager.getHighlightingStyles(line, line + chunk - 1);
+    }
+    size_t spans = 0;
+    for (size_t line = 0; line < lineCount; line += chunk) {
+        for (const auto& styles : manager.getHighlightingStyles(line, line + chunk - 1)) {
+            spans += styles.size();
+        }
+    }
+    ASSERT_EQ(manager.getCacheSize(), lineCount);
+    const double bytesPerLine = static_cast<double>(manager.getCacheMemoryUsage()) / lineCount;
+    
+    // Scrolling on past the cache limit evicts instead of growing
+    for (size_t line = lineCount; line < 2 * lineCount; line += chunk) {
+        manager.getHighlightingStyles(line, line + chunk - 1);
+    }
+    const size_t cachedAfterScroll = manager.getCacheSize();
+    auto lastChunk = manager.getHighlightingStyles(2 * lineCount - chunk, 2 * lineCount - 1);
+    
+    std::cout << "Style cache: " << std::fixed << std::setprecision(1) << bytesPerLine << " bytes per line over "
+              << lineCount << " C++ lines (" << std::setprecision(2) << static_cast<double>(spans) / lineCount
+              << " spans per line); " << cachedAfterScroll << " lines cached after scrolling through "
+              << 2 * lineCount << std::endl;
+    
+    // A heap-allocated style vector per line plus the timestamp maps used to
+    // cost about 245 bytes per line at two spans per line
+    EXPECT_LE(bytesPerLine, 245.0 / 5);
+    EXPECT_LE(cachedAfterScroll, SyntaxHighlightingManager::MAX_CACHE_LINES);
+    ASSERT_EQ(lastChunk.size(), chunk);
+    EXPECT_FALSE(lastChunk[0].empty());
+}
@@ -15,6 +15,7 @@
 
 #include "AppDebugLog.h"
 #include "TextBuffer.h"
+#include "ThreadSafeTextBuffer.h"
 #include "EditorCoreThreadPool.h"
 
 // Configuration constants for the stress test
@@ -50,6 +51,12 @@ namespace StressTestConfig {
     
     // Whether to track and verify that all operations were processed
     constexpr bool TRACK_OPERATIONS = true;
+    
+    // Snapshot contention benchmark: reader threads walking the whole
+    // document while one typist inserts characters
+    constexpr int NUM_SNAPSHOT_READERS = 4;
+    constexpr int CONTENTION_BENCHMARK_SECONDS = 2;
+    constexpr int BENCHMARK_DOCUMENT_LINES = 20000;
 }
 
 // Operation tracking for verification
@@ -496,6 +503,96 @@ private:
     std::mutex mutex_;
 };
 
+// Measures how much whole-document readers slow down a typist, comparing
+// readers that hold the read lock with readers that use snapshots
+class SnapshotContentionBenchmark {
+public:
+    struct Result {
+        double keystrokesPerSecond = 0.0;
+        double maxKeystrokeMicros = 0.0;
+        size_t documentsRead = 0;
+    };
+    
+    // Run the benchmark for both reader strategies and print the results
+    void run() {
+        const Result locked = measure(false);
+        const Result snapshots = measure(true);
+        
+        report("read lock", locked);
+        report("snapshots", snapshots);
+        
+        // Snapshot readers walk the document without holding the lock, so
+        // they must keep making progress while the typist writes
+        assert(snapshots.documentsRead > 0 && "Snapshot readers made no progress");
+    }
+    
+private:
+    Result measure(bool useSnapshots) {
+        ThreadSafeTextBuffer buffer;
+        buffer.clear(false);
+        for (int i = 0; i < StressTestConfig::BENCHMARK_DOCUMENT_LINES; ++i) {
+            buffer.addLine("Line " + std::to_string(i) + ": " + randomGen_.generateRandomLine());
+        }
+        
+        // Readers that hold the lock can starve the typist outright, so the
+        // benchmark runs for a fixed time and stopping releases everyone
+        std::atomic<bool> running{true};
+        std::atomic<size_t> documentsRead{0};
+        std::vector<std::thread> readers;
+        for (int i = 0; i < StressTestConfig::NUM_SNAPSHOT_READERS; ++i) {
+            readers.emplace_back([&]() {
+                while (running.load()) {
+                    size_t bytes = 0;
+                    auto visitor = [&bytes](size_t, std::string_view line) {
+                        bytes += line.size();
+                        return true;
+                    };
+                    if (useSnapshots) {
+                        auto snapshot = buffer.snapshot();
+                        snapshot->forEachLine(0, snapshot->lineCount(), visitor);
+                    } else {
+                        buffer.forEachLine(0, buffer.lineCount(), visitor);
+                    }
+                    assert(bytes > 0);
+                    documentsRead.fetch_add(1);
+                }
+            });
+        }
+        
+        Result result;
+        size_t keystrokes = 0;
+        std::thread typist([&]() {
+            while (running.load()) {
+                const auto keyStart = std::chrono::steady_clock::now();
+                buffer.insertChar(keystrokes % StressTestConfig::BENCHMARK_DOCUMENT_LINES, 0, 'x');
+                const std::chrono::duration<double, std::micro> keyTime = std::chrono::steady_clock::now() - keyStart;
+                result.maxKeystrokeMicros = std::max(result.maxKeystrokeMicros, keyTime.count());
+                ++keystrokes;
+            }
+        });
+        
+        std::this_thread::sleep_for(std::chrono::seconds(StressTestConfig::CONTENTION_BENCHMARK_SECONDS));
+        running.store(false);
+        typist.join();
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        
+        result.keystrokesPerSecond = static_cast<double>(keystrokes) / StressTestConfig::CONTENTION_BENCHMARK_SECONDS;
+        result.documentsRead = documentsRead.load();
+        return result;
+    }
+    
+    void report(const std::string& name, const Result& result) {
+        std::cout << "Snapshot contention (" << name << "): "
+                  << static_cast<size_t>(result.keystrokesPerSecond) << " keystrokes/s, worst keystroke "
+                  << result.maxKeystrokeMicros << " us, " << result.documentsRead << " documents read by "
+                  << StressTestConfig::NUM_SNAPSHOT_READERS << " readers" << std::endl;
+    }
+    
+    RandomGenerator randomGen_;
+};
+
 // Main function
 int main() {
     try {
@@ -505,6 +602,9 @@ int main() {
         test.runTest();
         test.cleanup();
         
+        SnapshotContentionBenchmark benchmark;
+        benchmark.run();
+        
         std::cout << "TextBuffer stress test completed successfully!" << std::endl;
         return 0;
     } catch (const std::exception& e) {
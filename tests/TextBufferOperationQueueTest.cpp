@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+#include "TextBufferOperationQueue.h"
+#include "EditorCoreThreadPool.h"
+#include "TextBuffer.h"
+#include "EditorError.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(TextBufferOperationQueueTest, DrainsInOrderInBatches)
+{
+    TextBufferOperationQueue queue(16);
+    TextBuffer buffer;
+    buffer.clear(false);
+
+    for (int i = 0; i < 10; ++i) {
+        queue.post([i](TextBuffer& b) { b.addLine(std::to_string(i)); });
+    }
+    EXPECT_EQ(queue.size(), 10u);
+
+    EXPECT_EQ(queue.drain(buffer, 4), 4u);
+    EXPECT_EQ(buffer.lineCount(), 4u);
+    EXPECT_EQ(queue.drain(buffer), 6u);
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(queue.drain(buffer), 0u);
+
+    for (size_t i = 0; i < buffer.lineCount(); ++i) {
+        EXPECT_EQ(buffer.getLine(i), std::to_string(i));
+    }
+}
+
+TEST(TextBufferOperationQueueTest, FuturesReportCompletionAndErrors)
+{
+    TextBufferOperationQueue queue;
+    TextBuffer buffer;
+
+    auto ok = queue.enqueue([](TextBuffer& b) { b.addLine("added"); });
+    auto failed = queue.enqueue([](TextBuffer&) { throw std::runtime_error("boom"); });
+    queue.post([](TextBuffer&) { throw std::runtime_error("ignored"); });
+
+    // The legacy dequeue path hands out every kind of entry as an operation
+    auto first = queue.dequeue();
+    ASSERT_TRUE(first);
+    first->execute(buffer);
+    EXPECT_EQ(queue.drain(buffer), 2u);
+
+    EXPECT_FALSE(ok.get().has_value());
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_EQ(buffer.getLine(buffer.lineCount() - 1), "added");
+
+    queue.shutdown();
+    EXPECT_EQ(queue.dequeue(), nullptr);
+    EXPECT_THROW(queue.post([](TextBuffer&) {}), TextBufferException);
+}
+
+TEST(TextBufferOperationQueueTest, ProducersWaitWhileRingIsFull)
+{
+    TextBufferOperationQueue queue(4);
+    ASSERT_EQ(queue.capacity(), 4u);
+
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 2000;
+    TextBuffer buffer;
+    buffer.clear(false);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kPerProducer; ++i) {
+                queue.post([p, i](TextBuffer& b) { b.addLine(std::to_string(p) + ":" + std::to_string(i)); });
+            }
+        });
+    }
+
+    size_t executed = 0;
+    while (executed < kProducers * kPerProducer) {
+        if (queue.waitForOperations()) {
+            executed += queue.drain(buffer, 3);
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // Each producer's operations run in the order it posted them
+    ASSERT_EQ(buffer.lineCount(), static_cast<size_t>(kProducers * kPerProducer));
+    std::vector<int> next(kProducers, 0);
+    for (size_t i = 0; i < buffer.lineCount(); ++i) {
+        const std::string& line = buffer.getLine(i);
+        const int p = std::stoi(line.substr(0, line.find(':')));
+        EXPECT_EQ(std::stoi(line.substr(line.find(':') + 1)), next[p]++);
+    }
+}
+
+TEST(TextBufferOperationQueueTest, WakeReleasesParkedConsumer)
+{
+    TextBufferOperationQueue queue;
+    std::atomic<bool> returned{false};
+    bool ready = true;
+
+    std::thread consumer([&]() {
+        ready = queue.waitForOperations();
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(returned.load());
+    queue.wake();
+    consumer.join();
+    EXPECT_FALSE(ready);
+
+    // A wake with nobody parked is not lost
+    queue.wake();
+    EXPECT_FALSE(queue.waitForOperations());
+}
+
+TEST(TextBufferOperationQueueTest, PoolOwnerThreadExecutesOperations)
+{
+    auto buffer = std::make_shared<TextBuffer>();
+    buffer->clear(false);
+
+    EditorCoreThreadPool pool(1);
+    pool.start();
+    pool.assignTextBufferOwnership(buffer);
+
+    std::atomic<int> ranOnOwner{0};
+    for (int i = 0; i < 1000; ++i) {
+        pool.textBufferOperations().post([&pool, &ranOnOwner, i](TextBuffer& b) {
+            ranOnOwner += pool.isTextBufferOwnerThread() ? 1 : 0;
+            b.addLine(std::to_string(i));
+        });
+    }
+    auto last = pool.textBufferOperations().enqueue([](TextBuffer&) {});
+    ASSERT_EQ(last.wait_for(5s), std::future_status::ready);
+
+    // General tasks still run on a pool without general workers
+    std::atomic<bool> taskRan{false};
+    pool.submitTask([&taskRan]() { taskRan = true; });
+    for (int i = 0; i < 500 && !taskRan; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    pool.shutdown();
+
+    EXPECT_TRUE(taskRan.load());
+    EXPECT_EQ(ranOnOwner.load(), 1000);
+    EXPECT_EQ(buffer->lineCount(), 1000u);
+}
@@ -1,12 +1,21 @@
 #include "../src/TextBuffer.h"
+#include "../src/PieceTableTextBuffer.h"
 #include "gtest/gtest.h"
 #include <string>
 #include <stdexcept>
 #include <vector>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
 
+// Every test runs against each ITextBuffer implementation that keeps the
+// whole document in memory
+template <typename Buffer>
 class TextBufferTest : public ::testing::Test {
 protected:
-    TextBuffer buffer;
+    Buffer buffer;
     
     void SetUp() override {
         // Ensure the buffer is completely empty before adding test lines
@@ -19,60 +28,63 @@ protected:
     }
 };
 
-TEST_F(TextBufferTest, Initialization) {
-    EXPECT_GE(buffer.lineCount(), 1) << "Buffer should start with at least one line";
+using InMemoryBuffers = ::testing::Types<TextBuffer, PieceTableTextBuffer>;
+TYPED_TEST_SUITE(TextBufferTest, InMemoryBuffers);
+
+TYPED_TEST(TextBufferTest, Initialization) {
+    EXPECT_GE(this->buffer.lineCount(), 1) << "Buffer should start with at least one line";
 }
 
-TEST_F(TextBufferTest, InsertString) {
-    buffer.setLine(0, "Hello");
+TYPED_TEST(TextBufferTest, InsertString) {
+    this->buffer.setLine(0, "Hello");
     
     // Insert at beginning
-    buffer.insertString(0, 0, "Start-");
-    EXPECT_EQ("Start-Hello", buffer.getLine(0)) << "Insert at beginning";
+    this->buffer.insertString(0, 0, "Start-");
+    EXPECT_EQ("Start-Hello", this->buffer.getLine(0)) << "Insert at beginning";
     
     // Insert at middle
-    buffer.insertString(0, 6, ", ");
-    EXPECT_EQ("Start-, Hello", buffer.getLine(0)) << "Insert in middle";
+    this->buffer.insertString(0, 6, ", ");
+    EXPECT_EQ("Start-, Hello", this->buffer.getLine(0)) << "Insert in middle";
     
     // Insert at end
-    buffer.insertString(0, buffer.getLine(0).length(), " End");
-    EXPECT_EQ("Start-, Hello End", buffer.getLine(0)) << "Insert at end";
+    this->buffer.insertString(0, this->buffer.getLine(0).length(), " End");
+    EXPECT_EQ("Start-, Hello End", this->buffer.getLine(0)) << "Insert at end";
 }
 
 // Test for the expected exception when inserting beyond the end of a line
-TEST_F(TextBufferTest, InsertStringBeyondEnd) {
-    buffer.setLine(0, "Test");
-    EXPECT_THROW(buffer.insertString(0, 100, "!"), std::exception) << "Insert beyond end should throw";
+TYPED_TEST(TextBufferTest, InsertStringBeyondEnd) {
+    this->buffer.setLine(0, "Test");
+    EXPECT_THROW(this->buffer.insertString(0, 100, "!"), std::exception) << "Insert beyond end should throw";
 }
 
-TEST_F(TextBufferTest, DeleteChar) {
-    buffer.setLine(0, "Hello");
+TYPED_TEST(TextBufferTest, DeleteChar) {
+    this->buffer.setLine(0, "Hello");
     
     // Delete within line
-    buffer.deleteChar(0, 2); // Delete 'l' (position at index 1)
-    EXPECT_EQ("Hllo", buffer.getLine(0)) << "Delete within line";
+    this->buffer.deleteChar(0, 2); // Delete 'l' (position at index 1)
+    EXPECT_EQ("Hllo", this->buffer.getLine(0)) << "Delete within line";
     
     // Delete at beginning of first line (no effect)
-    buffer.deleteChar(0, 0);
-    EXPECT_EQ("Hllo", buffer.getLine(0)) << "Delete at beginning of first line";
+    this->buffer.deleteChar(0, 0);
+    EXPECT_EQ("Hllo", this->buffer.getLine(0)) << "Delete at beginning of first line";
     
     // Delete beyond end (should delete at end)
-    buffer.deleteChar(0, 10);
-    EXPECT_EQ("Hll", buffer.getLine(0)) << "Delete beyond end (deletes at end)";
+    this->buffer.deleteChar(0, 10);
+    EXPECT_EQ("Hll", this->buffer.getLine(0)) << "Delete beyond end (deletes at end)";
     
     // Test joining lines
-    buffer.clear(true);
-    buffer.setLine(0, "First");
-    buffer.addLine("Second");
-    buffer.deleteChar(1, 0); // Delete the newline between lines
-    EXPECT_EQ(1, buffer.lineCount()) << "Join lines should reduce line count";
-    EXPECT_EQ("FirstSecond", buffer.getLine(0)) << "Join lines with backspace";
+    this->buffer.clear(true);
+    this->buffer.setLine(0, "First");
+    this->buffer.addLine("Second");
+    this->buffer.deleteChar(1, 0); // Delete the newline between lines
+    EXPECT_EQ(1, this->buffer.lineCount()) << "Join lines should reduce line count";
+    EXPECT_EQ("FirstSecond", this->buffer.getLine(0)) << "Join lines with backspace";
 }
 
-TEST_F(TextBufferTest, DeleteCharForward) {
+TYPED_TEST(TextBufferTest, DeleteCharForward) {
     // Test case 1: Delete within line
     {
-        TextBuffer testBuffer;
+        TypeParam testBuffer;
         testBuffer.clear(false);
         testBuffer.addLine("Hello");
         
@@ -82,7 +94,7 @@ TEST_F(TextBufferTest, DeleteCharForward) {
     
     // Test case 2: Delete at end of line (no effect)
     {
-        TextBuffer testBuffer;
+        TypeParam testBuffer;
         testBuffer.clear(false);
         testBuffer.addLine("Helo");
         
@@ -92,7 +104,7 @@ TEST_F(TextBufferTest, DeleteCharForward) {
     
     // Test case 3: Delete beyond end - should throw exception
     {
-        TextBuffer testBuffer;
+        TypeParam testBuffer;
         testBuffer.clear(false);
         testBuffer.addLine("Helo");
         
@@ -103,7 +115,7 @@ TEST_F(TextBufferTest, DeleteCharForward) {
     
     // Test case 4: Join lines
     {
-        TextBuffer testBuffer;
+        TypeParam testBuffer;
         testBuffer.clear(false);
         testBuffer.addLine("First");
         testBuffer.addLine("Second");
@@ -114,216 +126,216 @@ TEST_F(TextBufferTest, DeleteCharForward) {
     }
 }
 
-TEST_F(TextBufferTest, DeleteLine) {
+TYPED_TEST(TextBufferTest, DeleteLine) {
     // Test trying to delete the only line doesn't throw (current behavior)
-    buffer.clear(true);
-    size_t initialCount = buffer.lineCount();
-    buffer.deleteLine(0);
-    EXPECT_GE(buffer.lineCount(), initialCount) << "Buffer should maintain at least one line";
+    this->buffer.clear(true);
+    size_t initialCount = this->buffer.lineCount();
+    this->buffer.deleteLine(0);
+    EXPECT_GE(this->buffer.lineCount(), initialCount) << "Buffer should maintain at least one line";
     
     // Test deleting a line among multiple
-    buffer.clear(true);
-    buffer.setLine(0, "Line 0");
-    buffer.addLine("Line 1");
-    buffer.addLine("Line 2");
-    
-    buffer.deleteLine(1);
-    EXPECT_EQ(2, buffer.lineCount()) << "Buffer should have 2 lines after deletion";
-    EXPECT_EQ("Line 0", buffer.getLine(0)) << "First line should remain unchanged";
-    EXPECT_EQ("Line 2", buffer.getLine(1)) << "Third line should become second line";
+    this->buffer.clear(true);
+    this->buffer.setLine(0, "Line 0");
+    this->buffer.addLine("Line 1");
+    this->buffer.addLine("Line 2");
+    
+    this->buffer.deleteLine(1);
+    EXPECT_EQ(2, this->buffer.lineCount()) << "Buffer should have 2 lines after deletion";
+    EXPECT_EQ("Line 0", this->buffer.getLine(0)) << "First line should remain unchanged";
+    EXPECT_EQ("Line 2", this->buffer.getLine(1)) << "Third line should become second line";
 }
 
 // Test lineLength method
-TEST_F(TextBufferTest, LineLengthReturnsCorrectLength) {
-    EXPECT_EQ(10, buffer.lineLength(0)); // "First line"
-    EXPECT_EQ(11, buffer.lineLength(1)); // "Second line"
-    EXPECT_EQ(25, buffer.lineLength(2)); // "Third line with more text"
+TYPED_TEST(TextBufferTest, LineLengthReturnsCorrectLength) {
+    EXPECT_EQ(10, this->buffer.lineLength(0)); // "First line"
+    EXPECT_EQ(11, this->buffer.lineLength(1)); // "Second line"
+    EXPECT_EQ(25, this->buffer.lineLength(2)); // "Third line with more text"
 }
 
-TEST_F(TextBufferTest, LineLengthThrowsForInvalidIndex) {
-    EXPECT_THROW(buffer.lineLength(3), std::out_of_range);
-    EXPECT_THROW(buffer.lineLength(100), std::out_of_range);
+TYPED_TEST(TextBufferTest, LineLengthThrowsForInvalidIndex) {
+    EXPECT_THROW(this->buffer.lineLength(3), std::out_of_range);
+    EXPECT_THROW(this->buffer.lineLength(100), std::out_of_range);
 }
 
 // Test characterCount method
-TEST_F(TextBufferTest, CharacterCountReturnsCorrectTotal) {
-    EXPECT_EQ(10 + 11 + 25, buffer.characterCount()); // Sum of all line lengths
+TYPED_TEST(TextBufferTest, CharacterCountReturnsCorrectTotal) {
+    EXPECT_EQ(10 + 11 + 25, this->buffer.characterCount()); // Sum of all line lengths
     
     // Test with empty buffer
-    TextBuffer emptyBuffer;
+    TypeParam emptyBuffer;
     EXPECT_EQ(0, emptyBuffer.characterCount());
     
     // Test with empty line
-    TextBuffer bufferWithEmptyLine;
+    TypeParam bufferWithEmptyLine;
     bufferWithEmptyLine.addLine("");
     EXPECT_EQ(0, bufferWithEmptyLine.characterCount());
 }
 
 // Test getAllLines method
-TEST_F(TextBufferTest, GetAllLinesReturnsAllLines) {
+TYPED_TEST(TextBufferTest, GetAllLinesReturnsAllLines) {
     std::vector<std::string> expectedLines = {
         "First line",
         "Second line",
         "Third line with more text"
     };
     
-    EXPECT_EQ(expectedLines, buffer.getAllLines());
+    EXPECT_EQ(expectedLines, this->buffer.getAllLines());
 }
 
-TEST_F(TextBufferTest, GetAllLinesReturnsEmptyVectorForEmptyBuffer) {
-    TextBuffer emptyBuffer;
+TYPED_TEST(TextBufferTest, GetAllLinesReturnsEmptyVectorForEmptyBuffer) {
+    TypeParam emptyBuffer;
     EXPECT_TRUE(emptyBuffer.getAllLines().empty());
 }
 
 // Test replaceLineSegment method
-TEST_F(TextBufferTest, ReplaceLineSegmentReplacesTextCorrectly) {
+TYPED_TEST(TextBufferTest, ReplaceLineSegmentReplacesTextCorrectly) {
     // Replace "First" with "New"
-    buffer.replaceLineSegment(0, 0, 5, "New");
-    EXPECT_EQ("New line", buffer.getLine(0));
+    this->buffer.replaceLineSegment(0, 0, 5, "New");
+    EXPECT_EQ("New line", this->buffer.getLine(0));
     
     // Replace "Second" with "Modified"
-    buffer.replaceLineSegment(1, 0, 6, "Modified");
-    EXPECT_EQ("Modified line", buffer.getLine(1));
+    this->buffer.replaceLineSegment(1, 0, 6, "Modified");
+    EXPECT_EQ("Modified line", this->buffer.getLine(1));
     
     // Replace middle part of line
-    buffer.replaceLineSegment(2, 6, 15, "segment");
-    EXPECT_EQ("Third segment more text", buffer.getLine(2));
+    this->buffer.replaceLineSegment(2, 6, 15, "segment");
+    EXPECT_EQ("Third segment more text", this->buffer.getLine(2));
 }
 
-TEST_F(TextBufferTest, ReplaceLineSegmentHandlesInvalidRanges) {
+TYPED_TEST(TextBufferTest, ReplaceLineSegmentHandlesInvalidRanges) {
     // Test swapping startCol and endCol if startCol > endCol
-    buffer.replaceLineSegment(0, 5, 0, "New");
-    EXPECT_EQ("New line", buffer.getLine(0));
+    this->buffer.replaceLineSegment(0, 5, 0, "New");
+    EXPECT_EQ("New line", this->buffer.getLine(0));
     
     // Test endCol beyond line length
-    buffer.replaceLineSegment(1, 11, 20, " extended");
-    EXPECT_EQ("Second line extended", buffer.getLine(1));
+    this->buffer.replaceLineSegment(1, 11, 20, " extended");
+    EXPECT_EQ("Second line extended", this->buffer.getLine(1));
     
     // Test startCol beyond line length (should append)
-    buffer.replaceLineSegment(2, 30, 35, " appended");
-    EXPECT_EQ("Third line with more text appended", buffer.getLine(2));
+    this->buffer.replaceLineSegment(2, 30, 35, " appended");
+    EXPECT_EQ("Third line with more text appended", this->buffer.getLine(2));
 }
 
-TEST_F(TextBufferTest, ReplaceLineSegmentThrowsForInvalidLineIndex) {
-    EXPECT_THROW(buffer.replaceLineSegment(3, 0, 5, "Invalid"), std::out_of_range);
-    EXPECT_THROW(buffer.replaceLineSegment(100, 0, 5, "Invalid"), std::out_of_range);
+TYPED_TEST(TextBufferTest, ReplaceLineSegmentThrowsForInvalidLineIndex) {
+    EXPECT_THROW(this->buffer.replaceLineSegment(3, 0, 5, "Invalid"), std::out_of_range);
+    EXPECT_THROW(this->buffer.replaceLineSegment(100, 0, 5, "Invalid"), std::out_of_range);
 }
 
 // Test deleteLineSegment method
-TEST_F(TextBufferTest, DeleteLineSegmentDeletesTextCorrectly) {
+TYPED_TEST(TextBufferTest, DeleteLineSegmentDeletesTextCorrectly) {
     // Delete "First"
-    buffer.deleteLineSegment(0, 0, 5);
-    EXPECT_EQ(" line", buffer.getLine(0));
+    this->buffer.deleteLineSegment(0, 0, 5);
+    EXPECT_EQ(" line", this->buffer.getLine(0));
     
     // Delete "Second "
-    buffer.deleteLineSegment(1, 0, 7);
-    EXPECT_EQ("line", buffer.getLine(1));
+    this->buffer.deleteLineSegment(1, 0, 7);
+    EXPECT_EQ("line", this->buffer.getLine(1));
     
     // Delete middle part of line
-    buffer.deleteLineSegment(2, 6, 15);
-    EXPECT_EQ("Third  more text", buffer.getLine(2));
+    this->buffer.deleteLineSegment(2, 6, 15);
+    EXPECT_EQ("Third  more text", this->buffer.getLine(2));
 }
 
-TEST_F(TextBufferTest, DeleteLineSegmentHandlesInvalidRanges) {
+TYPED_TEST(TextBufferTest, DeleteLineSegmentHandlesInvalidRanges) {
     // Test swapping startCol and endCol if startCol > endCol
-    buffer.deleteLineSegment(0, 10, 5);
-    EXPECT_EQ("First", buffer.getLine(0));
+    this->buffer.deleteLineSegment(0, 10, 5);
+    EXPECT_EQ("First", this->buffer.getLine(0));
     
     // Test endCol beyond line length
-    buffer.deleteLineSegment(1, 7, 20);
-    EXPECT_EQ("Second ", buffer.getLine(1));
+    this->buffer.deleteLineSegment(1, 7, 20);
+    EXPECT_EQ("Second ", this->buffer.getLine(1));
     
     // Test startCol beyond line length (should do nothing)
-    buffer.deleteLineSegment(2, 30, 35);
-    EXPECT_EQ("Third line with more text", buffer.getLine(2));
+    this->buffer.deleteLineSegment(2, 30, 35);
+    EXPECT_EQ("Third line with more text", this->buffer.getLine(2));
     
     // Test startCol equals endCol (should do nothing)
-    buffer.deleteLineSegment(2, 5, 5);
-    EXPECT_EQ("Third line with more text", buffer.getLine(2));
+    this->buffer.deleteLineSegment(2, 5, 5);
+    EXPECT_EQ("Third line with more text", this->buffer.getLine(2));
 }
 
-TEST_F(TextBufferTest, DeleteLineSegmentThrowsForInvalidLineIndex) {
-    EXPECT_THROW(buffer.deleteLineSegment(3, 0, 5), std::out_of_range);
-    EXPECT_THROW(buffer.deleteLineSegment(100, 0, 5), std::out_of_range);
+TYPED_TEST(TextBufferTest, DeleteLineSegmentThrowsForInvalidLineIndex) {
+    EXPECT_THROW(this->buffer.deleteLineSegment(3, 0, 5), std::out_of_range);
+    EXPECT_THROW(this->buffer.deleteLineSegment(100, 0, 5), std::out_of_range);
 }
 
 // Test deleteLines method
-TEST_F(TextBufferTest, DeleteLinesRemovesSpecifiedRange) {
+TYPED_TEST(TextBufferTest, DeleteLinesRemovesSpecifiedRange) {
     // Delete a range of lines
-    buffer.deleteLines(0, 2);
-    EXPECT_EQ(1, buffer.lineCount());
-    EXPECT_EQ("Third line with more text", buffer.getLine(0));
+    this->buffer.deleteLines(0, 2);
+    EXPECT_EQ(1, this->buffer.lineCount());
+    EXPECT_EQ("Third line with more text", this->buffer.getLine(0));
 }
 
-TEST_F(TextBufferTest, DeleteLinesThrowsForInvalidRange) {
+TYPED_TEST(TextBufferTest, DeleteLinesThrowsForInvalidRange) {
     // Invalid startIndex
-    EXPECT_THROW(buffer.deleteLines(3, 4), std::out_of_range);
+    EXPECT_THROW(this->buffer.deleteLines(3, 4), std::out_of_range);
     
     // startIndex >= endIndex
-    EXPECT_THROW(buffer.deleteLines(1, 1), std::out_of_range);
-    EXPECT_THROW(buffer.deleteLines(2, 1), std::out_of_range);
+    EXPECT_THROW(this->buffer.deleteLines(1, 1), std::out_of_range);
+    EXPECT_THROW(this->buffer.deleteLines(2, 1), std::out_of_range);
 }
 
-TEST_F(TextBufferTest, DeleteLinesHandlesEdgeCases) {
+TYPED_TEST(TextBufferTest, DeleteLinesHandlesEdgeCases) {
     // Delete all lines
-    buffer.deleteLines(0, 3);
+    this->buffer.deleteLines(0, 3);
     
     // Buffer should maintain one empty line
-    EXPECT_EQ(1, buffer.lineCount());
-    EXPECT_EQ("", buffer.getLine(0));
+    EXPECT_EQ(1, this->buffer.lineCount());
+    EXPECT_EQ("", this->buffer.getLine(0));
     
     // Prepare buffer for next test
-    buffer.clear(false);
-    buffer.addLine("Line 0");
-    buffer.addLine("Line 1");
+    this->buffer.clear(false);
+    this->buffer.addLine("Line 0");
+    this->buffer.addLine("Line 1");
     
     // Delete partial range up to the end
-    buffer.deleteLines(0, 5); // endIndex is beyond buffer size, should clamp
-    EXPECT_EQ(1, buffer.lineCount());
-    EXPECT_EQ("", buffer.getLine(0));
+    this->buffer.deleteLines(0, 5); // endIndex is beyond this->buffer size, should clamp
+    EXPECT_EQ(1, this->buffer.lineCount());
+    EXPECT_EQ("", this->buffer.getLine(0));
 }
 
 // Test insertLines method
-TEST_F(TextBufferTest, InsertLinesInsertsAtSpecifiedIndex) {
+TYPED_TEST(TextBufferTest, InsertLinesInsertsAtSpecifiedIndex) {
     std::vector<std::string> newLines = {"New line 1", "New line 2"};
     
     // Insert in the middle
-    buffer.insertLines(1, newLines);
-    EXPECT_EQ(5, buffer.lineCount());
-    EXPECT_EQ("First line", buffer.getLine(0));
-    EXPECT_EQ("New line 1", buffer.getLine(1));
-    EXPECT_EQ("New line 2", buffer.getLine(2));
-    EXPECT_EQ("Second line", buffer.getLine(3));
-    EXPECT_EQ("Third line with more text", buffer.getLine(4));
+    this->buffer.insertLines(1, newLines);
+    EXPECT_EQ(5, this->buffer.lineCount());
+    EXPECT_EQ("First line", this->buffer.getLine(0));
+    EXPECT_EQ("New line 1", this->buffer.getLine(1));
+    EXPECT_EQ("New line 2", this->buffer.getLine(2));
+    EXPECT_EQ("Second line", this->buffer.getLine(3));
+    EXPECT_EQ("Third line with more text", this->buffer.getLine(4));
 }
 
-TEST_F(TextBufferTest, InsertLinesThrowsForInvalidIndex) {
+TYPED_TEST(TextBufferTest, InsertLinesThrowsForInvalidIndex) {
     std::vector<std::string> newLines = {"New line"};
-    EXPECT_THROW(buffer.insertLines(4, newLines), std::out_of_range);
+    EXPECT_THROW(this->buffer.insertLines(4, newLines), std::out_of_range);
 }
 
-TEST_F(TextBufferTest, InsertLinesHandlesEdgeCases) {
+TYPED_TEST(TextBufferTest, InsertLinesHandlesEdgeCases) {
     std::vector<std::string> newLines = {"New line 1", "New line 2"};
     
     // Insert at beginning
-    buffer.insertLines(0, newLines);
-    EXPECT_EQ(5, buffer.lineCount());
-    EXPECT_EQ("New line 1", buffer.getLine(0));
-    EXPECT_EQ("New line 2", buffer.getLine(1));
+    this->buffer.insertLines(0, newLines);
+    EXPECT_EQ(5, this->buffer.lineCount());
+    EXPECT_EQ("New line 1", this->buffer.getLine(0));
+    EXPECT_EQ("New line 2", this->buffer.getLine(1));
     
     // Insert at end
-    buffer.insertLines(buffer.lineCount(), newLines);
-    EXPECT_EQ(7, buffer.lineCount());
-    EXPECT_EQ("New line 1", buffer.getLine(5));
-    EXPECT_EQ("New line 2", buffer.getLine(6));
+    this->buffer.insertLines(this->buffer.lineCount(), newLines);
+    EXPECT_EQ(7, this->buffer.lineCount());
+    EXPECT_EQ("New line 1", this->buffer.getLine(5));
+    EXPECT_EQ("New line 2", this->buffer.getLine(6));
     
     // Insert empty vector (no change)
     std::vector<std::string> emptyLines;
-    buffer.insertLines(2, emptyLines);
-    EXPECT_EQ(7, buffer.lineCount()); // Count should remain the same
+    this->buffer.insertLines(2, emptyLines);
+    EXPECT_EQ(7, this->buffer.lineCount()); // Count should remain the same
     
     // Insert into empty buffer
-    TextBuffer emptyBuffer;
+    TypeParam emptyBuffer;
     emptyBuffer.clear(false);
     EXPECT_EQ(0, emptyBuffer.lineCount());
     emptyBuffer.insertLines(0, newLines);
@@ -333,49 +345,133 @@ TEST_F(TextBufferTest, InsertLinesHandlesEdgeCases) {
 }
 
 // Test isValidPosition method
-TEST_F(TextBufferTest, IsValidPositionIdentifiesValidPositions) {
+TYPED_TEST(TextBufferTest, IsValidPositionIdentifiesValidPositions) {
     // Valid positions
-    EXPECT_TRUE(buffer.isValidPosition(0, 0));  // Beginning of first line
-    EXPECT_TRUE(buffer.isValidPosition(0, 10)); // End of first line
-    EXPECT_TRUE(buffer.isValidPosition(2, 15)); // Middle of third line
+    EXPECT_TRUE(this->buffer.isValidPosition(0, 0));  // Beginning of first line
+    EXPECT_TRUE(this->buffer.isValidPosition(0, 10)); // End of first line
+    EXPECT_TRUE(this->buffer.isValidPosition(2, 15)); // Middle of third line
     
     // Invalid positions
-    EXPECT_FALSE(buffer.isValidPosition(3, 0));   // Line index out of bounds
-    EXPECT_FALSE(buffer.isValidPosition(0, 11));  // Column index out of bounds for first line
-    EXPECT_FALSE(buffer.isValidPosition(1, 100)); // Column index way out of bounds
+    EXPECT_FALSE(this->buffer.isValidPosition(3, 0));   // Line index out of bounds
+    EXPECT_FALSE(this->buffer.isValidPosition(0, 11));  // Column index out of bounds for first line
+    EXPECT_FALSE(this->buffer.isValidPosition(1, 100)); // Column index way out of bounds
     
     // Empty buffer has no valid positions
-    TextBuffer emptyBuffer;
+    TypeParam emptyBuffer;
     emptyBuffer.clear(false);
     EXPECT_FALSE(emptyBuffer.isValidPosition(0, 0));
 }
 
 // Test clampPosition method
-TEST_F(TextBufferTest, ClampPositionConstrainsToValidRange) {
+TYPED_TEST(TextBufferTest, ClampPositionConstrainsToValidRange) {
     // Clamp line index
-    auto clamped1 = buffer.clampPosition(5, 0);
+    auto clamped1 = this->buffer.clampPosition(5, 0);
     EXPECT_EQ(2, clamped1.first);   // Clamped to last line
     EXPECT_EQ(0, clamped1.second);  // Column unchanged
     
     // Clamp column index
-    auto clamped2 = buffer.clampPosition(0, 20);
+    auto clamped2 = this->buffer.clampPosition(0, 20);
     EXPECT_EQ(0, clamped2.first);    // Line unchanged
     EXPECT_EQ(10, clamped2.second);  // Clamped to end of first line
     
     // Clamp both indices
-    auto clamped3 = buffer.clampPosition(10, 30);
+    auto clamped3 = this->buffer.clampPosition(10, 30);
     EXPECT_EQ(2, clamped3.first);    // Clamped to last line
     EXPECT_EQ(25, clamped3.second);  // Clamped to end of last line
     
     // No clamping needed
-    auto clamped4 = buffer.clampPosition(1, 5);
+    auto clamped4 = this->buffer.clampPosition(1, 5);
     EXPECT_EQ(1, clamped4.first);
     EXPECT_EQ(5, clamped4.second);
     
     // Empty buffer test
-    TextBuffer emptyBuffer;
+    TypeParam emptyBuffer;
     emptyBuffer.clear(false);
     auto clamped5 = emptyBuffer.clampPosition(2, 3);
     EXPECT_EQ(0, clamped5.first);
     EXPECT_EQ(0, clamped5.second);
-} 
\ No newline at end of file
+}
+
+// Test saveToFile and loadFromFile with content that spans several write blocks
+TYPED_TEST(TextBufferTest, SaveAndLoadRoundTripsLargeContent) {
+    const std::string filename = "textbuffer_roundtrip_test.txt";
+    this->buffer.clear(false);
+    std::string expected;
+    for (size_t i = 0; i < 50000; ++i) {
+        std::string line = (i % 7 == 0) ? "" : "line " + std::to_string(i) + (i % 5 == 0 ? "\r" : "");
+        expected += line + "\n";
+        this->buffer.addLine(line);
+    }
+    this->buffer.addLine(std::string(3 * 1024 * 1024, 'x')); // Longer than a write block
+    expected += std::string(3 * 1024 * 1024, 'x') + "\n";
+
+    ASSERT_TRUE(this->buffer.saveToFile(filename));
+    {
+        std::ifstream in(filename, std::ios::binary);
+        std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        EXPECT_EQ(written, expected);
+    }
+
+    // No temporary file is left behind
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        EXPECT_EQ(entry.path().filename().string().find(filename + ".tmp"), std::string::npos);
+    }
+
+    TypeParam loaded;
+    ASSERT_TRUE(loaded.loadFromFile(filename));
+    EXPECT_EQ(loaded.getAllLines(), this->buffer.getAllLines());
+    std::remove(filename.c_str());
+}
+
+// Test that a file without a final newline keeps its last line and that a failed load changes nothing
+TYPED_TEST(TextBufferTest, LoadKeepsLastLineAndSurvivesFailure) {
+    const std::string filename = "textbuffer_load_test.txt";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "one\n\nthree";
+    }
+
+    ASSERT_TRUE(this->buffer.loadFromFile(filename));
+    EXPECT_EQ((std::vector<std::string>{"one", "", "three"}), this->buffer.getAllLines());
+
+    EXPECT_FALSE(this->buffer.loadFromFile("textbuffer_missing_file.txt"));
+    EXPECT_EQ(3u, this->buffer.lineCount());
+
+    // Saving over the file replaces it in place
+    this->buffer.setLine(1, "two");
+    ASSERT_TRUE(this->buffer.saveToFile(filename));
+    TypeParam reloaded;
+    ASSERT_TRUE(reloaded.loadFromFile(filename));
+    EXPECT_EQ((std::vector<std::string>{"one", "two", "three"}), reloaded.getAllLines());
+    std::remove(filename.c_str());
+}
+
+// Test forEachLine method
+TYPED_TEST(TextBufferTest, ForEachLineVisitsRangeInOrder) {
+    std::vector<size_t> indices;
+    std::vector<std::string> lines;
+    size_t visited = this->buffer.forEachLine(1, 3, [&](size_t lineIndex, std::string_view line) {
+        indices.push_back(lineIndex);
+        lines.emplace_back(line);
+        return true;
+    });
+    EXPECT_EQ(2u, visited);
+    EXPECT_EQ((std::vector<size_t>{1, 2}), indices);
+    EXPECT_EQ((std::vector<std::string>{"Second line", "Third line with more text"}), lines);
+
+    // Views point into the buffer's own storage; the piece table's getLine()
+    // hands out a materialized copy, so only the text can be compared there
+    this->buffer.forEachLine(0, 1, [&](size_t, std::string_view line) {
+        if constexpr (std::is_same_v<TypeParam, TextBuffer>) {
+            EXPECT_EQ(this->buffer.getLine(0).data(), line.data());
+        } else {
+            EXPECT_EQ(this->buffer.getLine(0), line);
+        }
+        return true;
+    });
+
+    // The end is clamped and the visitor can stop early
+    EXPECT_EQ(3u, this->buffer.forEachLine(0, 100, [](size_t, std::string_view) { return true; }));
+    EXPECT_EQ(1u, this->buffer.forEachLine(0, 100, [](size_t, std::string_view) { return false; }));
+    EXPECT_EQ(0u, this->buffer.forEachLine(5, 10, [](size_t, std::string_view) { return true; }));
+}
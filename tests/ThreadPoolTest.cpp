@@ -3,8 +3,14 @@
 #include <vector>
 #include <atomic>
 #include <numeric>
+#include <algorithm>
+#include <array>
+#include <set>
 #include <chrono>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <string>
 
 // Test basic functionality of the thread pool
 TEST(ThreadPoolTest, BasicFunctionality) {
@@ -165,6 +171,204 @@ TEST(ThreadPoolTest, Shutdown) {
     // We don't check the futures since they might be invalid after shutdown
 }
 
+// Test the move-only task type
+TEST(ThreadPoolTest, TaskStoresSmallCallablesInline) {
+    int calls = 0;
+    ThreadPool::Task small([&calls]() { ++calls; });
+    ASSERT_TRUE(small);
+    small();
+    
+    // Moving transfers the callable and empties the source
+    ThreadPool::Task moved(std::move(small));
+    EXPECT_FALSE(small);
+    moved();
+    EXPECT_EQ(calls, 2);
+    
+    // Large and move-only callables are accepted too
+    std::array<char, 256> big{};
+    big[0] = 'x';
+    auto owned = std::make_unique<int>(5);
+    ThreadPool::Task large([big, owned = std::move(owned), &calls]() { calls += *owned + (big[0] == 'x'); });
+    ThreadPool::Task assigned;
+    assigned = std::move(large);
+    assigned();
+    EXPECT_EQ(calls, 8);
+}
+
+// Test that move-only arguments and results pass through submit
+TEST(ThreadPoolTest, SubmitAcceptsArguments) {
+    ThreadPool pool(2);
+    
+    auto sum = pool.submit(ThreadPool::Priority::NORMAL, [](int a, const std::string& b) {
+        return a + static_cast<int>(b.size());
+    }, 40, std::string("ab"));
+    EXPECT_EQ(sum.get(), 42);
+    
+    auto owned = pool.submit(ThreadPool::Priority::HIGH, [](std::unique_ptr<int> value) {
+        return value;
+    }, std::make_unique<int>(7));
+    EXPECT_EQ(*owned.get(), 7);
+}
+
+// Test that tasks submitted from a worker are stolen by idle workers
+TEST(ThreadPoolTest, WorkersStealNestedTasks) {
+    ThreadPool pool(4);
+    
+    std::mutex threadsMutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> counter(0);
+    
+    // One task fans out into many; they all land in one worker's queue
+    auto root = pool.submit(ThreadPool::Priority::NORMAL, [&]() {
+        std::vector<std::future<void>> children;
+        for (int i = 0; i < 200; ++i) {
+            children.push_back(pool.submit(ThreadPool::Priority::NORMAL, [&]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+                {
+                    std::lock_guard<std::mutex> lock(threadsMutex);
+                    threads.insert(std::this_thread::get_id());
+                }
+                counter++;
+            }));
+        }
+        return children;
+    });
+    
+    for (auto& child : root.get()) {
+        child.wait();
+    }
+    EXPECT_EQ(counter, 200);
+    EXPECT_GT(threads.size(), 1u);
+    EXPECT_EQ(pool.getQueueSize(), 0u);
+}
+
+// Test that stealing takes higher priorities first
+TEST(ThreadPoolTest, StealingRespectsPriorities) {
+    ThreadPool pool(2);
+    
+    // Keep both workers busy while the queues fill up
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    auto blockerA = pool.submit(ThreadPool::Priority::NORMAL, [gate]() { gate.wait(); });
+    auto blockerB = pool.submit(ThreadPool::Priority::NORMAL, [gate]() { gate.wait(); });
+    while (pool.getActiveThreadCount() < 2) {
+        std::this_thread::yield();
+    }
+    
+    std::vector<int> executionOrder;
+    std::mutex orderMutex;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 20; ++i) {
+        const auto priority = (i % 2 == 0) ? ThreadPool::Priority::LOW : ThreadPool::Priority::HIGH;
+        futures.push_back(pool.submit(priority, [&, priority]() {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            executionOrder.push_back(static_cast<int>(priority));
+        }));
+    }
+    
+    release.set_value();
+    for (auto& future : futures) {
+        future.wait();
+    }
+    
+    // Workers look for HIGH tasks in every queue before taking a LOW one, so
+    // once a LOW task runs, only a HIGH task the other worker had already
+    // taken can finish after it
+    ASSERT_EQ(executionOrder.size(), 20u);
+    auto firstLow = std::find(executionOrder.begin(), executionOrder.end(), static_cast<int>(ThreadPool::Priority::LOW));
+    EXPECT_LE(std::count(firstLow, executionOrder.end(), static_cast<int>(ThreadPool::Priority::HIGH)), 1);
+}
+
+// Test that waiting tasks age past a stream of higher priority work
+TEST(ThreadPoolTest, AgingPreventsStarvation) {
+    ThreadPool pool(1);
+    pool.setAgingInterval(std::chrono::milliseconds(20));
+    
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    auto blocker = pool.submit(ThreadPool::Priority::HIGH, [gate]() { gate.wait(); });
+    while (pool.getActiveThreadCount() < 1) {
+        std::this_thread::yield();
+    }
+    
+    std::vector<std::string> executionOrder;
+    std::mutex orderMutex;
+    auto record = [&](const std::string& name) {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        executionOrder.push_back(name);
+    };
+    
+    // The LOW task waits two aging intervals, then HIGH work keeps arriving
+    auto low = pool.submit(ThreadPool::Priority::LOW, record, std::string("low"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 20; ++i) {
+        futures.push_back(pool.submit(ThreadPool::Priority::HIGH, record, std::string("high")));
+    }
+    
+    release.set_value();
+    low.get();
+    for (auto& future : futures) {
+        future.get();
+    }
+    
+    ASSERT_EQ(executionOrder.size(), 21u);
+    EXPECT_EQ(executionOrder.front(), "low");
+    EXPECT_EQ(pool.getPromotedTaskCount(), 1u);
+    
+    // Aging can be turned off
+    pool.setAgingInterval(ThreadPool::Clock::duration::zero());
+    EXPECT_EQ(pool.getAgingInterval(), ThreadPool::Clock::duration::zero());
+}
+
+// Test that expired and cancelled tasks are dropped unrun
+TEST(ThreadPoolTest, DropsExpiredAndCancelledTasks) {
+    ThreadPool pool(1);
+    
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    auto blocker = pool.submit(ThreadPool::Priority::HIGH, [gate]() { gate.wait(); });
+    while (pool.getActiveThreadCount() < 1) {
+        std::this_thread::yield();
+    }
+    
+    std::atomic<int> ran{0};
+    
+    ThreadPool::TaskOptions expiring;
+    expiring.deadline = ThreadPool::Clock::now() + std::chrono::milliseconds(10);
+    auto expired = pool.submit(expiring, [&ran]() { ran++; });
+    
+    ThreadPool::CancellationToken token;
+    ThreadPool::TaskOptions cancellable;
+    cancellable.priority = ThreadPool::Priority::LOW;
+    cancellable.token = token;
+    auto cancelled = pool.submit(cancellable, [&ran]() { ran++; });
+    
+    ThreadPool::TaskOptions patient;
+    patient.deadline = ThreadPool::Clock::now() + std::chrono::seconds(60);
+    patient.token = ThreadPool::CancellationToken();
+    auto kept = pool.submit(patient, [&ran]() { ran++; return 5; });
+    
+    token.cancel();
+    EXPECT_TRUE(token.isCancelled());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release.set_value();
+    
+    EXPECT_EQ(kept.get(), 5);
+    try {
+        expired.get();
+        FAIL() << "expired task ran";
+    } catch (const std::future_error& e) {
+        EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+    }
+    EXPECT_THROW(cancelled.get(), std::future_error);
+    
+    EXPECT_EQ(ran, 1);
+    EXPECT_EQ(pool.getExpiredTaskCount(), 1u);
+    EXPECT_EQ(pool.getCancelledTaskCount(), 1u);
+    EXPECT_EQ(pool.getQueueSize(), 0u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
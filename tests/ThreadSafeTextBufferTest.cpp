@@ -1,4 +1,5 @@
 #include "../src/ThreadSafeTextBuffer.h"
+#include "../src/EditorError.h"
 #include <gtest/gtest.h>
 #include <thread>
 #include <atomic>
@@ -6,6 +7,7 @@
 #include <string>
 #include <future>
 #include <chrono>
+#include <random>
 
 class ThreadSafeTextBufferTest : public ::testing::Test {
 protected:
@@ -299,6 +301,156 @@ TEST_F(ThreadSafeTextBufferTest, ReferenceHandling) {
     EXPECT_EQ(buffer.getLine(0), "Modified again");
 }
 
+// Snapshots are immutable views of one document version
+TEST_F(ThreadSafeTextBufferTest, SnapshotIsUnaffectedByLaterEdits) {
+    buffer.clear(false);
+    buffer.addLine("Line 1");
+    buffer.addLine("Line 2");
+    buffer.addLine("Line 3");
+    
+    auto before = buffer.snapshot();
+    const uint64_t version = buffer.version();
+    EXPECT_EQ(before->version(), version);
+    EXPECT_EQ(buffer.snapshot(), before);  // No change, same snapshot
+    
+    buffer.setLine(1, "Changed");
+    buffer.addLine("Line 4");
+    EXPECT_GT(buffer.version(), version);
+    
+    auto after = buffer.snapshot();
+    EXPECT_NE(after, before);
+    EXPECT_EQ(after->version(), buffer.version());
+    EXPECT_EQ(after->getAllLines(), (std::vector<std::string>{"Line 1", "Changed", "Line 3", "Line 4"}));
+    EXPECT_EQ(before->getAllLines(), (std::vector<std::string>{"Line 1", "Line 2", "Line 3"}));
+    EXPECT_THROW(before->getLine(3), TextBufferException);
+}
+
+TEST_F(ThreadSafeTextBufferTest, SnapshotSharesUnchangedChunks) {
+    buffer.clear(false);
+    for (int i = 0; i < 20000; ++i) {
+        buffer.addLine("line " + std::to_string(i));
+    }
+    auto first = buffer.snapshot();
+    ASSERT_GT(first->chunkCount(), 10u);
+    
+    // One keystroke invalidates only the chunk holding the edited line
+    buffer.insertChar(10000, 0, 'x');
+    auto second = buffer.snapshot();
+    EXPECT_EQ(second->sharedChunkCount(*first), first->chunkCount() - 1);
+    EXPECT_EQ(second->getLine(10000), "xline 10000");
+    EXPECT_EQ(first->getLine(10000), "line 10000");
+    
+    // Inserting lines shifts later chunks without copying them
+    buffer.insertLine(500, "inserted");
+    auto third = buffer.snapshot();
+    EXPECT_GE(third->sharedChunkCount(*second), second->chunkCount() - 1);
+    EXPECT_EQ(third->getLine(500), "inserted");
+    EXPECT_EQ(third->getLine(19999), "line 19998");
+}
+
+TEST_F(ThreadSafeTextBufferTest, SnapshotAfterClearDropsEveryChunk) {
+    // Clearing after an append must not reuse the previous snapshot's tail
+    for (bool keepEmptyLine : {true, false}) {
+        buffer.clear(false);
+        for (int i = 0; i < 512; ++i) {
+            buffer.addLine("line " + std::to_string(i));
+        }
+        buffer.snapshot();
+        buffer.addLine("x");
+        buffer.snapshot();
+        
+        buffer.clear(keepEmptyLine);
+        auto cleared = buffer.snapshot();
+        ASSERT_EQ(cleared->lineCount(), buffer.lineCount()) << "keepEmptyLine " << keepEmptyLine;
+        for (size_t i = 0; i < buffer.lineCount(); ++i) {
+            EXPECT_EQ(cleared->getLine(i), buffer.getLine(i)) << "keepEmptyLine " << keepEmptyLine;
+        }
+        
+        buffer.addLine("after");
+        auto appended = buffer.snapshot();
+        ASSERT_EQ(appended->lineCount(), buffer.lineCount());
+        EXPECT_EQ(appended->getLine(buffer.lineCount() - 1), "after");
+    }
+}
+
+TEST_F(ThreadSafeTextBufferTest, SnapshotMatchesBufferAfterRandomEdits) {
+    std::mt19937 rng(12);
+    buffer.clear(false);
+    for (int i = 0; i < 3000; ++i) {
+        buffer.addLine("line " + std::to_string(i));
+    }
+    
+    auto previous = buffer.snapshot();
+    for (int round = 0; round < 300; ++round) {
+        const size_t count = buffer.lineCount();
+        const size_t line = rng() % count;
+        switch (rng() % 7) {
+            case 0: buffer.insertChar(line, 0, 'a'); break;
+            case 1: buffer.insertLine(line, "new " + std::to_string(round)); break;
+            case 2: if (count > 1) buffer.deleteLine(line); break;
+            case 3: buffer.splitLine(line, 2); break;
+            case 4: if (line + 1 < count) buffer.joinLines(line); break;
+            case 5: buffer.deleteLines(line, std::min(count - 1, line + rng() % 800)); break;
+            case 6: buffer.insertLines(line, std::vector<std::string>(rng() % 900, "bulk")); break;
+        }
+        if (buffer.isEmpty()) {
+            buffer.addLine("");
+        }
+        
+        // Snapshot some rounds only, so several changes accumulate between captures
+        if (rng() % 3 == 0) {
+            auto current = buffer.snapshot();
+            ASSERT_EQ(current->getAllLines(), buffer.getAllLines()) << "round " << round;
+            ASSERT_EQ(current->lineCount(), buffer.lineCount());
+            previous = current;
+        }
+    }
+}
+
+TEST_F(ThreadSafeTextBufferTest, SnapshotReadersRunAlongsideTypist) {
+    buffer.clear(false);
+    for (int i = 0; i < 5000; ++i) {
+        buffer.addLine(std::string(40, 'a'));
+    }
+    const uint64_t baseVersion = buffer.version();
+    
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            while (!done.load()) {
+                auto snap = buffer.snapshot();
+                // Each keystroke adds one character and one version, so a
+                // consistent snapshot has exactly as many extra characters
+                // as versions since the typist started
+                size_t total = 0;
+                snap->forEachLine(0, snap->lineCount(), [&](size_t, std::string_view line) {
+                    total += line.size();
+                    return true;
+                });
+                if (total != 5000 * 40 + (snap->version() - baseVersion)) {
+                    failures.fetch_add(1);
+                }
+            }
+        });
+    }
+    
+    std::thread typist([&]() {
+        for (int i = 0; i < 2000; ++i) {
+            buffer.insertChar(static_cast<size_t>(i) % 5000, 0, 'b');
+        }
+        done.store(true);
+    });
+    
+    typist.join();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(buffer.snapshot()->lineLength(0), 41u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -35,9 +35,12 @@ static double measureCachePerformance(VirtualizedTextBuffer& buffer,
     // Reset cache stats before measurement
     buffer.resetCacheStats();
     
-    // Access the buffer according to the pattern
+    // Access the buffer according to the pattern. Prefetching is
+    // asynchronous; waiting after each access stands in for the time an
+    // editor spends rendering before the next scroll step.
     for (size_t lineIndex : accessPattern) {
         buffer.getLine(lineIndex);
+        buffer.waitForPrefetches();
     }
     
     // Return the cache hit rate
@@ -236,6 +239,239 @@ TEST_F(VirtualizedTextBufferCachingTest, SequentialVsRandomAccessPerformance) {
     EXPECT_GT(seqHitRate, randHitRate);
 }
 
+TEST_F(VirtualizedTextBufferCachingTest, ConcurrentReadersLoadPages) {
+    VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+    const VirtualizedTextBuffer& view = buffer;
+
+    // Readers only take the shared lock, so cold pages are loaded in parallel
+    const size_t threadCount = 4;
+    std::vector<std::thread> readers;
+    std::vector<size_t> mismatches(threadCount, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t t = 0; t < threadCount; ++t) {
+        readers.emplace_back([&, t]() {
+            std::mt19937 rng(static_cast<unsigned>(t));
+            std::uniform_int_distribution<size_t> lineDist(0, lineCount - 1);
+            for (size_t i = 0; i < 2000; ++i) {
+                size_t line = lineDist(rng);
+                std::string expected = "This is test line " + std::to_string(line);
+                if (view.getLineSegment(line, 0, expected.size()) != expected) {
+                    ++mismatches[t];
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "Concurrent random reads (" << threadCount << " threads): " << elapsed << " µs" << std::endl;
+
+    for (size_t t = 0; t < threadCount; ++t) {
+        EXPECT_EQ(mismatches[t], 0u) << "reader " << t;
+    }
+    EXPECT_LE(buffer.getPagesInMemory(), cacheSize);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ScanResistantPolicies) {
+    // A small working set read twice per round, followed by a scan of pages
+    // that are not reused soon. LRU lets every scan flush the working set;
+    // SLRU and ARC keep pages that were hit again.
+    auto hitRate = [this](VirtualizedTextBuffer::CacheEvictionPolicy policy) {
+        VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+        buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+        buffer.setCacheEvictionPolicy(policy);
+        buffer.resetCacheStats();
+
+        const size_t pageCount = lineCount / pageSize;
+        size_t scanPage = 10;
+        for (size_t round = 0; round < 100; ++round) {
+            for (size_t page = 0; page < 5; ++page) {
+                buffer.getLine(page * pageSize);
+                buffer.getLine(page * pageSize + 1);
+            }
+            for (size_t i = 0; i < 2 * cacheSize; ++i) {
+                buffer.getLine(scanPage * pageSize);
+                scanPage = scanPage + 1 < pageCount ? scanPage + 1 : 10;
+            }
+        }
+        return buffer.getCacheHitRate();
+    };
+
+    double lruHitRate = hitRate(VirtualizedTextBuffer::CacheEvictionPolicy::LRU);
+    double slruHitRate = hitRate(VirtualizedTextBuffer::CacheEvictionPolicy::SLRU);
+    double arcHitRate = hitRate(VirtualizedTextBuffer::CacheEvictionPolicy::ARC);
+
+    std::cout << "Scan hit rates - LRU: " << lruHitRate << "%, SLRU: " << slruHitRate
+              << "%, ARC: " << arcHitRate << "%" << std::endl;
+
+    EXPECT_GT(slruHitRate, lruHitRate);
+    EXPECT_GT(arcHitRate, lruHitRate);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ByteBudgetBoundsResidentMemory) {
+    // A page cap well above what the budget allows, so bytes decide
+    VirtualizedTextBuffer buffer(testFilename, pageSize, 1000);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+
+    const size_t budget = 64 * 1024;
+    buffer.setCacheByteBudget(budget);
+    EXPECT_EQ(buffer.getCacheByteBudget(), budget);
+    buffer.resetCacheStats();
+
+    for (size_t line = 0; line < lineCount; line += pageSize / 2) {
+        EXPECT_EQ(buffer.getLine(line).rfind("This is test line " + std::to_string(line) + " ", 0), 0u);
+    }
+
+    auto stats = buffer.getCacheStats();
+    std::cout << "Byte budget: " << stats.pagesResident << " pages, " << stats.bytesResident
+              << " bytes resident, " << stats.evictions << " evictions" << std::endl;
+
+    EXPECT_LE(stats.bytesResident, budget);
+    EXPECT_GT(stats.pagesResident, 0u);
+    EXPECT_LT(stats.pagesResident, lineCount / pageSize);
+    EXPECT_EQ(stats.pagesResident, buffer.getPagesInMemory());
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_EQ(stats.misses, lineCount / pageSize);
+    EXPECT_EQ(stats.byteBudget, budget);
+
+    // Shrinking the budget evicts immediately
+    buffer.setCacheByteBudget(budget / 4);
+    EXPECT_LE(buffer.getCacheStats().bytesResident, budget / 4);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ByteBudgetHoldsFewerLongLinePages) {
+    // Same number of lines per page, ten times the bytes per line
+    const std::string longFilename = "virtualized_buffer_long_lines.txt";
+    {
+        std::ofstream outFile(longFilename);
+        for (size_t i = 0; i < lineCount; ++i) {
+            outFile << "Long line " << i << " " << std::string(800, 'x') << "\n";
+        }
+    }
+
+    auto residentPages = [this](const std::string& filename) {
+        VirtualizedTextBuffer buffer(filename, pageSize, 1000);
+        buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+        buffer.setCacheByteBudget(512 * 1024);
+        for (size_t line = 0; line < lineCount; line += pageSize) {
+            buffer.getLine(line);
+        }
+        auto stats = buffer.getCacheStats();
+        EXPECT_LE(stats.bytesResident, stats.byteBudget);
+        return stats.pagesResident;
+    };
+
+    size_t shortPages = residentPages(testFilename);
+    size_t longPages = residentPages(longFilename);
+    deleteTestFile(longFilename);
+
+    std::cout << "Pages within 512 KiB - short lines: " << shortPages << ", long lines: " << longPages << std::endl;
+    EXPECT_LT(longPages, shortPages);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ByteBudgetTracksEdits) {
+    VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+    buffer.getLine(0);
+
+    auto before = buffer.getCacheStats();
+    EXPECT_GT(before.bytesResident, 0u);
+    EXPECT_EQ(before.bytesDirty, 0u);
+
+    // Growing a line is charged to its page once the edit is done
+    buffer.replaceLine(0, std::string(100000, 'y'));
+    auto after = buffer.getCacheStats();
+    EXPECT_GT(after.bytesDirty, 0u);
+    EXPECT_LE(after.bytesDirty, after.bytesResident);
+    EXPECT_GT(after.bytesResident, 100000u);
+
+    // A budget below the dirty page cannot evict it
+    buffer.setCacheByteBudget(1024);
+    EXPECT_EQ(buffer.getLine(0).size(), 100000u);
+    EXPECT_TRUE(buffer.isMemoryUsageHigh());
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, NoByteBudgetFallsBackToPageCap) {
+    VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+    buffer.setCacheByteBudget(0);
+
+    for (size_t page = 0; page < cacheSize - 1; ++page) {
+        buffer.getLine(page * pageSize);
+    }
+    EXPECT_FALSE(buffer.isMemoryUsageHigh());
+
+    for (size_t page = 0; page < 3 * cacheSize; ++page) {
+        buffer.getLine(page * pageSize);
+    }
+    EXPECT_EQ(buffer.getPagesInMemory(), cacheSize);
+    EXPECT_TRUE(buffer.isMemoryUsageHigh());
+    EXPECT_EQ(buffer.getCacheStats().evictions, 2 * cacheSize);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ColdTierServesRevisitedPages) {
+    auto scanTwice = [this](size_t coldBudget) {
+        VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+        buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+        buffer.setColdTierByteBudget(coldBudget);
+        for (size_t line = 0; line < lineCount; line += pageSize) {
+            buffer.getLine(line);
+        }
+
+        // Every page of the second pass was evicted by the first
+        buffer.resetCacheStats();
+        for (size_t line = 0; line < lineCount; line += pageSize) {
+            EXPECT_EQ(buffer.getLine(line).rfind("This is test line " + std::to_string(line) + " ", 0), 0u);
+        }
+        return std::make_pair(buffer.getCacheStats(), buffer.getCompressionRatio());
+    };
+
+    auto withTier = scanTwice(VirtualizedTextBuffer::kDefaultColdTierByteBudget);
+    auto withoutTier = scanTwice(0);
+
+    std::cout << "Cold tier: " << withTier.first.coldHits << " hits, " << withTier.first.coldMisses
+              << " misses, compression ratio " << withTier.second << std::endl;
+
+    EXPECT_EQ(withTier.first.misses, lineCount / pageSize);
+    EXPECT_EQ(withTier.first.coldHits, withTier.first.misses);
+    EXPECT_EQ(withTier.first.coldPagesResident, lineCount / pageSize - cacheSize);
+    EXPECT_EQ(withTier.first.coldPagesDirty, 0u);
+    EXPECT_LT(withTier.first.coldBytesResident, withTier.first.coldBytesUncompressed);
+    EXPECT_GT(withTier.second, 1.5);
+
+    EXPECT_EQ(withoutTier.first.coldHits, 0u);
+    EXPECT_EQ(withoutTier.first.coldMisses, lineCount / pageSize);
+    EXPECT_EQ(withoutTier.first.coldPagesResident, 0u);
+}
+
+TEST_F(VirtualizedTextBufferCachingTest, ColdTierBudgetDropsCleanPagesOnly) {
+    VirtualizedTextBuffer buffer(testFilename, pageSize, cacheSize);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+
+    for (size_t page = 0; page < lineCount / pageSize; ++page) {
+        if (page % 10 == 0) {
+            buffer.replaceLine(page * pageSize, "edited");
+        } else {
+            buffer.getLine(page * pageSize);
+        }
+    }
+
+    // With no budget left only the unsaved edits stay
+    buffer.setColdTierByteBudget(0);
+    auto stats = buffer.getCacheStats();
+    EXPECT_EQ(stats.coldPagesResident, stats.coldPagesDirty);
+    EXPECT_GT(stats.coldPagesDirty, 0u);
+
+    for (size_t page = 0; page < lineCount / pageSize; page += 10) {
+        EXPECT_EQ(buffer.getLine(page * pageSize), "edited");
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
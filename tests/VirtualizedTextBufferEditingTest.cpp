@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include "VirtualizedTextBuffer.h"
+#include "TextBuffer.h"
+#include <cstdio>       // For std::remove
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Test fixture for structural edits on a file-backed VirtualizedTextBuffer
+class VirtualizedTextBufferEditingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::ofstream out(testFilename);
+        for (size_t i = 0; i < lineCount; ++i) {
+            out << "line " << i << '\n';
+        }
+    }
+
+    void TearDown() override {
+        std::remove(testFilename.c_str());
+        std::remove((testFilename + ".idx").c_str());
+        std::remove(savedFilename.c_str());
+        std::remove((savedFilename + ".idx").c_str());
+    }
+
+    const std::string testFilename = "virtualized_editing_test.txt";
+    const std::string savedFilename = "virtualized_editing_saved.txt";
+    const size_t lineCount = 10000;
+};
+
+TEST_F(VirtualizedTextBufferEditingTest, InsertAndDeleteTouchOnlyOnePage) {
+    VirtualizedTextBuffer buffer(testFilename, 100, 10);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+
+    buffer.insertLine(5000, "inserted");
+    EXPECT_EQ(buffer.getPagesInMemory(), 1u);
+    EXPECT_EQ(buffer.lineCount(), lineCount + 1);
+
+    buffer.deleteLine(7000);
+    EXPECT_EQ(buffer.getPagesInMemory(), 2u);
+    EXPECT_EQ(buffer.lineCount(), lineCount);
+
+    const VirtualizedTextBuffer& view = buffer;
+    EXPECT_EQ(view.getLine(4999), "line 4999");
+    EXPECT_EQ(view.getLine(5000), "inserted");
+    EXPECT_EQ(view.getLine(5001), "line 5000");
+    EXPECT_EQ(view.getLine(6999), "line 6998");
+    EXPECT_EQ(view.getLine(7000), "line 7000");
+}
+
+TEST_F(VirtualizedTextBufferEditingTest, ForEachLineWalksAcrossPages) {
+    VirtualizedTextBuffer buffer(testFilename, 100, 4);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+    buffer.replaceLine(250, "edited");
+
+    // A range far larger than the cache streams through it page by page
+    size_t expected = 150;
+    bool inOrder = true;
+    size_t visited = buffer.forEachLine(150, 9000, [&](size_t lineIndex, std::string_view line) {
+        const std::string want = lineIndex == 250 ? "edited" : "line " + std::to_string(lineIndex);
+        inOrder = inOrder && lineIndex == expected++ && line == want;
+        return true;
+    });
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(visited, 8850u);
+    EXPECT_LE(buffer.getPagesInMemory(), 5u);
+
+    // Stopping early and clamping the end
+    std::string last;
+    visited = buffer.forEachLine(9990, 20000, [&](size_t, std::string_view line) {
+        last = std::string(line);
+        return line != "line 9995";
+    });
+    EXPECT_EQ(visited, 6u);
+    EXPECT_EQ(last, "line 9995");
+    EXPECT_EQ(buffer.forEachLine(lineCount, lineCount + 5, [](size_t, std::string_view) { return true; }), 0u);
+}
+
+TEST_F(VirtualizedTextBufferEditingTest, DeletingWholePagesDoesNotLoadThem) {
+    VirtualizedTextBuffer buffer(testFilename, 100, 10);
+    buffer.setPrefetchStrategy(VirtualizedTextBuffer::PrefetchStrategy::NONE);
+
+    buffer.deleteLines(150, 9950);              // Partial first and last page only
+    EXPECT_EQ(buffer.getPagesInMemory(), 2u);
+    ASSERT_EQ(buffer.lineCount(), 200u);
+
+    const VirtualizedTextBuffer& view = buffer;
+    EXPECT_EQ(view.getLine(149), "line 149");
+    EXPECT_EQ(view.getLine(150), "line 9950");
+    EXPECT_EQ(view.getLine(199), "line 9999");
+}
+
+TEST_F(VirtualizedTextBufferEditingTest, DirtyPagesSurviveEviction) {
+    VirtualizedTextBuffer buffer(testFilename, 10, 2);
+
+    // Edit far more pages than the cache can hold
+    for (size_t i = 0; i < lineCount; i += 500) {
+        buffer.replaceLine(i, "edited " + std::to_string(i));
+    }
+    for (size_t i = 0; i < lineCount; i += 37) {
+        buffer.lineLength(i);
+    }
+
+    const VirtualizedTextBuffer& view = buffer;
+    for (size_t i = 0; i < lineCount; i += 500) {
+        EXPECT_EQ(view.getLine(i), "edited " + std::to_string(i));
+    }
+    EXPECT_EQ(view.getLine(501), "line 501");
+
+    // Evicted edits are kept compressed in memory; the source is untouched until a save
+    auto stats = buffer.getCacheStats();
+    EXPECT_LE(stats.pagesResident, 2u);
+    EXPECT_GE(stats.coldPagesDirty, lineCount / 500 - 2);
+
+    TextBuffer source;
+    ASSERT_TRUE(source.loadFromFile(testFilename));
+    EXPECT_EQ(source.getLine(500), "line 500");
+
+    ASSERT_TRUE(buffer.saveToFile(testFilename));
+    EXPECT_EQ(buffer.getCacheStats().coldPagesDirty, 0u);
+    ASSERT_TRUE(source.loadFromFile(testFilename));
+    EXPECT_EQ(source.getLine(500), "edited 500");
+    EXPECT_EQ(view.getLine(1000), "edited 1000");
+}
+
+TEST_F(VirtualizedTextBufferEditingTest, SaveToSourceFileAndReload) {
+    {
+        VirtualizedTextBuffer buffer(testFilename, 64, 4);
+        buffer.insertLines(10, {"a", "b", "c"});
+        buffer.deleteLines(4000, 4100);
+        buffer.splitLine(9000, 3);
+        ASSERT_TRUE(buffer.saveToFile(testFilename));
+
+        // The buffer keeps working against the rewritten file
+        const VirtualizedTextBuffer& view = buffer;
+        EXPECT_EQ(view.getLine(11), "b");
+        EXPECT_EQ(view.getLine(5000), "line 5097");
+        EXPECT_EQ(buffer.lineCount(), lineCount + 3 - 100 + 1);
+    }
+
+    TextBuffer reference;
+    ASSERT_TRUE(reference.loadFromFile(testFilename));
+    ASSERT_EQ(reference.lineCount(), lineCount + 3 - 100 + 1);
+    EXPECT_EQ(reference.getLine(10), "a");
+    EXPECT_EQ(reference.getLine(9000), "lin");
+    EXPECT_EQ(reference.getLine(9001), "e 9097");
+
+    // Reopening uses the index written by the save
+    VirtualizedTextBuffer reopened(testFilename, 64, 4);
+    EXPECT_EQ(reopened.getLines(), reference.getLines());
+}
+
+// Random structural edits must leave the buffer identical to a TextBuffer
+TEST_F(VirtualizedTextBufferEditingTest, MatchesTextBufferOnRandomEdits) {
+    VirtualizedTextBuffer buffer(testFilename, 8, 3);
+    TextBuffer reference;
+    ASSERT_TRUE(reference.loadFromFile(testFilename));
+    std::mt19937 rng(4321);
+
+    for (int step = 0; step < 3000; ++step) {
+        const size_t lines = reference.lineCount();
+        const size_t line = rng() % lines;
+        const size_t col = rng() % (reference.lineLength(line) + 1);
+        const std::string text = "s" + std::to_string(step);
+
+        switch (rng() % 7) {
+            case 0: reference.insertLine(line, text); buffer.insertLine(line, text); break;
+            case 1:
+                if (lines > 1) { reference.deleteLine(line); buffer.deleteLine(line); }
+                break;
+            case 2: {
+                std::vector<std::string> block(rng() % 40, text);
+                reference.insertLines(line, block);
+                buffer.insertLines(line, block);
+                break;
+            }
+            case 3: {
+                const size_t end = std::min(lines - 1, line + rng() % 30);
+                if (end > line) { reference.deleteLines(line, end); buffer.deleteLines(line, end); }
+                break;
+            }
+            case 4: reference.splitLine(line, col); buffer.splitLine(line, col); break;
+            case 5: reference.deleteChar(line, col); buffer.deleteChar(line, col); break;
+            case 6: reference.deleteCharForward(line, col); buffer.deleteCharForward(line, col); break;
+        }
+
+        ASSERT_EQ(buffer.lineCount(), reference.lineCount()) << "step " << step;
+    }
+
+    EXPECT_EQ(buffer.getLines(), reference.getLines());
+
+    ASSERT_TRUE(buffer.saveToFile(savedFilename));
+    TextBuffer saved;
+    ASSERT_TRUE(saved.loadFromFile(savedFilename));
+    EXPECT_EQ(saved.getLines(), reference.getLines());
+}
@@ -513,4 +513,37 @@ TEST_F(CppHighlighterMultilineTest, StringLiteralWithComments) {
         }
     }
     EXPECT_TRUE(noCommentStyle) << "Line comment symbols inside a string shouldn't create a comment style";
-} 
\ No newline at end of file
+} 
+
+// Test that lines highlighted out of order pick up where a stored end state left off
+TEST_F(CppHighlighterMultilineTest, LexerStateCarriesAcrossLines) {
+    LexerState state;
+    highlighter.highlightLineFrom("int x; /* opens a comment", 0, state);
+    EXPECT_TRUE(state.has(LexerState::IN_BLOCK_COMMENT));
+    
+    // Lines highlighted in between do not disturb a stored state
+    LexerState other;
+    highlighter.highlightLineFrom("const char* s = R\"sql(SELECT", 7, other);
+    EXPECT_TRUE(other.has(LexerState::IN_RAW_STRING));
+    EXPECT_EQ(other.rawStringDelimiter(), "sql");
+    
+    // The comment continues on the next line and closes there
+    LexerState afterComment = state;
+    auto styles = highlighter.highlightLineFrom("still comment */ int y;", 1, afterComment);
+    ASSERT_TRUE(styles);
+    EXPECT_TRUE(hasStyle(*styles, 0, 16, SyntaxColor::Comment));
+    EXPECT_TRUE(hasStyle(*styles, 17, 20, SyntaxColor::Type)); // "int"
+    EXPECT_EQ(afterComment, LexerState());
+    
+    // The raw string ends only at its own delimiter
+    LexerState afterRaw = other;
+    highlighter.highlightLineFrom("FROM t)\" still raw", 8, afterRaw);
+    EXPECT_TRUE(afterRaw.has(LexerState::IN_RAW_STRING));
+    highlighter.highlightLineFrom("WHERE 1)sql\";", 9, afterRaw);
+    EXPECT_EQ(afterRaw, LexerState());
+    
+    // An edit that leaves the end state unchanged leaves later lines alone
+    LexerState edited;
+    highlighter.highlightLineFrom("int xyz; /* opens a comment", 0, edited);
+    EXPECT_EQ(edited, state);
+}
@@ -12,6 +12,9 @@
 
 #include "Editor.h"
 #include "WorkspaceManager.h"
+#include "VirtualizedTextBuffer.h"
+#include "LineIndexer.h"
+#include "MappedFile.h"
 #include "test_file_utilities.h"
 
 namespace fs = std::filesystem;
@@ -221,6 +224,46 @@ protected:
         std::cout << "File Open Test for " << sizeLabel << " completed in " << openTimeMs << " ms." << std::endl;
     }
     
+    /**
+     * Measure how fast a VirtualizedTextBuffer indexes a file it has never seen
+     */
+    void testVirtualizedIndexing(const std::string& filePath, const std::string& sizeLabel) {
+        if (filePath.empty() || !fs::exists(filePath)) {
+            GTEST_SKIP() << "Test file not generated or path empty for " << sizeLabel;
+            return;
+        }
+
+        const double fileSizeGB = static_cast<double>(fs::file_size(filePath)) / 1e9;
+        const std::string indexPath = filePath + ".idx";
+        fs::remove(indexPath);
+
+        // Raw scanner throughput
+        MappedFile file;
+        ASSERT_TRUE(file.open(filePath));
+        LineIndexer::Result scan;
+        double scanTimeMs = MeasureExecutionTimeMs([&]() {
+            scan = LineIndexer::scan(file, 1000);
+        });
+
+        // Full cold open, including writing the index file
+        size_t lineCount = 0;
+        double openTimeMs = MeasureExecutionTimeMs([&]() {
+            VirtualizedTextBuffer buffer(filePath, 1000, 16);
+            lineCount = buffer.lineCount();
+        });
+        fs::remove(indexPath);
+
+        std::cout << "[" << sizeLabel << "] Line index scan (" << LineIndexer::simdLevelName(LineIndexer::simdLevel())
+                  << ", " << std::thread::hardware_concurrency() << " threads): " << scanTimeMs << " ms, "
+                  << fileSizeGB / (scanTimeMs / 1000.0) << " GB/s" << std::endl;
+        std::cout << "[" << sizeLabel << "] Virtualized cold open: " << openTimeMs << " ms, "
+                  << fileSizeGB / (openTimeMs / 1000.0) << " GB/s" << std::endl;
+
+        EXPECT_GE(lineCount, scan.lineBreaks);
+        EXPECT_LE(openTimeMs, thresholds[sizeLabel].openTimeMs)
+            << sizeLabel << " virtualized open time exceeded threshold";
+    }
+
     /**
      * Test saving a file and measure performance
      */
@@ -399,6 +442,7 @@ TEST_F(ExtremeLargeFileTest, MediumLargeFileTest) {
     
     // Test file operations
     testFileOpen(mediumLargeFilePath_, "MediumLarge");
+    testVirtualizedIndexing(mediumLargeFilePath_, "MediumLarge");
     testFileSave(mediumLargeFilePath_, "MediumLarge");
     testScrolling(mediumLargeFilePath_, "MediumLarge");
     testSearching(mediumLargeFilePath_, "MediumLarge");
@@ -416,6 +460,7 @@ TEST_F(ExtremeLargeFileTest, VeryLargeFileTest) {
     
     // Test file operations
     testFileOpen(veryLargeFilePath_, "VeryLarge");
+    testVirtualizedIndexing(veryLargeFilePath_, "VeryLarge");
     testFileSave(veryLargeFilePath_, "VeryLarge");
     testScrolling(veryLargeFilePath_, "VeryLarge");
     testSearching(veryLargeFilePath_, "VeryLarge");
@@ -439,6 +484,7 @@ TEST_F(ExtremeLargeFileTest, ExtremeLargeFileTest) {
     
     // Test file operations
     testFileOpen(extremeLargeFilePath_, "ExtremeLarge");
+    testVirtualizedIndexing(extremeLargeFilePath_, "ExtremeLarge");
     testFileSave(extremeLargeFilePath_, "ExtremeLarge");
     testScrolling(extremeLargeFilePath_, "ExtremeLarge");
     testSearching(extremeLargeFilePath_, "ExtremeLarge");
@@ -463,6 +509,7 @@ TEST_F(ExtremeLargeFileTest, UltraLargeFileTest) {
     
     // Test file operations
     testFileOpen(ultraLargeFilePath_, "UltraLarge");
+    testVirtualizedIndexing(ultraLargeFilePath_, "UltraLarge");
     testFileSave(ultraLargeFilePath_, "UltraLarge");
     testScrolling(ultraLargeFilePath_, "UltraLarge");
     testSearching(ultraLargeFilePath_, "UltraLarge");
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <vector>
@@ -9,6 +10,7 @@
 #include <fstream>
 
 #include "Editor.h"
+#include "VirtualizedTextBuffer.h"
 #include "WorkspaceManager.h"
 #include "test_file_utilities.h"
 
@@ -140,6 +142,13 @@ protected:
         return duration.count();
     }
     
+    /**
+     * Convert a byte count and a duration in milliseconds to MB/s
+     */
+    static double MegabytesPerSecond(uintmax_t bytes, double ms) {
+        return ms > 0.0 ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+    }
+    
     /**
      * "Close" the current file by opening an empty file
      */
@@ -165,7 +174,8 @@ TEST_F(LargeFileTest, MeasureFileOpenTime) {
         
         std::cout << "Time to open " << fileSizeLabel << " (" 
                   << fs::file_size(filePath) / (1024 * 1024) << "MB) file: " 
-                  << openTimeMs << " ms" << std::endl;
+                  << openTimeMs << " ms (" << MegabytesPerSecond(fs::file_size(filePath), openTimeMs)
+                  << " MB/s)" << std::endl;
         
         // Verify file was opened successfully by checking line count
         const ITextBuffer& buffer = editor->getBuffer();
@@ -289,7 +299,8 @@ TEST_F(LargeFileTest, MeasureFileSaveTime) {
         
         std::cout << "Time to save " << fileSizeLabel << " (" 
                   << fs::file_size(filePath) / (1024 * 1024) << "MB) file: " 
-                  << saveTimeMs << " ms" << std::endl;
+                  << saveTimeMs << " ms (" << MegabytesPerSecond(fs::file_size(filePath), saveTimeMs)
+                  << " MB/s)" << std::endl;
         
         // Verify saved file exists and has reasonable size (not exact match due to possible line endings conversion)
         ASSERT_TRUE(fs::exists(savePath)) << "Saved file not found: " << savePath;
@@ -327,6 +338,35 @@ TEST_F(LargeFileTest, MeasureFileSaveTime) {
     }
 }
 
+/**
+ * Test to measure raw TextBuffer load and save throughput, without the editor on top
+ */
+TEST_F(LargeFileTest, MeasureTextBufferLoadSaveThroughput) {
+    if (largeFilePath_.empty() || !fs::exists(largeFilePath_)) {
+        GTEST_SKIP() << "Large test file not generated";
+    }
+    
+    const uintmax_t fileSize = fs::file_size(largeFilePath_);
+    const std::string savePath = testOutputDir + "throughput_saved_file.txt";
+    generatedTestFiles.push_back(savePath); // Mark for cleanup
+    
+    TextBuffer buffer;
+    double loadTimeMs = MeasureExecutionTimeMs([&]() {
+        ASSERT_TRUE(buffer.loadFromFile(largeFilePath_)) << "Failed to load " << largeFilePath_;
+    });
+    double saveTimeMs = MeasureExecutionTimeMs([&]() {
+        ASSERT_TRUE(buffer.saveToFile(savePath)) << "Failed to save " << savePath;
+    });
+    
+    std::cout << "TextBuffer load: " << loadTimeMs << " ms (" << MegabytesPerSecond(fileSize, loadTimeMs)
+              << " MB/s), " << buffer.lineCount() << " lines" << std::endl;
+    std::cout << "TextBuffer save: " << saveTimeMs << " ms (" << MegabytesPerSecond(fileSize, saveTimeMs)
+              << " MB/s)" << std::endl;
+    
+    // Saving writes every line back with a trailing newline
+    EXPECT_NEAR(static_cast<double>(fs::file_size(savePath)), static_cast<double>(fileSize), 1.0);
+}
+
 /**
  * Test to measure scrolling performance in large files
  */
@@ -381,6 +421,35 @@ TEST_F(LargeFileTest, MeasureScrollingPerformance) {
     std::cout << "Time to jump to beginning of file: " << jumpToBeginningTimeMs << " ms" << std::endl;
     ASSERT_LE(jumpToBeginningTimeMs, 100.0) << "Jumping to beginning of file is too slow";
     
+    // Per-line latency of scrolling a virtualized buffer. Prefetching runs
+    // on a background thread, so the tail latency should not grow with the
+    // prefetch distance.
+    const size_t virtualizedPageSize = 1000;
+    const size_t virtualizedCacheSize = 32;
+    for (size_t distance : {0, 2, 8}) {
+        VirtualizedTextBuffer buffer(largeFilePath_, virtualizedPageSize, virtualizedCacheSize);
+        buffer.setPrefetchStrategy(distance == 0 ? VirtualizedTextBuffer::PrefetchStrategy::NONE
+                                                 : VirtualizedTextBuffer::PrefetchStrategy::ADJACENT);
+        buffer.setPrefetchDistance(distance);
+        
+        const size_t scrollLines = std::min<size_t>(buffer.lineCount(), 200000);
+        std::vector<double> latenciesUs;
+        latenciesUs.reserve(scrollLines);
+        for (size_t line = 0; line < scrollLines; ++line) {
+            auto start = std::chrono::steady_clock::now();
+            buffer.getLine(line);
+            auto end = std::chrono::steady_clock::now();
+            latenciesUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        ASSERT_FALSE(latenciesUs.empty());
+        
+        std::sort(latenciesUs.begin(), latenciesUs.end());
+        double p50 = latenciesUs[latenciesUs.size() / 2];
+        double p99 = latenciesUs[std::min(latenciesUs.size() - 1, latenciesUs.size() * 99 / 100)];
+        std::cout << "Virtualized scroll, prefetch distance " << distance << ": p50 " << p50
+                  << " us, p99 " << p99 << " us, max " << latenciesUs.back() << " us" << std::endl;
+    }
+    
     // Clean up
     closeCurrentFile();
 }
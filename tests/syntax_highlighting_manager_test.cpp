@@ -1385,7 +1385,7 @@ TEST_F(SyntaxHighlightingManagerTest, CacheGrowthAndMemoryBehavior) {
     EXPECT_GT(finalCacheSize, 0);
 }
 
-// Test to verify cache behavior with the CACHE_ENTRY_LIFETIME_MS constant
+// Test that a repeated request is served from the cache
 TEST_F(SyntaxHighlightingManagerTest, CacheEntryLifetime) {
     // Set up a simple buffer
     text_buffer_ = TextBuffer();
@@ -1408,12 +1408,6 @@ TEST_F(SyntaxHighlightingManagerTest, CacheEntryLifetime) {
     // Immediate second request should use cache
     auto styles2 = manager_->getHighlightingStyles(0, 1);
     EXPECT_EQ(styles2.size(), 2);
-
-    // Note: We can't effectively test the CACHE_ENTRY_LIFETIME_MS timeout
-    // in a unit test without making the code more testable. This would require:
-    // 1. Making the timeout configurable for testing
-    // 2. Adding a way to manually trigger cache cleanup
-    // 3. Adding a way to query cache entry timestamps
 }
 
 TEST_F(SyntaxHighlightingManagerTest, CacheEvictionAndCleanup) {